@@ -283,6 +283,83 @@ static const struct aesni_gcm_tfm_s aesni_gcm_tfm_avx_gen4 = {
 
 #endif
 
+#ifdef CONFIG_AS_VAES
+/*
+ * asmlinkage void aesni_gcm_enc_update_vaes_by8()
+ * asmlinkage void aesni_gcm_dec_update_vaes_by8()
+ * Bulk GCM using VAES and VPCLMULQDQ on 8 blocks at a time.  The length
+ * must be a non-zero multiple of VAES_GCM_CHUNK and no partial block may
+ * be pending in gdata; everything else is left to the AVX2 (gen4) code,
+ * which shares the gcm_context_data layout.
+ */
+#define VAES_GCM_CHUNK (8 * AES_BLOCK_SIZE)
+
+asmlinkage void aesni_gcm_enc_update_vaes_by8(void *ctx,
+				     struct gcm_context_data *gdata, u8 *out,
+				     const u8 *in, unsigned long plaintext_len);
+asmlinkage void aesni_gcm_dec_update_vaes_by8(void *ctx,
+				     struct gcm_context_data *gdata, u8 *out,
+				     const u8 *in,
+				     unsigned long ciphertext_len);
+
+static void aesni_gcm_update_vaes(bool enc, void *ctx,
+				  struct gcm_context_data *gdata, u8 *out,
+				  const u8 *in, unsigned long len)
+{
+	void (*update)(void *ctx, struct gcm_context_data *gdata, u8 *out,
+		       const u8 *in, unsigned long len);
+	unsigned long n;
+
+	update = enc ? aesni_gcm_enc_update_avx_gen4 :
+		       aesni_gcm_dec_update_avx_gen4;
+
+	/* finish a partial block left over from the previous sg entry */
+	if (gdata->partial_block_len) {
+		n = min_t(unsigned long, len,
+			  GCM_BLOCK_LEN - gdata->partial_block_len);
+		update(ctx, gdata, out, in, n);
+		out += n;
+		in += n;
+		len -= n;
+	}
+
+	n = round_down(len, VAES_GCM_CHUNK);
+	if (n) {
+		if (enc)
+			aesni_gcm_enc_update_vaes_by8(ctx, gdata, out, in, n);
+		else
+			aesni_gcm_dec_update_vaes_by8(ctx, gdata, out, in, n);
+	}
+
+	if (len > n)
+		update(ctx, gdata, out + n, in + n, len - n);
+}
+
+static void aesni_gcm_enc_update_vaes(void *ctx,
+				      struct gcm_context_data *gdata, u8 *out,
+				      const u8 *in, unsigned long plaintext_len)
+{
+	aesni_gcm_update_vaes(true, ctx, gdata, out, in, plaintext_len);
+}
+
+static void aesni_gcm_dec_update_vaes(void *ctx,
+				      struct gcm_context_data *gdata, u8 *out,
+				      const u8 *in, unsigned long ciphertext_len)
+{
+	aesni_gcm_update_vaes(false, ctx, gdata, out, in, ciphertext_len);
+}
+
+static const struct aesni_gcm_tfm_s aesni_gcm_tfm_vaes = {
+	.init = &aesni_gcm_init_avx_gen4,
+	.enc_update = &aesni_gcm_enc_update_vaes,
+	.dec_update = &aesni_gcm_dec_update_vaes,
+	.finalize = &aesni_gcm_finalize_avx_gen4,
+};
+
+asmlinkage void aesni_xts_crypt16_vaes(struct crypto_aes_ctx *ctx, u8 *out,
+				       const u8 *in, bool enc, u8 *iv);
+#endif
+
 static inline struct
 aesni_rfc4106_gcm_ctx *aesni_rfc4106_gcm_ctx_get(struct crypto_aead *tfm)
 {
@@ -377,94 +454,150 @@ static int aesni_skcipher_setkey(struct crypto_skcipher *tfm, const u8 *key,
 				  crypto_skcipher_ctx(tfm), key, len);
 }
 
-static int ecb_encrypt(struct skcipher_request *req)
+/*
+ * Batched requests are processed back to back inside one FPU section.  Give
+ * the scheduler a chance between requests once this many bytes have been
+ * handled, as the single request paths would have done.
+ */
+#define AESNI_BATCH_YIELD	(16 * 1024)
+
+/*
+ * Nothing may sleep with the FPU held, so the walk of each request is set up
+ * as if the caller had not passed CRYPTO_TFM_REQ_MAY_SLEEP.
+ */
+static int aesni_skcipher_batch(struct skcipher_request **reqs, int *errs,
+				unsigned int nr,
+				int (*fn)(struct skcipher_request *req,
+					  struct skcipher_walk *walk, int err))
+{
+	unsigned int i, bytes = 0;
+	int ret = 0;
+
+	kernel_fpu_begin();
+	for (i = 0; i < nr; i++) {
+		struct skcipher_request *req = reqs[i];
+		u32 flags = req->base.flags;
+		struct skcipher_walk walk;
+		int err;
+
+		if (bytes >= AESNI_BATCH_YIELD) {
+			kernel_fpu_end();
+			kernel_fpu_begin();
+			bytes = 0;
+		}
+		bytes += req->cryptlen;
+
+		req->base.flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+		err = skcipher_walk_virt(&walk, req, true);
+		req->base.flags = flags;
+
+		errs[i] = fn(req, &walk, err);
+		if (!ret)
+			ret = errs[i];
+	}
+	kernel_fpu_end();
+
+	return ret;
+}
+
+/*
+ * Define the single request and batch entry points around a __name() helper
+ * that runs over a walk set up by the caller, with the FPU held.
+ */
+#define AESNI_SKCIPHER_FPU_FUNCS(name)					\
+static int name(struct skcipher_request *req)				\
+{									\
+	struct skcipher_walk walk;					\
+	int err;							\
+									\
+	err = skcipher_walk_virt(&walk, req, true);			\
+									\
+	kernel_fpu_begin();						\
+	err = __##name(req, &walk, err);				\
+	kernel_fpu_end();						\
+									\
+	return err;							\
+}									\
+									\
+static int name##_batch(struct skcipher_request **reqs, int *errs,	\
+			unsigned int nr)				\
+{									\
+	return aesni_skcipher_batch(reqs, errs, nr, __##name);		\
+}
+
+static int __ecb_encrypt(struct skcipher_request *req,
+			 struct skcipher_walk *walk, int err)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct crypto_aes_ctx *ctx = aes_ctx(crypto_skcipher_ctx(tfm));
-	struct skcipher_walk walk;
 	unsigned int nbytes;
-	int err;
 
-	err = skcipher_walk_virt(&walk, req, true);
-
-	kernel_fpu_begin();
-	while ((nbytes = walk.nbytes)) {
-		aesni_ecb_enc(ctx, walk.dst.virt.addr, walk.src.virt.addr,
+	while ((nbytes = walk->nbytes)) {
+		aesni_ecb_enc(ctx, walk->dst.virt.addr, walk->src.virt.addr,
 			      nbytes & AES_BLOCK_MASK);
 		nbytes &= AES_BLOCK_SIZE - 1;
-		err = skcipher_walk_done(&walk, nbytes);
+		err = skcipher_walk_done(walk, nbytes);
 	}
-	kernel_fpu_end();
 
 	return err;
 }
 
-static int ecb_decrypt(struct skcipher_request *req)
+static int __ecb_decrypt(struct skcipher_request *req,
+			 struct skcipher_walk *walk, int err)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct crypto_aes_ctx *ctx = aes_ctx(crypto_skcipher_ctx(tfm));
-	struct skcipher_walk walk;
 	unsigned int nbytes;
-	int err;
 
-	err = skcipher_walk_virt(&walk, req, true);
-
-	kernel_fpu_begin();
-	while ((nbytes = walk.nbytes)) {
-		aesni_ecb_dec(ctx, walk.dst.virt.addr, walk.src.virt.addr,
+	while ((nbytes = walk->nbytes)) {
+		aesni_ecb_dec(ctx, walk->dst.virt.addr, walk->src.virt.addr,
 			      nbytes & AES_BLOCK_MASK);
 		nbytes &= AES_BLOCK_SIZE - 1;
-		err = skcipher_walk_done(&walk, nbytes);
+		err = skcipher_walk_done(walk, nbytes);
 	}
-	kernel_fpu_end();
 
 	return err;
 }
 
-static int cbc_encrypt(struct skcipher_request *req)
+static int __cbc_encrypt(struct skcipher_request *req,
+			 struct skcipher_walk *walk, int err)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct crypto_aes_ctx *ctx = aes_ctx(crypto_skcipher_ctx(tfm));
-	struct skcipher_walk walk;
 	unsigned int nbytes;
-	int err;
 
-	err = skcipher_walk_virt(&walk, req, true);
-
-	kernel_fpu_begin();
-	while ((nbytes = walk.nbytes)) {
-		aesni_cbc_enc(ctx, walk.dst.virt.addr, walk.src.virt.addr,
-			      nbytes & AES_BLOCK_MASK, walk.iv);
+	while ((nbytes = walk->nbytes)) {
+		aesni_cbc_enc(ctx, walk->dst.virt.addr, walk->src.virt.addr,
+			      nbytes & AES_BLOCK_MASK, walk->iv);
 		nbytes &= AES_BLOCK_SIZE - 1;
-		err = skcipher_walk_done(&walk, nbytes);
+		err = skcipher_walk_done(walk, nbytes);
 	}
-	kernel_fpu_end();
 
 	return err;
 }
 
-static int cbc_decrypt(struct skcipher_request *req)
+static int __cbc_decrypt(struct skcipher_request *req,
+			 struct skcipher_walk *walk, int err)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct crypto_aes_ctx *ctx = aes_ctx(crypto_skcipher_ctx(tfm));
-	struct skcipher_walk walk;
 	unsigned int nbytes;
-	int err;
-
-	err = skcipher_walk_virt(&walk, req, true);
 
-	kernel_fpu_begin();
-	while ((nbytes = walk.nbytes)) {
-		aesni_cbc_dec(ctx, walk.dst.virt.addr, walk.src.virt.addr,
-			      nbytes & AES_BLOCK_MASK, walk.iv);
+	while ((nbytes = walk->nbytes)) {
+		aesni_cbc_dec(ctx, walk->dst.virt.addr, walk->src.virt.addr,
+			      nbytes & AES_BLOCK_MASK, walk->iv);
 		nbytes &= AES_BLOCK_SIZE - 1;
-		err = skcipher_walk_done(&walk, nbytes);
+		err = skcipher_walk_done(walk, nbytes);
 	}
-	kernel_fpu_end();
 
 	return err;
 }
 
+AESNI_SKCIPHER_FPU_FUNCS(ecb_encrypt)
+AESNI_SKCIPHER_FPU_FUNCS(ecb_decrypt)
+AESNI_SKCIPHER_FPU_FUNCS(cbc_encrypt)
+AESNI_SKCIPHER_FPU_FUNCS(cbc_decrypt)
+
 #ifdef CONFIG_X86_64
 static void ctr_crypt_final(struct crypto_aes_ctx *ctx,
 			    struct skcipher_walk *walk)
@@ -500,32 +633,29 @@ static void aesni_ctr_enc_avx_tfm(struct crypto_aes_ctx *ctx, u8 *out,
 }
 #endif
 
-static int ctr_crypt(struct skcipher_request *req)
+static int __ctr_crypt(struct skcipher_request *req,
+		       struct skcipher_walk *walk, int err)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct crypto_aes_ctx *ctx = aes_ctx(crypto_skcipher_ctx(tfm));
-	struct skcipher_walk walk;
 	unsigned int nbytes;
-	int err;
 
-	err = skcipher_walk_virt(&walk, req, true);
-
-	kernel_fpu_begin();
-	while ((nbytes = walk.nbytes) >= AES_BLOCK_SIZE) {
-		aesni_ctr_enc_tfm(ctx, walk.dst.virt.addr, walk.src.virt.addr,
-			              nbytes & AES_BLOCK_MASK, walk.iv);
+	while ((nbytes = walk->nbytes) >= AES_BLOCK_SIZE) {
+		aesni_ctr_enc_tfm(ctx, walk->dst.virt.addr, walk->src.virt.addr,
+			              nbytes & AES_BLOCK_MASK, walk->iv);
 		nbytes &= AES_BLOCK_SIZE - 1;
-		err = skcipher_walk_done(&walk, nbytes);
+		err = skcipher_walk_done(walk, nbytes);
 	}
-	if (walk.nbytes) {
-		ctr_crypt_final(ctx, &walk);
-		err = skcipher_walk_done(&walk, 0);
+	if (walk->nbytes) {
+		ctr_crypt_final(ctx, walk);
+		err = skcipher_walk_done(walk, 0);
 	}
-	kernel_fpu_end();
 
 	return err;
 }
 
+AESNI_SKCIPHER_FPU_FUNCS(ctr_crypt)
+
 static int xts_aesni_setkey(struct crypto_skcipher *tfm, const u8 *key,
 			    unsigned int keylen)
 {
@@ -601,12 +731,61 @@ static const struct common_glue_ctx aesni_dec_xts = {
 	} }
 };
 
+#ifdef CONFIG_AS_VAES
+static void aesni_xts_enc16_vaes(void *ctx, u128 *dst, const u128 *src,
+				 le128 *iv)
+{
+	aesni_xts_crypt16_vaes(ctx, (u8 *)dst, (const u8 *)src, true, (u8 *)iv);
+}
+
+static void aesni_xts_dec16_vaes(void *ctx, u128 *dst, const u128 *src,
+				 le128 *iv)
+{
+	aesni_xts_crypt16_vaes(ctx, (u8 *)dst, (const u8 *)src, false, (u8 *)iv);
+}
+
+static const struct common_glue_ctx aesni_enc_xts_vaes = {
+	.num_funcs = 3,
+	.fpu_blocks_limit = 1,
+
+	.funcs = { {
+		.num_blocks = 16,
+		.fn_u = { .xts = GLUE_XTS_FUNC_CAST(aesni_xts_enc16_vaes) }
+	}, {
+		.num_blocks = 8,
+		.fn_u = { .xts = GLUE_XTS_FUNC_CAST(aesni_xts_enc8) }
+	}, {
+		.num_blocks = 1,
+		.fn_u = { .xts = GLUE_XTS_FUNC_CAST(aesni_xts_enc) }
+	} }
+};
+
+static const struct common_glue_ctx aesni_dec_xts_vaes = {
+	.num_funcs = 3,
+	.fpu_blocks_limit = 1,
+
+	.funcs = { {
+		.num_blocks = 16,
+		.fn_u = { .xts = GLUE_XTS_FUNC_CAST(aesni_xts_dec16_vaes) }
+	}, {
+		.num_blocks = 8,
+		.fn_u = { .xts = GLUE_XTS_FUNC_CAST(aesni_xts_dec8) }
+	}, {
+		.num_blocks = 1,
+		.fn_u = { .xts = GLUE_XTS_FUNC_CAST(aesni_xts_dec) }
+	} }
+};
+#endif
+
+static const struct common_glue_ctx *aesni_enc_xts_tfm = &aesni_enc_xts;
+static const struct common_glue_ctx *aesni_dec_xts_tfm = &aesni_dec_xts;
+
 static int xts_encrypt(struct skcipher_request *req)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct aesni_xts_ctx *ctx = crypto_skcipher_ctx(tfm);
 
-	return glue_xts_req_128bit(&aesni_enc_xts, req,
+	return glue_xts_req_128bit(aesni_enc_xts_tfm, req,
 				   XTS_TWEAK_CAST(aesni_xts_tweak),
 				   aes_ctx(ctx->raw_tweak_ctx),
 				   aes_ctx(ctx->raw_crypt_ctx),
@@ -618,7 +797,7 @@ static int xts_decrypt(struct skcipher_request *req)
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct aesni_xts_ctx *ctx = crypto_skcipher_ctx(tfm);
 
-	return glue_xts_req_128bit(&aesni_dec_xts, req,
+	return glue_xts_req_128bit(aesni_dec_xts_tfm, req,
 				   XTS_TWEAK_CAST(aesni_xts_tweak),
 				   aes_ctx(ctx->raw_tweak_ctx),
 				   aes_ctx(ctx->raw_crypt_ctx),
@@ -724,6 +903,10 @@ static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 	if (!enc)
 		left -= auth_tag_len;
 
+#ifdef CONFIG_AS_VAES
+	if (left < AVX_GEN4_OPTSIZE && gcm_tfm == &aesni_gcm_tfm_vaes)
+		gcm_tfm = &aesni_gcm_tfm_avx_gen2;
+#endif
 #ifdef CONFIG_AS_AVX2
 	if (left < AVX_GEN4_OPTSIZE && gcm_tfm == &aesni_gcm_tfm_avx_gen4)
 		gcm_tfm = &aesni_gcm_tfm_avx_gen2;
@@ -759,7 +942,6 @@ static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 		}
 	}
 
-	kernel_fpu_begin();
 	gcm_tfm->init(aes_ctx, &data, iv,
 		hash_subkey, assoc, assoclen);
 	if (req->src != req->dst) {
@@ -805,7 +987,6 @@ static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 		}
 	}
 	gcm_tfm->finalize(aes_ctx, &data, authTag, auth_tag_len);
-	kernel_fpu_end();
 
 	if (!assocmem)
 		scatterwalk_unmap(assoc);
@@ -834,6 +1015,48 @@ static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 	return 0;
 }
 
+/* Batched AEAD requests don't sleep and share the FPU like skcipher ones */
+static int aesni_aead_batch(struct aead_request **reqs, int *errs,
+			    unsigned int nr, int (*fn)(struct aead_request *req))
+{
+	unsigned int i, bytes = 0;
+	int ret = 0;
+
+	kernel_fpu_begin();
+	for (i = 0; i < nr; i++) {
+		if (bytes >= AESNI_BATCH_YIELD) {
+			kernel_fpu_end();
+			kernel_fpu_begin();
+			bytes = 0;
+		}
+		bytes += reqs[i]->assoclen + reqs[i]->cryptlen;
+		errs[i] = fn(reqs[i]);
+		if (!ret)
+			ret = errs[i];
+	}
+	kernel_fpu_end();
+
+	return ret;
+}
+
+#define AESNI_AEAD_FPU_FUNCS(name)					\
+static int name(struct aead_request *req)				\
+{									\
+	int err;							\
+									\
+	kernel_fpu_begin();						\
+	err = __##name(req);						\
+	kernel_fpu_end();						\
+									\
+	return err;							\
+}									\
+									\
+static int name##_batch(struct aead_request **reqs, int *errs,		\
+			unsigned int nr)				\
+{									\
+	return aesni_aead_batch(reqs, errs, nr, __##name);		\
+}
+
 static int gcmaes_encrypt(struct aead_request *req, unsigned int assoclen,
 			  u8 *hash_subkey, u8 *iv, void *aes_ctx)
 {
@@ -848,7 +1071,7 @@ static int gcmaes_decrypt(struct aead_request *req, unsigned int assoclen,
 				aes_ctx);
 }
 
-static int helper_rfc4106_encrypt(struct aead_request *req)
+static int __helper_rfc4106_encrypt(struct aead_request *req)
 {
 	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
 	struct aesni_rfc4106_gcm_ctx *ctx = aesni_rfc4106_gcm_ctx_get(tfm);
@@ -874,7 +1097,7 @@ static int helper_rfc4106_encrypt(struct aead_request *req)
 			      aes_ctx);
 }
 
-static int helper_rfc4106_decrypt(struct aead_request *req)
+static int __helper_rfc4106_decrypt(struct aead_request *req)
 {
 	__be32 counter = cpu_to_be32(1);
 	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
@@ -900,6 +1123,9 @@ static int helper_rfc4106_decrypt(struct aead_request *req)
 	return gcmaes_decrypt(req, req->assoclen - 8, ctx->hash_subkey, iv,
 			      aes_ctx);
 }
+
+AESNI_AEAD_FPU_FUNCS(helper_rfc4106_encrypt)
+AESNI_AEAD_FPU_FUNCS(helper_rfc4106_decrypt)
 #endif
 
 static struct crypto_alg aesni_cipher_alg = {
@@ -937,6 +1163,8 @@ static struct skcipher_alg aesni_skciphers[] = {
 		.setkey		= aesni_skcipher_setkey,
 		.encrypt	= ecb_encrypt,
 		.decrypt	= ecb_decrypt,
+		.encrypt_batch	= ecb_encrypt_batch,
+		.decrypt_batch	= ecb_decrypt_batch,
 	}, {
 		.base = {
 			.cra_name		= "__cbc(aes)",
@@ -953,6 +1181,8 @@ static struct skcipher_alg aesni_skciphers[] = {
 		.setkey		= aesni_skcipher_setkey,
 		.encrypt	= cbc_encrypt,
 		.decrypt	= cbc_decrypt,
+		.encrypt_batch	= cbc_encrypt_batch,
+		.decrypt_batch	= cbc_decrypt_batch,
 #ifdef CONFIG_X86_64
 	}, {
 		.base = {
@@ -971,6 +1201,8 @@ static struct skcipher_alg aesni_skciphers[] = {
 		.setkey		= aesni_skcipher_setkey,
 		.encrypt	= ctr_crypt,
 		.decrypt	= ctr_crypt,
+		.encrypt_batch	= ctr_crypt_batch,
+		.decrypt_batch	= ctr_crypt_batch,
 	}, {
 		.base = {
 			.cra_name		= "__xts(aes)",
@@ -1005,7 +1237,7 @@ static int generic_gcmaes_set_key(struct crypto_aead *aead, const u8 *key,
 	       rfc4106_set_hash_subkey(ctx->hash_subkey, key, key_len);
 }
 
-static int generic_gcmaes_encrypt(struct aead_request *req)
+static int __generic_gcmaes_encrypt(struct aead_request *req)
 {
 	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
 	struct generic_gcmaes_ctx *ctx = generic_gcmaes_ctx_get(tfm);
@@ -1020,7 +1252,7 @@ static int generic_gcmaes_encrypt(struct aead_request *req)
 			      aes_ctx);
 }
 
-static int generic_gcmaes_decrypt(struct aead_request *req)
+static int __generic_gcmaes_decrypt(struct aead_request *req)
 {
 	__be32 counter = cpu_to_be32(1);
 	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
@@ -1035,11 +1267,16 @@ static int generic_gcmaes_decrypt(struct aead_request *req)
 			      aes_ctx);
 }
 
+AESNI_AEAD_FPU_FUNCS(generic_gcmaes_encrypt)
+AESNI_AEAD_FPU_FUNCS(generic_gcmaes_decrypt)
+
 static struct aead_alg aesni_aeads[] = { {
 	.setkey			= common_rfc4106_set_key,
 	.setauthsize		= common_rfc4106_set_authsize,
 	.encrypt		= helper_rfc4106_encrypt,
 	.decrypt		= helper_rfc4106_decrypt,
+	.encrypt_batch		= helper_rfc4106_encrypt_batch,
+	.decrypt_batch		= helper_rfc4106_decrypt_batch,
 	.ivsize			= GCM_RFC4106_IV_SIZE,
 	.maxauthsize		= 16,
 	.base = {
@@ -1057,6 +1294,8 @@ static struct aead_alg aesni_aeads[] = { {
 	.setauthsize		= generic_gcmaes_set_authsize,
 	.encrypt		= generic_gcmaes_encrypt,
 	.decrypt		= generic_gcmaes_decrypt,
+	.encrypt_batch		= generic_gcmaes_encrypt_batch,
+	.decrypt_batch		= generic_gcmaes_decrypt_batch,
 	.ivsize			= GCM_AES_IV_SIZE,
 	.maxauthsize		= 16,
 	.base = {
@@ -1089,6 +1328,14 @@ static int __init aesni_init(void)
 	if (!x86_match_cpu(aesni_cpu_id))
 		return -ENODEV;
 #ifdef CONFIG_X86_64
+#ifdef CONFIG_AS_VAES
+	if (boot_cpu_has(X86_FEATURE_AVX2) &&
+	    boot_cpu_has(X86_FEATURE_VAES) &&
+	    boot_cpu_has(X86_FEATURE_VPCLMULQDQ)) {
+		pr_info("VAES version of gcm_enc/dec engaged.\n");
+		aesni_gcm_tfm = &aesni_gcm_tfm_vaes;
+	} else
+#endif
 #ifdef CONFIG_AS_AVX2
 	if (boot_cpu_has(X86_FEATURE_AVX2)) {
 		pr_info("AVX2 version of gcm_enc/dec engaged.\n");
@@ -1113,6 +1360,15 @@ static int __init aesni_init(void)
 		pr_info("AES CTR mode by8 optimization enabled\n");
 	}
 #endif
+#ifdef CONFIG_AS_VAES
+	if (boot_cpu_has(X86_FEATURE_AVX2) &&
+	    boot_cpu_has(X86_FEATURE_VAES) &&
+	    boot_cpu_has(X86_FEATURE_VPCLMULQDQ)) {
+		aesni_enc_xts_tfm = &aesni_enc_xts_vaes;
+		aesni_dec_xts_tfm = &aesni_dec_xts_vaes;
+		pr_info("AES XTS mode by16 VAES optimization enabled\n");
+	}
+#endif
 #endif
 
 	err = crypto_register_alg(&aesni_cipher_alg);
@@ -159,10 +159,39 @@ static int chacha_simd_stream_xor(struct skcipher_walk *walk,
 	return err;
 }
 
-static int chacha_simd(struct skcipher_request *req)
+/* Both of these run over a walk set up by the caller, with the FPU held */
+static int __chacha_simd(struct skcipher_request *req,
+			 struct skcipher_walk *walk)
+{
+	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
+	struct chacha_ctx *ctx = crypto_skcipher_ctx(tfm);
+
+	return chacha_simd_stream_xor(walk, ctx, req->iv);
+}
+
+static int __xchacha_simd(struct skcipher_request *req,
+			  struct skcipher_walk *walk)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
 	struct chacha_ctx *ctx = crypto_skcipher_ctx(tfm);
+	struct chacha_ctx subctx;
+	u32 *state, state_buf[16 + 2] __aligned(8);
+	u8 real_iv[16];
+
+	BUILD_BUG_ON(CHACHA_STATE_ALIGN != 16);
+	state = PTR_ALIGN(state_buf + 0, CHACHA_STATE_ALIGN);
+	crypto_chacha_init(state, ctx, req->iv);
+
+	hchacha_block_ssse3(state, subctx.key, ctx->nrounds);
+	subctx.nrounds = ctx->nrounds;
+
+	memcpy(&real_iv[0], req->iv + 24, 8);
+	memcpy(&real_iv[8], req->iv + 16, 8);
+	return chacha_simd_stream_xor(walk, &subctx, real_iv);
+}
+
+static int chacha_simd(struct skcipher_request *req)
+{
 	struct skcipher_walk walk;
 	int err;
 
@@ -174,19 +203,14 @@ static int chacha_simd(struct skcipher_request *req)
 		return err;
 
 	kernel_fpu_begin();
-	err = chacha_simd_stream_xor(&walk, ctx, req->iv);
+	err = __chacha_simd(req, &walk);
 	kernel_fpu_end();
 	return err;
 }
 
 static int xchacha_simd(struct skcipher_request *req)
 {
-	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
-	struct chacha_ctx *ctx = crypto_skcipher_ctx(tfm);
 	struct skcipher_walk walk;
-	struct chacha_ctx subctx;
-	u32 *state, state_buf[16 + 2] __aligned(8);
-	u8 real_iv[16];
 	int err;
 
 	if (req->cryptlen <= CHACHA_BLOCK_SIZE || !crypto_simd_usable())
@@ -196,22 +220,81 @@ static int xchacha_simd(struct skcipher_request *req)
 	if (err)
 		return err;
 
-	BUILD_BUG_ON(CHACHA_STATE_ALIGN != 16);
-	state = PTR_ALIGN(state_buf + 0, CHACHA_STATE_ALIGN);
-	crypto_chacha_init(state, ctx, req->iv);
-
 	kernel_fpu_begin();
+	err = __xchacha_simd(req, &walk);
+	kernel_fpu_end();
+	return err;
+}
 
-	hchacha_block_ssse3(state, subctx.key, ctx->nrounds);
-	subctx.nrounds = ctx->nrounds;
+/*
+ * Process a list of requests inside one FPU section, which is released every
+ * 4096 bytes between requests as well as within them.  Nothing may sleep
+ * while it is held, so each request is handled as if the caller had not
+ * passed CRYPTO_TFM_REQ_MAY_SLEEP, short ones by the generic code.
+ */
+static int chacha_simd_batch_common(struct skcipher_request **reqs, int *errs,
+				    unsigned int nr,
+				    int (*generic)(struct skcipher_request *req),
+				    int (*fn)(struct skcipher_request *req,
+					      struct skcipher_walk *walk))
+{
+	int next_yield = 4096; /* bytes until next FPU yield */
+	unsigned int i;
+	int ret = 0;
+
+	if (!crypto_simd_usable()) {
+		for (i = 0; i < nr; i++) {
+			errs[i] = generic(reqs[i]);
+			if (!ret)
+				ret = errs[i];
+		}
+		return ret;
+	}
 
-	memcpy(&real_iv[0], req->iv + 24, 8);
-	memcpy(&real_iv[8], req->iv + 16, 8);
-	err = chacha_simd_stream_xor(&walk, &subctx, real_iv);
+	kernel_fpu_begin();
+	for (i = 0; i < nr; i++) {
+		struct skcipher_request *req = reqs[i];
+		u32 flags = req->base.flags;
+		struct skcipher_walk walk;
 
+		if (next_yield <= 0) {
+			/* temporarily allow preemption */
+			kernel_fpu_end();
+			kernel_fpu_begin();
+			next_yield = 4096;
+		}
+		next_yield -= req->cryptlen;
+
+		req->base.flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+		if (req->cryptlen <= CHACHA_BLOCK_SIZE) {
+			errs[i] = generic(req);
+		} else {
+			errs[i] = skcipher_walk_virt(&walk, req, true);
+			if (!errs[i])
+				errs[i] = fn(req, &walk);
+		}
+		req->base.flags = flags;
+
+		if (!ret)
+			ret = errs[i];
+	}
 	kernel_fpu_end();
 
-	return err;
+	return ret;
+}
+
+static int chacha_simd_batch(struct skcipher_request **reqs, int *errs,
+			     unsigned int nr)
+{
+	return chacha_simd_batch_common(reqs, errs, nr, crypto_chacha_crypt,
+					__chacha_simd);
+}
+
+static int xchacha_simd_batch(struct skcipher_request **reqs, int *errs,
+			      unsigned int nr)
+{
+	return chacha_simd_batch_common(reqs, errs, nr, crypto_xchacha_crypt,
+					__xchacha_simd);
 }
 
 static struct skcipher_alg algs[] = {
@@ -230,6 +313,8 @@ static struct skcipher_alg algs[] = {
 		.setkey			= crypto_chacha20_setkey,
 		.encrypt		= chacha_simd,
 		.decrypt		= chacha_simd,
+		.encrypt_batch		= chacha_simd_batch,
+		.decrypt_batch		= chacha_simd_batch,
 	}, {
 		.base.cra_name		= "xchacha20",
 		.base.cra_driver_name	= "xchacha20-simd",
@@ -245,6 +330,8 @@ static struct skcipher_alg algs[] = {
 		.setkey			= crypto_chacha20_setkey,
 		.encrypt		= xchacha_simd,
 		.decrypt		= xchacha_simd,
+		.encrypt_batch		= xchacha_simd_batch,
+		.decrypt_batch		= xchacha_simd_batch,
 	}, {
 		.base.cra_name		= "xchacha12",
 		.base.cra_driver_name	= "xchacha12-simd",
@@ -260,6 +347,8 @@ static struct skcipher_alg algs[] = {
 		.setkey			= crypto_chacha12_setkey,
 		.encrypt		= xchacha_simd,
 		.decrypt		= xchacha_simd,
+		.encrypt_batch		= xchacha_simd_batch,
+		.decrypt_batch		= xchacha_simd_batch,
 	},
 };
 
@@ -40,6 +40,7 @@
 #include <crypto/sha256_base.h>
 #include <linux/string.h>
 #include <asm/simd.h>
+#include <asm/unaligned.h>
 
 asmlinkage void sha256_transform_ssse3(u32 *digest, const char *data,
 				       u64 rounds);
@@ -247,12 +248,112 @@ static int sha256_avx2_final(struct shash_desc *desc, u8 *out)
 	return sha256_avx2_finup(desc, NULL, 0, out);
 }
 
+#define SHA256_MB_LANES		8
+/* Below this many messages the single-buffer code is faster. */
+#define SHA256_MB_MIN_LANES	4
+
+struct sha256_x8_args {
+	u32 digest[SHA256_DIGEST_SIZE / sizeof(u32)][SHA256_MB_LANES];
+	const u8 *data_ptr[SHA256_MB_LANES];
+};
+
+asmlinkage void sha256_x8_avx2(struct sha256_x8_args *args, u64 num_blks);
+
+static int sha256_avx2_digest(struct shash_desc *desc, const u8 *data,
+			      unsigned int len, u8 *out)
+{
+	return crypto_shash_alg(desc->tfm)->init(desc) ?:
+	       sha256_avx2_finup(desc, data, len, out);
+}
+
+/*
+ * Hash up to eight messages in parallel, one per 32-bit lane. Lanes beyond
+ * @lanes rehash the first message and their digests are discarded.
+ */
+static void sha256_x8_digest(struct shash_desc *desc, const u8 * const *data,
+			     unsigned int len, u8 * const *out,
+			     unsigned int lanes)
+{
+	struct sha256_state *sctx = shash_desc_ctx(desc);
+	unsigned int digest_words = crypto_shash_digestsize(desc->tfm) /
+				    sizeof(u32);
+	unsigned int blocks = len / SHA256_BLOCK_SIZE;
+	unsigned int partial = len % SHA256_BLOCK_SIZE;
+	struct sha256_x8_args args;
+	u8 pad[SHA256_BLOCK_SIZE] = { 0x80, };
+	unsigned int i, w;
+
+	/* the IV differs between sha224 and sha256 */
+	crypto_shash_alg(desc->tfm)->init(desc);
+	for (w = 0; w < ARRAY_SIZE(args.digest); w++)
+		for (i = 0; i < SHA256_MB_LANES; i++)
+			args.digest[w][i] = sctx->state[w];
+	for (i = 0; i < SHA256_MB_LANES; i++)
+		args.data_ptr[i] = data[i < lanes ? i : 0];
+
+	kernel_fpu_begin();
+	sha256_x8_avx2(&args, blocks);
+
+	if (!partial) {
+		/* all lanes share the same padding block */
+		*(__be64 *)&pad[SHA256_BLOCK_SIZE - sizeof(__be64)] =
+			cpu_to_be64((u64)len << 3);
+		for (i = 0; i < SHA256_MB_LANES; i++)
+			args.data_ptr[i] = pad;
+		sha256_x8_avx2(&args, 1);
+
+		for (i = 0; i < lanes; i++)
+			for (w = 0; w < digest_words; w++)
+				put_unaligned_be32(args.digest[w][i],
+						   out[i] + w * sizeof(u32));
+	} else {
+		/* finish each lane's tail with the single-buffer code */
+		for (i = 0; i < lanes; i++) {
+			for (w = 0; w < ARRAY_SIZE(args.digest); w++)
+				sctx->state[w] = args.digest[w][i];
+			sctx->count = len - partial;
+			sha256_base_do_update(desc, args.data_ptr[i], partial,
+				(sha256_block_fn *)sha256_transform_rorx);
+			sha256_base_do_finalize(desc,
+				(sha256_block_fn *)sha256_transform_rorx);
+			sha256_base_finish(desc, out[i]);
+		}
+	}
+	kernel_fpu_end();
+
+	memzero_explicit(&args, sizeof(args));
+}
+
+static int sha256_avx2_digest_batch(struct shash_desc *desc,
+				    const u8 * const *data, unsigned int len,
+				    u8 * const *out, unsigned int nr)
+{
+	unsigned int lanes;
+	int err = 0;
+
+	if (crypto_simd_usable()) {
+		while (nr >= SHA256_MB_MIN_LANES) {
+			lanes = min_t(unsigned int, nr, SHA256_MB_LANES);
+			sha256_x8_digest(desc, data, len, out, lanes);
+			data += lanes;
+			out += lanes;
+			nr -= lanes;
+		}
+	}
+
+	for (; nr && !err; nr--)
+		err = sha256_avx2_digest(desc, *data++, len, *out++);
+
+	return err;
+}
+
 static struct shash_alg sha256_avx2_algs[] = { {
 	.digestsize	=	SHA256_DIGEST_SIZE,
 	.init		=	sha256_base_init,
 	.update		=	sha256_avx2_update,
 	.final		=	sha256_avx2_final,
 	.finup		=	sha256_avx2_finup,
+	.digest_batch	=	sha256_avx2_digest_batch,
 	.descsize	=	sizeof(struct sha256_state),
 	.base		=	{
 		.cra_name	=	"sha256",
@@ -267,6 +368,7 @@ static struct shash_alg sha256_avx2_algs[] = { {
 	.update		=	sha256_avx2_update,
 	.final		=	sha256_avx2_final,
 	.finup		=	sha256_avx2_finup,
+	.digest_batch	=	sha256_avx2_digest_batch,
 	.descsize	=	sizeof(struct sha256_state),
 	.base		=	{
 		.cra_name	=	"sha224",
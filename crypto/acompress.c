@@ -68,6 +68,8 @@ static int crypto_acomp_init_tfm(struct crypto_tfm *tfm)
 	acomp->compress = alg->compress;
 	acomp->decompress = alg->decompress;
 	acomp->dst_free = alg->dst_free;
+	acomp->setlevel = alg->setlevel;
+	acomp->setdict = alg->setdict;
 	acomp->reqsize = alg->reqsize;
 
 	if (alg->exit)
@@ -121,6 +121,99 @@ int crypto_aead_decrypt(struct aead_request *req)
 }
 EXPORT_SYMBOL_GPL(crypto_aead_decrypt);
 
+static int crypto_aead_crypt_batch(struct aead_request **reqs, int *errs,
+				   unsigned int nr, bool enc)
+{
+	struct crypto_aead *aead;
+	struct aead_alg *aalg;
+	struct crypto_alg *alg;
+	unsigned int cryptlen[MAX_CRYPTO_BATCH];
+	int (*batch)(struct aead_request **, int *, unsigned int);
+	unsigned int i, n;
+	int ret = 0;
+
+	if (!nr)
+		return 0;
+
+	aead = crypto_aead_reqtfm(reqs[0]);
+	aalg = crypto_aead_alg(aead);
+	alg = aead->base.__crt_alg;
+	batch = enc ? aalg->encrypt_batch : aalg->decrypt_batch;
+
+	for (; nr; reqs += n, errs += n, nr -= n) {
+		n = min_t(unsigned int, nr, MAX_CRYPTO_BATCH);
+
+		for (i = 0; i < n; i++) {
+			cryptlen[i] = reqs[i]->cryptlen;
+			crypto_stats_get(alg);
+		}
+
+		if (crypto_aead_get_flags(aead) & CRYPTO_TFM_NEED_KEY) {
+			for (i = 0; i < n; i++)
+				errs[i] = -ENOKEY;
+		} else if (!enc) {
+			/*
+			 * Reject short requests up front so that batch
+			 * implementations only ever see well-formed ones.
+			 */
+			struct aead_request *good[MAX_CRYPTO_BATCH];
+			int goodidx[MAX_CRYPTO_BATCH];
+			int gooderr[MAX_CRYPTO_BATCH];
+			unsigned int ngood = 0;
+
+			for (i = 0; i < n; i++) {
+				if (reqs[i]->cryptlen < crypto_aead_authsize(aead)) {
+					errs[i] = -EINVAL;
+					continue;
+				}
+				goodidx[ngood] = i;
+				good[ngood++] = reqs[i];
+			}
+
+			if (batch && ngood) {
+				batch(good, gooderr, ngood);
+				for (i = 0; i < ngood; i++)
+					errs[goodidx[i]] = gooderr[i];
+			} else {
+				for (i = 0; i < ngood; i++)
+					errs[goodidx[i]] = aalg->decrypt(good[i]);
+			}
+		} else if (batch) {
+			batch(reqs, errs, n);
+		} else {
+			for (i = 0; i < n; i++)
+				errs[i] = aalg->encrypt(reqs[i]);
+		}
+
+		for (i = 0; i < n; i++) {
+			if (enc)
+				crypto_stats_aead_encrypt(cryptlen[i], alg,
+							  errs[i]);
+			else
+				crypto_stats_aead_decrypt(cryptlen[i], alg,
+							  errs[i]);
+			if (!ret)
+				ret = errs[i];
+		}
+	}
+
+	return ret;
+}
+
+int crypto_aead_encrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr)
+{
+	return crypto_aead_crypt_batch(reqs, errs, nr, true);
+}
+EXPORT_SYMBOL_GPL(crypto_aead_encrypt_batch);
+
+int crypto_aead_decrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr)
+{
+	return crypto_aead_crypt_batch(reqs, errs, nr, false);
+}
+EXPORT_SYMBOL_GPL(crypto_aead_decrypt_batch);
+
 static void crypto_aead_exit_tfm(struct crypto_tfm *tfm)
 {
 	struct crypto_aead *aead = __crypto_aead_cast(tfm);
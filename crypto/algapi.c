@@ -11,6 +11,7 @@
 #include <linux/fips.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/module.h>
 #include <linux/rtnetlink.h>
@@ -1053,6 +1054,7 @@ EXPORT_SYMBOL_GPL(crypto_type_has_alg);
 void crypto_stats_init(struct crypto_alg *alg)
 {
 	memset(&alg->stats, 0, sizeof(alg->stats));
+	memset(&alg->qstats, 0, sizeof(alg->qstats));
 }
 EXPORT_SYMBOL_GPL(crypto_stats_init);
 
@@ -1286,6 +1288,64 @@ void crypto_stats_skcipher_decrypt(unsigned int cryptlen, int ret,
 	crypto_alg_put(alg);
 }
 EXPORT_SYMBOL_GPL(crypto_stats_skcipher_decrypt);
+
+/*
+ * Account the result of crypto_enqueue_request() against @alg.  Unlike the
+ * other helpers this one does not pair with crypto_stats_get(), the caller
+ * already holds a reference through its tfm.
+ */
+void crypto_stats_queue(struct crypto_alg *alg, int ret)
+{
+	if (ret == -ENOSPC) {
+		atomic64_inc(&alg->qstats.drop_cnt);
+	} else {
+		atomic64_inc(&alg->qstats.enqueue_cnt);
+		if (ret == -EBUSY)
+			atomic64_inc(&alg->qstats.backlog_cnt);
+	}
+}
+EXPORT_SYMBOL_GPL(crypto_stats_queue);
+
+static void crypto_stats_max(atomic64_t *v, u64 val)
+{
+	s64 old = atomic64_read(v);
+
+	while ((u64)old < val) {
+		s64 cur = atomic64_cmpxchg(v, old, val);
+
+		if (cur == old)
+			break;
+		old = cur;
+	}
+}
+
+/* Account the queue depth a newly queued request found */
+void crypto_stats_queue_depth(struct crypto_alg *alg, unsigned int depth)
+{
+	crypto_stats_max(&alg->qstats.depth_max, depth);
+}
+EXPORT_SYMBOL_GPL(crypto_stats_queue_depth);
+
+void crypto_stats_queue_start(struct crypto_async_request *req)
+{
+	req->queue_ns = ktime_get_ns();
+}
+EXPORT_SYMBOL_GPL(crypto_stats_queue_start);
+
+/*
+ * Account the completion of a request stamped by crypto_stats_queue_start().
+ * Must be called before the request's completion callback, which may free it.
+ */
+void crypto_stats_queue_complete(struct crypto_async_request *req)
+{
+	struct crypto_alg *alg = req->tfm->__crt_alg;
+	u64 ns = ktime_get_ns() - req->queue_ns;
+
+	atomic64_inc(&alg->qstats.complete_cnt);
+	atomic64_add(ns, &alg->qstats.latency_ns);
+	crypto_stats_max(&alg->qstats.latency_max_ns, ns);
+}
+EXPORT_SYMBOL_GPL(crypto_stats_queue_complete);
 #endif
 
 static int __init crypto_algapi_init(void)
@@ -28,12 +28,26 @@ static int crypto_decompress(struct crypto_tfm *tfm,
 	                                                   dlen);
 }
 
+static int crypto_comp_setlevel_unsupp(struct crypto_tfm *tfm, int level)
+{
+	return -EOPNOTSUPP;
+}
+
+static int crypto_comp_setdict_unsupp(struct crypto_tfm *tfm,
+				      const u8 *dict, unsigned int len)
+{
+	return -EOPNOTSUPP;
+}
+
 int crypto_init_compress_ops(struct crypto_tfm *tfm)
 {
 	struct compress_tfm *ops = &tfm->crt_compress;
+	struct compress_alg *alg = &tfm->__crt_alg->cra_compress;
 
 	ops->cot_compress = crypto_compress;
 	ops->cot_decompress = crypto_decompress;
+	ops->cot_setlevel = alg->coa_setlevel ?: crypto_comp_setlevel_unsupp;
+	ops->cot_setdict = alg->coa_setdict ?: crypto_comp_setdict_unsupp;
 
 	return 0;
 }
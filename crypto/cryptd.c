@@ -22,15 +22,32 @@
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/scatterlist.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/workqueue.h>
 
+#define CRYPTD_MAX_BATCH	32
+
+static int cryptd_set_max_cpu_qlen(const char *val,
+				   const struct kernel_param *kp);
+
+static const struct kernel_param_ops cryptd_max_cpu_qlen_ops = {
+	.set = cryptd_set_max_cpu_qlen,
+	.get = param_get_uint,
+};
+
 static unsigned int cryptd_max_cpu_qlen = 1000;
-module_param(cryptd_max_cpu_qlen, uint, 0);
+module_param_cb(cryptd_max_cpu_qlen, &cryptd_max_cpu_qlen_ops,
+		&cryptd_max_cpu_qlen, 0644);
 MODULE_PARM_DESC(cryptd_max_cpu_qlen, "Set cryptd Max queue depth");
 
+static unsigned int cryptd_batch = 8;
+module_param(cryptd_batch, uint, 0644);
+MODULE_PARM_DESC(cryptd_batch, "Max requests handled per cryptd worker run (1-"
+		 __stringify(CRYPTD_MAX_BATCH) ")");
+
 static struct workqueue_struct *cryptd_wq;
 
 struct cryptd_cpu_queue {
@@ -42,6 +59,10 @@ struct cryptd_queue {
 	struct cryptd_cpu_queue __percpu *cpu_queue;
 };
 
+static struct cryptd_queue queue;
+/* Serialises max_cpu_qlen updates against setting up and freeing queue */
+static DEFINE_MUTEX(cryptd_queue_lock);
+
 struct cryptd_instance_ctx {
 	struct crypto_spawn spawn;
 	struct cryptd_queue *queue;
@@ -110,6 +131,37 @@ static int cryptd_init_queue(struct cryptd_queue *queue,
 	return 0;
 }
 
+static int cryptd_set_max_cpu_qlen(const char *val,
+				   const struct kernel_param *kp)
+{
+	struct cryptd_cpu_queue *cpu_queue;
+	unsigned int qlen;
+	int cpu, err;
+
+	err = kstrtouint(val, 0, &qlen);
+	if (err)
+		return err;
+	if (!qlen)
+		return -EINVAL;
+
+	mutex_lock(&cryptd_queue_lock);
+	cryptd_max_cpu_qlen = qlen;
+
+	/*
+	 * Not set up yet or already torn down, cryptd_init_queue() will pick
+	 * the value up.  Requests already queued beyond a lowered limit are
+	 * still processed, only new ones are refused or put on the backlog.
+	 */
+	if (queue.cpu_queue) {
+		for_each_possible_cpu(cpu) {
+			cpu_queue = per_cpu_ptr(queue.cpu_queue, cpu);
+			WRITE_ONCE(cpu_queue->queue.max_qlen, qlen);
+		}
+	}
+	mutex_unlock(&cryptd_queue_lock);
+	return 0;
+}
+
 static void cryptd_fini_queue(struct cryptd_queue *queue)
 {
 	int cpu;
@@ -120,6 +172,7 @@ static void cryptd_fini_queue(struct cryptd_queue *queue)
 		BUG_ON(cpu_queue->queue.qlen);
 	}
 	free_percpu(queue->cpu_queue);
+	queue->cpu_queue = NULL;
 }
 
 static int cryptd_enqueue_request(struct cryptd_queue *queue,
@@ -132,6 +185,7 @@ static int cryptd_enqueue_request(struct cryptd_queue *queue,
 	cpu = get_cpu();
 	cpu_queue = this_cpu_ptr(queue->cpu_queue);
 	err = crypto_enqueue_request(&cpu_queue->queue, request);
+	crypto_stats_queue(request->tfm->__crt_alg, err);
 
 	refcnt = crypto_tfm_ctx(request->tfm);
 
@@ -151,34 +205,43 @@ static int cryptd_enqueue_request(struct cryptd_queue *queue,
 	return err;
 }
 
-/* Called in workqueue context, do one real cryption work (via
- * req->complete) and reschedule itself if there are more work to
- * do. */
+/* Called in workqueue context, do up to cryptd_batch real cryption
+ * works (via req->complete) and reschedule itself if there are more
+ * work to do. */
 static void cryptd_queue_worker(struct work_struct *work)
 {
+	struct crypto_async_request *backlog[CRYPTD_MAX_BATCH];
+	struct crypto_async_request *req[CRYPTD_MAX_BATCH];
 	struct cryptd_cpu_queue *cpu_queue;
-	struct crypto_async_request *req, *backlog;
+	unsigned int batch, i, n;
 
 	cpu_queue = container_of(work, struct cryptd_cpu_queue, work);
+	batch = clamp_val(READ_ONCE(cryptd_batch), 1, CRYPTD_MAX_BATCH);
 	/*
-	 * Only handle one request at a time to avoid hogging crypto workqueue.
+	 * Pull a bounded batch of requests off the queue in one go, so a
+	 * busy queue pays for the locking and the work rescheduling once
+	 * per batch rather than once per request without hogging the
+	 * crypto workqueue.
 	 * preempt_disable/enable is used to prevent being preempted by
 	 * cryptd_enqueue_request(). local_bh_disable/enable is used to prevent
 	 * cryptd_enqueue_request() being accessed from software interrupts.
 	 */
 	local_bh_disable();
 	preempt_disable();
-	backlog = crypto_get_backlog(&cpu_queue->queue);
-	req = crypto_dequeue_request(&cpu_queue->queue);
+	for (n = 0; n < batch; n++) {
+		backlog[n] = crypto_get_backlog(&cpu_queue->queue);
+		req[n] = crypto_dequeue_request(&cpu_queue->queue);
+		if (!req[n])
+			break;
+	}
 	preempt_enable();
 	local_bh_enable();
 
-	if (!req)
-		return;
-
-	if (backlog)
-		backlog->complete(backlog, -EINPROGRESS);
-	req->complete(req, 0);
+	for (i = 0; i < n; i++) {
+		if (backlog[i])
+			backlog[i]->complete(backlog[i], -EINPROGRESS);
+		req[i]->complete(req[i], 0);
+	}
 
 	if (cpu_queue->queue.qlen)
 		queue_work(cryptd_wq, &cpu_queue->work);
@@ -908,8 +971,6 @@ static int cryptd_create_aead(struct crypto_template *tmpl,
 	return err;
 }
 
-static struct cryptd_queue queue;
-
 static int cryptd_create(struct crypto_template *tmpl, struct rtattr **tb)
 {
 	struct crypto_attr_type *algt;
@@ -1126,7 +1187,9 @@ static int __init cryptd_init(void)
 	if (!cryptd_wq)
 		return -ENOMEM;
 
+	mutex_lock(&cryptd_queue_lock);
 	err = cryptd_init_queue(&queue, cryptd_max_cpu_qlen);
+	mutex_unlock(&cryptd_queue_lock);
 	if (err)
 		goto err_destroy_wq;
 
@@ -1137,7 +1200,9 @@ static int __init cryptd_init(void)
 	return 0;
 
 err_fini_queue:
+	mutex_lock(&cryptd_queue_lock);
 	cryptd_fini_queue(&queue);
+	mutex_unlock(&cryptd_queue_lock);
 err_destroy_wq:
 	destroy_workqueue(cryptd_wq);
 	return err;
@@ -1146,7 +1211,9 @@ static int __init cryptd_init(void)
 static void __exit cryptd_exit(void)
 {
 	destroy_workqueue(cryptd_wq);
+	mutex_lock(&cryptd_queue_lock);
 	cryptd_fini_queue(&queue);
+	mutex_unlock(&cryptd_queue_lock);
 	crypto_unregister_template(&cryptd_tmpl);
 }
 
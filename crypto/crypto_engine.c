@@ -9,12 +9,48 @@
 
 #include <linux/err.h>
 #include <linux/delay.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
 #include <crypto/engine.h>
 #include <uapi/linux/sched/types.h>
 #include "internal.h"
 
 #define CRYPTO_ENGINE_MAX_QLEN 10
 
+static struct crypto_engine_ctx *crypto_engine_ctx(struct crypto_async_request *req)
+{
+	return crypto_tfm_ctx(req->tfm);
+}
+
+/*
+ * Drop @req from the in-flight requests, undo prepare_request() if it was
+ * run and complete the request.
+ */
+static void __crypto_finalize_request(struct crypto_engine *engine,
+				      struct crypto_async_request *req,
+				      int err, bool prepared)
+{
+	struct crypto_engine_ctx *enginectx = crypto_engine_ctx(req);
+	unsigned long flags;
+	int ret;
+
+	if (prepared && enginectx->op.unprepare_request) {
+		ret = enginectx->op.unprepare_request(engine, req);
+		if (ret)
+			dev_err(engine->dev, "failed to unprepare request\n");
+	}
+
+	spin_lock_irqsave(&engine->queue_lock, flags);
+	if (!WARN_ON_ONCE(!engine->inflight))
+		engine->inflight--;
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
+
+	crypto_stats_queue_complete(req);
+	req->complete(req, err);
+
+	kthread_queue_work(engine->kworker, &engine->pump_requests);
+}
+
 /**
  * crypto_finalize_request - finalize one request if the request is done
  * @engine: the hardware engine
@@ -24,57 +60,104 @@
 static void crypto_finalize_request(struct crypto_engine *engine,
 			     struct crypto_async_request *req, int err)
 {
-	unsigned long flags;
-	bool finalize_cur_req = false;
-	int ret;
-	struct crypto_engine_ctx *enginectx;
+	/* Requests only reach the driver once prepare_request() succeeded */
+	__crypto_finalize_request(engine, req, err,
+				  !!crypto_engine_ctx(req)->op.prepare_request);
+}
 
-	spin_lock_irqsave(&engine->queue_lock, flags);
-	if (engine->cur_req == req)
-		finalize_cur_req = true;
-	spin_unlock_irqrestore(&engine->queue_lock, flags);
+/*
+ * Pick the next request round-robin over the non-empty flows.  The request
+ * counts as in flight until __crypto_finalize_request(), on success and
+ * error paths alike.  Called with queue_lock held.
+ */
+static struct crypto_async_request *
+crypto_engine_dequeue(struct crypto_engine *engine)
+{
+	struct crypto_async_request *req, *backlog;
+	unsigned int i;
+
+	for (i = 0; i < CRYPTO_ENGINE_NR_FLOWS; i++) {
+		struct crypto_queue *queue = &engine->flows[engine->cur_flow];
+
+		engine->cur_flow = (engine->cur_flow + 1) %
+				   CRYPTO_ENGINE_NR_FLOWS;
+		if (!crypto_queue_len(queue))
+			continue;
+
+		backlog = crypto_get_backlog(queue);
+		req = crypto_dequeue_request(queue);
+		engine->queue.qlen--;
+		engine->inflight++;
+		if (backlog)
+			backlog->complete(backlog, -EINPROGRESS);
+		return req;
+	}
+
+	return NULL;
+}
 
-	if (finalize_cur_req) {
-		enginectx = crypto_tfm_ctx(req->tfm);
-		if (engine->cur_req_prepared &&
-		    enginectx->op.unprepare_request) {
-			ret = enginectx->op.unprepare_request(engine, req);
-			if (ret)
-				dev_err(engine->dev, "failed to unprepare request\n");
+/*
+ * Prepare @req and hand it to the driver.  Returns 0 if the driver accepted
+ * it, otherwise the request has already been finalized with the error.  A
+ * driver failing do_one_request() must not finalize the request itself, so
+ * that it leaves the in-flight count exactly once.
+ */
+static int crypto_engine_run_request(struct crypto_engine *engine,
+				     struct crypto_async_request *req)
+{
+	struct crypto_engine_ctx *enginectx = crypto_engine_ctx(req);
+	bool prepared = false;
+	int ret;
+
+	if (enginectx->op.prepare_request) {
+		ret = enginectx->op.prepare_request(engine, req);
+		if (ret) {
+			dev_err(engine->dev, "failed to prepare request: %d\n",
+				ret);
+			goto req_err;
 		}
-		spin_lock_irqsave(&engine->queue_lock, flags);
-		engine->cur_req = NULL;
-		engine->cur_req_prepared = false;
-		spin_unlock_irqrestore(&engine->queue_lock, flags);
+		prepared = true;
 	}
+	if (!enginectx->op.do_one_request) {
+		dev_err(engine->dev, "failed to do request\n");
+		ret = -EINVAL;
+		goto req_err;
+	}
+	ret = enginectx->op.do_one_request(engine, req);
+	if (ret) {
+		dev_err(engine->dev, "Failed to do one request from queue: %d\n", ret);
+		goto req_err;
+	}
+	return 0;
 
-	req->complete(req, err);
-
-	kthread_queue_work(engine->kworker, &engine->pump_requests);
+req_err:
+	__crypto_finalize_request(engine, req, ret, prepared);
+	return ret;
 }
 
 /**
- * crypto_pump_requests - dequeue one request from engine queue to process
+ * crypto_pump_requests - dequeue requests from engine queue to process
  * @engine: the hardware engine
  * @in_kthread: true if we are in the context of the request pump thread
  *
  * This function checks if there is any request in the engine queue that
  * needs processing and if so call out to the driver to initialize hardware
- * and handle each request.
+ * and handle each request.  Up to max_inflight requests are handed to the
+ * driver before do_batch_requests() kicks them off together.
  */
 static void crypto_pump_requests(struct crypto_engine *engine,
 				 bool in_kthread)
 {
-	struct crypto_async_request *async_req, *backlog;
+	struct crypto_async_request *async_req;
+	unsigned int dispatched = 0;
 	unsigned long flags;
 	bool was_busy = false;
 	int ret;
-	struct crypto_engine_ctx *enginectx;
 
 	spin_lock_irqsave(&engine->queue_lock, flags);
 
-	/* Make sure we are not already running a request */
-	if (engine->cur_req)
+	/* Make sure the driver can take another request */
+	if (engine->inflight >= engine->max_inflight)
 		goto out;
 
 	/* If another context is idling then defer */
@@ -85,7 +168,7 @@ static void crypto_pump_requests(struct crypto_engine *engine,
 
 	/* Check if the engine queue is idle */
 	if (!crypto_queue_len(&engine->queue) || !engine->running) {
-		if (!engine->busy)
+		if (!engine->busy || engine->inflight)
 			goto out;
 
 		/* Only do teardown in the thread */
@@ -109,15 +192,10 @@ static void crypto_pump_requests(struct crypto_engine *engine,
 	}
 
 	/* Get the fist request from the engine queue to handle */
-	backlog = crypto_get_backlog(&engine->queue);
-	async_req = crypto_dequeue_request(&engine->queue);
+	async_req = crypto_engine_dequeue(engine);
 	if (!async_req)
 		goto out;
 
-	engine->cur_req = async_req;
-	if (backlog)
-		backlog->complete(backlog, -EINPROGRESS);
-
 	if (engine->busy)
 		was_busy = true;
 	else
@@ -130,35 +208,32 @@ static void crypto_pump_requests(struct crypto_engine *engine,
 		ret = engine->prepare_crypt_hardware(engine);
 		if (ret) {
 			dev_err(engine->dev, "failed to prepare crypt hardware\n");
-			goto req_err;
+			__crypto_finalize_request(engine, async_req, ret, false);
+			return;
 		}
 	}
 
-	enginectx = crypto_tfm_ctx(async_req->tfm);
+	for (;;) {
+		if (!crypto_engine_run_request(engine, async_req))
+			dispatched++;
 
-	if (enginectx->op.prepare_request) {
-		ret = enginectx->op.prepare_request(engine, async_req);
-		if (ret) {
-			dev_err(engine->dev, "failed to prepare request: %d\n",
-				ret);
-			goto req_err;
-		}
-		engine->cur_req_prepared = true;
-	}
-	if (!enginectx->op.do_one_request) {
-		dev_err(engine->dev, "failed to do request\n");
-		ret = -EINVAL;
-		goto req_err;
-	}
-	ret = enginectx->op.do_one_request(engine, async_req);
-	if (ret) {
-		dev_err(engine->dev, "Failed to do one request from queue: %d\n", ret);
-		goto req_err;
+		spin_lock_irqsave(&engine->queue_lock, flags);
+		if (engine->inflight >= engine->max_inflight ||
+		    !engine->running)
+			break;
+		async_req = crypto_engine_dequeue(engine);
+		if (!async_req)
+			break;
+		spin_unlock_irqrestore(&engine->queue_lock, flags);
 	}
-	return;
+	spin_unlock_irqrestore(&engine->queue_lock, flags);
 
-req_err:
-	crypto_finalize_request(engine, async_req, ret);
+	if (dispatched && engine->do_batch_requests) {
+		ret = engine->do_batch_requests(engine);
+		if (ret)
+			dev_err(engine->dev, "failed to do batch requests: %d\n",
+				ret);
+	}
 	return;
 
 out:
@@ -182,6 +257,8 @@ static int crypto_transfer_request(struct crypto_engine *engine,
 				   struct crypto_async_request *req,
 				   bool need_pump)
 {
+	struct crypto_queue *flow;
+	unsigned int room;
 	unsigned long flags;
 	int ret;
 
@@ -192,9 +269,30 @@ static int crypto_transfer_request(struct crypto_engine *engine,
 		return -ESHUTDOWN;
 	}
 
-	ret = crypto_enqueue_request(&engine->queue, req);
+	flow = &engine->flows[hash_ptr(req->tfm,
+				       ilog2(CRYPTO_ENGINE_NR_FLOWS))];
+	/*
+	 * engine->queue.max_qlen bounds the requests queued on all flows
+	 * together, and may be tuned at runtime, e.g. through omap-aes sysfs.
+	 * A flow may grow by whatever room is left.  Once it holds backlogged
+	 * requests it stays full, so that later requests queue behind them.
+	 */
+	room = 0;
+	if (engine->queue.qlen < engine->queue.max_qlen &&
+	    flow->backlog == &flow->list)
+		room = engine->queue.max_qlen - engine->queue.qlen;
+	flow->max_qlen = flow->qlen + room;
+
+	crypto_stats_queue_start(req);
+	ret = crypto_enqueue_request(flow, req);
+	crypto_stats_queue(req->tfm->__crt_alg, ret);
+	if (ret != -ENOSPC) {
+		engine->queue.qlen++;
+		crypto_stats_queue_depth(req->tfm->__crt_alg,
+					 engine->queue.qlen + engine->inflight);
+	}
 
-	if (!engine->busy && need_pump)
+	if (engine->inflight < engine->max_inflight && need_pump)
 		kthread_queue_work(engine->kworker, &engine->pump_requests);
 
 	spin_unlock_irqrestore(&engine->queue_lock, flags);
@@ -442,20 +540,32 @@ int crypto_engine_stop(struct crypto_engine *engine)
 EXPORT_SYMBOL_GPL(crypto_engine_stop);
 
 /**
- * crypto_engine_alloc_init - allocate crypto hardware engine structure and
- * initialize it.
+ * crypto_engine_alloc_init_and_set - allocate crypto hardware engine structure
+ * and initialize it by setting the maximum number of entries in the software
+ * crypto-engine queue.
  * @dev: the device attached with one hardware engine
+ * @max_inflight: number of requests the driver can process at the same time;
+ * the pump keeps handing requests to do_one_request() until this many are
+ * waiting to be finalized
+ * @cbk_do_batch: pointer to a callback function to be invoked after a burst
+ * of requests has been handed to do_one_request(), so the driver can submit
+ * them to the hardware together; may be NULL
  * @rt: whether this queue is set to run as a realtime task
+ * @qlen: maximum number of requests queued on the engine
  *
  * This must be called from context that can sleep.
  * Return: the crypto engine structure on success, else NULL.
  */
-struct crypto_engine *crypto_engine_alloc_init(struct device *dev, bool rt)
+struct crypto_engine *crypto_engine_alloc_init_and_set(struct device *dev,
+						       unsigned int max_inflight,
+						       int (*cbk_do_batch)(struct crypto_engine *engine),
+						       bool rt, int qlen)
 {
 	struct sched_param param = { .sched_priority = MAX_RT_PRIO / 2 };
 	struct crypto_engine *engine;
+	unsigned int i;
 
-	if (!dev)
+	if (!dev || !max_inflight)
 		return NULL;
 
 	engine = devm_kzalloc(dev, sizeof(*engine), GFP_KERNEL);
@@ -467,12 +577,15 @@ struct crypto_engine *crypto_engine_alloc_init(struct device *dev, bool rt)
 	engine->running = false;
 	engine->busy = false;
 	engine->idling = false;
-	engine->cur_req_prepared = false;
+	engine->max_inflight = max_inflight;
+	engine->do_batch_requests = cbk_do_batch;
 	engine->priv_data = dev;
 	snprintf(engine->name, sizeof(engine->name),
 		 "%s-engine", dev_name(dev));
 
-	crypto_init_queue(&engine->queue, CRYPTO_ENGINE_MAX_QLEN);
+	crypto_init_queue(&engine->queue, qlen);
+	for (i = 0; i < CRYPTO_ENGINE_NR_FLOWS; i++)
+		crypto_init_queue(&engine->flows[i], qlen);
 	spin_lock_init(&engine->queue_lock);
 
 	engine->kworker = kthread_create_worker(0, "%s", engine->name);
@@ -489,6 +602,24 @@ struct crypto_engine *crypto_engine_alloc_init(struct device *dev, bool rt)
 
 	return engine;
 }
+EXPORT_SYMBOL_GPL(crypto_engine_alloc_init_and_set);
+
+/**
+ * crypto_engine_alloc_init - allocate crypto hardware engine structure and
+ * initialize it.
+ * @dev: the device attached with one hardware engine
+ * @rt: whether this queue is set to run as a realtime task
+ *
+ * The engine hands one request at a time to the driver.
+ *
+ * This must be called from context that can sleep.
+ * Return: the crypto engine structure on success, else NULL.
+ */
+struct crypto_engine *crypto_engine_alloc_init(struct device *dev, bool rt)
+{
+	return crypto_engine_alloc_init_and_set(dev, 1, NULL, rt,
+						CRYPTO_ENGINE_MAX_QLEN);
+}
 EXPORT_SYMBOL_GPL(crypto_engine_alloc_init);
 
 /**
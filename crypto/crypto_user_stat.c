@@ -175,6 +175,26 @@ static int crypto_report_rng(struct sk_buff *skb, struct crypto_alg *alg)
 	return nla_put(skb, CRYPTOCFGA_STAT_RNG, sizeof(rrng), &rrng);
 }
 
+static int crypto_report_queue(struct sk_buff *skb, struct crypto_alg *alg)
+{
+	struct crypto_stat_queue rqueue;
+
+	memset(&rqueue, 0, sizeof(rqueue));
+
+	strscpy(rqueue.type, "queue", sizeof(rqueue.type));
+
+	rqueue.stat_enqueue_cnt = atomic64_read(&alg->qstats.enqueue_cnt);
+	rqueue.stat_backlog_cnt = atomic64_read(&alg->qstats.backlog_cnt);
+	rqueue.stat_drop_cnt = atomic64_read(&alg->qstats.drop_cnt);
+	rqueue.stat_depth_max = atomic64_read(&alg->qstats.depth_max);
+	rqueue.stat_complete_cnt = atomic64_read(&alg->qstats.complete_cnt);
+	rqueue.stat_latency_ns = atomic64_read(&alg->qstats.latency_ns);
+	rqueue.stat_latency_max_ns =
+		atomic64_read(&alg->qstats.latency_max_ns);
+
+	return nla_put(skb, CRYPTOCFGA_STAT_QUEUE, sizeof(rqueue), &rqueue);
+}
+
 static int crypto_reportstat_one(struct crypto_alg *alg,
 				 struct crypto_user_alg *ualg,
 				 struct sk_buff *skb)
@@ -259,6 +279,9 @@ static int crypto_reportstat_one(struct crypto_alg *alg,
 		       __func__);
 	}
 
+	if ((alg->cra_flags & CRYPTO_ALG_ASYNC) && crypto_report_queue(skb, alg))
+		goto nla_put_failure;
+
 out:
 	return 0;
 
@@ -0,0 +1,557 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Batched hashing of independent blocks
+ *
+ * See include/crypto/hash_batch.h for an overview.
+ */
+
+#include <crypto/hash.h>
+#include <crypto/hash_batch.h>
+#include <linux/debugfs.h>
+#include <linux/err.h>
+#include <linux/highmem.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/scatterlist.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
+/* blocks handed to ->digest_batch() per call, one per SIMD lane */
+#define HASH_BATCH_MB_LANES	8
+
+static LIST_HEAD(hash_batch_stats_list);
+static DEFINE_MUTEX(hash_batch_stats_lock);
+static struct dentry *hash_batch_debugfs;
+
+static const char * const hash_batch_impl_names[CRYPTO_HASH_BATCH_NR_IMPLS] = {
+	[CRYPTO_HASH_BATCH_SYNC]	= "sync",
+	[CRYPTO_HASH_BATCH_MB]		= "multi-buffer",
+	[CRYPTO_HASH_BATCH_ASYNC]	= "async",
+};
+
+const char *crypto_hash_batch_impl_name(enum crypto_hash_batch_impl impl)
+{
+	if (impl >= CRYPTO_HASH_BATCH_NR_IMPLS)
+		return "unknown";
+	return hash_batch_impl_names[impl];
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_impl_name);
+
+/**
+ * crypto_alloc_hash_batch_tfm() - allocate a transform for batched hashing
+ * @alg_name: algorithm or driver name, e.g. "sha256"
+ *
+ * The highest priority driver for @alg_name is used.  Asynchronous drivers
+ * are driven through ahash with all blocks of a batch in flight; synchronous
+ * ones through shash, with ->digest_batch() if the driver implements it.
+ *
+ * Callers that use crypto_hash_batch_set_hashstate() with a state exported
+ * from another transform should pass that transform's driver name, so that
+ * both agree on the state format.
+ *
+ * Return: the transform on success, else an ERR_PTR()
+ */
+struct crypto_hash_batch_tfm *crypto_alloc_hash_batch_tfm(const char *alg_name)
+{
+	struct crypto_hash_batch_tfm *tfm;
+	struct crypto_ahash *ahash;
+	struct crypto_shash *shash;
+	int err;
+
+	tfm = kzalloc(sizeof(*tfm), GFP_KERNEL);
+	if (!tfm)
+		return ERR_PTR(-ENOMEM);
+
+	ahash = crypto_alloc_ahash(alg_name, 0, 0);
+	if (IS_ERR(ahash)) {
+		err = PTR_ERR(ahash);
+		goto err_free;
+	}
+
+	if (!(crypto_ahash_tfm(ahash)->__crt_alg->cra_flags &
+	      CRYPTO_ALG_ASYNC)) {
+		shash = crypto_alloc_shash(crypto_ahash_driver_name(ahash),
+					   0, 0);
+		if (!IS_ERR(shash)) {
+			crypto_free_ahash(ahash);
+			tfm->shash = shash;
+			tfm->impl = crypto_shash_has_digest_batch(shash) ?
+				    CRYPTO_HASH_BATCH_MB :
+				    CRYPTO_HASH_BATCH_SYNC;
+			tfm->digestsize = crypto_shash_digestsize(shash);
+			return tfm;
+		}
+		/* a synchronous ahash-only driver: fall through */
+	}
+
+	tfm->ahash = ahash;
+	tfm->impl = CRYPTO_HASH_BATCH_ASYNC;
+	tfm->digestsize = crypto_ahash_digestsize(ahash);
+	return tfm;
+
+err_free:
+	kfree(tfm);
+	return ERR_PTR(err);
+}
+EXPORT_SYMBOL_GPL(crypto_alloc_hash_batch_tfm);
+
+void crypto_free_hash_batch_tfm(struct crypto_hash_batch_tfm *tfm)
+{
+	if (!tfm)
+		return;
+	if (tfm->impl == CRYPTO_HASH_BATCH_ASYNC)
+		crypto_free_ahash(tfm->ahash);
+	else
+		crypto_free_shash(tfm->shash);
+	kfree(tfm);
+}
+EXPORT_SYMBOL_GPL(crypto_free_hash_batch_tfm);
+
+const char *crypto_hash_batch_driver_name(struct crypto_hash_batch_tfm *tfm)
+{
+	if (tfm->impl == CRYPTO_HASH_BATCH_ASYNC)
+		return crypto_ahash_driver_name(tfm->ahash);
+	return crypto_shash_driver_name(tfm->shash);
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_driver_name);
+
+/**
+ * crypto_hash_batch_alloc() - allocate a batch
+ * @tfm: the transform to hash with
+ * @max: maximum number of blocks queued before a flush
+ * @gfp: allocation flags
+ *
+ * Return: the batch, or NULL on allocation failure
+ */
+struct crypto_hash_batch *crypto_hash_batch_alloc(
+		struct crypto_hash_batch_tfm *tfm, unsigned int max, gfp_t gfp)
+{
+	struct crypto_hash_batch *batch;
+	unsigned int i;
+
+	if (WARN_ON(!max))
+		return NULL;
+
+	batch = kzalloc(sizeof(*batch), gfp);
+	if (!batch)
+		return NULL;
+
+	batch->tfm = tfm;
+	batch->max = max;
+	init_completion(&batch->completion);
+
+	batch->items = kcalloc(max, sizeof(*batch->items), gfp);
+	if (!batch->items)
+		goto err_free;
+
+	if (tfm->impl != CRYPTO_HASH_BATCH_ASYNC) {
+		batch->desc = kmalloc(sizeof(*batch->desc) +
+				      crypto_shash_descsize(tfm->shash), gfp);
+		if (!batch->desc)
+			goto err_free;
+		batch->desc->tfm = tfm->shash;
+		return batch;
+	}
+
+	batch->items[0].sg = kmalloc_array(max, sizeof(struct scatterlist),
+					   gfp);
+	if (!batch->items[0].sg)
+		goto err_free;
+
+	for (i = 0; i < max; i++) {
+		struct crypto_hash_batch_item *item = &batch->items[i];
+
+		item->batch = batch;
+		item->sg = &batch->items[0].sg[i];
+		item->req = ahash_request_alloc(tfm->ahash, gfp);
+		if (!item->req)
+			goto err_free;
+	}
+	return batch;
+
+err_free:
+	crypto_hash_batch_free(batch);
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_alloc);
+
+void crypto_hash_batch_free(struct crypto_hash_batch *batch)
+{
+	unsigned int i;
+
+	if (!batch)
+		return;
+
+	if (batch->items) {
+		for (i = 0; i < batch->max; i++)
+			ahash_request_free(batch->items[i].req);
+		kfree(batch->items[0].sg);
+	}
+	kzfree(batch->desc);
+	kfree(batch->items);
+	kfree(batch);
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_free);
+
+static struct crypto_hash_batch_item *
+hash_batch_next(struct crypto_hash_batch *batch, unsigned int len, u8 *out)
+{
+	struct crypto_hash_batch_item *item;
+
+	if (batch->nr == batch->max)
+		return NULL;
+
+	item = &batch->items[batch->nr];
+	item->len = len;
+	item->out = out;
+	return item;
+}
+
+/**
+ * crypto_hash_batch_add_page() - queue a block held in a page
+ * @batch: the batch
+ * @page: the page holding the block
+ * @offset: offset of the block in @page
+ * @len: length of the block, which must not cross the end of @page
+ * @out: where to store the digest
+ *
+ * The page must stay referenced until the batch has been flushed.
+ *
+ * Return: the block's index in the batch, or -ENOSPC if the batch is full
+ */
+int crypto_hash_batch_add_page(struct crypto_hash_batch *batch,
+			       struct page *page, unsigned int offset,
+			       unsigned int len, u8 *out)
+{
+	struct crypto_hash_batch_item *item;
+
+	if (WARN_ON_ONCE(offset + len > PAGE_SIZE))
+		return -EINVAL;
+
+	item = hash_batch_next(batch, len, out);
+	if (!item)
+		return -ENOSPC;
+
+	item->page = page;
+	item->offset = offset;
+	item->data = NULL;
+	return batch->nr++;
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_add_page);
+
+/**
+ * crypto_hash_batch_add() - queue a block held in linearly mapped memory
+ * @batch: the batch
+ * @data: the block, which must not be vmalloc()ed memory
+ * @len: length of the block
+ * @out: where to store the digest
+ *
+ * Return: the block's index in the batch, or -ENOSPC if the batch is full
+ */
+int crypto_hash_batch_add(struct crypto_hash_batch *batch, const void *data,
+			  unsigned int len, u8 *out)
+{
+	struct crypto_hash_batch_item *item;
+
+	item = hash_batch_next(batch, len, out);
+	if (!item)
+		return -ENOSPC;
+
+	item->page = NULL;
+	item->data = data;
+	return batch->nr++;
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_add);
+
+static void hash_batch_item_done(struct crypto_hash_batch *batch,
+				 struct crypto_hash_batch_item *item, int err)
+{
+	if (batch->done)
+		batch->done(batch->done_data, item - batch->items, err);
+}
+
+static const u8 *hash_batch_map(struct crypto_hash_batch_item *item)
+{
+	if (item->page)
+		return (u8 *)kmap_atomic(item->page) + item->offset;
+	return item->data;
+}
+
+static void hash_batch_unmap(struct crypto_hash_batch_item *item,
+			     const u8 *addr)
+{
+	if (item->page)
+		kunmap_atomic((void *)(addr - item->offset));
+}
+
+static int hash_batch_one(struct crypto_hash_batch *batch,
+			  struct crypto_hash_batch_item *item)
+{
+	struct shash_desc *desc = batch->desc;
+	const u8 *addr = hash_batch_map(item);
+	int err;
+
+	if (batch->hashstate) {
+		err = crypto_shash_import(desc, batch->hashstate);
+		if (!err)
+			err = crypto_shash_finup(desc, addr, item->len,
+						 item->out);
+	} else {
+		err = crypto_shash_digest(desc, addr, item->len, item->out);
+	}
+
+	hash_batch_unmap(item, addr);
+	hash_batch_item_done(batch, item, err);
+	return err;
+}
+
+/* Hash @nr blocks of the same length with one ->digest_batch() call */
+static int hash_batch_mb(struct crypto_hash_batch *batch,
+			 struct crypto_hash_batch_item *items, unsigned int nr)
+{
+	const u8 *data[HASH_BATCH_MB_LANES];
+	u8 *out[HASH_BATCH_MB_LANES];
+	unsigned int i;
+	int err;
+
+	for (i = 0; i < nr; i++) {
+		data[i] = hash_batch_map(&items[i]);
+		out[i] = items[i].out;
+	}
+
+	err = crypto_shash_digest_batch(batch->desc, data, items[0].len,
+					out, nr);
+
+	/* atomic kmaps nest, so drop them in reverse order */
+	for (i = nr; i-- > 0; )
+		hash_batch_unmap(&items[i], data[i]);
+	for (i = 0; i < nr; i++)
+		hash_batch_item_done(batch, &items[i], err);
+	return err;
+}
+
+static int hash_batch_flush_sync(struct crypto_hash_batch *batch,
+				 unsigned int *counts)
+{
+	struct crypto_hash_batch_item *items = batch->items;
+	bool mb = batch->tfm->impl == CRYPTO_HASH_BATCH_MB &&
+		  !batch->hashstate;
+	unsigned int i = 0;
+	int err = 0;
+
+	while (i < batch->nr) {
+		unsigned int n = 1;
+
+		if (mb)
+			while (i + n < batch->nr && n < HASH_BATCH_MB_LANES &&
+			       items[i + n].len == items[i].len)
+				n++;
+
+		if (n > 1) {
+			err = hash_batch_mb(batch, &items[i], n);
+			counts[CRYPTO_HASH_BATCH_MB] += n;
+		} else {
+			err = hash_batch_one(batch, &items[i]);
+			counts[CRYPTO_HASH_BATCH_SYNC]++;
+		}
+		if (err)
+			break;
+		i += n;
+	}
+	return err;
+}
+
+static void hash_batch_async_complete(struct crypto_hash_batch *batch,
+				      struct crypto_hash_batch_item *item,
+				      int err)
+{
+	if (err)
+		cmpxchg(&batch->err, 0, err);
+	hash_batch_item_done(batch, item, err);
+	if (atomic_dec_and_test(&batch->inflight))
+		complete(&batch->completion);
+}
+
+static void hash_batch_async_done(struct crypto_async_request *areq, int err)
+{
+	struct crypto_hash_batch_item *item = areq->data;
+
+	/* a backlogged request was moved to the queue */
+	if (err == -EINPROGRESS)
+		return;
+
+	hash_batch_async_complete(item->batch, item, err);
+}
+
+static int hash_batch_flush_async(struct crypto_hash_batch *batch,
+				  unsigned int *counts)
+{
+	unsigned int i;
+
+	batch->err = 0;
+	reinit_completion(&batch->completion);
+	/* held until every request is submitted */
+	atomic_set(&batch->inflight, 1);
+
+	for (i = 0; i < batch->nr; i++) {
+		struct crypto_hash_batch_item *item = &batch->items[i];
+		struct ahash_request *req = item->req;
+		int err;
+
+		if (item->page) {
+			sg_init_table(item->sg, 1);
+			sg_set_page(item->sg, item->page, item->len,
+				    item->offset);
+		} else {
+			sg_init_one(item->sg, item->data, item->len);
+		}
+		ahash_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP |
+						CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   hash_batch_async_done, item);
+		ahash_request_set_crypt(req, item->sg, item->out, item->len);
+
+		atomic_inc(&batch->inflight);
+		if (batch->hashstate) {
+			err = crypto_ahash_import(req, batch->hashstate);
+			if (!err)
+				err = crypto_ahash_finup(req);
+		} else {
+			err = crypto_ahash_digest(req);
+		}
+		if (err != -EINPROGRESS && err != -EBUSY)
+			hash_batch_async_complete(batch, item, err);
+	}
+	counts[CRYPTO_HASH_BATCH_ASYNC] = batch->nr;
+
+	if (!atomic_dec_and_test(&batch->inflight))
+		wait_for_completion(&batch->completion);
+	return batch->err;
+}
+
+/**
+ * crypto_hash_batch_flush() - hash all queued blocks
+ * @batch: the batch
+ *
+ * Hash the queued blocks, calling the completion callback for each of them,
+ * and empty the batch.  Returns once every digest has been written.  The
+ * synchronous implementations stop at the first error.
+ *
+ * Context: Process context; may sleep.
+ * Return: 0 on success, else the first error encountered
+ */
+int crypto_hash_batch_flush(struct crypto_hash_batch *batch)
+{
+	unsigned int counts[CRYPTO_HASH_BATCH_NR_IMPLS] = {};
+	u64 start, bytes = 0;
+	unsigned int i;
+	int err;
+
+	if (!batch->nr)
+		return 0;
+
+	start = ktime_get_ns();
+	if (batch->tfm->impl == CRYPTO_HASH_BATCH_ASYNC)
+		err = hash_batch_flush_async(batch, counts);
+	else
+		err = hash_batch_flush_sync(batch, counts);
+
+	if (batch->stats) {
+		struct crypto_hash_batch_stats *stats = batch->stats;
+		u64 ns = ktime_get_ns() - start;
+
+		for (i = 0; i < batch->nr; i++)
+			bytes += batch->items[i].len;
+
+		atomic64_add(batch->nr, &stats->hashes);
+		atomic64_add(bytes, &stats->bytes);
+		atomic64_add(ns, &stats->ns);
+		for (i = 0; i < CRYPTO_HASH_BATCH_NR_IMPLS; i++)
+			if (counts[i])
+				atomic64_add(counts[i], &stats->impl[i]);
+	}
+
+	batch->nr = 0;
+	return err;
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_flush);
+
+/**
+ * crypto_hash_batch_account() - account hashing done outside of a batch
+ * @stats: the statistics to update
+ * @impl: the implementation that did the hashing
+ * @hashes: number of digests computed
+ * @bytes: number of bytes hashed
+ * @ns: time taken, in nanoseconds
+ *
+ * For subsystems that hash single streams and only want the instrumentation.
+ */
+void crypto_hash_batch_account(struct crypto_hash_batch_stats *stats,
+			       enum crypto_hash_batch_impl impl,
+			       unsigned int hashes, u64 bytes, u64 ns)
+{
+	atomic64_add(hashes, &stats->hashes);
+	atomic64_add(bytes, &stats->bytes);
+	atomic64_add(ns, &stats->ns);
+	if (impl < CRYPTO_HASH_BATCH_NR_IMPLS)
+		atomic64_add(hashes, &stats->impl[impl]);
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_account);
+
+void crypto_hash_batch_stats_register(struct crypto_hash_batch_stats *stats)
+{
+	mutex_lock(&hash_batch_stats_lock);
+	list_add_tail(&stats->list, &hash_batch_stats_list);
+	mutex_unlock(&hash_batch_stats_lock);
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_stats_register);
+
+void crypto_hash_batch_stats_unregister(struct crypto_hash_batch_stats *stats)
+{
+	mutex_lock(&hash_batch_stats_lock);
+	list_del_init(&stats->list);
+	mutex_unlock(&hash_batch_stats_lock);
+}
+EXPORT_SYMBOL_GPL(crypto_hash_batch_stats_unregister);
+
+static int hash_batch_stats_show(struct seq_file *m, void *v)
+{
+	struct crypto_hash_batch_stats *stats;
+	unsigned int i;
+
+	mutex_lock(&hash_batch_stats_lock);
+	list_for_each_entry(stats, &hash_batch_stats_list, list) {
+		u64 bytes = atomic64_read(&stats->bytes);
+		u64 ns = atomic64_read(&stats->ns);
+
+		seq_printf(m, "%s: hashes %lld bytes %llu ns %llu MB/s %llu",
+			   stats->name, atomic64_read(&stats->hashes), bytes,
+			   ns, ns ? div64_u64(bytes * 1000, ns) : 0);
+		for (i = 0; i < CRYPTO_HASH_BATCH_NR_IMPLS; i++)
+			seq_printf(m, " %s %lld", hash_batch_impl_names[i],
+				   atomic64_read(&stats->impl[i]));
+		seq_putc(m, '\n');
+	}
+	mutex_unlock(&hash_batch_stats_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hash_batch_stats);
+
+static int __init hash_batch_init(void)
+{
+	hash_batch_debugfs = debugfs_create_dir("hash_batch", NULL);
+	debugfs_create_file("stats", 0444, hash_batch_debugfs, NULL,
+			    &hash_batch_stats_fops);
+	return 0;
+}
+
+static void __exit hash_batch_exit(void)
+{
+	debugfs_remove_recursive(hash_batch_debugfs);
+}
+
+subsys_initcall(hash_batch_init);
+module_exit(hash_batch_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Batched hashing of independent blocks");
@@ -117,6 +117,16 @@ static int crypto_scomp_init_tfm(struct crypto_tfm *tfm)
 	return ret;
 }
 
+/*
+ * Requests whose source and destination each sit in a single lowmem
+ * scatterlist entry are processed in place, which leaves the per-CPU scratch
+ * buffers and their lock to the requests that actually need linearising.
+ */
+static bool scomp_sg_linear(struct scatterlist *sg, unsigned int len)
+{
+	return sg->length >= len && !PageHighMem(sg_page(sg));
+}
+
 static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 {
 	struct crypto_acomp *tfm = crypto_acomp_reqtfm(req);
@@ -135,6 +145,18 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 	if (!req->dlen || req->dlen > SCOMP_SCRATCH_SIZE)
 		req->dlen = SCOMP_SCRATCH_SIZE;
 
+	if (req->dst && scomp_sg_linear(req->src, req->slen) &&
+	    scomp_sg_linear(req->dst, req->dlen)) {
+		if (dir)
+			return crypto_scomp_compress(scomp, sg_virt(req->src),
+						     req->slen,
+						     sg_virt(req->dst),
+						     &req->dlen, *ctx);
+		return crypto_scomp_decompress(scomp, sg_virt(req->src),
+					       req->slen, sg_virt(req->dst),
+					       &req->dlen, *ctx);
+	}
+
 	scratch = raw_cpu_ptr(&scomp_scratch);
 	spin_lock(&scratch->lock);
 
@@ -171,6 +193,23 @@ static int scomp_acomp_decompress(struct acomp_req *req)
 	return scomp_acomp_comp_decomp(req, 0);
 }
 
+static int scomp_acomp_setlevel(struct crypto_acomp *tfm, int level)
+{
+	struct crypto_scomp **tfm_ctx = acomp_tfm_ctx(tfm);
+	struct crypto_scomp *scomp = *tfm_ctx;
+
+	return crypto_scomp_alg(scomp)->setlevel(scomp, level);
+}
+
+static int scomp_acomp_setdict(struct crypto_acomp *tfm, const u8 *dict,
+			       unsigned int len)
+{
+	struct crypto_scomp **tfm_ctx = acomp_tfm_ctx(tfm);
+	struct crypto_scomp *scomp = *tfm_ctx;
+
+	return crypto_scomp_alg(scomp)->setdict(scomp, dict, len);
+}
+
 static void crypto_exit_scomp_ops_async(struct crypto_tfm *tfm)
 {
 	struct crypto_scomp **ctx = crypto_tfm_ctx(tfm);
@@ -188,6 +227,7 @@ int crypto_init_scomp_ops_async(struct crypto_tfm *tfm)
 	struct crypto_alg *calg = tfm->__crt_alg;
 	struct crypto_acomp *crt = __crypto_acomp_tfm(tfm);
 	struct crypto_scomp **ctx = crypto_tfm_ctx(tfm);
+	struct scomp_alg *salg = __crypto_scomp_alg(calg);
 	struct crypto_scomp *scomp;
 
 	if (!crypto_mod_get(calg))
@@ -205,6 +245,8 @@ int crypto_init_scomp_ops_async(struct crypto_tfm *tfm)
 	crt->compress = scomp_acomp_compress;
 	crt->decompress = scomp_acomp_decompress;
 	crt->dst_free = sgl_free;
+	crt->setlevel = salg->setlevel ? scomp_acomp_setlevel : NULL;
+	crt->setdict = salg->setdict ? scomp_acomp_setdict : NULL;
 	crt->reqsize = sizeof(void *);
 
 	return 0;
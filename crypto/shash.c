@@ -207,6 +207,47 @@ int crypto_shash_digest(struct shash_desc *desc, const u8 *data,
 }
 EXPORT_SYMBOL_GPL(crypto_shash_digest);
 
+static int shash_default_digest_batch(struct shash_desc *desc,
+				      const u8 * const *data, unsigned int len,
+				      u8 * const *out, unsigned int nr)
+{
+	unsigned int i;
+	int err = 0;
+
+	for (i = 0; i < nr && !err; i++)
+		err = crypto_shash_digest(desc, data[i], len, out[i]);
+
+	return err;
+}
+
+int crypto_shash_digest_batch(struct shash_desc *desc, const u8 * const *data,
+			      unsigned int len, u8 * const *out,
+			      unsigned int nr)
+{
+	struct crypto_shash *tfm = desc->tfm;
+	struct shash_alg *shash = crypto_shash_alg(tfm);
+	unsigned long alignmask = crypto_shash_alignmask(tfm);
+	unsigned int i;
+
+	if (crypto_shash_get_flags(tfm) & CRYPTO_TFM_NEED_KEY)
+		return -ENOKEY;
+
+	for (i = 0; i < nr; i++)
+		if (((unsigned long)data[i] | (unsigned long)out[i]) &
+		    alignmask)
+			return shash_default_digest_batch(desc, data, len,
+							  out, nr);
+
+	return shash->digest_batch(desc, data, len, out, nr);
+}
+EXPORT_SYMBOL_GPL(crypto_shash_digest_batch);
+
+bool crypto_shash_has_digest_batch(struct crypto_shash *tfm)
+{
+	return crypto_shash_alg(tfm)->digest_batch != shash_default_digest_batch;
+}
+EXPORT_SYMBOL_GPL(crypto_shash_has_digest_batch);
+
 static int shash_default_export(struct shash_desc *desc, void *out)
 {
 	memcpy(out, shash_desc_ctx(desc), crypto_shash_descsize(desc->tfm));
@@ -478,6 +519,8 @@ static int shash_prepare_alg(struct shash_alg *alg)
 	}
 	if (!alg->setkey)
 		alg->setkey = shash_no_setkey;
+	if (!alg->digest_batch)
+		alg->digest_batch = shash_default_digest_batch;
 
 	return 0;
 }
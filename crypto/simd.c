@@ -105,6 +105,44 @@ static int simd_skcipher_decrypt(struct skcipher_request *req)
 	return crypto_skcipher_decrypt(subreq);
 }
 
+static int simd_skcipher_crypt_batch(struct skcipher_request **reqs,
+				     int *errs, unsigned int nr, bool enc)
+{
+	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(reqs[0]);
+	struct simd_skcipher_ctx *ctx = crypto_skcipher_ctx(tfm);
+	struct skcipher_request *subreqs[MAX_CRYPTO_BATCH];
+	struct crypto_skcipher *child;
+	unsigned int i;
+
+	if (!crypto_simd_usable() ||
+	    (in_atomic() && cryptd_skcipher_queued(ctx->cryptd_tfm)))
+		child = &ctx->cryptd_tfm->base;
+	else
+		child = cryptd_skcipher_child(ctx->cryptd_tfm);
+
+	for (i = 0; i < nr; i++) {
+		subreqs[i] = skcipher_request_ctx(reqs[i]);
+		*subreqs[i] = *reqs[i];
+		skcipher_request_set_tfm(subreqs[i], child);
+	}
+
+	if (enc)
+		return crypto_skcipher_encrypt_batch(subreqs, errs, nr);
+	return crypto_skcipher_decrypt_batch(subreqs, errs, nr);
+}
+
+static int simd_skcipher_encrypt_batch(struct skcipher_request **reqs,
+				       int *errs, unsigned int nr)
+{
+	return simd_skcipher_crypt_batch(reqs, errs, nr, true);
+}
+
+static int simd_skcipher_decrypt_batch(struct skcipher_request **reqs,
+				       int *errs, unsigned int nr)
+{
+	return simd_skcipher_crypt_batch(reqs, errs, nr, false);
+}
+
 static void simd_skcipher_exit(struct crypto_skcipher *tfm)
 {
 	struct simd_skcipher_ctx *ctx = crypto_skcipher_ctx(tfm);
@@ -193,6 +231,10 @@ struct simd_skcipher_alg *simd_skcipher_create_compat(const char *algname,
 	alg->setkey = simd_skcipher_setkey;
 	alg->encrypt = simd_skcipher_encrypt;
 	alg->decrypt = simd_skcipher_decrypt;
+	if (ialg->encrypt_batch)
+		alg->encrypt_batch = simd_skcipher_encrypt_batch;
+	if (ialg->decrypt_batch)
+		alg->decrypt_batch = simd_skcipher_decrypt_batch;
 
 	err = crypto_register_skcipher(alg);
 	if (err)
@@ -356,6 +398,44 @@ static int simd_aead_decrypt(struct aead_request *req)
 	return crypto_aead_decrypt(subreq);
 }
 
+static int simd_aead_crypt_batch(struct aead_request **reqs, int *errs,
+				 unsigned int nr, bool enc)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(reqs[0]);
+	struct simd_aead_ctx *ctx = crypto_aead_ctx(tfm);
+	struct aead_request *subreqs[MAX_CRYPTO_BATCH];
+	struct crypto_aead *child;
+	unsigned int i;
+
+	if (!crypto_simd_usable() ||
+	    (in_atomic() && cryptd_aead_queued(ctx->cryptd_tfm)))
+		child = &ctx->cryptd_tfm->base;
+	else
+		child = cryptd_aead_child(ctx->cryptd_tfm);
+
+	for (i = 0; i < nr; i++) {
+		subreqs[i] = aead_request_ctx(reqs[i]);
+		*subreqs[i] = *reqs[i];
+		aead_request_set_tfm(subreqs[i], child);
+	}
+
+	if (enc)
+		return crypto_aead_encrypt_batch(subreqs, errs, nr);
+	return crypto_aead_decrypt_batch(subreqs, errs, nr);
+}
+
+static int simd_aead_encrypt_batch(struct aead_request **reqs, int *errs,
+				   unsigned int nr)
+{
+	return simd_aead_crypt_batch(reqs, errs, nr, true);
+}
+
+static int simd_aead_decrypt_batch(struct aead_request **reqs, int *errs,
+				   unsigned int nr)
+{
+	return simd_aead_crypt_batch(reqs, errs, nr, false);
+}
+
 static void simd_aead_exit(struct crypto_aead *tfm)
 {
 	struct simd_aead_ctx *ctx = crypto_aead_ctx(tfm);
@@ -443,6 +523,10 @@ struct simd_aead_alg *simd_aead_create_compat(const char *algname,
 	alg->setauthsize = simd_aead_setauthsize;
 	alg->encrypt = simd_aead_encrypt;
 	alg->decrypt = simd_aead_decrypt;
+	if (ialg->encrypt_batch)
+		alg->encrypt_batch = simd_aead_encrypt_batch;
+	if (ialg->decrypt_batch)
+		alg->decrypt_batch = simd_aead_decrypt_batch;
 
 	err = crypto_register_aead(alg);
 	if (err)
@@ -875,6 +875,71 @@ int crypto_skcipher_decrypt(struct skcipher_request *req)
 }
 EXPORT_SYMBOL_GPL(crypto_skcipher_decrypt);
 
+static int crypto_skcipher_crypt_batch(struct skcipher_request **reqs,
+				       int *errs, unsigned int nr, bool enc)
+{
+	struct crypto_skcipher *tfm;
+	struct crypto_alg *alg;
+	unsigned int cryptlen[MAX_CRYPTO_BATCH];
+	int (*batch)(struct skcipher_request **, int *, unsigned int);
+	unsigned int i, n;
+	int ret = 0;
+
+	if (!nr)
+		return 0;
+
+	tfm = crypto_skcipher_reqtfm(reqs[0]);
+	alg = tfm->base.__crt_alg;
+	batch = enc ? tfm->encrypt_batch : tfm->decrypt_batch;
+
+	for (; nr; reqs += n, errs += n, nr -= n) {
+		n = min_t(unsigned int, nr, MAX_CRYPTO_BATCH);
+
+		for (i = 0; i < n; i++) {
+			cryptlen[i] = reqs[i]->cryptlen;
+			crypto_stats_get(alg);
+		}
+
+		if (crypto_skcipher_get_flags(tfm) & CRYPTO_TFM_NEED_KEY) {
+			for (i = 0; i < n; i++)
+				errs[i] = -ENOKEY;
+		} else if (batch) {
+			batch(reqs, errs, n);
+		} else {
+			for (i = 0; i < n; i++)
+				errs[i] = enc ? tfm->encrypt(reqs[i]) :
+						tfm->decrypt(reqs[i]);
+		}
+
+		for (i = 0; i < n; i++) {
+			if (enc)
+				crypto_stats_skcipher_encrypt(cryptlen[i],
+							      errs[i], alg);
+			else
+				crypto_stats_skcipher_decrypt(cryptlen[i],
+							      errs[i], alg);
+			if (!ret)
+				ret = errs[i];
+		}
+	}
+
+	return ret;
+}
+
+int crypto_skcipher_encrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr)
+{
+	return crypto_skcipher_crypt_batch(reqs, errs, nr, true);
+}
+EXPORT_SYMBOL_GPL(crypto_skcipher_encrypt_batch);
+
+int crypto_skcipher_decrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr)
+{
+	return crypto_skcipher_crypt_batch(reqs, errs, nr, false);
+}
+EXPORT_SYMBOL_GPL(crypto_skcipher_decrypt_batch);
+
 static void crypto_skcipher_exit_tfm(struct crypto_tfm *tfm)
 {
 	struct crypto_skcipher *skcipher = __crypto_skcipher_cast(tfm);
@@ -897,6 +962,8 @@ static int crypto_skcipher_init_tfm(struct crypto_tfm *tfm)
 	skcipher->setkey = skcipher_setkey;
 	skcipher->encrypt = alg->encrypt;
 	skcipher->decrypt = alg->decrypt;
+	skcipher->encrypt_batch = alg->encrypt_batch;
+	skcipher->decrypt_batch = alg->decrypt_batch;
 	skcipher->ivsize = alg->ivsize;
 	skcipher->keysize = alg->max_keysize;
 
@@ -33,8 +33,16 @@
 #include <linux/jiffies.h>
 #include <linux/timex.h>
 #include <linux/interrupt.h>
+#include <linux/prandom.h>
+#include <linux/vmalloc.h>
 #include "tcrypt.h"
 
+/*
+ * Number of requests handed to the batch API at once by the mb speed tests
+ * when mb_batch is set.
+ */
+#define MB_BATCH_SIZE	16
+
 /*
  * Need slab memory for testing (size in number of pages).
  */
@@ -63,6 +71,7 @@ static u32 type;
 static u32 mask;
 static int mode;
 static u32 num_mb = 8;
+static bool mb_batch;
 static char *tvmem[TVMEMSIZE];
 
 static char *check[] = {
@@ -78,6 +87,8 @@ static char *check[] = {
 
 static u32 block_sizes[] = { 16, 64, 256, 1024, 1472, 8192, 0 };
 static u32 aead_sizes[] = { 16, 64, 256, 512, 1024, 2048, 4096, 8192, 0 };
+/* page and record sized buffers, where the wide AES-NI paths engage */
+static u32 bulk_sizes[] = { 4096, 8192, 12288, 0 };
 
 #define XBUFSIZE 8
 #define MAX_IVLEN 32
@@ -159,11 +170,26 @@ static int do_mult_aead_op(struct test_mb_aead_data *data, int enc,
 	int i, err = 0;
 
 	/* Fire up a bunch of concurrent requests */
-	for (i = 0; i < num_mb; i++) {
-		if (enc == ENCRYPT)
-			rc[i] = crypto_aead_encrypt(data[i].req);
-		else
-			rc[i] = crypto_aead_decrypt(data[i].req);
+	if (mb_batch) {
+		struct aead_request *reqs[MB_BATCH_SIZE];
+		int j, n;
+
+		for (i = 0; i < num_mb; i += n) {
+			n = min_t(int, num_mb - i, MB_BATCH_SIZE);
+			for (j = 0; j < n; j++)
+				reqs[j] = data[i + j].req;
+			if (enc == ENCRYPT)
+				crypto_aead_encrypt_batch(reqs, rc + i, n);
+			else
+				crypto_aead_decrypt_batch(reqs, rc + i, n);
+		}
+	} else {
+		for (i = 0; i < num_mb; i++) {
+			if (enc == ENCRYPT)
+				rc[i] = crypto_aead_encrypt(data[i].req);
+			else
+				rc[i] = crypto_aead_decrypt(data[i].req);
+		}
 	}
 
 	/* Wait for all requests to finish */
@@ -515,10 +541,10 @@ static int test_aead_cycles(struct aead_request *req, int enc, int blen)
 	return ret;
 }
 
-static void test_aead_speed(const char *algo, int enc, unsigned int secs,
-			    struct aead_speed_template *template,
-			    unsigned int tcount, u8 authsize,
-			    unsigned int aad_size, u8 *keysize)
+static void __test_aead_speed(const char *algo, int enc, unsigned int secs,
+			      struct aead_speed_template *template,
+			      unsigned int tcount, u8 authsize,
+			      unsigned int aad_size, u8 *keysize, u32 *sizes)
 {
 	unsigned int i, j;
 	struct crypto_aead *tfm;
@@ -587,7 +613,7 @@ static void test_aead_speed(const char *algo, int enc, unsigned int secs,
 
 	i = 0;
 	do {
-		b_size = aead_sizes;
+		b_size = sizes;
 		do {
 			assoc = axbuf[0];
 			memset(assoc, 0xff, aad_size);
@@ -692,6 +718,15 @@ static void test_aead_speed(const char *algo, int enc, unsigned int secs,
 	kfree(iv);
 }
 
+static void test_aead_speed(const char *algo, int enc, unsigned int secs,
+			    struct aead_speed_template *template,
+			    unsigned int tcount, u8 authsize,
+			    unsigned int aad_size, u8 *keysize)
+{
+	__test_aead_speed(algo, enc, secs, template, tcount, authsize,
+			  aad_size, keysize, aead_sizes);
+}
+
 static void test_hash_sg_init(struct scatterlist *sg)
 {
 	int i;
@@ -1144,6 +1179,170 @@ static void test_hash_speed(const char *algo, unsigned int secs,
 	return test_ahash_speed_common(algo, secs, speed, CRYPTO_ALG_ASYNC);
 }
 
+struct test_mb_shash_data {
+	struct shash_desc *desc;
+	const u8 **src;
+	u8 **result;
+	bool batch;
+};
+
+static int do_mult_shash_op(struct test_mb_shash_data *data, int blen,
+			    u32 num_mb)
+{
+	int i, err = 0;
+
+	if (data->batch)
+		return crypto_shash_digest_batch(data->desc, data->src, blen,
+						 data->result, num_mb);
+
+	for (i = 0; i < num_mb && !err; i++)
+		err = crypto_shash_digest(data->desc, data->src[i], blen,
+					  data->result[i]);
+
+	return err;
+}
+
+static int test_mb_shash_jiffies(struct test_mb_shash_data *data, int blen,
+				 int secs, u32 num_mb)
+{
+	unsigned long start, end;
+	int bcount;
+	int ret;
+
+	for (start = jiffies, end = start + secs * HZ, bcount = 0;
+	     time_before(jiffies, end); bcount++) {
+		ret = do_mult_shash_op(data, blen, num_mb);
+		if (ret)
+			return ret;
+	}
+
+	pr_cont("%d operations in %d seconds (%ld bytes)\n",
+		bcount * num_mb, secs, (long)bcount * blen * num_mb);
+
+	return 0;
+}
+
+static int test_mb_shash_cycles(struct test_mb_shash_data *data, int blen,
+				u32 num_mb)
+{
+	unsigned long cycles = 0;
+	int ret;
+	int i;
+
+	/* Warm-up run. */
+	for (i = 0; i < 4; i++) {
+		ret = do_mult_shash_op(data, blen, num_mb);
+		if (ret)
+			return ret;
+	}
+
+	/* The real thing. */
+	for (i = 0; i < 8; i++) {
+		cycles_t start, end;
+
+		start = get_cycles();
+		ret = do_mult_shash_op(data, blen, num_mb);
+		end = get_cycles();
+
+		if (ret)
+			return ret;
+
+		cycles += end - start;
+	}
+
+	pr_cont("1 operation in %lu cycles (%d bytes)\n",
+		(cycles + 4) / (8 * num_mb), blen);
+
+	return 0;
+}
+
+/*
+ * Compare hashing num_mb independent buffers one at a time against handing
+ * them to crypto_shash_digest_batch() in one call.
+ */
+static void test_mb_shash_speed(const char *algo, unsigned int secs,
+				struct hash_speed *speed, u32 num_mb)
+{
+	struct test_mb_shash_data data = {};
+	struct crypto_shash *tfm;
+	unsigned int i, k;
+	int ret;
+
+	tfm = crypto_alloc_shash(algo, 0, 0);
+	if (IS_ERR(tfm)) {
+		pr_err("failed to load transform for %s: %ld\n",
+		       algo, PTR_ERR(tfm));
+		return;
+	}
+
+	data.desc = kzalloc(sizeof(*data.desc) + crypto_shash_descsize(tfm),
+			    GFP_KERNEL);
+	data.src = kcalloc(num_mb, sizeof(*data.src), GFP_KERNEL);
+	data.result = kcalloc(num_mb, sizeof(*data.result), GFP_KERNEL);
+	if (!data.desc || !data.src || !data.result)
+		goto out;
+	data.desc->tfm = tfm;
+
+	for (k = 0; k < num_mb; k++) {
+		data.src[k] = kmalloc(TVMEMSIZE * PAGE_SIZE, GFP_KERNEL);
+		data.result[k] = kmalloc(MAX_DIGEST_SIZE, GFP_KERNEL);
+		if (!data.src[k] || !data.result[k])
+			goto out;
+		memset((u8 *)data.src[k], 0xff, TVMEMSIZE * PAGE_SIZE);
+	}
+
+	pr_info("\ntesting speed of batched %s (%s)\n", algo,
+		crypto_tfm_alg_driver_name(crypto_shash_tfm(tfm)));
+
+	for (i = 0; speed[i].blen != 0; i++) {
+		/* Batching only applies to whole digests. */
+		if (speed[i].blen != speed[i].plen)
+			continue;
+
+		if (speed[i].blen > TVMEMSIZE * PAGE_SIZE) {
+			pr_err("template (%u) too big for tvmem (%lu)\n",
+			       speed[i].blen, TVMEMSIZE * PAGE_SIZE);
+			break;
+		}
+
+		if (speed[i].klen)
+			crypto_shash_setkey(tfm, tvmem[0], speed[i].klen);
+
+		for (k = 0; k < 2; k++) {
+			data.batch = k;
+			pr_info("test%3u (%5u byte blocks, %4u buffers, %s): ",
+				i, speed[i].blen, num_mb,
+				data.batch ? "batched" : "one by one");
+
+			if (secs) {
+				ret = test_mb_shash_jiffies(&data,
+							    speed[i].blen,
+							    secs, num_mb);
+				cond_resched();
+			} else {
+				ret = test_mb_shash_cycles(&data,
+							   speed[i].blen,
+							   num_mb);
+			}
+
+			if (ret) {
+				pr_err("hashing failed ret=%d\n", ret);
+				goto out;
+			}
+		}
+	}
+
+out:
+	for (k = 0; data.src && k < num_mb; k++)
+		kfree(data.src[k]);
+	for (k = 0; data.result && k < num_mb; k++)
+		kfree(data.result[k]);
+	kfree(data.result);
+	kfree(data.src);
+	kfree(data.desc);
+	crypto_free_shash(tfm);
+}
+
 struct test_mb_skcipher_data {
 	struct scatterlist sg[XBUFSIZE];
 	struct skcipher_request *req;
@@ -1157,11 +1356,26 @@ static int do_mult_acipher_op(struct test_mb_skcipher_data *data, int enc,
 	int i, err = 0;
 
 	/* Fire up a bunch of concurrent requests */
-	for (i = 0; i < num_mb; i++) {
-		if (enc == ENCRYPT)
-			rc[i] = crypto_skcipher_encrypt(data[i].req);
-		else
-			rc[i] = crypto_skcipher_decrypt(data[i].req);
+	if (mb_batch) {
+		struct skcipher_request *reqs[MB_BATCH_SIZE];
+		int j, n;
+
+		for (i = 0; i < num_mb; i += n) {
+			n = min_t(int, num_mb - i, MB_BATCH_SIZE);
+			for (j = 0; j < n; j++)
+				reqs[j] = data[i + j].req;
+			if (enc == ENCRYPT)
+				crypto_skcipher_encrypt_batch(reqs, rc + i, n);
+			else
+				crypto_skcipher_decrypt_batch(reqs, rc + i, n);
+		}
+	} else {
+		for (i = 0; i < num_mb; i++) {
+			if (enc == ENCRYPT)
+				rc[i] = crypto_skcipher_encrypt(data[i].req);
+			else
+				rc[i] = crypto_skcipher_decrypt(data[i].req);
+		}
 	}
 
 	/* Wait for all requests to finish */
@@ -1488,7 +1702,8 @@ static int test_acipher_cycles(struct skcipher_request *req, int enc,
 
 static void test_skcipher_speed(const char *algo, int enc, unsigned int secs,
 				struct cipher_speed_template *template,
-				unsigned int tcount, u8 *keysize, bool async)
+				unsigned int tcount, u8 *keysize, bool async,
+				u32 *sizes)
 {
 	unsigned int ret, i, j, k, iv_len;
 	struct crypto_wait wait;
@@ -1529,7 +1744,7 @@ static void test_skcipher_speed(const char *algo, int enc, unsigned int secs,
 
 	i = 0;
 	do {
-		b_size = block_sizes;
+		b_size = sizes;
 
 		do {
 			struct scatterlist sg[TVMEMSIZE];
@@ -1621,7 +1836,14 @@ static void test_acipher_speed(const char *algo, int enc, unsigned int secs,
 			       unsigned int tcount, u8 *keysize)
 {
 	return test_skcipher_speed(algo, enc, secs, template, tcount, keysize,
-				   true);
+				   true, block_sizes);
+}
+
+static void test_acipher_bulk_speed(const char *algo, int enc,
+				    unsigned int secs, u8 *keysize)
+{
+	return test_skcipher_speed(algo, enc, secs, NULL, 0, keysize,
+				   true, bulk_sizes);
 }
 
 static void test_cipher_speed(const char *algo, int enc, unsigned int secs,
@@ -1629,7 +1851,203 @@ static void test_cipher_speed(const char *algo, int enc, unsigned int secs,
 			      unsigned int tcount, u8 *keysize)
 {
 	return test_skcipher_speed(algo, enc, secs, template, tcount, keysize,
-				   false);
+				   false, block_sizes);
+}
+
+/*
+ * Compression speed tests work on COMP_SPEED_BLOCKS independent blocks of
+ * COMP_SPEED_BLKSZ bytes, the unit zram and zswap compress.  The corpus is
+ * generated from a small vocabulary so that it compresses like text, and the
+ * dictionary is a separate sample from the same generator.
+ */
+#define COMP_SPEED_BLKSZ	PAGE_SIZE
+#define COMP_SPEED_BLOCKS	16
+
+static const char * const comp_speed_words[] = {
+	"the", "of", "and", "to", "in", "is", "for", "that", "with", "on",
+	"kernel", "page", "buffer", "struct", "return", "static", "int",
+	"void", "unsigned", "const", "error", "device", "memory", "lock",
+	"\n", "\t", "(", ")", "{", "}", ";", "->", "=", "0x", "NULL",
+};
+
+static void comp_speed_fill(u8 *buf, unsigned int len,
+			    struct rnd_state *rnd)
+{
+	unsigned int pos = 0;
+
+	while (pos < len) {
+		const char *w = comp_speed_words[prandom_u32_state(rnd) %
+						 ARRAY_SIZE(comp_speed_words)];
+		unsigned int n = min_t(unsigned int, strlen(w), len - pos);
+
+		memcpy(buf + pos, w, n);
+		pos += n;
+		if (pos < len)
+			buf[pos++] = ' ';
+	}
+}
+
+static int comp_speed_run(struct crypto_comp *tfm, bool comp, u8 *src,
+			  unsigned int *slen, u8 *dst, unsigned int *dlen)
+{
+	unsigned int i, n;
+	int ret;
+
+	for (i = 0; i < COMP_SPEED_BLOCKS; i++) {
+		n = 2 * COMP_SPEED_BLKSZ;
+		if (comp)
+			ret = crypto_comp_compress(tfm,
+						   src + i * COMP_SPEED_BLKSZ,
+						   COMP_SPEED_BLKSZ,
+						   dst + i * 2 * COMP_SPEED_BLKSZ,
+						   &n);
+		else
+			ret = crypto_comp_decompress(tfm,
+						     src + i * 2 * COMP_SPEED_BLKSZ,
+						     slen[i],
+						     dst + i * COMP_SPEED_BLKSZ,
+						     &n);
+		if (ret)
+			return ret;
+		if (dlen)
+			dlen[i] = n;
+	}
+
+	return 0;
+}
+
+static int comp_speed_measure(struct crypto_comp *tfm, bool comp,
+			      unsigned int secs, u8 *src, unsigned int *slen,
+			      u8 *dst)
+{
+	unsigned long cycles = 0;
+	int ret, i;
+
+	if (secs) {
+		unsigned long start, end;
+		int bcount;
+
+		for (start = jiffies, end = start + secs * HZ, bcount = 0;
+		     time_before(jiffies, end); bcount++) {
+			ret = comp_speed_run(tfm, comp, src, slen, dst, NULL);
+			if (ret)
+				return ret;
+		}
+		pr_cont("%d operations in %d seconds (%ld bytes)\n",
+			bcount * COMP_SPEED_BLOCKS, secs,
+			(long)bcount * COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ);
+		return 0;
+	}
+
+	/* Warm-up run. */
+	ret = comp_speed_run(tfm, comp, src, slen, dst, NULL);
+	if (ret)
+		return ret;
+
+	/* The real thing. */
+	for (i = 0; i < 8; i++) {
+		cycles_t start, end;
+
+		start = get_cycles();
+		ret = comp_speed_run(tfm, comp, src, slen, dst, NULL);
+		end = get_cycles();
+		if (ret)
+			return ret;
+
+		cycles += end - start;
+	}
+
+	pr_cont("%6lu cycles/operation, %4lu cycles/byte\n",
+		cycles / (8 * COMP_SPEED_BLOCKS),
+		cycles / (8 * COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ));
+	return 0;
+}
+
+static void test_comp_speed(const char *algo, int level,
+			    unsigned int dictsize, unsigned int secs)
+{
+	struct crypto_comp *tfm;
+	struct rnd_state rnd;
+	unsigned int slen[COMP_SPEED_BLOCKS];
+	unsigned long total = 0;
+	u8 *plain, *comp, *out, *dict = NULL;
+	unsigned int i;
+	int ret;
+
+	tfm = crypto_alloc_comp(algo, 0, 0);
+	if (IS_ERR(tfm)) {
+		pr_err("failed to load transform for %s: %ld\n", algo,
+		       PTR_ERR(tfm));
+		return;
+	}
+
+	pr_info("\ntesting speed of %s (%s) level %d, %u byte dictionary\n",
+		algo, crypto_tfm_alg_driver_name(crypto_comp_tfm(tfm)), level,
+		dictsize);
+
+	plain = vmalloc(COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ);
+	comp = vmalloc(COMP_SPEED_BLOCKS * 2 * COMP_SPEED_BLKSZ);
+	out = vmalloc(COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ);
+	if (dictsize)
+		dict = vmalloc(dictsize);
+	if (!plain || !comp || !out || (dictsize && !dict))
+		goto out;
+
+	prandom_seed_state(&rnd, 0x7a737464);
+	comp_speed_fill(plain, COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ, &rnd);
+	if (dictsize)
+		comp_speed_fill(dict, dictsize, &rnd);
+
+	if (level) {
+		ret = crypto_comp_setlevel(tfm, level);
+		if (ret) {
+			pr_err("setting level %d failed: %d\n", level, ret);
+			goto out;
+		}
+	}
+	if (dictsize) {
+		ret = crypto_comp_setdict(tfm, dict, dictsize);
+		if (ret) {
+			pr_err("loading dictionary failed: %d\n", ret);
+			goto out;
+		}
+	}
+
+	ret = comp_speed_run(tfm, true, plain, NULL, comp, slen);
+	if (ret)
+		goto out_err;
+	ret = comp_speed_run(tfm, false, comp, slen, out, NULL);
+	if (ret)
+		goto out_err;
+	if (memcmp(plain, out, COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ)) {
+		pr_err("decompressed data mismatch\n");
+		goto out;
+	}
+
+	for (i = 0; i < COMP_SPEED_BLOCKS; i++)
+		total += slen[i];
+	pr_info("%lu bytes compressed to %lu (%lu%%)\n",
+		COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ, total,
+		total * 100 / (COMP_SPEED_BLOCKS * COMP_SPEED_BLKSZ));
+
+	pr_info("compress:   ");
+	ret = comp_speed_measure(tfm, true, secs, plain, NULL, comp);
+	if (ret)
+		goto out_err;
+	pr_info("decompress: ");
+	ret = comp_speed_measure(tfm, false, secs, comp, slen, out);
+	if (ret)
+		goto out_err;
+	goto out;
+
+out_err:
+	pr_err("%s failed: %d\n", algo, ret);
+out:
+	vfree(dict);
+	vfree(out);
+	vfree(comp);
+	vfree(plain);
+	crypto_free_comp(tfm);
 }
 
 static void test_available(void)
@@ -2343,6 +2761,24 @@ static int do_test(const char *alg, u32 type, u32 mask, int m, u32 num_mb)
 				NULL, 0, 16, 8, speed_template_16);
 		break;
 
+	case 222:
+		__test_aead_speed("rfc4106(gcm(aes))", ENCRYPT, sec, NULL, 0,
+				  16, 16, aead_speed_template_20, bulk_sizes);
+		__test_aead_speed("gcm(aes)", ENCRYPT, sec, NULL, 0, 16, 8,
+				  speed_template_16_24_32, bulk_sizes);
+		__test_aead_speed("rfc4106(gcm(aes))", DECRYPT, sec, NULL, 0,
+				  16, 16, aead_speed_template_20, bulk_sizes);
+		__test_aead_speed("gcm(aes)", DECRYPT, sec, NULL, 0, 16, 8,
+				  speed_template_16_24_32, bulk_sizes);
+		break;
+
+	case 223:
+		test_acipher_bulk_speed("xts(aes)", ENCRYPT, sec,
+					speed_template_32_64);
+		test_acipher_bulk_speed("xts(aes)", DECRYPT, sec,
+					speed_template_32_64);
+		break;
+
 	case 300:
 		if (alg) {
 			test_hash_speed(alg, sec, generic_hash_speed_template);
@@ -2586,6 +3022,11 @@ static int do_test(const char *alg, u32 type, u32 mask, int m, u32 num_mb)
 				    generic_hash_speed_template, num_mb);
 		if (mode > 400 && mode < 500) break;
 		/* fall through */
+	case 428:
+		test_mb_shash_speed("sha256", sec, generic_hash_speed_template,
+				    num_mb);
+		if (mode > 400 && mode < 500) break;
+		/* fall through */
 	case 499:
 		break;
 
@@ -3013,6 +3454,27 @@ static int do_test(const char *alg, u32 type, u32 mask, int m, u32 num_mb)
 				       speed_template_8_32, num_mb);
 		break;
 
+	case 610:
+		test_mb_skcipher_speed("chacha20", ENCRYPT, sec, NULL, 0,
+				       speed_template_32, num_mb);
+		test_mb_skcipher_speed("xchacha20", ENCRYPT, sec, NULL, 0,
+				       speed_template_32, num_mb);
+		test_mb_skcipher_speed("xchacha12", ENCRYPT, sec, NULL, 0,
+				       speed_template_32, num_mb);
+		break;
+
+	case 700:
+		test_comp_speed("deflate", 0, 0, sec);
+		test_comp_speed("lzo", 0, 0, sec);
+		test_comp_speed("lz4", 0, 0, sec);
+		test_comp_speed("zstd", 0, 0, sec);
+		test_comp_speed("zstd", 1, 0, sec);
+		test_comp_speed("zstd", 9, 0, sec);
+		test_comp_speed("zstd", 0, 16384, sec);
+		test_comp_speed("zstd", 1, 16384, sec);
+		test_comp_speed("zstd", 9, 16384, sec);
+		break;
+
 	case 1000:
 		test_available();
 		break;
@@ -3076,6 +3538,8 @@ MODULE_PARM_DESC(sec, "Length in seconds of speed tests "
 		      "(defaults to zero which uses CPU cycles instead)");
 module_param(num_mb, uint, 0000);
 MODULE_PARM_DESC(num_mb, "Number of concurrent requests to be used in mb speed tests (defaults to 8)");
+module_param(mb_batch, bool, 0000);
+MODULE_PARM_DESC(mb_batch, "Submit mb speed test requests through the batch API");
 
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Quick & dirty crypto testing module");
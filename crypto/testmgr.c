@@ -1083,6 +1083,59 @@ static inline const void *sg_data(struct scatterlist *sg)
 	return page_address(sg_page(sg)) + sg->offset;
 }
 
+/*
+ * Number of buffers passed to ->digest_batch(). Deliberately not a multiple of
+ * any SIMD lane count, so that implementations also exercise their tail path.
+ */
+#define TESTMGR_DIGEST_BATCH	9
+
+/* Test ->digest_batch() by hashing the same buffer several times */
+static int test_shash_digest_batch(const char *driver,
+				   const char *vec_name,
+				   const struct testvec_config *cfg,
+				   struct shash_desc *desc,
+				   const u8 *data, unsigned int len,
+				   const u8 *result)
+{
+	const unsigned int digestsize = crypto_shash_digestsize(desc->tfm);
+	const u8 *srcs[TESTMGR_DIGEST_BATCH];
+	u8 *outs[TESTMGR_DIGEST_BATCH];
+	u8 *batch_result;
+	unsigned int i;
+	int err;
+
+	batch_result = kcalloc(TESTMGR_DIGEST_BATCH, digestsize, GFP_KERNEL);
+	if (!batch_result)
+		return -ENOMEM;
+
+	for (i = 0; i < TESTMGR_DIGEST_BATCH; i++) {
+		srcs[i] = data;
+		outs[i] = batch_result + i * digestsize;
+	}
+
+	if (cfg->nosimd)
+		crypto_disable_simd_for_test();
+	err = crypto_shash_digest_batch(desc, srcs, len, outs,
+					TESTMGR_DIGEST_BATCH);
+	if (cfg->nosimd)
+		crypto_reenable_simd_for_test();
+	err = check_shash_op("digest_batch", err, driver, vec_name, cfg);
+	if (err)
+		goto out;
+
+	for (i = 0; i < TESTMGR_DIGEST_BATCH; i++) {
+		if (memcmp(outs[i], result, digestsize) != 0) {
+			pr_err("alg: shash: %s digest_batch() gives wrong result for buffer %u on test vector %s, cfg=\"%s\"\n",
+			       driver, i, vec_name, cfg->name);
+			err = -EINVAL;
+			break;
+		}
+	}
+out:
+	kfree(batch_result);
+	return err;
+}
+
 /* Test one hash test vector in one configuration, using the shash API */
 static int test_shash_vec_cfg(const char *driver,
 			      const struct hash_testvec *vec,
@@ -1156,7 +1209,13 @@ static int test_shash_vec_cfg(const char *driver,
 			       driver, vec_name, vec->digest_error, cfg->name);
 			return -EINVAL;
 		}
-		goto result_ready;
+		err = check_hash_result("shash", result, digestsize, vec,
+					vec_name, driver, cfg);
+		if (err)
+			return err;
+		return test_shash_digest_batch(driver, vec_name, cfg, desc,
+					       sg_data(&tsgl->sgl[0]),
+					       tsgl->sgl[0].length, result);
 	}
 
 	/* Using init(), zero or more update(), then final() or finup() */
@@ -1834,6 +1893,102 @@ static int alg_test_hash(const struct alg_test_desc *desc, const char *driver,
 	return err;
 }
 
+/*
+ * Number of requests passed to the skcipher and AEAD batch operations.  Odd,
+ * so that an implementation pairing requests up also handles a leftover one.
+ */
+#define TESTMGR_CIPHER_BATCH	5
+
+/*
+ * Test crypto_aead_{en,de}crypt_batch() by submitting several copies of a test
+ * vector, each in its own linear buffer and processed in place, in one call
+ */
+static int test_aead_vec_batch(const char *driver, int enc,
+			       const struct aead_testvec *vec,
+			       const char *vec_name,
+			       const struct testvec_config *cfg,
+			       struct crypto_aead *tfm)
+{
+	const unsigned int ivsize = crypto_aead_ivsize(tfm);
+	const unsigned int inlen = enc ? vec->plen : vec->clen;
+	const unsigned int outlen = enc ? vec->clen : vec->plen;
+	const unsigned int len = max(vec->alen + max(vec->plen, vec->clen), 1U);
+	const char *op = enc ? "encryption" : "decryption";
+	struct aead_request *reqs[TESTMGR_CIPHER_BATCH] = {};
+	struct crypto_wait waits[TESTMGR_CIPHER_BATCH];
+	struct scatterlist sgs[TESTMGR_CIPHER_BATCH];
+	int errs[TESTMGR_CIPHER_BATCH];
+	u8 ivs[TESTMGR_CIPHER_BATCH][MAX_IVLEN];
+	unsigned int i;
+	u8 *bufs;
+	int err;
+
+	bufs = kmalloc_array(TESTMGR_CIPHER_BATCH, len, GFP_KERNEL);
+	if (!bufs)
+		return -ENOMEM;
+
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++) {
+		u8 *buf = bufs + i * len;
+
+		reqs[i] = aead_request_alloc(tfm, GFP_KERNEL);
+		if (!reqs[i]) {
+			err = -ENOMEM;
+			goto out;
+		}
+		crypto_init_wait(&waits[i]);
+
+		if (vec->iv)
+			memcpy(ivs[i], vec->iv, ivsize);
+		else
+			memset(ivs[i], 0, ivsize);
+
+		memcpy(buf, vec->assoc, vec->alen);
+		memcpy(buf + vec->alen, enc ? vec->ptext : vec->ctext, inlen);
+		sg_init_one(&sgs[i], buf, vec->alen + max(inlen, outlen));
+
+		aead_request_set_callback(reqs[i], CRYPTO_TFM_REQ_MAY_BACKLOG |
+					  cfg->req_flags,
+					  crypto_req_done, &waits[i]);
+		aead_request_set_crypt(reqs[i], &sgs[i], &sgs[i], inlen, ivs[i]);
+		aead_request_set_ad(reqs[i], vec->alen);
+	}
+
+	if (cfg->nosimd)
+		crypto_disable_simd_for_test();
+	if (enc)
+		crypto_aead_encrypt_batch(reqs, errs, TESTMGR_CIPHER_BATCH);
+	else
+		crypto_aead_decrypt_batch(reqs, errs, TESTMGR_CIPHER_BATCH);
+	if (cfg->nosimd)
+		crypto_reenable_simd_for_test();
+
+	/* Wait for every request before looking at any of them */
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++)
+		errs[i] = crypto_wait_req(errs[i], &waits[i]);
+
+	err = 0;
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++) {
+		if (errs[i]) {
+			pr_err("alg: aead: %s batch %s failed on request %u of test vector %s; err=%d, cfg=\"%s\"\n",
+			       driver, op, i, vec_name, errs[i], cfg->name);
+			err = errs[i];
+			break;
+		}
+		if (memcmp(bufs + i * len + vec->alen,
+			   enc ? vec->ctext : vec->ptext, outlen) != 0) {
+			pr_err("alg: aead: %s batch %s test failed (wrong result) on request %u of test vector %s, cfg=\"%s\"\n",
+			       driver, op, i, vec_name, cfg->name);
+			err = -EINVAL;
+			break;
+		}
+	}
+out:
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++)
+		aead_request_free(reqs[i]);
+	kfree(bufs);
+	return err;
+}
+
 static int test_aead_vec_cfg(const char *driver, int enc,
 			     const struct aead_testvec *vec,
 			     const char *vec_name,
@@ -2002,7 +2157,7 @@ static int test_aead_vec_cfg(const char *driver, int enc,
 		return err;
 	}
 
-	return 0;
+	return test_aead_vec_batch(driver, enc, vec, vec_name, cfg, tfm);
 }
 
 static int test_aead_vec(const char *driver, int enc,
@@ -2434,6 +2589,93 @@ static int test_cipher(struct crypto_cipher *tfm, int enc,
 	return ret;
 }
 
+/*
+ * Test crypto_skcipher_{en,de}crypt_batch() by submitting several copies of a
+ * test vector, each in its own linear buffer, in one call
+ */
+static int test_skcipher_vec_batch(const char *driver, int enc,
+				   const struct cipher_testvec *vec,
+				   const char *vec_name,
+				   const struct testvec_config *cfg,
+				   struct crypto_skcipher *tfm)
+{
+	const unsigned int ivsize = crypto_skcipher_ivsize(tfm);
+	const unsigned int len = max(vec->len, 1U);
+	const char *op = enc ? "encryption" : "decryption";
+	struct skcipher_request *reqs[TESTMGR_CIPHER_BATCH] = {};
+	struct crypto_wait waits[TESTMGR_CIPHER_BATCH];
+	struct scatterlist sgs[TESTMGR_CIPHER_BATCH];
+	int errs[TESTMGR_CIPHER_BATCH];
+	u8 ivs[TESTMGR_CIPHER_BATCH][MAX_IVLEN];
+	unsigned int i;
+	u8 *bufs;
+	int err;
+
+	bufs = kmalloc_array(TESTMGR_CIPHER_BATCH, len, GFP_KERNEL);
+	if (!bufs)
+		return -ENOMEM;
+
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++) {
+		reqs[i] = skcipher_request_alloc(tfm, GFP_KERNEL);
+		if (!reqs[i]) {
+			err = -ENOMEM;
+			goto out;
+		}
+		crypto_init_wait(&waits[i]);
+
+		if (vec->generates_iv && !enc)
+			memcpy(ivs[i], vec->iv_out, ivsize);
+		else if (vec->iv)
+			memcpy(ivs[i], vec->iv, ivsize);
+		else
+			memset(ivs[i], 0, ivsize);
+
+		memcpy(bufs + i * len, enc ? vec->ptext : vec->ctext, vec->len);
+		sg_init_one(&sgs[i], bufs + i * len, vec->len);
+
+		skcipher_request_set_callback(reqs[i], CRYPTO_TFM_REQ_MAY_BACKLOG |
+					      cfg->req_flags,
+					      crypto_req_done, &waits[i]);
+		skcipher_request_set_crypt(reqs[i], &sgs[i], &sgs[i], vec->len,
+					   ivsize ? ivs[i] : NULL);
+	}
+
+	if (cfg->nosimd)
+		crypto_disable_simd_for_test();
+	if (enc)
+		crypto_skcipher_encrypt_batch(reqs, errs, TESTMGR_CIPHER_BATCH);
+	else
+		crypto_skcipher_decrypt_batch(reqs, errs, TESTMGR_CIPHER_BATCH);
+	if (cfg->nosimd)
+		crypto_reenable_simd_for_test();
+
+	/* Wait for every request before looking at any of them */
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++)
+		errs[i] = crypto_wait_req(errs[i], &waits[i]);
+
+	err = 0;
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++) {
+		if (errs[i]) {
+			pr_err("alg: skcipher: %s batch %s failed on request %u of test vector %s; err=%d, cfg=\"%s\"\n",
+			       driver, op, i, vec_name, errs[i], cfg->name);
+			err = errs[i];
+			break;
+		}
+		if (memcmp(bufs + i * len, enc ? vec->ctext : vec->ptext,
+			   vec->len) != 0) {
+			pr_err("alg: skcipher: %s batch %s test failed (wrong result) on request %u of test vector %s, cfg=\"%s\"\n",
+			       driver, op, i, vec_name, cfg->name);
+			err = -EINVAL;
+			break;
+		}
+	}
+out:
+	for (i = 0; i < TESTMGR_CIPHER_BATCH; i++)
+		skcipher_request_free(reqs[i]);
+	kfree(bufs);
+	return err;
+}
+
 static int test_skcipher_vec_cfg(const char *driver, int enc,
 				 const struct cipher_testvec *vec,
 				 const char *vec_name,
@@ -2594,7 +2836,7 @@ static int test_skcipher_vec_cfg(const char *driver, int enc,
 		return -EINVAL;
 	}
 
-	return 0;
+	return test_skcipher_vec_batch(driver, enc, vec, vec_name, cfg, tfm);
 }
 
 static int test_skcipher_vec(const char *driver, int enc,
@@ -4,12 +4,14 @@
  *
  * Copyright (c) 2017-present, Facebook, Inc.
  */
+#include <linux/atomic.h>
 #include <linux/crypto.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/net.h>
+#include <linux/slab.h>
 #include <linux/vmalloc.h>
 #include <linux/zstd.h>
 #include <crypto/internal/scompress.h>
@@ -17,23 +19,128 @@
 
 #define ZSTD_DEF_LEVEL	3
 
+/*
+ * Per-tfm settings.  The digested dictionaries are read-only once built and
+ * are shared by every compression context of the tfm.
+ */
+struct zstd_params {
+	int level;
+	size_t src_hint;
+	void *dict;
+	unsigned int dict_len;
+	ZSTD_CDict *cdict;
+	ZSTD_DDict *ddict;
+	void *cdict_wksp;
+	void *ddict_wksp;
+	atomic_t users;
+};
+
 struct zstd_ctx {
 	ZSTD_CCtx *cctx;
 	ZSTD_DCtx *dctx;
 	void *cwksp;
 	void *dwksp;
+	const struct zstd_params *params;
+};
+
+/* Context of the synchronous "compress" algorithm */
+struct zstd_comp_ctx {
+	struct zstd_params params;
+	struct zstd_ctx ctx;
 };
 
-static ZSTD_parameters zstd_params(void)
+static ZSTD_parameters zstd_params(const struct zstd_params *p)
+{
+	return ZSTD_getParams(p->level, p->src_hint, p->dict_len);
+}
+
+static void zstd_params_init(struct zstd_params *p, size_t src_hint)
+{
+	p->level = ZSTD_DEF_LEVEL;
+	p->src_hint = src_hint;
+	atomic_set(&p->users, 0);
+}
+
+static void zstd_dict_free(struct zstd_params *p)
+{
+	vfree(p->cdict_wksp);
+	vfree(p->ddict_wksp);
+	kvfree(p->dict);
+	p->cdict_wksp = NULL;
+	p->ddict_wksp = NULL;
+	p->dict = NULL;
+	p->dict_len = 0;
+	p->cdict = NULL;
+	p->ddict = NULL;
+}
+
+/*
+ * Digest @dict for the current level.  On failure the previous dictionary
+ * state of @p is left untouched.
+ */
+static int zstd_dict_build(struct zstd_params *p, const u8 *dict,
+			   unsigned int len)
 {
-	return ZSTD_getParams(ZSTD_DEF_LEVEL, 0, 0);
+	struct zstd_params new = *p;
+	ZSTD_parameters params;
+	size_t cwksp_size, dwksp_size;
+	int ret;
+
+	new.dict = NULL;
+	new.cdict_wksp = NULL;
+	new.ddict_wksp = NULL;
+	new.cdict = NULL;
+	new.ddict = NULL;
+	new.dict_len = len;
+
+	if (len) {
+		new.dict = kvmalloc(len, GFP_KERNEL);
+		if (!new.dict)
+			return -ENOMEM;
+		memcpy(new.dict, dict, len);
+
+		params = zstd_params(&new);
+		cwksp_size = ZSTD_CDictWorkspaceBound(params.cParams);
+		dwksp_size = ZSTD_DDictWorkspaceBound();
+
+		new.cdict_wksp = vzalloc(cwksp_size);
+		new.ddict_wksp = vzalloc(dwksp_size);
+		ret = -ENOMEM;
+		if (!new.cdict_wksp || !new.ddict_wksp)
+			goto out_free;
+
+		new.cdict = ZSTD_initCDict(new.dict, len, params,
+					   new.cdict_wksp, cwksp_size);
+		new.ddict = ZSTD_initDDict(new.dict, len,
+					   new.ddict_wksp, dwksp_size);
+		ret = -EINVAL;
+		if (!new.cdict || !new.ddict)
+			goto out_free;
+	}
+
+	zstd_dict_free(p);
+	p->dict = new.dict;
+	p->dict_len = new.dict_len;
+	p->cdict = new.cdict;
+	p->ddict = new.ddict;
+	p->cdict_wksp = new.cdict_wksp;
+	p->ddict_wksp = new.ddict_wksp;
+	return 0;
+
+out_free:
+	zstd_dict_free(&new);
+	return ret;
 }
 
 static int zstd_comp_init(struct zstd_ctx *ctx)
 {
 	int ret = 0;
-	const ZSTD_parameters params = zstd_params();
-	const size_t wksp_size = ZSTD_CCtxWorkspaceBound(params.cParams);
+	const struct zstd_params *p = ctx->params;
+	const ZSTD_parameters params = zstd_params(p);
+	const ZSTD_parameters nodict = ZSTD_getParams(p->level, p->src_hint, 0);
+	/* Stay large enough should the dictionary be removed later */
+	const size_t wksp_size = max(ZSTD_CCtxWorkspaceBound(params.cParams),
+				     ZSTD_CCtxWorkspaceBound(nodict.cParams));
 
 	ctx->cwksp = vzalloc(wksp_size);
 	if (!ctx->cwksp) {
@@ -103,8 +210,52 @@ static int __zstd_init(void *ctx)
 	return ret;
 }
 
+/*
+ * Change the level of @p.  The compression workspace and the digested
+ * dictionary both depend on it, so @ctx (if any) is resized and the
+ * dictionary rebuilt; on failure everything is left as it was.
+ */
+static int zstd_set_level(struct zstd_params *p, struct zstd_ctx *ctx,
+			  int level)
+{
+	struct zstd_ctx new = { .params = p };
+	int old_level = p->level;
+	int ret;
+
+	if (!level)
+		level = ZSTD_DEF_LEVEL;
+	if (level < 1 || level > ZSTD_maxCLevel())
+		return -EINVAL;
+	if (level == old_level)
+		return 0;
+
+	p->level = level;
+	if (ctx) {
+		ret = zstd_comp_init(&new);
+		if (ret)
+			goto out_restore;
+	}
+	ret = zstd_dict_build(p, p->dict, p->dict_len);
+	if (ret) {
+		zstd_comp_exit(&new);
+		goto out_restore;
+	}
+
+	if (ctx) {
+		zstd_comp_exit(ctx);
+		ctx->cwksp = new.cwksp;
+		ctx->cctx = new.cctx;
+	}
+	return 0;
+
+out_restore:
+	p->level = old_level;
+	return ret;
+}
+
 static void *zstd_alloc_ctx(struct crypto_scomp *tfm)
 {
+	struct zstd_params *params = crypto_tfm_ctx(crypto_scomp_tfm(tfm));
 	int ret;
 	struct zstd_ctx *ctx;
 
@@ -112,20 +263,36 @@ static void *zstd_alloc_ctx(struct crypto_scomp *tfm)
 	if (!ctx)
 		return ERR_PTR(-ENOMEM);
 
+	ctx->params = params;
 	ret = __zstd_init(ctx);
 	if (ret) {
 		kfree(ctx);
 		return ERR_PTR(ret);
 	}
 
+	atomic_inc(&params->users);
 	return ctx;
 }
 
 static int zstd_init(struct crypto_tfm *tfm)
 {
-	struct zstd_ctx *ctx = crypto_tfm_ctx(tfm);
+	struct zstd_comp_ctx *ctx = crypto_tfm_ctx(tfm);
 
-	return __zstd_init(ctx);
+	zstd_params_init(&ctx->params, 0);
+	ctx->ctx.params = &ctx->params;
+	return __zstd_init(&ctx->ctx);
+}
+
+static int zstd_scomp_init(struct crypto_tfm *tfm)
+{
+	struct zstd_params *params = crypto_tfm_ctx(tfm);
+
+	/*
+	 * Requests through the acomp interface never exceed the scratch
+	 * size, which lets zstd pick a smaller window and workspace.
+	 */
+	zstd_params_init(params, SCOMP_SCRATCH_SIZE);
+	return 0;
 }
 
 static void __zstd_exit(void *ctx)
@@ -136,15 +303,64 @@ static void __zstd_exit(void *ctx)
 
 static void zstd_free_ctx(struct crypto_scomp *tfm, void *ctx)
 {
+	struct zstd_params *params = crypto_tfm_ctx(crypto_scomp_tfm(tfm));
+
+	atomic_dec(&params->users);
 	__zstd_exit(ctx);
 	kzfree(ctx);
 }
 
 static void zstd_exit(struct crypto_tfm *tfm)
 {
-	struct zstd_ctx *ctx = crypto_tfm_ctx(tfm);
+	struct zstd_comp_ctx *ctx = crypto_tfm_ctx(tfm);
 
-	__zstd_exit(ctx);
+	__zstd_exit(&ctx->ctx);
+	zstd_dict_free(&ctx->params);
+}
+
+static void zstd_scomp_exit(struct crypto_tfm *tfm)
+{
+	zstd_dict_free(crypto_tfm_ctx(tfm));
+}
+
+static int zstd_setlevel(struct crypto_tfm *tfm, int level)
+{
+	struct zstd_comp_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	return zstd_set_level(&ctx->params, &ctx->ctx, level);
+}
+
+static int zstd_setdict(struct crypto_tfm *tfm, const u8 *dict,
+			unsigned int len)
+{
+	struct zstd_comp_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	return zstd_dict_build(&ctx->params, dict, len);
+}
+
+/*
+ * Request contexts are sized for the level in force when they were
+ * allocated, so the scomp settings are frozen once requests exist.
+ */
+static int zstd_scomp_setlevel(struct crypto_scomp *tfm, int level)
+{
+	struct zstd_params *params = crypto_tfm_ctx(crypto_scomp_tfm(tfm));
+
+	if (atomic_read(&params->users))
+		return -EBUSY;
+
+	return zstd_set_level(params, NULL, level);
+}
+
+static int zstd_scomp_setdict(struct crypto_scomp *tfm, const u8 *dict,
+			      unsigned int len)
+{
+	struct zstd_params *params = crypto_tfm_ctx(crypto_scomp_tfm(tfm));
+
+	if (atomic_read(&params->users))
+		return -EBUSY;
+
+	return zstd_dict_build(params, dict, len);
 }
 
 static int __zstd_compress(const u8 *src, unsigned int slen,
@@ -152,9 +368,17 @@ static int __zstd_compress(const u8 *src, unsigned int slen,
 {
 	size_t out_len;
 	struct zstd_ctx *zctx = ctx;
-	const ZSTD_parameters params = zstd_params();
+	const struct zstd_params *p = zctx->params;
 
-	out_len = ZSTD_compressCCtx(zctx->cctx, dst, *dlen, src, slen, params);
+	if (p->cdict) {
+		out_len = ZSTD_compress_usingCDict(zctx->cctx, dst, *dlen,
+						   src, slen, p->cdict);
+	} else {
+		const ZSTD_parameters params = zstd_params(p);
+
+		out_len = ZSTD_compressCCtx(zctx->cctx, dst, *dlen, src, slen,
+					    params);
+	}
 	if (ZSTD_isError(out_len))
 		return -EINVAL;
 	*dlen = out_len;
@@ -164,9 +388,9 @@ static int __zstd_compress(const u8 *src, unsigned int slen,
 static int zstd_compress(struct crypto_tfm *tfm, const u8 *src,
 			 unsigned int slen, u8 *dst, unsigned int *dlen)
 {
-	struct zstd_ctx *ctx = crypto_tfm_ctx(tfm);
+	struct zstd_comp_ctx *ctx = crypto_tfm_ctx(tfm);
 
-	return __zstd_compress(src, slen, dst, dlen, ctx);
+	return __zstd_compress(src, slen, dst, dlen, &ctx->ctx);
 }
 
 static int zstd_scompress(struct crypto_scomp *tfm, const u8 *src,
@@ -181,8 +405,14 @@ static int __zstd_decompress(const u8 *src, unsigned int slen,
 {
 	size_t out_len;
 	struct zstd_ctx *zctx = ctx;
-
-	out_len = ZSTD_decompressDCtx(zctx->dctx, dst, *dlen, src, slen);
+	const struct zstd_params *p = zctx->params;
+
+	if (p->ddict)
+		out_len = ZSTD_decompress_usingDDict(zctx->dctx, dst, *dlen,
+						     src, slen, p->ddict);
+	else
+		out_len = ZSTD_decompressDCtx(zctx->dctx, dst, *dlen,
+					      src, slen);
 	if (ZSTD_isError(out_len))
 		return -EINVAL;
 	*dlen = out_len;
@@ -192,9 +422,9 @@ static int __zstd_decompress(const u8 *src, unsigned int slen,
 static int zstd_decompress(struct crypto_tfm *tfm, const u8 *src,
 			   unsigned int slen, u8 *dst, unsigned int *dlen)
 {
-	struct zstd_ctx *ctx = crypto_tfm_ctx(tfm);
+	struct zstd_comp_ctx *ctx = crypto_tfm_ctx(tfm);
 
-	return __zstd_decompress(src, slen, dst, dlen, ctx);
+	return __zstd_decompress(src, slen, dst, dlen, &ctx->ctx);
 }
 
 static int zstd_sdecompress(struct crypto_scomp *tfm, const u8 *src,
@@ -208,13 +438,15 @@ static struct crypto_alg alg = {
 	.cra_name		= "zstd",
 	.cra_driver_name	= "zstd-generic",
 	.cra_flags		= CRYPTO_ALG_TYPE_COMPRESS,
-	.cra_ctxsize		= sizeof(struct zstd_ctx),
+	.cra_ctxsize		= sizeof(struct zstd_comp_ctx),
 	.cra_module		= THIS_MODULE,
 	.cra_init		= zstd_init,
 	.cra_exit		= zstd_exit,
 	.cra_u			= { .compress = {
 	.coa_compress		= zstd_compress,
-	.coa_decompress		= zstd_decompress } }
+	.coa_decompress		= zstd_decompress,
+	.coa_setlevel		= zstd_setlevel,
+	.coa_setdict		= zstd_setdict } }
 };
 
 static struct scomp_alg scomp = {
@@ -222,9 +454,14 @@ static struct scomp_alg scomp = {
 	.free_ctx		= zstd_free_ctx,
 	.compress		= zstd_scompress,
 	.decompress		= zstd_sdecompress,
+	.setlevel		= zstd_scomp_setlevel,
+	.setdict		= zstd_scomp_setdict,
 	.base			= {
 		.cra_name	= "zstd",
 		.cra_driver_name = "zstd-scomp",
+		.cra_ctxsize	 = sizeof(struct zstd_params),
+		.cra_init	 = zstd_scomp_init,
+		.cra_exit	 = zstd_scomp_exit,
 		.cra_module	 = THIS_MODULE,
 	}
 };
@@ -467,7 +467,6 @@ __virtio_crypto_ablkcipher_do_req(struct virtio_crypto_sym_request *vc_sym_req,
 	spin_lock_irqsave(&data_vq->lock, flags);
 	err = virtqueue_add_sgs(data_vq->vq, sgs, num_out,
 				num_in, vc_req, GFP_ATOMIC);
-	virtqueue_kick(data_vq->vq);
 	spin_unlock_irqrestore(&data_vq->lock, flags);
 	if (unlikely(err < 0))
 		goto free_iv;
@@ -566,15 +565,9 @@ int virtio_crypto_ablkcipher_crypt_req(
 				ablkcipher_request_ctx(req);
 	struct virtio_crypto_request *vc_req = &vc_sym_req->base;
 	struct data_queue *data_vq = vc_req->dataq;
-	int ret;
-
-	ret = __virtio_crypto_ablkcipher_do_req(vc_sym_req, req, data_vq);
-	if (ret < 0)
-		return ret;
 
-	virtqueue_kick(data_vq->vq);
-
-	return 0;
+	/* The device is notified by virtcrypto_dataq_kick() */
+	return __virtio_crypto_ablkcipher_do_req(vc_sym_req, req, data_vq);
 }
 
 static void virtio_crypto_ablkcipher_finalize_req(
@@ -45,6 +45,32 @@ static void virtcrypto_dataq_callback(struct virtqueue *vq)
 	spin_unlock_irqrestore(&vcrypto->data_vq[qid].lock, flags);
 }
 
+/*
+ * Called by the engine after it has added a burst of requests to the data
+ * virtqueue, so that the device is notified once for all of them.
+ */
+static int virtcrypto_dataq_kick(struct crypto_engine *engine)
+{
+	struct virtio_device *vdev = dev_to_virtio(engine->priv_data);
+	struct virtio_crypto *vcrypto = vdev->priv;
+	struct data_queue *data_vq;
+	unsigned long flags;
+	int i;
+
+	for (i = 0; i < vcrypto->max_data_queues; i++) {
+		data_vq = &vcrypto->data_vq[i];
+		if (data_vq->engine != engine)
+			continue;
+
+		spin_lock_irqsave(&data_vq->lock, flags);
+		virtqueue_kick(data_vq->vq);
+		spin_unlock_irqrestore(&data_vq->lock, flags);
+		return 0;
+	}
+
+	return -ENODEV;
+}
+
 static int virtcrypto_find_vqs(struct virtio_crypto *vi)
 {
 	vq_callback_t **callbacks;
@@ -53,6 +79,7 @@ static int virtcrypto_find_vqs(struct virtio_crypto *vi)
 	int i, total_vqs;
 	const char **names;
 	struct device *dev = &vi->vdev->dev;
+	unsigned int max_inflight;
 
 	/*
 	 * We expect 1 data virtqueue, followed by
@@ -93,8 +120,20 @@ static int virtcrypto_find_vqs(struct virtio_crypto *vi)
 	for (i = 0; i < vi->max_data_queues; i++) {
 		spin_lock_init(&vi->data_vq[i].lock);
 		vi->data_vq[i].vq = vqs[i];
+		/*
+		 * With indirect descriptors each request takes a single ring
+		 * entry, so the engine can fill the whole ring before it
+		 * kicks.  Otherwise a request needs an unknown number of
+		 * entries, and only one is passed to the device at a time.
+		 */
+		max_inflight = 1;
+		if (virtio_has_feature(vi->vdev, VIRTIO_RING_F_INDIRECT_DESC))
+			max_inflight = virtqueue_get_vring_size(vqs[i]);
 		/* Initialize crypto engine */
-		vi->data_vq[i].engine = crypto_engine_alloc_init(dev, 1);
+		vi->data_vq[i].engine =
+			crypto_engine_alloc_init_and_set(dev, max_inflight,
+							 virtcrypto_dataq_kick,
+							 1, max_inflight);
 		if (!vi->data_vq[i].engine) {
 			ret = -ENOMEM;
 			goto err_engine;
@@ -78,6 +78,11 @@
  * something better would be fairly complex and since gfx thrashing is a fairly
  * steep cliff not a real concern. Removing a node again is O(1).
  *
+ * Holes are additionally sorted into power-of-two size classes, each with a
+ * list and a bit in a mask of the non-empty classes. DRM_MM_INSERT_FIT looks up
+ * the first class whose holes are all large enough with a single bit search,
+ * where DRM_MM_INSERT_BEST descends the size tree for the exact best fit.
+ *
  * drm_mm supports a few features: Alignment and range restrictions can be
  * supplied. Furthermore every &drm_mm_node has a color value (which is just an
  * opaque unsigned long) which in conjunction with a driver callback can be used
@@ -255,9 +260,16 @@ static void insert_hole_size(struct rb_root_cached *root,
 	rb_insert_color_cached(&node->rb_hole_size, root, first);
 }
 
+/* The class of a hole, all holes in class n are at least 2^n */
+static inline unsigned int hole_class(u64 size)
+{
+	return fls64(size) - 1;
+}
+
 static void add_hole(struct drm_mm_node *node)
 {
 	struct drm_mm *mm = node->mm;
+	unsigned int class;
 
 	node->hole_size =
 		__drm_mm_hole_node_end(node) - __drm_mm_hole_node_start(node);
@@ -267,15 +279,28 @@ static void add_hole(struct drm_mm_node *node)
 	RB_INSERT(mm->holes_addr, rb_hole_addr, HOLE_ADDR);
 
 	list_add(&node->hole_stack, &mm->hole_stack);
+
+	class = hole_class(node->hole_size);
+	list_add(&node->hole_class, &mm->holes_class[class]);
+	mm->holes_class_mask |= BIT_ULL(class);
 }
 
 static void rm_hole(struct drm_mm_node *node)
 {
+	struct drm_mm *mm = node->mm;
+	unsigned int class;
+
 	DRM_MM_BUG_ON(!drm_mm_hole_follows(node));
 
 	list_del(&node->hole_stack);
-	rb_erase_cached(&node->rb_hole_size, &node->mm->holes_size);
-	rb_erase(&node->rb_hole_addr, &node->mm->holes_addr);
+	rb_erase_cached(&node->rb_hole_size, &mm->holes_size);
+	rb_erase(&node->rb_hole_addr, &mm->holes_addr);
+
+	class = hole_class(node->hole_size);
+	list_del(&node->hole_class);
+	if (list_empty(&mm->holes_class[class]))
+		mm->holes_class_mask &= ~BIT_ULL(class);
+
 	node->hole_size = 0;
 
 	DRM_MM_BUG_ON(drm_mm_hole_follows(node));
@@ -338,6 +363,61 @@ static struct drm_mm_node *find_hole(struct drm_mm *mm, u64 addr)
 	return node;
 }
 
+/* The first hole of the smallest non-empty class from @class upwards */
+static struct drm_mm_node *class_hole(struct drm_mm *mm, unsigned int class)
+{
+	u64 mask;
+
+	if (class >= ARRAY_SIZE(mm->holes_class))
+		return NULL;
+
+	mask = mm->holes_class_mask & (~0ull << class);
+	if (!mask)
+		return NULL;
+
+	return list_first_entry(&mm->holes_class[__ffs64(mask)],
+				struct drm_mm_node, hole_class);
+}
+
+static struct drm_mm_node *
+next_fit_hole(struct drm_mm *mm, struct drm_mm_node *node, u64 size)
+{
+	unsigned int class = hole_class(size);
+	struct drm_mm_node *next;
+
+	if (node) {
+		unsigned int node_class = hole_class(node->hole_size);
+
+		if (!list_is_last(&node->hole_class,
+				  &mm->holes_class[node_class]))
+			return list_next_entry(node, hole_class);
+
+		/* That was the last resort */
+		if (node_class == class && !is_power_of_2(size))
+			return NULL;
+
+		next = class_hole(mm, node_class + 1);
+		if (next)
+			return next;
+	}
+
+	if (is_power_of_2(size) || list_empty(&mm->holes_class[class]))
+		return NULL;
+
+	return list_first_entry(&mm->holes_class[class],
+				struct drm_mm_node, hole_class);
+}
+
+/*
+ * Every hole from the class of roundup_pow_of_two(size) upwards fits @size,
+ * so try those first. Only if they are all unsuitable, fall back to the
+ * class of rounddown_pow_of_two(size), where only some of the holes fit.
+ */
+static struct drm_mm_node *fit_hole(struct drm_mm *mm, u64 size)
+{
+	return class_hole(mm, fls64(size - 1)) ?: next_fit_hole(mm, NULL, size);
+}
+
 static struct drm_mm_node *
 first_hole(struct drm_mm *mm,
 	   u64 start, u64 end, u64 size,
@@ -358,12 +438,16 @@ first_hole(struct drm_mm *mm,
 		return list_first_entry_or_null(&mm->hole_stack,
 						struct drm_mm_node,
 						hole_stack);
+
+	case DRM_MM_INSERT_FIT:
+		return fit_hole(mm, size);
 	}
 }
 
 static struct drm_mm_node *
 next_hole(struct drm_mm *mm,
 	  struct drm_mm_node *node,
+	  u64 size,
 	  enum drm_mm_insert_mode mode)
 {
 	switch (mode) {
@@ -380,6 +464,9 @@ next_hole(struct drm_mm *mm,
 	case DRM_MM_INSERT_EVICT:
 		node = list_next_entry(node, hole_stack);
 		return &node->hole_stack == &mm->hole_stack ? NULL : node;
+
+	case DRM_MM_INSERT_FIT:
+		return next_fit_hole(mm, node, size);
 	}
 }
 
@@ -445,6 +532,79 @@ static u64 rb_to_hole_size_or_zero(struct rb_node *rb)
 	return rb ? rb_to_hole_size(rb) : 0;
 }
 
+/*
+ * Try to place @node within @hole, honouring the range, alignment and colour
+ * restrictions. Returns true if @node was inserted.
+ */
+static bool insert_in_hole(struct drm_mm * const mm,
+			   struct drm_mm_node * const hole,
+			   struct drm_mm_node * const node,
+			   u64 size, u64 alignment, u64 remainder_mask,
+			   unsigned long color,
+			   u64 range_start, u64 range_end,
+			   enum drm_mm_insert_mode mode)
+{
+	u64 hole_start = __drm_mm_hole_node_start(hole);
+	u64 hole_end = hole_start + hole->hole_size;
+	u64 adj_start, adj_end;
+	u64 col_start, col_end;
+
+	col_start = hole_start;
+	col_end = hole_end;
+	if (mm->color_adjust)
+		mm->color_adjust(hole, color, &col_start, &col_end);
+
+	adj_start = max(col_start, range_start);
+	adj_end = min(col_end, range_end);
+
+	if (adj_end <= adj_start || adj_end - adj_start < size)
+		return false;
+
+	if (mode == DRM_MM_INSERT_HIGH)
+		adj_start = adj_end - size;
+
+	if (alignment) {
+		u64 rem;
+
+		if (likely(remainder_mask))
+			rem = adj_start & remainder_mask;
+		else
+			div64_u64_rem(adj_start, alignment, &rem);
+		if (rem) {
+			adj_start -= rem;
+			if (mode != DRM_MM_INSERT_HIGH)
+				adj_start += alignment;
+
+			if (adj_start < max(col_start, range_start) ||
+			    min(col_end, range_end) - adj_start < size)
+				return false;
+
+			if (adj_end <= adj_start ||
+			    adj_end - adj_start < size)
+				return false;
+		}
+	}
+
+	node->mm = mm;
+	node->size = size;
+	node->start = adj_start;
+	node->color = color;
+	node->hole_size = 0;
+
+	__set_bit(DRM_MM_NODE_ALLOCATED_BIT, &node->flags);
+	list_add(&node->node_list, &hole->node_list);
+	drm_mm_interval_tree_add_node(hole, node);
+
+	rm_hole(hole);
+	if (adj_start > hole_start)
+		add_hole(hole);
+	if (adj_start + size < hole_end)
+		add_hole(node);
+
+	save_stack(node);
+	return true;
+}
+
 /**
  * drm_mm_insert_node_in_range - ranged search for space and insert @node
  * @mm: drm_mm to allocate from
@@ -489,11 +649,9 @@ int drm_mm_insert_node_in_range(struct drm_mm * const mm,
 	remainder_mask = is_power_of_2(alignment) ? alignment - 1 : 0;
 	for (hole = first_hole(mm, range_start, range_end, size, mode);
 	     hole;
-	     hole = once ? NULL : next_hole(mm, hole, mode)) {
+	     hole = once ? NULL : next_hole(mm, hole, size, mode)) {
 		u64 hole_start = __drm_mm_hole_node_start(hole);
 		u64 hole_end = hole_start + hole->hole_size;
-		u64 adj_start, adj_end;
-		u64 col_start, col_end;
 
 		if (mode == DRM_MM_INSERT_LOW && hole_start >= range_end)
 			break;
@@ -501,65 +659,94 @@ int drm_mm_insert_node_in_range(struct drm_mm * const mm,
 		if (mode == DRM_MM_INSERT_HIGH && hole_end <= range_start)
 			break;
 
-		col_start = hole_start;
-		col_end = hole_end;
-		if (mm->color_adjust)
-			mm->color_adjust(hole, color, &col_start, &col_end);
+		if (insert_in_hole(mm, hole, node,
+				   size, alignment, remainder_mask, color,
+				   range_start, range_end, mode))
+			return 0;
+	}
 
-		adj_start = max(col_start, range_start);
-		adj_end = min(col_end, range_end);
+	return -ENOSPC;
+}
+EXPORT_SYMBOL(drm_mm_insert_node_in_range);
 
-		if (adj_end <= adj_start || adj_end - adj_start < size)
-			continue;
+/**
+ * drm_mm_insert_nodes_in_range - ranged search for space and insert @nodes
+ * @mm: drm_mm to allocate from
+ * @nodes: preallocated nodes to insert
+ * @count: number of @nodes
+ * @size: size of each allocation
+ * @alignment: alignment of each allocation
+ * @color: opaque tag value to use for the nodes
+ * @start: start of the allowed range for the nodes
+ * @end: end of the allowed range for the nodes
+ * @mode: fine-tune the allocation search and placement
+ *
+ * Inserts @count nodes of the same size, like as many calls to
+ * drm_mm_insert_node_in_range(). Each node after the first is placed next to
+ * the previous one (above it, or below for DRM_MM_INSERT_HIGH) if the rest of
+ * that hole allows, keeping the batch together and saving the search for
+ * most nodes. Either all of @nodes are inserted or none are.
+ *
+ * The preallocated @nodes must be cleared to 0.
+ *
+ * Returns:
+ * 0 on success, -ENOSPC if there's no suitable hole for one of the nodes.
+ */
+int drm_mm_insert_nodes_in_range(struct drm_mm *mm,
+				 struct drm_mm_node **nodes,
+				 unsigned int count,
+				 u64 size,
+				 u64 alignment,
+				 unsigned long color,
+				 u64 start,
+				 u64 end,
+				 enum drm_mm_insert_mode mode)
+{
+	enum drm_mm_insert_mode search = mode & ~DRM_MM_INSERT_ONCE;
+	struct drm_mm_node *prev = NULL;
+	u64 remainder_mask;
+	unsigned int n;
+	int err;
 
-		if (mode == DRM_MM_INSERT_HIGH)
-			adj_start = adj_end - size;
+	if (alignment <= 1)
+		alignment = 0;
+	remainder_mask = is_power_of_2(alignment) ? alignment - 1 : 0;
 
-		if (alignment) {
-			u64 rem;
+	for (n = 0; n < count; n++) {
+		struct drm_mm_node *node = nodes[n];
 
-			if (likely(remainder_mask))
-				rem = adj_start & remainder_mask;
-			else
-				div64_u64_rem(adj_start, alignment, &rem);
-			if (rem) {
-				adj_start -= rem;
-				if (mode != DRM_MM_INSERT_HIGH)
-					adj_start += alignment;
+		if (prev) {
+			struct drm_mm_node *hole = prev;
 
-				if (adj_start < max(col_start, range_start) ||
-				    min(col_end, range_end) - adj_start < size)
-					continue;
+			if (search == DRM_MM_INSERT_HIGH)
+				hole = list_prev_entry(prev, node_list);
 
-				if (adj_end <= adj_start ||
-				    adj_end - adj_start < size)
-					continue;
+			if (drm_mm_hole_follows(hole) &&
+			    insert_in_hole(mm, hole, node,
+					   size, alignment, remainder_mask,
+					   color, start, end, search)) {
+				prev = node;
+				continue;
 			}
 		}
 
-		node->mm = mm;
-		node->size = size;
-		node->start = adj_start;
-		node->color = color;
-		node->hole_size = 0;
-
-		__set_bit(DRM_MM_NODE_ALLOCATED_BIT, &node->flags);
-		list_add(&node->node_list, &hole->node_list);
-		drm_mm_interval_tree_add_node(hole, node);
+		err = drm_mm_insert_node_in_range(mm, node,
+						  size, alignment, color,
+						  start, end, mode);
+		if (err)
+			goto err_remove;
 
-		rm_hole(hole);
-		if (adj_start > hole_start)
-			add_hole(hole);
-		if (adj_start + size < hole_end)
-			add_hole(node);
-
-		save_stack(node);
-		return 0;
+		prev = node;
 	}
 
-	return -ENOSPC;
+	return 0;
+
+err_remove:
+	while (n--)
+		drm_mm_remove_node(nodes[n]);
+	return err;
 }
-EXPORT_SYMBOL(drm_mm_insert_node_in_range);
+EXPORT_SYMBOL(drm_mm_insert_nodes_in_range);
 
 static inline bool drm_mm_node_scanned_block(const struct drm_mm_node *node)
 {
@@ -621,6 +808,7 @@ void drm_mm_replace_node(struct drm_mm_node *old, struct drm_mm_node *new)
 
 	if (drm_mm_hole_follows(old)) {
 		list_replace(&old->hole_stack, &new->hole_stack);
+		list_replace(&old->hole_class, &new->hole_class);
 		rb_replace_node_cached(&old->rb_hole_size,
 				       &new->rb_hole_size,
 				       &mm->holes_size);
@@ -912,6 +1100,8 @@ EXPORT_SYMBOL(drm_mm_scan_color_evict);
  */
 void drm_mm_init(struct drm_mm *mm, u64 start, u64 size)
 {
+	int i;
+
 	DRM_MM_BUG_ON(start + size <= start);
 
 	mm->color_adjust = NULL;
@@ -920,6 +1110,9 @@ void drm_mm_init(struct drm_mm *mm, u64 start, u64 size)
 	mm->interval_tree = RB_ROOT_CACHED;
 	mm->holes_size = RB_ROOT_CACHED;
 	mm->holes_addr = RB_ROOT;
+	for (i = 0; i < ARRAY_SIZE(mm->holes_class); i++)
+		INIT_LIST_HEAD(&mm->holes_class[i]);
+	mm->holes_class_mask = 0;
 
 	/* Clever trick to avoid a special case in the free hole tracking. */
 	INIT_LIST_HEAD(&mm->head_node.node_list);
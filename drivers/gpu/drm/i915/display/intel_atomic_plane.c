@@ -357,8 +357,8 @@ void intel_disable_plane(struct intel_plane *plane,
 	plane->disable_plane(plane, crtc_state);
 }
 
-void skl_update_planes_on_crtc(struct intel_atomic_state *state,
-			       struct intel_crtc *crtc)
+static void skl_commit_planes_on_crtc(struct intel_atomic_state *state,
+				      struct intel_crtc *crtc, u32 plane_mask)
 {
 	struct intel_crtc_state *old_crtc_state =
 		intel_atomic_get_old_crtc_state(state, crtc);
@@ -380,6 +380,9 @@ void skl_update_planes_on_crtc(struct intel_atomic_state *state,
 		struct intel_plane_state *new_plane_state =
 			intel_atomic_get_new_plane_state(state, plane);
 
+		if (!(plane_mask & BIT(plane->id)))
+			continue;
+
 		if (new_plane_state->uapi.visible ||
 		    new_plane_state->planar_slave) {
 			intel_update_plane(plane, new_crtc_state, new_plane_state);
@@ -389,6 +392,88 @@ void skl_update_planes_on_crtc(struct intel_atomic_state *state,
 	}
 }
 
+/*
+ * Record the universal plane updates in the crtc's DSB ahead of the vblank
+ * evasion critical section, which then only has to start the DSB. The
+ * cursor keeps being programmed with MMIO from the critical section, its
+ * registers are shared with the legacy cursor fast path.
+ *
+ * The command buffer is allocated on the first update of an active crtc
+ * and kept until the crtc is disabled, so a flip only records into it.
+ */
+void skl_record_planes_on_crtc(struct intel_atomic_state *state,
+			       struct intel_crtc *crtc)
+{
+	struct drm_i915_private *dev_priv = to_i915(state->base.dev);
+	struct intel_crtc_state *new_crtc_state =
+		intel_atomic_get_new_crtc_state(state, crtc);
+	struct intel_dsb *dsb = &crtc->dsb;
+
+	if (!HAS_DSB(dev_priv) || !i915_modparams.enable_dsb_planes ||
+	    intel_vgpu_active(dev_priv))
+		return;
+
+	if (!(new_crtc_state->update_planes & ~BIT(PLANE_CURSOR)))
+		return;
+
+	if (!crtc->dsb_planes) {
+		/* without a buffer the writes would go to the hardware now */
+		dsb = intel_dsb_get(crtc);
+		if (!dsb->cmd_buf)
+			return;
+
+		crtc->dsb_planes = true;
+	}
+
+	new_crtc_state->dsb = dsb;
+	skl_commit_planes_on_crtc(state, crtc, new_crtc_state->update_planes &
+				  ~BIT(PLANE_CURSOR));
+}
+
+void skl_update_planes_on_crtc(struct intel_atomic_state *state,
+			       struct intel_crtc *crtc)
+{
+	struct intel_crtc_state *new_crtc_state =
+		intel_atomic_get_new_crtc_state(state, crtc);
+	struct intel_dsb *dsb = new_crtc_state->dsb;
+
+	if (!dsb) {
+		skl_commit_planes_on_crtc(state, crtc,
+					  new_crtc_state->update_planes);
+		return;
+	}
+
+	skl_commit_planes_on_crtc(state, crtc, BIT(PLANE_CURSOR));
+
+	crtc->debug.dsb_bytes = dsb->free_pos * sizeof(u32);
+	intel_dsb_commit_nowait(dsb);
+}
+
+/*
+ * Wait for the DSB started by skl_update_planes_on_crtc(), once out of the
+ * vblank evasion critical section, before the buffer can be recorded into
+ * again.
+ */
+void skl_wait_planes_on_crtc(struct intel_atomic_state *state,
+			     struct intel_crtc *crtc)
+{
+	struct intel_crtc_state *new_crtc_state =
+		intel_atomic_get_new_crtc_state(state, crtc);
+
+	if (new_crtc_state->dsb)
+		intel_dsb_wait(new_crtc_state->dsb);
+}
+
+/* Drop the DSB reference taken by skl_record_planes_on_crtc(). */
+void skl_release_planes_dsb(struct intel_crtc *crtc)
+{
+	if (!crtc->dsb_planes)
+		return;
+
+	crtc->dsb_planes = false;
+	intel_dsb_put(&crtc->dsb);
+}
+
 void i9xx_update_planes_on_crtc(struct intel_atomic_state *state,
 				struct intel_crtc *crtc)
 {
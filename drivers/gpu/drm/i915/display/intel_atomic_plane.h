@@ -32,8 +32,13 @@ void intel_plane_free(struct intel_plane *plane);
 struct drm_plane_state *intel_plane_duplicate_state(struct drm_plane *plane);
 void intel_plane_destroy_state(struct drm_plane *plane,
 			       struct drm_plane_state *state);
+void skl_record_planes_on_crtc(struct intel_atomic_state *state,
+			       struct intel_crtc *crtc);
+void skl_release_planes_dsb(struct intel_crtc *crtc);
 void skl_update_planes_on_crtc(struct intel_atomic_state *state,
 			       struct intel_crtc *crtc);
+void skl_wait_planes_on_crtc(struct intel_atomic_state *state,
+			     struct intel_crtc *crtc);
 void i9xx_update_planes_on_crtc(struct intel_atomic_state *state,
 				struct intel_crtc *crtc);
 int intel_plane_atomic_check_with_state(const struct intel_crtc_state *old_crtc_state,
@@ -7637,6 +7637,7 @@ static void intel_crtc_disable_noatomic(struct drm_crtc *crtc,
 	WARN_ON(drm_atomic_set_mode_for_crtc(crtc->state, NULL) < 0);
 	crtc->state->active = false;
 	intel_crtc->active = false;
+	skl_release_planes_dsb(intel_crtc);
 	crtc->enabled = false;
 	crtc->state->connector_mask = 0;
 	crtc->state->encoder_mask = 0;
@@ -12273,6 +12274,7 @@ static void intel_crtc_destroy(struct drm_crtc *crtc)
 {
 	struct intel_crtc *intel_crtc = to_intel_crtc(crtc);
 
+	skl_release_planes_dsb(intel_crtc);
 	drm_crtc_cleanup(crtc);
 	kfree(intel_crtc);
 }
@@ -14866,6 +14868,9 @@ static void intel_update_crtc(struct intel_crtc *crtc,
 	else if (new_plane_state)
 		intel_fbc_enable(crtc, new_crtc_state, new_plane_state);
 
+	if (INTEL_GEN(dev_priv) >= 9)
+		skl_record_planes_on_crtc(state, crtc);
+
 	/* Perform vblank evasion around commit operation */
 	intel_pipe_update_start(new_crtc_state);
 
@@ -14878,6 +14883,9 @@ static void intel_update_crtc(struct intel_crtc *crtc,
 
 	intel_pipe_update_end(new_crtc_state);
 
+	if (INTEL_GEN(dev_priv) >= 9)
+		skl_wait_planes_on_crtc(state, crtc);
+
 	/*
 	 * We usually enable FIFO underrun interrupts as part of the
 	 * CRTC enable sequence during modesets.  But when we inherit a
@@ -14918,6 +14926,7 @@ static void intel_old_crtc_state_disables(struct intel_atomic_state *state,
 
 	dev_priv->display.crtc_disable(old_crtc_state, state);
 	crtc->active = false;
+	skl_release_planes_dsb(crtc);
 	intel_fbc_disable(crtc);
 	intel_disable_shared_dpll(old_crtc_state);
 
@@ -15039,11 +15048,14 @@ static void intel_post_crtc_enable_updates(struct intel_crtc *crtc,
 	else if (new_plane_state)
 		intel_fbc_enable(crtc, new_crtc_state, new_plane_state);
 
+	skl_record_planes_on_crtc(state, crtc);
+
 	/* Perform vblank evasion around commit operation */
 	intel_pipe_update_start(new_crtc_state);
 	commit_pipe_config(state, old_crtc_state, new_crtc_state);
 	skl_update_planes_on_crtc(state, crtc);
 	intel_pipe_update_end(new_crtc_state);
+	skl_wait_planes_on_crtc(state, crtc);
 
 	/*
 	 * We usually enable FIFO underrun interrupts as part of the
@@ -1013,6 +1013,9 @@ struct intel_crtc_state {
 	/* bitmask of planes that will be updated during the commit */
 	u8 update_planes;
 
+	/* plane and watermark writes are recorded here, if not NULL */
+	struct intel_dsb *dsb;
+
 	struct {
 		u32 enable;
 		u32 gcp;
@@ -1095,6 +1098,7 @@ struct intel_crtc {
 		ktime_t start_vbl_time;
 		int min_vbl, max_vbl;
 		int scanline_start;
+		unsigned int dsb_bytes;
 	} debug;
 
 	/* scalers available on this crtc */
@@ -1102,6 +1106,9 @@ struct intel_crtc {
 
 	/* per pipe DSB related info */
 	struct intel_dsb dsb;
+
+	/* plane updates hold a reference on the DSB until the crtc is off */
+	bool dsb_planes;
 };
 
 struct intel_plane {
@@ -9,6 +9,9 @@
 
 #define DSB_BUF_SIZE    (2 * PAGE_SIZE)
 
+/* Leaves room for the largest instruction and its padding, in dwords */
+#define DSB_BUF_END	(DSB_BUF_SIZE / sizeof(u32) - 4)
+
 /**
  * DOC: DSB
  *
@@ -24,6 +27,12 @@
  *
  * DSB HW can support only register writes (both indexed and direct MMIO
  * writes). There are no registers reads possible with DSB HW engine.
+ *
+ * Besides LUT loads, the plane and watermark registers of a commit are
+ * recorded ahead of the vblank evasion critical section, which then only
+ * has to start the DSB. The double buffered registers still latch at the
+ * next vblank, as with MMIO, and the DSB is waited upon once the critical
+ * section is over.
  */
 
 /* DSB opcodes. */
@@ -116,6 +125,7 @@ intel_dsb_get(struct intel_crtc *crtc)
 	obj = i915_gem_object_create_internal(i915, DSB_BUF_SIZE);
 	if (IS_ERR(obj)) {
 		DRM_ERROR("Gem object creation failed\n");
+		atomic_dec(&dsb->refcount);
 		goto err;
 	}
 
@@ -195,7 +205,7 @@ void intel_dsb_indexed_reg_write(struct intel_dsb *dsb, i915_reg_t reg,
 		return;
 	}
 
-	if (WARN_ON(dsb->free_pos >= DSB_BUF_SIZE)) {
+	if (WARN_ON(dsb->free_pos >= DSB_BUF_END)) {
 		DRM_DEBUG_KMS("DSB buffer overflow\n");
 		return;
 	}
@@ -269,7 +279,7 @@ void intel_dsb_reg_write(struct intel_dsb *dsb, i915_reg_t reg, u32 val)
 		return;
 	}
 
-	if (WARN_ON(dsb->free_pos >= DSB_BUF_SIZE)) {
+	if (WARN_ON(dsb->free_pos >= DSB_BUF_END)) {
 		DRM_DEBUG_KMS("DSB buffer overflow\n");
 		return;
 	}
@@ -281,30 +291,48 @@ void intel_dsb_reg_write(struct intel_dsb *dsb, i915_reg_t reg, u32 val)
 			       i915_mmio_reg_offset(reg);
 }
 
-/**
- * intel_dsb_commit() - Trigger workload execution of DSB.
- * @dsb: intel_dsb structure.
- *
- * This function is used to do actual write to hardware using DSB.
- * On errors, fall back to MMIO. Also this function help to reset the context.
- */
-void intel_dsb_commit(struct intel_dsb *dsb)
+/* Replay the recorded writes, for when the DSB engine can't be used. */
+static void intel_dsb_mmio_fallback(struct intel_dsb *dsb)
 {
 	struct intel_crtc *crtc = container_of(dsb, typeof(*crtc), dsb);
-	struct drm_device *dev = crtc->base.dev;
-	struct drm_i915_private *dev_priv = to_i915(dev);
+	struct drm_i915_private *dev_priv = to_i915(crtc->base.dev);
+	const u32 *buf = dsb->cmd_buf;
+	unsigned long irqflags;
+	int i = 0;
+
+	spin_lock_irqsave(&dev_priv->uncore.lock, irqflags);
+
+	while (i < dsb->free_pos) {
+		i915_reg_t reg = _MMIO(buf[i + 1] & DSB_REG_VALUE_MASK);
+		u32 n;
+
+		if (buf[i + 1] >> DSB_OPCODE_SHIFT != DSB_OPCODE_INDEXED_WRITE) {
+			I915_WRITE_FW(reg, buf[i]);
+			i += 2;
+			continue;
+		}
+
+		for (n = 0; n < buf[i]; n++)
+			I915_WRITE_FW(reg, buf[i + 2 + n]);
+		i = ALIGN(i + 2 + buf[i], 2);
+	}
+
+	spin_unlock_irqrestore(&dev_priv->uncore.lock, irqflags);
+}
+
+static bool intel_dsb_start(struct intel_dsb *dsb)
+{
+	struct intel_crtc *crtc = container_of(dsb, typeof(*crtc), dsb);
+	struct drm_i915_private *dev_priv = to_i915(crtc->base.dev);
 	enum pipe pipe = crtc->pipe;
 	u32 tail;
 
-	if (!dsb->free_pos)
-		return;
-
 	if (!intel_dsb_enable_engine(dsb))
-		goto reset;
+		return false;
 
 	if (is_dsb_busy(dsb)) {
 		DRM_ERROR("HEAD_PTR write failed - dsb engine is busy.\n");
-		goto reset;
+		return false;
 	}
 	I915_WRITE(DSB_HEAD(pipe, dsb->id), i915_ggtt_offset(dsb->vma));
 
@@ -315,18 +343,72 @@ void intel_dsb_commit(struct intel_dsb *dsb)
 
 	if (is_dsb_busy(dsb)) {
 		DRM_ERROR("TAIL_PTR write failed - dsb engine is busy.\n");
-		goto reset;
+		return false;
 	}
 	DRM_DEBUG_KMS("DSB execution started - head 0x%x, tail 0x%x\n",
 		      i915_ggtt_offset(dsb->vma), tail);
 	I915_WRITE(DSB_TAIL(pipe, dsb->id), i915_ggtt_offset(dsb->vma) + tail);
-	if (wait_for(!is_dsb_busy(dsb), 1)) {
-		DRM_ERROR("Timed out waiting for DSB workload completion.\n");
-		goto reset;
-	}
 
-reset:
+	return true;
+}
+
+static void intel_dsb_reset(struct intel_dsb *dsb)
+{
 	dsb->free_pos = 0;
 	dsb->ins_start_offset = 0;
 	intel_dsb_disable_engine(dsb);
 }
+
+/**
+ * intel_dsb_commit_nowait() - Start workload execution of DSB.
+ * @dsb: intel_dsb structure.
+ *
+ * This function starts the DSB on the recorded writes and returns at once,
+ * so that it can be called from the vblank evasion critical section. The
+ * context is kept until intel_dsb_wait() is called. If the DSB can't be
+ * started, the writes are done through MMIO and the context is reset.
+ */
+void intel_dsb_commit_nowait(struct intel_dsb *dsb)
+{
+	if (!dsb->free_pos)
+		return;
+
+	if (!intel_dsb_start(dsb)) {
+		intel_dsb_mmio_fallback(dsb);
+		intel_dsb_reset(dsb);
+	}
+}
+
+/**
+ * intel_dsb_wait() - Wait for the DSB started by intel_dsb_commit_nowait().
+ * @dsb: intel_dsb structure.
+ *
+ * This function waits for the DSB to go idle and resets the context. If
+ * it doesn't, the writes are replayed through MMIO, so that the hardware
+ * doesn't keep a half programmed state.
+ */
+void intel_dsb_wait(struct intel_dsb *dsb)
+{
+	if (!dsb->free_pos)
+		return;
+
+	if (wait_for(!is_dsb_busy(dsb), 1)) {
+		DRM_ERROR("Timed out waiting for DSB workload completion.\n");
+		intel_dsb_mmio_fallback(dsb);
+	}
+
+	intel_dsb_reset(dsb);
+}
+
+/**
+ * intel_dsb_commit() - Trigger workload execution of DSB.
+ * @dsb: intel_dsb structure.
+ *
+ * This function is used to do actual write to hardware using DSB.
+ * On errors, fall back to MMIO. Also this function help to reset the context.
+ */
+void intel_dsb_commit(struct intel_dsb *dsb)
+{
+	intel_dsb_commit_nowait(dsb);
+	intel_dsb_wait(dsb);
+}
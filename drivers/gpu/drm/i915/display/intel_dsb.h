@@ -48,5 +48,7 @@ void intel_dsb_reg_write(struct intel_dsb *dsb, i915_reg_t reg, u32 val);
 void intel_dsb_indexed_reg_write(struct intel_dsb *dsb, i915_reg_t reg,
 				 u32 val);
 void intel_dsb_commit(struct intel_dsb *dsb);
+void intel_dsb_commit_nowait(struct intel_dsb *dsb);
+void intel_dsb_wait(struct intel_dsb *dsb);
 
 #endif
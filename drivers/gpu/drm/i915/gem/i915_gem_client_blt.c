@@ -142,6 +142,9 @@ static void clear_pages_dma_fence_cb(struct dma_fence *fence,
 {
 	struct clear_pages_work *w = container_of(cb, typeof(*w), cb);
 
+	/* The blitter is done with the pages */
+	i915_gem_object_unpin_pages(w->sleeve->vma->obj);
+
 	if (fence->error)
 		dma_fence_set_error(&w->dma, fence->error);
 
@@ -228,6 +231,7 @@ static void clear_pages_worker(struct work_struct *work)
 	i915_vma_unpin(vma);
 out_signal:
 	if (unlikely(err)) {
+		i915_gem_object_unpin_pages(obj);
 		dma_fence_set_error(&w->dma, err);
 		dma_fence_signal(&w->dma);
 		dma_fence_put(&w->dma);
@@ -255,7 +259,12 @@ clear_pages_work_notify(struct i915_sw_fence *fence,
 
 static DEFINE_SPINLOCK(fence_lock);
 
-/* XXX: better name please */
+/*
+ * XXX: better name please
+ *
+ * @pages must be the pages of @obj, they are kept pinned until the fill
+ * has completed.
+ */
 int i915_gem_schedule_fill_pages_blt(struct drm_i915_gem_object *obj,
 				     struct intel_context *ce,
 				     struct sg_table *pages,
@@ -280,6 +289,9 @@ int i915_gem_schedule_fill_pages_blt(struct drm_i915_gem_object *obj,
 	work->sleeve = sleeve;
 	work->ce = ce;
 
+	/* Keep the pages until the fill completes, see clear_pages_dma_fence_cb */
+	__i915_gem_object_pin_pages(obj);
+
 	INIT_WORK(&work->work, clear_pages_worker);
 
 	init_irq_work(&work->irq_work, clear_pages_signal_irq_worker);
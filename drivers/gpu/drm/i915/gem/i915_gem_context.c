@@ -96,6 +96,16 @@ void i915_lut_handle_free(struct i915_lut_handle *lut)
 	return kmem_cache_free(global.slab_luts, lut);
 }
 
+static void eb_lists_free(struct i915_gem_context *ctx)
+{
+	struct i915_eb_list *list, *ln;
+
+	list_for_each_entry_safe(list, ln, &ctx->eb_lists, link)
+		kvfree(list);
+	INIT_LIST_HEAD(&ctx->eb_lists);
+	ctx->eb_list_count = 0;
+}
+
 static void lut_close(struct i915_gem_context *ctx)
 {
 	struct radix_tree_iter iter;
@@ -103,6 +113,8 @@ static void lut_close(struct i915_gem_context *ctx)
 
 	lockdep_assert_held(&ctx->mutex);
 
+	eb_lists_free(ctx);
+
 	rcu_read_lock();
 	radix_tree_for_each_slot(slot, &ctx->handles_vma, &iter, 0) {
 		struct i915_vma *vma = rcu_dereference_raw(*slot);
@@ -516,6 +528,7 @@ __create_context(struct drm_i915_private *i915)
 	RCU_INIT_POINTER(ctx->engines, e);
 
 	INIT_RADIX_TREE(&ctx->handles_vma, GFP_KERNEL);
+	INIT_LIST_HEAD(&ctx->eb_lists);
 
 	/* NB: Mark all slices as needing a remap so that when the context first
 	 * loads it will restore whatever remap state already exists. If there
@@ -26,6 +26,7 @@ struct pid;
 struct drm_i915_private;
 struct drm_i915_file_private;
 struct i915_address_space;
+struct i915_vma;
 struct intel_timeline;
 struct intel_ring;
 
@@ -35,6 +36,18 @@ struct i915_gem_engines {
 	struct intel_context *engines[];
 };
 
+/*
+ * The handles of an execbuf and the vmas they resolved to, so that submitting
+ * the same buffer list again skips looking each of them up.
+ */
+struct i915_eb_list {
+	struct list_head link;
+	u32 handles_seqno;
+	unsigned int count;
+	u32 *handles;
+	struct i915_vma *vma[];
+};
+
 struct i915_gem_engines_iter {
 	unsigned int idx;
 	const struct i915_gem_engines *engines;
@@ -177,6 +190,16 @@ struct i915_gem_context {
 	 */
 	struct radix_tree_root handles_vma;
 
+	/**
+	 * @eb_lists: buffer lists of recent execbufs, most recent first.
+	 * Guarded by @mutex, and only valid while @handles_seqno is what it
+	 * was when they were added: it is bumped on every handle removed from
+	 * @handles_vma.
+	 */
+	struct list_head eb_lists;
+	unsigned int eb_list_count;
+	u32 handles_seqno;
+
 	/** jump_whitelist: Bit array for tracking cmds during cmdparsing
 	 *  Guarded by struct_mutex
 	 */
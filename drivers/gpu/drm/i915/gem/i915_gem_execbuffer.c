@@ -5,6 +5,7 @@
  */
 
 #include <linux/intel-iommu.h>
+#include <linux/dma-fence-chain.h>
 #include <linux/dma-resv.h>
 #include <linux/sync_file.h>
 #include <linux/uaccess.h>
@@ -26,6 +27,7 @@
 #include "i915_gem_context.h"
 #include "i915_gem_ioctls.h"
 #include "i915_trace.h"
+#include "i915_user_extensions.h"
 
 enum {
 	FORCE_CPU_RELOC = 1,
@@ -273,6 +275,15 @@ struct i915_execbuffer {
 	 */
 	int lut_size;
 	struct hlist_head *buckets; /** ht for relocation handles */
+
+	struct eb_fence *fences; /** syncobj to wait upon or signal */
+	unsigned long num_fences;
+};
+
+struct eb_fence {
+	struct drm_syncobj *syncobj; /* Use with ptr_mask_bits() */
+	struct dma_fence_chain *chain_fence; /* preallocated timeline point */
+	u64 value;
 };
 
 #define exec_entry(EB, VMA) (&(EB)->exec[(VMA)->exec_flags - (EB)->flags])
@@ -742,10 +753,86 @@ static int eb_select_context(struct i915_execbuffer *eb)
 	return 0;
 }
 
+/*
+ * Clients tend to submit the same large set of buffers over and over, e.g.
+ * every frame. The last few buffer lists of a context are kept along with
+ * the vmas their handles resolved to, and resubmitting one of them skips
+ * looking up every handle in handles_vma.
+ */
+#define EB_LIST_MIN_COUNT 32
+#define EB_LIST_MAX 4
+
+static struct i915_eb_list *eb_find_list(struct i915_execbuffer *eb)
+{
+	struct i915_gem_context *ctx = eb->gem_context;
+	struct i915_eb_list *list;
+	unsigned int i;
+
+	if (eb->buffer_count < EB_LIST_MIN_COUNT)
+		return NULL;
+
+	list_for_each_entry(list, &ctx->eb_lists, link) {
+		if (list->handles_seqno != ctx->handles_seqno ||
+		    list->count != eb->buffer_count)
+			continue;
+
+		for (i = 0; i < list->count; i++) {
+			if (list->handles[i] != eb->exec[i].handle)
+				break;
+		}
+		if (i < list->count)
+			continue;
+
+		list_move(&list->link, &ctx->eb_lists);
+		return list;
+	}
+
+	return NULL;
+}
+
+static void eb_add_list(struct i915_execbuffer *eb)
+{
+	struct i915_gem_context *ctx = eb->gem_context;
+	const unsigned int count = eb->buffer_count;
+	struct i915_eb_list *list, *ln;
+	unsigned int i;
+
+	if (count < EB_LIST_MIN_COUNT)
+		return;
+
+	/* Drop the lists a closed handle invalidated, then the oldest */
+	list_for_each_entry_safe_reverse(list, ln, &ctx->eb_lists, link) {
+		if (list->handles_seqno == ctx->handles_seqno &&
+		    ctx->eb_list_count < EB_LIST_MAX)
+			continue;
+
+		list_del(&list->link);
+		kvfree(list);
+		ctx->eb_list_count--;
+	}
+
+	list = kvmalloc(struct_size(list, vma, count) + count * sizeof(u32),
+			GFP_KERNEL | __GFP_NOWARN);
+	if (!list)
+		return;
+
+	list->handles_seqno = ctx->handles_seqno;
+	list->count = count;
+	list->handles = (u32 *)(list->vma + count);
+	for (i = 0; i < count; i++) {
+		list->handles[i] = eb->exec[i].handle;
+		list->vma[i] = eb->vma[i];
+	}
+
+	list_add(&list->link, &ctx->eb_lists);
+	ctx->eb_list_count++;
+}
+
 static int eb_lookup_vmas(struct i915_execbuffer *eb)
 {
 	struct radix_tree_root *handles_vma = &eb->gem_context->handles_vma;
 	struct drm_i915_gem_object *obj;
+	struct i915_eb_list *list;
 	unsigned int i, batch;
 	int err;
 
@@ -763,11 +850,17 @@ static int eb_lookup_vmas(struct i915_execbuffer *eb)
 		goto err_ctx;
 	}
 
+	list = eb_find_list(eb);
 	for (i = 0; i < eb->buffer_count; i++) {
 		u32 handle = eb->exec[i].handle;
 		struct i915_lut_handle *lut;
 		struct i915_vma *vma;
 
+		if (list) {
+			vma = list->vma[i];
+			goto add_vma;
+		}
+
 		vma = radix_tree_lookup(handles_vma, handle);
 		if (likely(vma))
 			goto add_vma;
@@ -817,6 +910,8 @@ static int eb_lookup_vmas(struct i915_execbuffer *eb)
 			   eb_vma_misplaced(&eb->exec[i], vma, eb->flags[i]));
 	}
 
+	if (!list)
+		eb_add_list(eb);
 	mutex_unlock(&eb->gem_context->mutex);
 
 	eb->args->flags |= __EXEC_VALIDATED;
@@ -1952,11 +2047,20 @@ static bool i915_gem_check_execbuffer(struct drm_i915_gem_execbuffer2 *exec)
 		return false;
 
 	/* Kernel clipping was a DRI1 misfeature */
-	if (!(exec->flags & I915_EXEC_FENCE_ARRAY)) {
+	if (!(exec->flags & (I915_EXEC_FENCE_ARRAY |
+			     I915_EXEC_USE_EXTENSIONS))) {
 		if (exec->num_cliprects || exec->cliprects_ptr)
 			return false;
 	}
 
+	/* The extension chain reuses cliprects_ptr, num_cliprects is unused */
+	if (exec->flags & I915_EXEC_USE_EXTENSIONS) {
+		if (exec->flags & I915_EXEC_FENCE_ARRAY)
+			return false;
+		if (exec->num_cliprects)
+			return false;
+	}
+
 	if (exec->DR4 == 0xffffffff) {
 		DRM_DEBUG("UXA submitting garbage DR4, fixing up\n");
 		exec->DR4 = 0;
@@ -2354,98 +2458,213 @@ eb_pin_engine(struct i915_execbuffer *eb,
 }
 
 static void
-__free_fence_array(struct drm_syncobj **fences, unsigned int n)
+__free_fence_array(struct eb_fence *fences, unsigned int n)
 {
-	while (n--)
-		drm_syncobj_put(ptr_mask_bits(fences[n], 2));
+	while (n--) {
+		drm_syncobj_put(ptr_mask_bits(fences[n].syncobj, 2));
+		kfree(fences[n].chain_fence);
+	}
 	kvfree(fences);
 }
 
-static struct drm_syncobj **
-get_fence_array(struct drm_i915_gem_execbuffer2 *args,
-		struct drm_file *file)
+static void
+put_fence_array(struct i915_execbuffer *eb)
+{
+	if (eb->fences)
+		__free_fence_array(eb->fences, eb->num_fences);
+}
+
+static int
+add_fence(struct i915_execbuffer *eb, struct eb_fence *f,
+	  const struct drm_i915_gem_exec_fence *fence, u64 point)
+{
+	struct drm_syncobj *syncobj;
+
+	if (fence->flags & __I915_EXEC_FENCE_UNKNOWN_FLAGS)
+		return -EINVAL;
+
+	syncobj = drm_syncobj_find(eb->file, fence->handle);
+	if (!syncobj) {
+		DRM_DEBUG("Invalid syncobj handle provided\n");
+		return -ENOENT;
+	}
+
+	f->chain_fence = NULL;
+	if (point && fence->flags & I915_EXEC_FENCE_SIGNAL) {
+		/* A request cannot wait upon the point it signals */
+		if (fence->flags & I915_EXEC_FENCE_WAIT) {
+			DRM_DEBUG("Trying to wait & signal the same timeline point\n");
+			drm_syncobj_put(syncobj);
+			return -EINVAL;
+		}
+
+		/*
+		 * Allocate the chain node now so that, once the request is
+		 * submitted, adding the point cannot fail.
+		 */
+		f->chain_fence = kmalloc(sizeof(*f->chain_fence), GFP_KERNEL);
+		if (!f->chain_fence) {
+			drm_syncobj_put(syncobj);
+			return -ENOMEM;
+		}
+	}
+
+	BUILD_BUG_ON(~(ARCH_KMALLOC_MINALIGN - 1) &
+		     ~__I915_EXEC_FENCE_UNKNOWN_FLAGS);
+
+	f->syncobj = ptr_pack_bits(syncobj, fence->flags, 2);
+	f->value = point;
+	return 0;
+}
+
+static struct eb_fence *
+alloc_fence_array(unsigned long nfences, size_t user_size)
+{
+	/* Check multiplication overflow for access_ok() and kvmalloc_array() */
+	BUILD_BUG_ON(sizeof(size_t) > sizeof(unsigned long));
+	if (nfences > min_t(unsigned long,
+			    ULONG_MAX / user_size,
+			    SIZE_MAX / sizeof(struct eb_fence)))
+		return ERR_PTR(-EINVAL);
+
+	return kvmalloc_array(nfences, sizeof(struct eb_fence),
+			      __GFP_NOWARN | GFP_KERNEL) ?: ERR_PTR(-ENOMEM);
+}
+
+static int
+get_fence_array(struct i915_execbuffer *eb)
 {
+	struct drm_i915_gem_execbuffer2 *args = eb->args;
 	const unsigned long nfences = args->num_cliprects;
 	struct drm_i915_gem_exec_fence __user *user;
-	struct drm_syncobj **fences;
+	struct eb_fence *fences;
 	unsigned long n;
 	int err;
 
 	if (!(args->flags & I915_EXEC_FENCE_ARRAY))
-		return NULL;
+		return 0;
 
-	/* Check multiplication overflow for access_ok() and kvmalloc_array() */
-	BUILD_BUG_ON(sizeof(size_t) > sizeof(unsigned long));
-	if (nfences > min_t(unsigned long,
-			    ULONG_MAX / sizeof(*user),
-			    SIZE_MAX / sizeof(*fences)))
-		return ERR_PTR(-EINVAL);
+	fences = alloc_fence_array(nfences, sizeof(*user));
+	if (IS_ERR(fences))
+		return PTR_ERR(fences);
 
 	user = u64_to_user_ptr(args->cliprects_ptr);
-	if (!access_ok(user, nfences * sizeof(*user)))
-		return ERR_PTR(-EFAULT);
-
-	fences = kvmalloc_array(nfences, sizeof(*fences),
-				__GFP_NOWARN | GFP_KERNEL);
-	if (!fences)
-		return ERR_PTR(-ENOMEM);
+	if (!access_ok(user, nfences * sizeof(*user))) {
+		err = -EFAULT;
+		goto err;
+	}
 
 	for (n = 0; n < nfences; n++) {
 		struct drm_i915_gem_exec_fence fence;
-		struct drm_syncobj *syncobj;
 
 		if (__copy_from_user(&fence, user++, sizeof(fence))) {
 			err = -EFAULT;
 			goto err;
 		}
 
-		if (fence.flags & __I915_EXEC_FENCE_UNKNOWN_FLAGS) {
-			err = -EINVAL;
+		err = add_fence(eb, &fences[n], &fence, 0);
+		if (err)
 			goto err;
-		}
+	}
 
-		syncobj = drm_syncobj_find(file, fence.handle);
-		if (!syncobj) {
-			DRM_DEBUG("Invalid syncobj handle provided\n");
-			err = -ENOENT;
+	eb->fences = fences;
+	eb->num_fences = nfences;
+	return 0;
+
+err:
+	__free_fence_array(fences, n);
+	return err;
+}
+
+static int parse_timeline_fences(struct i915_user_extension __user *ext,
+				 void *data)
+{
+	struct drm_i915_gem_execbuffer_ext_timeline_fences timeline_fences;
+	struct i915_execbuffer *eb = data;
+	struct drm_i915_gem_exec_fence __user *user;
+	u64 __user *user_values;
+	struct eb_fence *fences;
+	unsigned long nfences;
+	unsigned long n;
+	int err;
+
+	if (copy_from_user(&timeline_fences, ext, sizeof(timeline_fences)))
+		return -EFAULT;
+
+	/* Only one timeline fence array per execbuf */
+	if (eb->fences)
+		return -EINVAL;
+
+	nfences = timeline_fences.fence_count;
+	if (nfences != timeline_fences.fence_count)
+		return -EINVAL;
+
+	fences = alloc_fence_array(nfences, sizeof(*user));
+	if (IS_ERR(fences))
+		return PTR_ERR(fences);
+
+	user = u64_to_user_ptr(timeline_fences.handles_ptr);
+	user_values = u64_to_user_ptr(timeline_fences.values_ptr);
+	if (!access_ok(user, nfences * sizeof(*user)) ||
+	    !access_ok(user_values, nfences * sizeof(*user_values))) {
+		err = -EFAULT;
+		goto err;
+	}
+
+	for (n = 0; n < nfences; n++) {
+		struct drm_i915_gem_exec_fence fence;
+		u64 point;
+
+		if (__copy_from_user(&fence, user++, sizeof(fence)) ||
+		    __get_user(point, user_values++)) {
+			err = -EFAULT;
 			goto err;
 		}
 
-		BUILD_BUG_ON(~(ARCH_KMALLOC_MINALIGN - 1) &
-			     ~__I915_EXEC_FENCE_UNKNOWN_FLAGS);
-
-		fences[n] = ptr_pack_bits(syncobj, fence.flags, 2);
+		err = add_fence(eb, &fences[n], &fence, point);
+		if (err)
+			goto err;
 	}
 
-	return fences;
+	eb->fences = fences;
+	eb->num_fences = nfences;
+	return 0;
 
 err:
 	__free_fence_array(fences, n);
-	return ERR_PTR(err);
+	return err;
 }
 
-static void
-put_fence_array(struct drm_i915_gem_execbuffer2 *args,
-		struct drm_syncobj **fences)
+static const i915_user_extension_fn execbuf_extensions[] = {
+	[DRM_I915_GEM_EXECBUFFER_EXT_TIMELINE_FENCES] = parse_timeline_fences,
+};
+
+static int
+parse_execbuf2_extensions(struct i915_execbuffer *eb)
 {
-	if (fences)
-		__free_fence_array(fences, args->num_cliprects);
+	struct drm_i915_gem_execbuffer2 *args = eb->args;
+
+	if (!(args->flags & I915_EXEC_USE_EXTENSIONS))
+		return 0;
+
+	return i915_user_extensions(u64_to_user_ptr(args->cliprects_ptr),
+				    execbuf_extensions,
+				    ARRAY_SIZE(execbuf_extensions),
+				    eb);
 }
 
 static int
-await_fence_array(struct i915_execbuffer *eb,
-		  struct drm_syncobj **fences)
+await_fence_array(struct i915_execbuffer *eb)
 {
-	const unsigned int nfences = eb->args->num_cliprects;
 	unsigned int n;
 	int err;
 
-	for (n = 0; n < nfences; n++) {
+	for (n = 0; n < eb->num_fences; n++) {
 		struct drm_syncobj *syncobj;
 		struct dma_fence *fence;
 		unsigned int flags;
 
-		syncobj = ptr_unpack_bits(fences[n], &flags, 2);
+		syncobj = ptr_unpack_bits(eb->fences[n].syncobj, &flags, 2);
 		if (!(flags & I915_EXEC_FENCE_WAIT))
 			continue;
 
@@ -2453,6 +2672,19 @@ await_fence_array(struct i915_execbuffer *eb,
 		if (!fence)
 			return -EINVAL;
 
+		if (eb->fences[n].value) {
+			err = dma_fence_chain_find_seqno(&fence,
+							 eb->fences[n].value);
+			if (err) {
+				dma_fence_put(fence);
+				return err;
+			}
+
+			/* The point has already signaled */
+			if (!fence)
+				continue;
+		}
+
 		err = i915_request_await_dma_fence(eb->request, fence);
 		dma_fence_put(fence);
 		if (err < 0)
@@ -2463,22 +2695,29 @@ await_fence_array(struct i915_execbuffer *eb,
 }
 
 static void
-signal_fence_array(struct i915_execbuffer *eb,
-		   struct drm_syncobj **fences)
+signal_fence_array(struct i915_execbuffer *eb)
 {
-	const unsigned int nfences = eb->args->num_cliprects;
 	struct dma_fence * const fence = &eb->request->fence;
 	unsigned int n;
 
-	for (n = 0; n < nfences; n++) {
+	for (n = 0; n < eb->num_fences; n++) {
 		struct drm_syncobj *syncobj;
 		unsigned int flags;
 
-		syncobj = ptr_unpack_bits(fences[n], &flags, 2);
+		syncobj = ptr_unpack_bits(eb->fences[n].syncobj, &flags, 2);
 		if (!(flags & I915_EXEC_FENCE_SIGNAL))
 			continue;
 
-		drm_syncobj_replace_fence(syncobj, fence);
+		if (eb->fences[n].chain_fence) {
+			drm_syncobj_add_point(syncobj,
+					      eb->fences[n].chain_fence,
+					      fence,
+					      eb->fences[n].value);
+			/* The chain node now belongs to the syncobj */
+			eb->fences[n].chain_fence = NULL;
+		} else {
+			drm_syncobj_replace_fence(syncobj, fence);
+		}
 	}
 }
 
@@ -2486,8 +2725,7 @@ static int
 i915_gem_do_execbuffer(struct drm_device *dev,
 		       struct drm_file *file,
 		       struct drm_i915_gem_execbuffer2 *args,
-		       struct drm_i915_gem_exec_object2 *exec,
-		       struct drm_syncobj **fences)
+		       struct drm_i915_gem_exec_object2 *exec)
 {
 	struct drm_i915_private *i915 = to_i915(dev);
 	struct i915_execbuffer eb;
@@ -2519,6 +2757,9 @@ i915_gem_do_execbuffer(struct drm_device *dev,
 	eb.batch_start_offset = args->batch_start_offset;
 	eb.batch_len = args->batch_len;
 
+	eb.fences = NULL;
+	eb.num_fences = 0;
+
 	eb.batch_flags = 0;
 	if (args->flags & I915_EXEC_SECURE) {
 		if (INTEL_GEN(i915) >= 11)
@@ -2536,10 +2777,20 @@ i915_gem_do_execbuffer(struct drm_device *dev,
 	if (args->flags & I915_EXEC_IS_PINNED)
 		eb.batch_flags |= I915_DISPATCH_PINNED;
 
+	err = parse_execbuf2_extensions(&eb);
+	if (err)
+		goto err_ext;
+
+	err = get_fence_array(&eb);
+	if (err)
+		goto err_ext;
+
 	if (args->flags & I915_EXEC_FENCE_IN) {
 		in_fence = sync_file_get_fence(lower_32_bits(args->rsvd2));
-		if (!in_fence)
-			return -EINVAL;
+		if (!in_fence) {
+			err = -EINVAL;
+			goto err_ext;
+		}
 	}
 
 	if (args->flags & I915_EXEC_FENCE_SUBMIT) {
@@ -2668,8 +2919,8 @@ i915_gem_do_execbuffer(struct drm_device *dev,
 			goto err_request;
 	}
 
-	if (fences) {
-		err = await_fence_array(&eb, fences);
+	if (eb.fences) {
+		err = await_fence_array(&eb);
 		if (err)
 			goto err_request;
 	}
@@ -2699,8 +2950,8 @@ i915_gem_do_execbuffer(struct drm_device *dev,
 	add_to_client(eb.request, file);
 	i915_request_add(eb.request);
 
-	if (fences)
-		signal_fence_array(&eb, fences);
+	if (eb.fences)
+		signal_fence_array(&eb);
 
 	if (out_fence) {
 		if (err == 0) {
@@ -2735,6 +2986,8 @@ i915_gem_do_execbuffer(struct drm_device *dev,
 	dma_fence_put(exec_fence);
 err_in_fence:
 	dma_fence_put(in_fence);
+err_ext:
+	put_fence_array(&eb);
 	return err;
 }
 
@@ -2828,7 +3081,7 @@ i915_gem_execbuffer_ioctl(struct drm_device *dev, void *data,
 			exec2_list[i].flags = 0;
 	}
 
-	err = i915_gem_do_execbuffer(dev, file, &exec2, exec2_list, NULL);
+	err = i915_gem_do_execbuffer(dev, file, &exec2, exec2_list);
 	if (exec2.flags & __EXEC_HAS_RELOC) {
 		struct drm_i915_gem_exec_object __user *user_exec_list =
 			u64_to_user_ptr(args->buffers_ptr);
@@ -2859,7 +3112,6 @@ i915_gem_execbuffer2_ioctl(struct drm_device *dev, void *data,
 {
 	struct drm_i915_gem_execbuffer2 *args = data;
 	struct drm_i915_gem_exec_object2 *exec2_list;
-	struct drm_syncobj **fences = NULL;
 	const size_t count = args->buffer_count;
 	int err;
 
@@ -2887,15 +3139,7 @@ i915_gem_execbuffer2_ioctl(struct drm_device *dev, void *data,
 		return -EFAULT;
 	}
 
-	if (args->flags & I915_EXEC_FENCE_ARRAY) {
-		fences = get_fence_array(args, file);
-		if (IS_ERR(fences)) {
-			kvfree(exec2_list);
-			return PTR_ERR(fences);
-		}
-	}
-
-	err = i915_gem_do_execbuffer(dev, file, args, exec2_list, fences);
+	err = i915_gem_do_execbuffer(dev, file, args, exec2_list);
 
 	/*
 	 * Now that we have begun execution of the batchbuffer, we ignore
@@ -2935,7 +3179,10 @@ end:;
 	}
 
 	args->flags &= ~__I915_EXEC_UNKNOWN_FLAGS;
-	put_fence_array(args, fences);
 	kvfree(exec2_list);
 	return err;
 }
+
+#if IS_ENABLED(CONFIG_DRM_I915_SELFTEST)
+#include "selftests/i915_gem_execbuffer.c"
+#endif
@@ -19,13 +19,134 @@
 #define QUIET (__GFP_NORETRY | __GFP_NOWARN)
 #define MAYFAIL (__GFP_RETRY_MAYFAIL | __GFP_NOWARN)
 
-static void internal_free_pages(struct sg_table *st)
+/* Upper bound of memory kept in the pool while not under pressure */
+#define INTERNAL_POOL_MAX_PAGES (SZ_64M >> PAGE_SHIFT)
+
+/*
+ * Internal objects come and go at a high rate (batch pool nodes, shadow
+ * batches, rings, scratch), and their high order pages are expensive to
+ * find again once fragmented. As their contents are never cleared nor
+ * exposed to userspace, the pages of a freed object are kept in a small
+ * pool and handed to the next object. The shrinker empties the pool.
+ */
+static bool internal_pool_enabled(struct drm_i915_private *i915)
+{
+	/* 965gm restricts the pages to DMA32, keep it simple and skip */
+	return !(IS_I965GM(i915) || IS_I965G(i915));
+}
+
+static struct page *internal_pool_get(struct drm_i915_private *i915,
+				      unsigned int order)
+{
+	struct i915_page_pool *pool = &i915->mm.internal_pool;
+	struct page *page;
+
+	/* Beyond what the page allocator can provide, the caller backs off */
+	if (order >= ARRAY_SIZE(pool->free))
+		return NULL;
+
+	spin_lock(&pool->lock);
+	page = list_first_entry_or_null(&pool->free[order], typeof(*page), lru);
+	if (page) {
+		list_del(&page->lru);
+		pool->count -= BIT(order);
+		pool->hits++;
+	}
+	spin_unlock(&pool->lock);
+
+	return page;
+}
+
+static void internal_pool_miss(struct drm_i915_private *i915)
 {
+	struct i915_page_pool *pool = &i915->mm.internal_pool;
+
+	spin_lock(&pool->lock);
+	pool->misses++;
+	spin_unlock(&pool->lock);
+}
+
+static bool internal_pool_put(struct drm_i915_private *i915,
+			      struct page *page, unsigned int order)
+{
+	struct i915_page_pool *pool = &i915->mm.internal_pool;
+	bool added = false;
+
+	spin_lock(&pool->lock);
+	if (pool->count + BIT(order) <= INTERNAL_POOL_MAX_PAGES) {
+		list_add(&page->lru, &pool->free[order]);
+		pool->count += BIT(order);
+		added = true;
+	}
+	spin_unlock(&pool->lock);
+
+	return added;
+}
+
+/**
+ * i915_gem_internal_pool_drain - release the pooled internal object pages
+ * @i915: i915 device
+ *
+ * Returns the number of pages given back to the system.
+ */
+unsigned long i915_gem_internal_pool_drain(struct drm_i915_private *i915)
+{
+	struct i915_page_pool *pool = &i915->mm.internal_pool;
+	unsigned long freed = 0;
+	unsigned int order;
+
+	for (order = 0; order < ARRAY_SIZE(pool->free); order++) {
+		struct page *page, *next;
+		unsigned long count = 0;
+		LIST_HEAD(free);
+
+		spin_lock(&pool->lock);
+		list_splice_init(&pool->free[order], &free);
+		spin_unlock(&pool->lock);
+
+		list_for_each_entry_safe(page, next, &free, lru) {
+			__free_pages(page, order);
+			count += BIT(order);
+			cond_resched();
+		}
+
+		spin_lock(&pool->lock);
+		pool->count -= count;
+		spin_unlock(&pool->lock);
+
+		freed += count;
+	}
+
+	return freed;
+}
+
+void i915_gem_init__internal(struct drm_i915_private *i915)
+{
+	struct i915_page_pool *pool = &i915->mm.internal_pool;
+	unsigned int order;
+
+	spin_lock_init(&pool->lock);
+	for (order = 0; order < ARRAY_SIZE(pool->free); order++)
+		INIT_LIST_HEAD(&pool->free[order]);
+}
+
+static void internal_free_pages(struct drm_i915_private *i915,
+				struct sg_table *st)
+{
+	const bool pool = internal_pool_enabled(i915);
 	struct scatterlist *sg;
 
 	for (sg = st->sgl; sg; sg = __sg_next(sg)) {
-		if (sg_page(sg))
-			__free_pages(sg_page(sg), get_order(sg->length));
+		unsigned int order = get_order(sg->length);
+		struct page *page = sg_page(sg);
+
+		if (!page)
+			continue;
+
+		if (pool && internal_pool_put(i915, page, order))
+			continue;
+
+		__free_pages(page, order);
 	}
 
 	sg_free_table(st);
@@ -35,6 +156,7 @@ static void internal_free_pages(struct sg_table *st)
 static int i915_gem_object_get_pages_internal(struct drm_i915_gem_object *obj)
 {
 	struct drm_i915_private *i915 = to_i915(obj->base.dev);
+	const bool pool = internal_pool_enabled(i915);
 	struct sg_table *st;
 	struct scatterlist *sg;
 	unsigned int sg_page_sizes;
@@ -80,20 +202,34 @@ static int i915_gem_object_get_pages_internal(struct drm_i915_gem_object *obj)
 
 	do {
 		int order = min(fls(npages) - 1, max_order);
+		bool pooled = false;
 		struct page *page;
 
 		do {
+			page = NULL;
+			if (pool)
+				page = internal_pool_get(i915, order);
+			if (page) {
+				pooled = true;
+				break;
+			}
 			page = alloc_pages(gfp | (order ? QUIET : MAYFAIL),
 					   order);
 			if (page)
 				break;
 			if (!order--)
-				goto err;
+				break;
 
 			/* Limit subsequent allocations as well */
 			max_order = order;
 		} while (1);
 
+		/* One miss per chunk the pool could not provide, at any order */
+		if (pool && !pooled)
+			internal_pool_miss(i915);
+		if (!page)
+			goto err;
+
 		sg_set_page(sg, page, PAGE_SIZE << order, 0);
 		sg_page_sizes |= PAGE_SIZE << order;
 		st->nents++;
@@ -110,7 +246,7 @@ static int i915_gem_object_get_pages_internal(struct drm_i915_gem_object *obj)
 	if (i915_gem_gtt_prepare_pages(obj, st)) {
 		/* Failed to dma-map try again with single page sg segments */
 		if (get_order(st->sgl->length)) {
-			internal_free_pages(st);
+			internal_free_pages(i915, st);
 			max_order = 0;
 			goto create_st;
 		}
@@ -124,7 +260,7 @@ static int i915_gem_object_get_pages_internal(struct drm_i915_gem_object *obj)
 err:
 	sg_set_page(sg, NULL, 0, 0);
 	sg_mark_end(sg);
-	internal_free_pages(st);
+	internal_free_pages(i915, st);
 
 	return -ENOMEM;
 }
@@ -132,8 +268,10 @@ static int i915_gem_object_get_pages_internal(struct drm_i915_gem_object *obj)
 static void i915_gem_object_put_pages_internal(struct drm_i915_gem_object *obj,
 					       struct sg_table *pages)
 {
+	struct drm_i915_private *i915 = to_i915(obj->base.dev);
+
 	i915_gem_gtt_finish_pages(obj, pages);
-	internal_free_pages(pages);
+	internal_free_pages(i915, pages);
 
 	obj->mm.dirty = false;
 }
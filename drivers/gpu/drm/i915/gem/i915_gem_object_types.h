@@ -124,6 +124,8 @@ struct drm_i915_gem_object {
 #define I915_BO_ALLOC_CONTIGUOUS BIT(0)
 #define I915_BO_ALLOC_VOLATILE   BIT(1)
 #define I915_BO_ALLOC_FLAGS (I915_BO_ALLOC_CONTIGUOUS | I915_BO_ALLOC_VOLATILE)
+#define I915_BO_POPULATED        BIT(2) /* backing store was allocated once */
+#define I915_BO_WRITEBACK_BIT    3 /* queued for writeback by the shrinker */
 
 	/*
 	 * Is the object to be mapped as read-only to the GPU
@@ -230,6 +232,18 @@ struct drm_i915_gem_object {
 		 */
 		struct list_head link;
 
+		/**
+		 * Element within i915->mm.writeback_list, while the shrinker
+		 * worker is to write back the released pages.
+		 */
+		struct llist_node writeback_link;
+
+		/**
+		 * jiffies when last used by the GPU, so that the shrinker
+		 * can leave the working set of the GPU until last.
+		 */
+		unsigned long last_use;
+
 		/**
 		 * Advice: are the backing pages purgeable?
 		 */
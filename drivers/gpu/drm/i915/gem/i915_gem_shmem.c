@@ -4,7 +4,9 @@
  * Copyright © 2014-2016 Intel Corporation
  */
 
+#include <linux/mmu_context.h>
 #include <linux/pagevec.h>
+#include <linux/sched/mm.h>
 #include <linux/swap.h>
 
 #include "gem/i915_gem_region.h"
@@ -14,6 +16,20 @@
 #include "i915_scatterlist.h"
 #include "i915_trace.h"
 
+/*
+ * Objects at least this large have their pages populated in the background
+ * as soon as they are created, by workers each taking a chunk of the object.
+ */
+#define SHMEM_POPULATE_ASYNC_MIN SZ_8M
+#define SHMEM_POPULATE_CHUNK SZ_2M
+
+struct shmem_populate {
+	struct work_struct work;
+	struct drm_i915_gem_object *obj;
+	struct mm_struct *mm;
+	pgoff_t start, end;
+};
+
 /*
  * Move pages to appropriate lru and release the pagevec, decrementing the
  * ref count of those pages.
@@ -25,6 +41,14 @@ static void check_release_pagevec(struct pagevec *pvec)
 	cond_resched();
 }
 
+static void shmem_account_populate(struct drm_i915_private *i915, u64 ns)
+{
+	atomic64_inc(&i915->mm.populate.count);
+	atomic64_add(ns, &i915->mm.populate.total_ns);
+	if (ns > READ_ONCE(i915->mm.populate.max_ns))
+		WRITE_ONCE(i915->mm.populate.max_ns, ns);
+}
+
 static int shmem_get_pages(struct drm_i915_gem_object *obj)
 {
 	struct drm_i915_private *i915 = to_i915(obj->base.dev);
@@ -40,8 +64,13 @@ static int shmem_get_pages(struct drm_i915_gem_object *obj)
 	unsigned int max_segment = i915_sg_segment_size();
 	unsigned int sg_page_sizes;
 	gfp_t noreclaim;
+	u64 t0 = 0;
 	int ret;
 
+	if (obj->base.size >= SHMEM_POPULATE_ASYNC_MIN &&
+	    !(obj->flags & I915_BO_POPULATED))
+		t0 = ktime_get_ns();
+
 	/*
 	 * Assert that the object is not currently in any GPU domain. As it
 	 * wasn't in the GTT, there shouldn't be any way it could have been in
@@ -193,6 +222,10 @@ static int shmem_get_pages(struct drm_i915_gem_object *obj)
 
 	__i915_gem_object_set_pages(obj, st, sg_page_sizes);
 
+	if (t0)
+		shmem_account_populate(i915, ktime_get_ns() - t0);
+	obj->flags |= I915_BO_POPULATED;
+
 	return 0;
 
 err_sg:
@@ -556,6 +589,135 @@ i915_gem_object_create_shmem(struct drm_i915_private *i915,
 					     size, 0);
 }
 
+static void shmem_populate_work(struct work_struct *work)
+{
+	struct shmem_populate *p = container_of(work, typeof(*p), work);
+	struct drm_i915_gem_object *obj = p->obj;
+	struct address_space *mapping = obj->base.filp->f_mapping;
+	gfp_t gfp;
+	pgoff_t i;
+
+	/*
+	 * Only take memory that is readily available, the synchronous
+	 * shmem_get_pages() is the one to reclaim and report ENOMEM.
+	 */
+	gfp = mapping_gfp_constraint(mapping, ~__GFP_RECLAIM);
+	gfp |= __GFP_NORETRY | __GFP_NOWARN;
+
+	/*
+	 * shmem charges the pages to the memcg of current->mm, so borrow the
+	 * creator's mm; otherwise they would land in the root memcg. If the
+	 * creator has already gone, leave the pages to shmem_get_pages().
+	 */
+	i = p->start;
+	if (p->mm) {
+		if (!mmget_not_zero(p->mm))
+			goto out;
+		use_mm(p->mm);
+	}
+
+	for (; i < p->end; i++) {
+		struct page *page;
+
+		/* Stop once the object is in use or no longer wanted */
+		if (obj->mm.madv != I915_MADV_WILLNEED ||
+		    i915_gem_object_has_pages(obj))
+			break;
+
+		page = shmem_read_mapping_page_gfp(mapping, i, gfp);
+		if (IS_ERR(page))
+			break;
+
+		put_page(page);
+		cond_resched();
+	}
+
+	if (p->mm) {
+		unuse_mm(p->mm);
+		mmput(p->mm);
+	}
+
+	/*
+	 * A purge truncates the backing store under obj->mm.lock, so it
+	 * either ran after our reads and dropped them already, or we see
+	 * it here and must throw away what we just put back.
+	 */
+	if (i != p->start) {
+		mutex_lock(&obj->mm.lock);
+		if (obj->mm.madv == __I915_MADV_PURGED)
+			shmem_truncate_range(file_inode(obj->base.filp),
+					     (loff_t)p->start << PAGE_SHIFT,
+					     ((loff_t)i << PAGE_SHIFT) - 1);
+		mutex_unlock(&obj->mm.lock);
+	}
+
+	atomic64_add(i - p->start,
+		     &to_i915(obj->base.dev)->mm.populate.prefault_pages);
+
+out:
+	if (p->mm)
+		mmdrop(p->mm);
+	i915_gem_object_put(obj);
+	kfree(p);
+}
+
+/**
+ * i915_gem_object_populate_async - populate a new object in the background
+ * @obj: a freshly created shmem object
+ *
+ * Allocating (and clearing) the pages of a large object on its first use
+ * stalls whoever first uses it, usually the execbuf or a fault. Instead,
+ * large objects are read into the page cache as soon as they are created,
+ * by workers each covering a chunk of the object so that they run in
+ * parallel. The first use then finds its pages ready and only has to pin
+ * them, or waits for the remainder as it would have done anyway. The pages
+ * are charged to the memcg of the caller, as if it had populated them.
+ */
+void i915_gem_object_populate_async(struct drm_i915_gem_object *obj)
+{
+	struct drm_i915_private *i915 = to_i915(obj->base.dev);
+	const pgoff_t count = obj->base.size >> PAGE_SHIFT;
+	const pgoff_t chunk = SHMEM_POPULATE_CHUNK >> PAGE_SHIFT;
+	pgoff_t start;
+
+	if (obj->base.size < SHMEM_POPULATE_ASYNC_MIN || !i915->mm.populate_wq)
+		return;
+
+	GEM_BUG_ON(obj->ops != &i915_gem_shmem_ops);
+
+	for (start = 0; start < count; start += chunk) {
+		struct shmem_populate *p;
+
+		p = kmalloc(sizeof(*p), GFP_KERNEL | __GFP_NOWARN);
+		if (!p)
+			break;
+
+		INIT_WORK(&p->work, shmem_populate_work);
+		p->obj = i915_gem_object_get(obj);
+		p->mm = current->mm;
+		if (p->mm)
+			mmgrab(p->mm);
+		p->start = start;
+		p->end = min(start + chunk, count);
+		queue_work(i915->mm.populate_wq, &p->work);
+	}
+}
+
+int i915_gem_init_populate(struct drm_i915_private *i915)
+{
+	i915->mm.populate_wq =
+		alloc_workqueue("i915-populate", WQ_UNBOUND, 0);
+	if (!i915->mm.populate_wq)
+		return -ENOMEM;
+
+	return 0;
+}
+
+void i915_gem_cleanup_populate(struct drm_i915_private *i915)
+{
+	destroy_workqueue(i915->mm.populate_wq);
+}
+
 /* Allocate a new GEM object and fill it with the supplied data */
 struct drm_i915_gem_object *
 i915_gem_object_create_shmem_from_data(struct drm_i915_private *dev_priv,
@@ -16,6 +16,9 @@
 
 #include "i915_trace.h"
 
+/* Objects used by the GPU within this period are its working set */
+#define SHRINK_YOUNG_MS 100
+
 static bool swap_available(void)
 {
 	return get_nr_swap_pages() > 0;
@@ -62,6 +65,28 @@ static bool unsafe_drop_pages(struct drm_i915_gem_object *obj,
 	return !i915_gem_object_has_pages(obj);
 }
 
+static bool is_young(const struct drm_i915_gem_object *obj)
+{
+	unsigned long last_use = READ_ONCE(obj->mm.last_use);
+
+	return time_in_range_open(jiffies, last_use,
+				  last_use + msecs_to_jiffies(SHRINK_YOUNG_MS));
+}
+
+static void queue_writeback(struct drm_i915_gem_object *obj)
+{
+	struct drm_i915_private *i915 = to_i915(obj->base.dev);
+
+	lockdep_assert_held(&obj->mm.lock);
+
+	if (test_and_set_bit(I915_BO_WRITEBACK_BIT, &obj->flags))
+		return;
+
+	i915_gem_object_get(obj);
+	if (llist_add(&obj->mm.writeback_link, &i915->mm.writeback_list))
+		queue_work(system_unbound_wq, &i915->mm.writeback_work);
+}
+
 static void try_to_writeback(struct drm_i915_gem_object *obj,
 			     unsigned int flags)
 {
@@ -72,10 +97,60 @@ static void try_to_writeback(struct drm_i915_gem_object *obj,
 		return;
 	}
 
-	if (flags & I915_SHRINK_WRITEBACK)
+	if (!(flags & I915_SHRINK_WRITEBACK))
+		return;
+
+	/*
+	 * Writing back walks every page of the object, leave that to the
+	 * worker rather than holding up the reclaimer for large objects.
+	 */
+	if (flags & I915_SHRINK_ASYNC)
+		queue_writeback(obj);
+	else
 		i915_gem_object_writeback(obj);
 }
 
+static void writeback_worker(struct work_struct *work)
+{
+	struct drm_i915_private *i915 =
+		container_of(work, typeof(*i915), mm.writeback_work);
+	struct drm_i915_gem_object *obj, *on;
+	struct llist_node *list;
+
+	list = llist_del_all(&i915->mm.writeback_list);
+	llist_for_each_entry_safe(obj, on, list, mm.writeback_link) {
+		mutex_lock(&obj->mm.lock);
+		clear_bit(I915_BO_WRITEBACK_BIT, &obj->flags);
+
+		/* The pages may have been reacquired or purged meanwhile */
+		if (!i915_gem_object_has_pages(obj) &&
+		    obj->mm.madv == I915_MADV_WILLNEED) {
+			i915_gem_object_writeback(obj);
+			atomic64_inc(&i915->mm.shrink_stats.writeback);
+		}
+		mutex_unlock(&obj->mm.lock);
+
+		i915_gem_object_put(obj);
+		cond_resched();
+	}
+}
+
+static void account_shrink(struct drm_i915_private *i915,
+			   unsigned int shrink, ktime_t start)
+{
+	atomic64_t *hist = i915->mm.shrink_stats.latency[0];
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int bucket;
+
+	/* Only I915_SHRINK_ACTIVE may wait for the GPU */
+	if (shrink & I915_SHRINK_ACTIVE)
+		hist = i915->mm.shrink_stats.latency[1];
+
+	bucket = min_t(int, fls64(max_t(s64, us, 0)),
+		       I915_SHRINK_HIST_BUCKETS - 1);
+	atomic64_inc(&hist[bucket]);
+}
+
 /**
  * i915_gem_shrink - Shrink buffer object caches
  * @i915: i915 device
@@ -98,6 +173,10 @@ static void try_to_writeback(struct drm_i915_gem_object *obj,
  * backing storage pins at the buffer object level) result in the shrinker code
  * having to skip the object.
  *
+ * With I915_SHRINK_COLD, objects the GPU used within the last SHRINK_YOUNG_MS
+ * are also skipped, so that a second call without it releases the GPU's
+ * working set only after everything else.
+ *
  * Returns:
  * The number of pages of backing storage actually released.
  */
@@ -121,6 +200,7 @@ i915_gem_shrink(struct drm_i915_private *i915,
 	intel_wakeref_t wakeref = 0;
 	unsigned long count = 0;
 	unsigned long scanned = 0;
+	ktime_t start = ktime_get();
 
 	/*
 	 * When shrinking the active list, we should also consider active
@@ -202,6 +282,11 @@ i915_gem_shrink(struct drm_i915_private *i915,
 			if (!can_release_pages(obj))
 				continue;
 
+			if (shrink & I915_SHRINK_COLD && is_young(obj)) {
+				atomic64_inc(&i915->mm.shrink_stats.young);
+				continue;
+			}
+
 			if (!kref_get_unless_zero(&obj->base.refcount))
 				continue;
 
@@ -227,9 +312,18 @@ i915_gem_shrink(struct drm_i915_private *i915,
 		spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 	}
 
+	/*
+	 * Internal objects return their pages to a pool for reuse; under
+	 * memory pressure those must go back to the system, and only now
+	 * are they actually freed.
+	 */
+	count += i915_gem_internal_pool_drain(i915);
+
 	if (shrink & I915_SHRINK_BOUND)
 		intel_runtime_pm_put(&i915->runtime_pm, wakeref);
 
+	account_shrink(i915, shrink, start);
+
 	if (nr_scanned)
 		*nr_scanned += scanned;
 	return count;
@@ -273,6 +367,7 @@ i915_gem_shrinker_count(struct shrinker *shrinker, struct shrink_control *sc)
 	unsigned long count;
 
 	count = READ_ONCE(i915->mm.shrink_memory) >> PAGE_SHIFT;
+	count += READ_ONCE(i915->mm.internal_pool.count);
 	num_objects = READ_ONCE(i915->mm.shrink_count);
 
 	/*
@@ -302,11 +397,24 @@ i915_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 
 	sc->nr_scanned = 0;
 
+	/*
+	 * Direct reclaim runs in whichever thread is allocating, quite
+	 * possibly the one feeding the GPU: take what the GPU has not
+	 * touched recently first, and never wait for it. Only kswapd
+	 * goes on to wait for active objects.
+	 */
 	freed = i915_gem_shrink(i915,
 				sc->nr_to_scan,
 				&sc->nr_scanned,
 				I915_SHRINK_BOUND |
-				I915_SHRINK_UNBOUND);
+				I915_SHRINK_UNBOUND |
+				I915_SHRINK_COLD);
+	if (sc->nr_scanned < sc->nr_to_scan)
+		freed += i915_gem_shrink(i915,
+					 sc->nr_to_scan - sc->nr_scanned,
+					 &sc->nr_scanned,
+					 I915_SHRINK_BOUND |
+					 I915_SHRINK_UNBOUND);
 	if (sc->nr_scanned < sc->nr_to_scan && current_is_kswapd()) {
 		intel_wakeref_t wakeref;
 
@@ -317,7 +425,8 @@ i915_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 						 I915_SHRINK_ACTIVE |
 						 I915_SHRINK_BOUND |
 						 I915_SHRINK_UNBOUND |
-						 I915_SHRINK_WRITEBACK);
+						 I915_SHRINK_WRITEBACK |
+						 I915_SHRINK_ASYNC);
 		}
 	}
 
@@ -400,6 +509,9 @@ i915_gem_shrinker_vmap(struct notifier_block *nb, unsigned long event, void *ptr
 
 void i915_gem_driver_register__shrinker(struct drm_i915_private *i915)
 {
+	init_llist_head(&i915->mm.writeback_list);
+	INIT_WORK(&i915->mm.writeback_work, writeback_worker);
+
 	i915->mm.shrinker.scan_objects = i915_gem_shrinker_scan;
 	i915->mm.shrinker.count_objects = i915_gem_shrinker_count;
 	i915->mm.shrinker.seeks = DEFAULT_SEEKS;
@@ -418,6 +530,9 @@ void i915_gem_driver_unregister__shrinker(struct drm_i915_private *i915)
 	WARN_ON(unregister_vmap_purge_notifier(&i915->mm.vmap_notifier));
 	WARN_ON(unregister_oom_notifier(&i915->mm.oom_notifier));
 	unregister_shrinker(&i915->mm.shrinker);
+
+	/* Only the shrinker queues writeback, release what it left behind */
+	flush_work(&i915->mm.writeback_work);
 }
 
 void i915_gem_shrinker_taints_mutex(struct drm_i915_private *i915,
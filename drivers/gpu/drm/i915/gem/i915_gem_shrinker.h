@@ -21,6 +21,11 @@ unsigned long i915_gem_shrink(struct drm_i915_private *i915,
 #define I915_SHRINK_ACTIVE	BIT(2)
 #define I915_SHRINK_VMAPS	BIT(3)
 #define I915_SHRINK_WRITEBACK	BIT(4)
+#define I915_SHRINK_ASYNC	BIT(5) /* writeback from a worker */
+#define I915_SHRINK_COLD	BIT(6) /* skip recently used objects */
+
+/* log2 buckets of shrink latency in us, the last one open-ended */
+#define I915_SHRINK_HIST_BUCKETS 20
 
 unsigned long i915_gem_shrink_all(struct drm_i915_private *i915);
 void i915_gem_driver_register__shrinker(struct drm_i915_private *i915);
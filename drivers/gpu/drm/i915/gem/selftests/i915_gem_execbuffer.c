@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2020 Intel Corporation
+ */
+
+#include "i915_selftest.h"
+
+#include "gt/intel_gt.h"
+
+#include "selftests/igt_flush_test.h"
+#include "selftests/mock_drm.h"
+
+#define EB_NUM_OBJECTS 1000
+#define EB_NUM_SUBMITS 100
+
+/* What the ioctl does around i915_gem_do_execbuffer() */
+static int igt_execbuf(struct drm_i915_private *i915, struct drm_file *file,
+		       struct drm_i915_gem_execbuffer2 *args,
+		       struct drm_i915_gem_exec_object2 *exec)
+{
+	unsigned int i;
+	int err;
+
+	err = i915_gem_do_execbuffer(&i915->drm, file, args, exec);
+	args->flags &= ~__I915_EXEC_UNKNOWN_FLAGS;
+	if (err)
+		return err;
+
+	for (i = 0; i < args->buffer_count; i++) {
+		if (exec[i].offset & UPDATE)
+			exec[i].offset = gen8_canonical_addr(exec[i].offset &
+							     PIN_OFFSET_MASK);
+	}
+
+	return 0;
+}
+
+static int igt_add_object(struct drm_i915_private *i915,
+			  struct drm_file *file, u32 *handle, bool batch)
+{
+	struct drm_i915_gem_object *obj;
+	int err;
+
+	obj = i915_gem_object_create_internal(i915, PAGE_SIZE);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	if (batch) {
+		u32 *cs;
+
+		cs = i915_gem_object_pin_map(obj, I915_MAP_WB);
+		if (IS_ERR(cs)) {
+			i915_gem_object_put(obj);
+			return PTR_ERR(cs);
+		}
+
+		*cs = MI_BATCH_BUFFER_END;
+		i915_gem_object_flush_map(obj);
+		i915_gem_object_unpin_map(obj);
+	}
+
+	err = drm_gem_handle_create(file, &obj->base, handle);
+	i915_gem_object_put(obj);
+	return err;
+}
+
+static u64 igt_time_execbuf(struct drm_i915_private *i915,
+			    struct drm_file *file,
+			    struct drm_i915_gem_execbuffer2 *args,
+			    struct drm_i915_gem_exec_object2 *exec,
+			    struct i915_gem_context *ctx, bool cached,
+			    int *err)
+{
+	ktime_t dt = 0;
+	unsigned int n;
+
+	for (n = 0; n < EB_NUM_SUBMITS; n++) {
+		ktime_t t0;
+
+		/* Make the lookup start from scratch, as without the lists */
+		if (!cached) {
+			mutex_lock(&ctx->mutex);
+			ctx->handles_seqno++;
+			mutex_unlock(&ctx->mutex);
+		}
+
+		t0 = ktime_get();
+		*err = igt_execbuf(i915, file, args, exec);
+		dt = ktime_add(dt, ktime_sub(ktime_get(), t0));
+		if (*err)
+			break;
+	}
+
+	return div_u64(ktime_to_ns(dt), EB_NUM_SUBMITS);
+}
+
+static int igt_execbuf_buffer_list(void *arg)
+{
+	struct drm_i915_private *i915 = arg;
+	struct drm_i915_gem_exec_object2 *exec;
+	struct drm_i915_gem_execbuffer2 args = {};
+	struct i915_gem_context *ctx;
+	struct drm_file *file;
+	u64 cached, uncached;
+	unsigned int i;
+	int err;
+
+	file = mock_file(i915);
+	if (IS_ERR(file))
+		return PTR_ERR(file);
+
+	ctx = i915_gem_context_lookup(file->driver_priv, 0);
+	if (!ctx) {
+		err = -ENOENT;
+		goto out_file;
+	}
+
+	exec = kvmalloc_array(EB_NUM_OBJECTS + 1, eb_element_size(),
+			      GFP_KERNEL | __GFP_ZERO);
+	if (!exec) {
+		err = -ENOMEM;
+		goto out_ctx;
+	}
+
+	for (i = 0; i < EB_NUM_OBJECTS; i++) {
+		err = igt_add_object(i915, file, &exec[i].handle,
+				     i == EB_NUM_OBJECTS - 1);
+		if (err)
+			goto out_exec;
+	}
+
+	args.buffer_count = EB_NUM_OBJECTS;
+	args.flags = I915_EXEC_NO_RELOC;
+
+	err = igt_execbuf(i915, file, &args, exec);
+	if (err) {
+		pr_err("First execbuf failed, err=%d\n", err);
+		goto out_exec;
+	}
+
+	if (list_empty(&ctx->eb_lists)) {
+		pr_err("Buffer list of %d objects not kept\n", EB_NUM_OBJECTS);
+		err = -EINVAL;
+		goto out_exec;
+	}
+
+	uncached = igt_time_execbuf(i915, file, &args, exec, ctx, false, &err);
+	if (err)
+		goto out_exec;
+
+	cached = igt_time_execbuf(i915, file, &args, exec, ctx, true, &err);
+	if (err)
+		goto out_exec;
+
+	pr_info("%d objects: %lluns per execbuf reusing the buffer list, %lluns looking up every handle\n",
+		EB_NUM_OBJECTS, cached, uncached);
+
+	/* A closed handle must not be found through a kept list */
+	err = drm_gem_handle_delete(file, exec[0].handle);
+	if (err)
+		goto out_exec;
+
+	err = igt_execbuf(i915, file, &args, exec);
+	if (err != -ENOENT) {
+		pr_err("execbuf with a closed handle returned %d\n", err);
+		err = -EINVAL;
+		goto out_exec;
+	}
+	err = 0;
+
+out_exec:
+	kvfree(exec);
+out_ctx:
+	i915_gem_context_put(ctx);
+out_file:
+	if (igt_flush_test(i915))
+		err = -EIO;
+	mock_file_free(i915, file);
+	return err;
+}
+
+int i915_gem_execbuffer_live_selftests(struct drm_i915_private *i915)
+{
+	static const struct i915_subtest tests[] = {
+		SUBTEST(igt_execbuf_buffer_list),
+	};
+
+	if (intel_gt_is_wedged(&i915->gt))
+		return 0;
+
+	return i915_live_subtests(tests, i915);
+}
@@ -1539,6 +1539,7 @@ void intel_engine_dump(struct intel_engine_cs *engine,
 	drm_printf(m, "Idle? %s\n", yesno(intel_engine_is_idle(engine)));
 
 	intel_engine_print_breadcrumbs(engine, m);
+	intel_engine_print_cmd_cache(engine, m);
 }
 
 static ktime_t __intel_engine_get_busy_time(struct intel_engine_cs *engine)
@@ -58,6 +58,7 @@ struct drm_i915_reg_table;
 struct i915_gem_context;
 struct i915_request;
 struct i915_sched_attr;
+struct intel_engine_cmd_cache;
 struct intel_gt;
 struct intel_ring;
 struct intel_uncore;
@@ -497,6 +498,12 @@ struct intel_engine_cs {
 	 */
 	u32 (*get_cmd_length_mask)(u32 cmd_header);
 
+	/*
+	 * Batches that already passed the command parser, see
+	 * i915_cmd_parser.c.
+	 */
+	struct intel_engine_cmd_cache *cmd_cache;
+
 	struct {
 		unsigned int enabled;
 		/**
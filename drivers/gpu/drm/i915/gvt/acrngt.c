@@ -29,6 +29,8 @@
 #include <linux/mm.h>
 #include <linux/types.h>
 #include <linux/kthread.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/time.h>
 #include <linux/freezer.h>
 #include <linux/wait.h>
@@ -64,6 +66,11 @@ static DEFINE_MUTEX(acrn_gvt_sysfs_lock);
 struct gvt_acrngt acrngt_priv;
 const struct intel_gvt_ops *intel_gvt_ops;
 
+static bool vcpu_threads;
+module_param(vcpu_threads, bool, 0444);
+MODULE_PARM_DESC(vcpu_threads,
+	"Emulate the ioreqs of each vcpu in its own thread (default: false)");
+
 static void disable_domu_plane(int pipe, int plane)
 {
 	struct drm_i915_private *dev_priv = acrngt_priv.gvt->dev_priv;
@@ -86,6 +93,14 @@ void acrngt_instance_destroy(struct intel_vgpu *vgpu)
 		if (info && info->emulation_thread != NULL)
 			kthread_stop(info->emulation_thread);
 
+		if (info && info->vcpu_threads) {
+			int vcpu;
+
+			for (vcpu = 0; vcpu < info->nr_vcpu; vcpu++)
+				if (info->vcpu_threads[vcpu].task)
+					kthread_stop(info->vcpu_threads[vcpu].task);
+		}
+
 		for_each_pipe(gvt->dev_priv, pipe) {
 			for_each_universal_plane(gvt->dev_priv, pipe, plane) {
 				if (gvt->pipe_info[pipe].owner == vgpu->id) {
@@ -108,6 +123,7 @@ void acrngt_instance_destroy(struct intel_vgpu *vgpu)
 		if (info->vm)
 			put_vm(info->vm);
 
+		kfree(info->vcpu_threads);
 		kfree(info);
 	}
 }
@@ -222,13 +238,86 @@ static void handle_request_error(struct intel_vgpu *vgpu)
 	mutex_unlock(&vgpu->gvt->lock);
 }
 
+/* Emulate the request of @vcpu if it is pending, return 1 if it was. */
+static int acrngt_handle_ioreq(struct intel_vgpu *vgpu, int client, int vcpu)
+{
+	struct acrngt_hvm_dev *info = (struct acrngt_hvm_dev *)vgpu->handle;
+	struct vhm_request *req = &info->req_buf[vcpu];
+	int ret;
+
+	if (atomic_read(&req->processed) != REQ_STATE_PROCESSING ||
+	    req->client != client)
+		return 0;
+
+	gvt_dbg_core("handle ioreq type %d\n", req->type);
+	switch (req->type) {
+	case REQ_PCICFG:
+		ret = acrngt_hvm_pio_emulation(vgpu, req);
+		break;
+	case REQ_MMIO:
+	case REQ_WP:
+		ret = acrngt_hvm_mmio_emulation(vgpu, req);
+		break;
+	default:
+		gvt_err("Unknown ioreq type %x\n", req->type);
+		ret = -EINVAL;
+		break;
+	}
+	/* error handling */
+	if (ret)
+		handle_request_error(vgpu);
+
+	smp_mb();
+	atomic_set(&req->processed, REQ_STATE_COMPLETE);
+	/* complete request */
+	if (acrn_ioreq_complete_request(client, vcpu, req))
+		gvt_err("failed complete request\n");
+
+	return 1;
+}
+
+/*
+ * Serve the pending requests of vcpus [@first, @last), then scan again for
+ * ones posted meanwhile, so that a burst of MMIO accesses is emulated in one
+ * wakeup instead of going back to sleep after every request.
+ */
+static int acrngt_drain_ioreqs(struct intel_vgpu *vgpu, int client,
+			       int first, int last)
+{
+	int vcpu, n, total = 0;
+
+	do {
+		n = 0;
+		for (vcpu = first; vcpu < last; vcpu++)
+			n += acrngt_handle_ioreq(vgpu, client, vcpu);
+		total += n;
+	} while (n && !kthread_should_stop());
+
+	return total;
+}
+
+static void acrngt_account_wakeup(struct acrngt_hvm_dev *info, int nr)
+{
+	s64 max = atomic64_read(&info->stat_max_batch);
+	s64 old;
+
+	atomic64_inc(&info->stat_wakeups);
+	atomic64_add(nr, &info->stat_ioreqs);
+
+	while (nr > max) {
+		old = atomic64_cmpxchg(&info->stat_max_batch, max, nr);
+		if (old == max)
+			break;
+		max = old;
+	}
+}
+
 static int acrngt_emulation_thread(void *priv)
 {
 	struct intel_vgpu *vgpu = (struct intel_vgpu *)priv;
 	struct acrngt_hvm_dev *info = (struct acrngt_hvm_dev *)vgpu->handle;
-	struct vhm_request *req;
 
-	int vcpu, ret;
+	int ret;
 	int nr_vcpus = info->nr_vcpu;
 
 	gvt_dbg_core("start kthread for VM%d\n", info->vm_id);
@@ -248,45 +337,89 @@ static int acrngt_emulation_thread(void *priv)
 		if (kthread_should_stop())
 			return 0;
 
-		for (vcpu = 0; vcpu < nr_vcpus; vcpu++) {
-			req = &info->req_buf[vcpu];
-			if (atomic_read(&req->processed) ==
-				REQ_STATE_PROCESSING &&
-				req->client == info->client) {
-				gvt_dbg_core("handle ioreq type %d\n",
-						req->type);
-				switch (req->type) {
-				case REQ_PCICFG:
-					ret = acrngt_hvm_pio_emulation(vgpu, req);
-					break;
-				case REQ_MMIO:
-				case REQ_WP:
-					ret = acrngt_hvm_mmio_emulation(vgpu, req);
-					break;
-				default:
-					gvt_err("Unknown ioreq type %x\n",
-						req->type);
-					ret = -EINVAL;
-					break;
-				}
-				/* error handling */
-				if (ret)
-					handle_request_error(vgpu);
-
-				smp_mb();
-				atomic_set(&req->processed, REQ_STATE_COMPLETE);
-				/* complete request */
-				if (acrn_ioreq_complete_request(info->client,
-						vcpu, req))
-					gvt_err("failed complete request\n");
-			}
+		acrngt_account_wakeup(info,
+			acrngt_drain_ioreqs(vgpu, info->client, 0, nr_vcpus));
+	}
+
+	BUG(); /* It's actually impossible to reach here */
+	return 0;
+}
+
+/*
+ * With vcpu_threads set, every vcpu gets its own thread so that the requests
+ * of different vcpus are not queued behind each other.  The emulation itself
+ * still serializes on vgpu_lock.
+ */
+static int acrngt_vcpu_emulation_thread(void *priv)
+{
+	struct acrngt_vcpu_thread *t = priv;
+	struct intel_vgpu *vgpu = t->vgpu;
+	struct acrngt_hvm_dev *info = (struct acrngt_hvm_dev *)vgpu->handle;
+	int client = info->client;
+	int ret;
+
+	gvt_dbg_core("start kthread for VM%d vcpu %d\n", info->vm_id, t->vcpu);
+
+	set_freezable();
+	while (1) {
+		ret = acrn_ioreq_wait_vcpu(client, t->vcpu, 1);
+
+		if (ret) {
+			gvt_err("error while waiting for vcpu %d ioreq %d\n",
+				t->vcpu, ret);
+			t->task = NULL;
+			return 0;
 		}
+
+		if (kthread_should_stop())
+			return 0;
+
+		acrngt_account_wakeup(info,
+			acrngt_drain_ioreqs(vgpu, client, t->vcpu, t->vcpu + 1));
 	}
 
 	BUG(); /* It's actually impossible to reach here */
 	return 0;
 }
 
+static int acrngt_start_vcpu_threads(struct intel_vgpu *vgpu)
+{
+	struct acrngt_hvm_dev *info = (struct acrngt_hvm_dev *)vgpu->handle;
+	struct acrngt_vcpu_thread *t;
+	int vcpu;
+
+	info->vcpu_threads = kcalloc(info->nr_vcpu, sizeof(*t), GFP_KERNEL);
+	if (!info->vcpu_threads)
+		return -ENOMEM;
+
+	for (vcpu = 0; vcpu < info->nr_vcpu; vcpu++) {
+		t = &info->vcpu_threads[vcpu];
+		t->vgpu = vgpu;
+		t->vcpu = vcpu;
+		t->task = kthread_run(acrngt_vcpu_emulation_thread, t,
+				"acrngt_emulation:%d/%d", info->vm_id, vcpu);
+		if (IS_ERR(t->task)) {
+			int ret = PTR_ERR(t->task);
+
+			t->task = NULL;
+			return ret;
+		}
+	}
+	return 0;
+}
+
+static int acrngt_stats_show(struct seq_file *m, void *unused)
+{
+	struct acrngt_hvm_dev *info = m->private;
+
+	seq_printf(m, "wakeups: %lld\n", atomic64_read(&info->stat_wakeups));
+	seq_printf(m, "ioreqs: %lld\n", atomic64_read(&info->stat_ioreqs));
+	seq_printf(m, "max_batch: %lld\n",
+		   atomic64_read(&info->stat_max_batch));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(acrngt_stats);
+
 struct intel_vgpu *acrngt_instance_create(domid_t vm_id,
 					struct intel_vgpu_type *vgpu_type)
 {
@@ -353,13 +486,24 @@ struct intel_vgpu *acrngt_instance_create(domid_t vm_id,
 	/* trap config space access */
 	acrn_ioreq_intercept_bdf(info->client, 0, 2, 0);
 
-	thread = kthread_run(acrngt_emulation_thread, vgpu,
-			"acrngt_emulation:%d", vm_id);
-	if (IS_ERR(thread)) {
-		gvt_err("failed to run emulation thread for vm %d\n", vm_id);
-		goto err;
+	if (vcpu_threads) {
+		if (acrngt_start_vcpu_threads(vgpu)) {
+			gvt_err("failed to run emulation threads for vm %d\n",
+				vm_id);
+			goto err;
+		}
+	} else {
+		thread = kthread_run(acrngt_emulation_thread, vgpu,
+				"acrngt_emulation:%d", vm_id);
+		if (IS_ERR(thread)) {
+			gvt_err("failed to run emulation thread for vm %d\n",
+				vm_id);
+			goto err;
+		}
+		info->emulation_thread = thread;
 	}
-	info->emulation_thread = thread;
+	debugfs_create_file("acrngt_stats", 0444, vgpu->debugfs, info,
+			    &acrngt_stats_fops);
 	gvt_dbg_core("create vgpu instance success, vm_id %d, client %d,"
 		" nr_vcpu %d\n", info->vm_id, info->client, info->nr_vcpu);
 
@@ -46,10 +46,23 @@ struct acrngt_hvm_dev {
 
 	int nr_vcpu;
 	struct task_struct *emulation_thread;
+	/* one per vcpu instead of emulation_thread, see vcpu_threads param */
+	struct acrngt_vcpu_thread *vcpu_threads;
 
 	int client;
 	struct vhm_request *req_buf;
 	struct vhm_vm *vm;
+
+	/* emulation statistics, shown in the vGPU's debugfs directory */
+	atomic64_t stat_wakeups;
+	atomic64_t stat_ioreqs;
+	atomic64_t stat_max_batch;
+};
+
+struct acrngt_vcpu_thread {
+	struct intel_vgpu *vgpu;
+	int vcpu;
+	struct task_struct *task;
 };
 
 struct acrngt_hvm_params {
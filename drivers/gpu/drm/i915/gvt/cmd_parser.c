@@ -34,6 +34,7 @@
  *
  */
 
+#include <linux/jhash.h>
 #include <linux/slab.h>
 
 #include "i915_drv.h"
@@ -460,6 +461,38 @@ enum {
 	PPGTT_BUFFER
 };
 
+/* largest batch buffer kept in the scan cache */
+#define BB_CACHE_MAX_SIZE	SZ_64K
+/* bytes of cached batch buffers per vGPU */
+#define BB_CACHE_MAX_BYTES	SZ_4M
+#define BB_CACHE_MAX_PATCHES	16
+
+/*
+ * A batch buffer that passed the scan.  @cmds holds the guest's commands up
+ * to and excluding the terminating MI_BATCH_BUFFER_END or chained
+ * MI_BATCH_BUFFER_START, the scan result is the values it patched and the
+ * events it raised.
+ */
+struct bb_cache_entry {
+	struct hlist_node gma_node;
+	struct hlist_node hash_node;
+	struct list_head lru;
+	unsigned long gma;
+	u32 hash;
+	u32 size;
+	u32 end_offset;
+	int ring_id;
+	int buf_type;
+	int buf_addr_type;
+	unsigned int nr_patches;
+	struct {
+		u32 offset;
+		u32 val;
+	} patches[BB_CACHE_MAX_PATCHES];
+	DECLARE_BITMAP(events, INTEL_GVT_EVENT_MAX);
+	u32 cmds[];
+};
+
 struct parser_exec_state {
 	struct intel_vgpu *vgpu;
 	int ring_id;
@@ -498,6 +531,11 @@ struct parser_exec_state {
 	const struct cmd_info *info;
 
 	struct intel_vgpu_workload *workload;
+
+	/* batch buffer being scanned for the scan cache, if cacheable */
+	struct bb_cache_entry *bb_rec;
+	void *bb_rec_va;
+	void *bb_rec_end_va;
 };
 
 #define gmadr_dw_number(s)	\
@@ -810,9 +848,54 @@ static inline int cmd_length(struct parser_exec_state *s)
 	return get_cmd_length(s->info, cmd_val(s, 0));
 }
 
+static void bb_cache_drop(struct parser_exec_state *s)
+{
+	kvfree(s->bb_rec);
+	s->bb_rec = NULL;
+}
+
+/*
+ * The batch buffer being scanned depends on more than its own content, e.g.
+ * it writes vregs, and has to be scanned again on every submission.
+ */
+static void bb_cache_uncacheable(struct parser_exec_state *s)
+{
+	if (!s->bb_rec)
+		return;
+
+	s->vgpu->submission.bb_cache.uncacheable++;
+	bb_cache_drop(s);
+}
+
+static void bb_cache_note_patch(struct parser_exec_state *s, u32 *addr)
+{
+	struct bb_cache_entry *e = s->bb_rec;
+
+	if (!e)
+		return;
+
+	if ((void *)addr < s->bb_rec_va || (void *)addr >= s->bb_rec_end_va ||
+	    e->nr_patches == BB_CACHE_MAX_PATCHES) {
+		bb_cache_uncacheable(s);
+		return;
+	}
+
+	e->patches[e->nr_patches].offset = (void *)addr - s->bb_rec_va;
+	e->patches[e->nr_patches].val = *addr;
+	e->nr_patches++;
+}
+
+static void set_pending_event(struct parser_exec_state *s, int event)
+{
+	set_bit(event, s->workload->pending_events);
+	if (s->bb_rec)
+		set_bit(event, s->bb_rec->events);
+}
+
 /* do not remove this, some platform may need clflush here */
 #define patch_value(s, addr, val) do { \
 	*addr = val; \
+	bb_cache_note_patch(s, addr); \
 } while (0)
 
 static bool is_shadowed_mmio(unsigned int offset)
@@ -874,6 +957,7 @@ static int mocs_cmd_reg_handler(struct parser_exec_state *s,
 {
 	if (!is_mocs_mmio(offset))
 		return -EINVAL;
+	bb_cache_uncacheable(s);
 	vgpu_vreg(s->vgpu, offset) = cmd_val(s, index + 1);
 	return 0;
 }
@@ -929,6 +1013,7 @@ static int cmd_reg_handler(struct parser_exec_state *s,
 	if (IS_GEN(gvt->dev_priv, 9) &&
 			intel_gvt_mmio_is_in_ctx(gvt, offset) &&
 			!strncmp(cmd, "lri", 3)) {
+		bb_cache_uncacheable(s);
 		intel_gvt_hypervisor_read_gpa(s->vgpu,
 			s->workload->ring_context_gpa + 12, &ctx_sr_ctl, 4);
 		/* check inhibit context */
@@ -1141,6 +1226,7 @@ static int cmd_handler_pipe_control(struct parser_exec_state *s)
 				if (ret)
 					return ret;
 				if (index_mode) {
+					bb_cache_uncacheable(s);
 					hws_pga = s->vgpu->hws_pga[s->ring_id];
 					gma = hws_pga + gma;
 					patch_value(s, cmd_ptr(s, 2), gma);
@@ -1155,15 +1241,14 @@ static int cmd_handler_pipe_control(struct parser_exec_state *s)
 		return ret;
 
 	if (cmd_val(s, 1) & PIPE_CONTROL_NOTIFY)
-		set_bit(cmd_interrupt_events[s->ring_id].pipe_control_notify,
-				s->workload->pending_events);
+		set_pending_event(s,
+			cmd_interrupt_events[s->ring_id].pipe_control_notify);
 	return 0;
 }
 
 static int cmd_handler_mi_user_interrupt(struct parser_exec_state *s)
 {
-	set_bit(cmd_interrupt_events[s->ring_id].mi_user_interrupt,
-			s->workload->pending_events);
+	set_pending_event(s, cmd_interrupt_events[s->ring_id].mi_user_interrupt);
 	patch_value(s, cmd_ptr(s, 0), MI_NOOP);
 	return 0;
 }
@@ -1418,6 +1503,9 @@ static int cmd_handler_mi_display_flip(struct parser_exec_state *s)
 	if (ret)
 		return ret;
 
+	/* flips update the plane vregs */
+	bb_cache_uncacheable(s);
+
 	ret = decode_mi_display_flip(s, &info);
 	if (ret) {
 		gvt_vgpu_err("fail to decode MI display flip command\n");
@@ -1667,6 +1755,7 @@ static int cmd_handler_mi_flush_dw(struct parser_exec_state *s)
 		if (ret)
 			return ret;
 		if (index_mode) {
+			bb_cache_uncacheable(s);
 			hws_pga = s->vgpu->hws_pga[s->ring_id];
 			gma = hws_pga + gma;
 			patch_value(s, cmd_ptr(s, 1), gma);
@@ -1676,8 +1765,8 @@ static int cmd_handler_mi_flush_dw(struct parser_exec_state *s)
 	}
 	/* Check notify bit */
 	if ((cmd_val(s, 0) & (1 << 8)))
-		set_bit(cmd_interrupt_events[s->ring_id].mi_flush_dw,
-				s->workload->pending_events);
+		set_pending_event(s,
+			cmd_interrupt_events[s->ring_id].mi_flush_dw);
 	return ret;
 }
 
@@ -1816,13 +1905,219 @@ static int audit_bb_end(struct parser_exec_state *s, void *va)
 	return -EBADRQC;
 }
 
+/*
+ * Scan cache
+ *
+ * Guests submit the same batch buffers over and over, e.g. every frame.  A
+ * batch buffer which passed the scan is kept with the values the scan
+ * patched into it and the events it raised; when the guest submits a batch
+ * buffer with the same content again, those are replayed instead of scanning
+ * it.  Batch buffers whose scan has side effects beyond that, or depends on
+ * vGPU state, are never cached, see bb_cache_uncacheable().
+ *
+ * The shadow copy is made on every submission anyway and always compared
+ * with the cached content, so a guest rewriting a batch buffer never needs
+ * to be trapped: a cached batch buffer is looked up by its address first,
+ * which also saves find_bb_size() walking it, and by a hash of its content
+ * when it moved.
+ */
+static u32 bb_cache_hash(const void *va, unsigned long size)
+{
+	return jhash2(va, size / sizeof(u32), 0);
+}
+
+static bool bb_cache_key_match(struct bb_cache_entry *e,
+			       struct parser_exec_state *s)
+{
+	return e->ring_id == s->ring_id && e->buf_type == s->buf_type &&
+		e->buf_addr_type == s->buf_addr_type;
+}
+
+static struct bb_cache_entry *
+bb_cache_find_gma(struct intel_vgpu_bb_cache *cache,
+		  struct parser_exec_state *s, unsigned long gma)
+{
+	struct bb_cache_entry *e;
+
+	hash_for_each_possible(cache->gma_table, e, gma_node, gma)
+		if (e->gma == gma && bb_cache_key_match(e, s))
+			return e;
+
+	return NULL;
+}
+
+static struct bb_cache_entry *
+bb_cache_find_content(struct intel_vgpu_bb_cache *cache,
+		      struct parser_exec_state *s, const void *va,
+		      unsigned long size, u32 hash)
+{
+	struct bb_cache_entry *e;
+
+	hash_for_each_possible(cache->hash_table, e, hash_node, hash)
+		if (e->hash == hash && e->size == size &&
+		    bb_cache_key_match(e, s) && !memcmp(e->cmds, va, size))
+			return e;
+
+	return NULL;
+}
+
+static void bb_cache_remove(struct intel_vgpu_bb_cache *cache,
+			    struct bb_cache_entry *e)
+{
+	hash_del(&e->gma_node);
+	hash_del(&e->hash_node);
+	list_del(&e->lru);
+	cache->nr_entries--;
+	cache->bytes -= e->size;
+	kvfree(e);
+}
+
+/* Cached content turned up at @gma, replacing any entry there. */
+static void bb_cache_move(struct intel_vgpu_bb_cache *cache,
+			  struct parser_exec_state *s,
+			  struct bb_cache_entry *e, unsigned long gma)
+{
+	struct bb_cache_entry *old;
+
+	old = bb_cache_find_gma(cache, s, gma);
+	if (old)
+		bb_cache_remove(cache, old);
+
+	hash_del(&e->gma_node);
+	e->gma = gma;
+	hash_add(cache->gma_table, &e->gma_node, gma);
+}
+
+/* Start recording the scan of a batch buffer just copied to @va. */
+static void bb_cache_record(struct parser_exec_state *s, unsigned long gma,
+			    void *va, unsigned long size,
+			    unsigned long end_offset, u32 hash)
+{
+	struct bb_cache_entry *e;
+
+	if (size > BB_CACHE_MAX_SIZE)
+		return;
+
+	e = kvmalloc(struct_size(e, cmds, size / sizeof(u32)), GFP_KERNEL);
+	if (!e)
+		return;
+
+	e->gma = gma;
+	e->hash = hash;
+	e->size = size;
+	e->end_offset = end_offset;
+	e->ring_id = s->ring_id;
+	e->buf_type = s->buf_type;
+	e->buf_addr_type = s->buf_addr_type;
+	e->nr_patches = 0;
+	bitmap_zero(e->events, INTEL_GVT_EVENT_MAX);
+	memcpy(e->cmds, va, size);
+
+	s->bb_rec = e;
+	s->bb_rec_va = va;
+	s->bb_rec_end_va = va + end_offset;
+}
+
+/* The recorded batch buffer was scanned up to its terminating command. */
+static void bb_cache_commit(struct parser_exec_state *s)
+{
+	struct intel_vgpu_bb_cache *cache = &s->vgpu->submission.bb_cache;
+	struct bb_cache_entry *e = s->bb_rec, *old;
+
+	s->bb_rec = NULL;
+
+	old = bb_cache_find_gma(cache, s, e->gma);
+	if (old)
+		bb_cache_remove(cache, old);
+
+	hash_add(cache->gma_table, &e->gma_node, e->gma);
+	hash_add(cache->hash_table, &e->hash_node, e->hash);
+	list_add(&e->lru, &cache->lru);
+	cache->nr_entries++;
+	cache->bytes += e->size;
+
+	while (cache->bytes > BB_CACHE_MAX_BYTES) {
+		bb_cache_remove(cache, list_last_entry(&cache->lru,
+						       struct bb_cache_entry,
+						       lru));
+		cache->evictions++;
+	}
+}
+
+/* Apply the scan result of @e to the shadow batch buffer at @va. */
+static void bb_cache_replay(struct parser_exec_state *s,
+			    struct bb_cache_entry *e, void *va)
+{
+	struct intel_vgpu_bb_cache *cache = &s->vgpu->submission.bb_cache;
+	unsigned int i;
+
+	for (i = 0; i < e->nr_patches; i++)
+		*(u32 *)(va + e->patches[i].offset) = e->patches[i].val;
+
+	bitmap_or(s->workload->pending_events, s->workload->pending_events,
+		  e->events, INTEL_GVT_EVENT_MAX);
+
+	list_move(&e->lru, &cache->lru);
+	cache->hits++;
+	cache->scan_bytes_avoided += e->end_offset;
+}
+
+/**
+ * intel_vgpu_init_bb_cache - initialize the batch buffer scan cache
+ * @vgpu: a vGPU
+ */
+void intel_vgpu_init_bb_cache(struct intel_vgpu *vgpu)
+{
+	struct intel_vgpu_bb_cache *cache = &vgpu->submission.bb_cache;
+
+	memset(cache, 0, sizeof(*cache));
+	hash_init(cache->gma_table);
+	hash_init(cache->hash_table);
+	INIT_LIST_HEAD(&cache->lru);
+}
+
+/**
+ * intel_vgpu_clean_bb_cache - drop all cached batch buffers
+ * @vgpu: a vGPU
+ *
+ * The statistics are kept.
+ */
+void intel_vgpu_clean_bb_cache(struct intel_vgpu *vgpu)
+{
+	struct intel_vgpu_bb_cache *cache = &vgpu->submission.bb_cache;
+	struct bb_cache_entry *e, *n;
+
+	list_for_each_entry_safe(e, n, &cache->lru, lru)
+		bb_cache_remove(cache, e);
+}
+
+void intel_vgpu_bb_cache_show(struct intel_vgpu *vgpu, struct seq_file *m)
+{
+	struct intel_vgpu_bb_cache *cache = &vgpu->submission.bb_cache;
+
+	seq_printf(m, "entries: %u (%lu bytes)\n",
+		   cache->nr_entries, cache->bytes);
+	seq_printf(m, "lookups: %llu\n", cache->lookups);
+	seq_printf(m, "hits: %llu\n", cache->hits);
+	seq_printf(m, "stale: %llu\n", cache->stale);
+	seq_printf(m, "uncacheable: %llu\n", cache->uncacheable);
+	seq_printf(m, "evictions: %llu\n", cache->evictions);
+	seq_printf(m, "scan bytes avoided: %llu\n", cache->scan_bytes_avoided);
+}
+
 static int perform_bb_shadow(struct parser_exec_state *s)
 {
 	struct intel_vgpu *vgpu = s->vgpu;
+	struct intel_vgpu_bb_cache *cache = &vgpu->submission.bb_cache;
+	struct bb_cache_entry *cached;
 	struct intel_vgpu_shadow_bb *bb;
 	unsigned long gma = 0;
 	unsigned long bb_size;
 	unsigned long bb_end_cmd_offset;
+	bool lookup_gma = true;
+	bool stale = false;
+	u32 hash = 0;
+	void *va;
 	int ret = 0;
 	struct intel_vgpu_mm *mm = (s->buf_addr_type == GTT_BUFFER) ?
 		s->vgpu->gtt.ggtt_mm : s->workload->shadow_mm;
@@ -1833,9 +2128,20 @@ static int perform_bb_shadow(struct parser_exec_state *s)
 	if (gma == INTEL_GVT_INVALID_ADDR)
 		return -EFAULT;
 
-	ret = find_bb_size(s, &bb_size, &bb_end_cmd_offset);
-	if (ret)
-		return ret;
+	/* a batch buffer calling a 2nd level one isn't cached */
+	bb_cache_uncacheable(s);
+	cache->lookups++;
+
+again:
+	cached = lookup_gma ? bb_cache_find_gma(cache, s, gma) : NULL;
+	if (cached) {
+		bb_size = cached->size;
+		bb_end_cmd_offset = cached->end_offset;
+	} else {
+		ret = find_bb_size(s, &bb_size, &bb_end_cmd_offset);
+		if (ret)
+			return ret;
+	}
 
 	bb = kzalloc(sizeof(*bb), GFP_KERNEL);
 	if (!bb)
@@ -1880,16 +2186,33 @@ static int perform_bb_shadow(struct parser_exec_state *s)
 		bb->clflush &= ~CLFLUSH_BEFORE;
 	}
 
+	va = bb->va + start_offset;
 	ret = copy_gma_to_hva(s->vgpu, mm,
-			      gma, gma + bb_size,
-			      bb->va + start_offset);
+			      gma, gma + bb_size, va);
+	if (cached && (ret < 0 || memcmp(va, cached->cmds, bb_size))) {
+		/*
+		 * Rewritten by the guest, or no longer mapped as far as the
+		 * cached size reaches: find the size from the guest again.
+		 */
+		bb_cache_remove(cache, cached);
+		cache->stale++;
+		stale = true;
+		goto err_unmap;
+	}
 	if (ret < 0) {
 		gvt_vgpu_err("fail to copy guest ring buffer\n");
 		ret = -EFAULT;
 		goto err_unmap;
 	}
 
-	ret = audit_bb_end(s, bb->va + start_offset + bb_end_cmd_offset);
+	if (!cached) {
+		hash = bb_cache_hash(va, bb_size);
+		cached = bb_cache_find_content(cache, s, va, bb_size, hash);
+		if (cached && cached->gma != gma)
+			bb_cache_move(cache, s, cached, gma);
+	}
+
+	ret = audit_bb_end(s, va + bb_end_cmd_offset);
 	if (ret)
 		goto err_unmap;
 
@@ -1912,8 +2235,17 @@ static int perform_bb_shadow(struct parser_exec_state *s)
 	 * buffer's gma in pair. After all, we don't want to pin the shadow
 	 * buffer here (too early).
 	 */
-	s->ip_va = bb->va + start_offset;
+	s->ip_va = va;
 	s->ip_gma = gma;
+
+	/* a cached batch buffer only needs its last command parsed */
+	if (cached) {
+		bb_cache_replay(s, cached, va);
+		s->ip_va += bb_end_cmd_offset;
+		s->ip_gma += bb_end_cmd_offset;
+	} else {
+		bb_cache_record(s, gma, va, bb_size, bb_end_cmd_offset, hash);
+	}
 	return 0;
 err_unmap:
 	i915_gem_object_unpin_map(bb->obj);
@@ -1923,6 +2255,11 @@ static int perform_bb_shadow(struct parser_exec_state *s)
 	i915_gem_object_put(bb->obj);
 err_free_bb:
 	kfree(bb);
+	if (stale) {
+		stale = false;
+		lookup_gma = false;
+		goto again;
+	}
 	return ret;
 }
 
@@ -2660,6 +2997,9 @@ static int cmd_parser_exec(struct parser_exec_state *s)
 	u32 cmd;
 	int ret = 0;
 
+	if (s->bb_rec && s->ip_va == s->bb_rec_end_va)
+		bb_cache_commit(s);
+
 	cmd = cmd_val(s, 0);
 
 	/* fastpath for MI_NOOP */
@@ -2789,6 +3129,7 @@ static int scan_workload(struct intel_vgpu_workload *workload)
 	s.rb_va = workload->shadow_ring_buffer_va;
 	s.workload = workload;
 	s.is_ctx_wa = false;
+	s.bb_rec = NULL;
 
 	if ((bypass_scan_mask & (1 << workload->ring_id)) ||
 		gma_head == gma_tail)
@@ -2800,6 +3141,7 @@ static int scan_workload(struct intel_vgpu_workload *workload)
 
 	ret = command_scan(&s, workload->rb_head, workload->rb_tail,
 		workload->rb_start, _RING_CTL_BUF_SIZE(workload->rb_ctl));
+	bb_cache_drop(&s);
 
 out:
 	return ret;
@@ -2838,6 +3180,7 @@ static int scan_wa_ctx(struct intel_shadow_wa_ctx *wa_ctx)
 	s.rb_va = wa_ctx->indirect_ctx.shadow_va;
 	s.workload = workload;
 	s.is_ctx_wa = true;
+	s.bb_rec = NULL;
 
 	ret = ip_gma_set(&s, gma_head);
 	if (ret)
@@ -2845,6 +3188,7 @@ static int scan_wa_ctx(struct intel_shadow_wa_ctx *wa_ctx)
 
 	ret = command_scan(&s, 0, ring_tail,
 		wa_ctx->indirect_ctx.guest_gma, ring_size);
+	bb_cache_drop(&s);
 out:
 	return ret;
 }
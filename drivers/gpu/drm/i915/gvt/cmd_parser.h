@@ -36,8 +36,40 @@
 #ifndef _GVT_CMD_PARSER_H_
 #define _GVT_CMD_PARSER_H_
 
+#include <linux/hashtable.h>
+
 #define GVT_CMD_HASH_BITS 7
 
+#define GVT_BB_CACHE_HASH_BITS 6
+
+/*
+ * Batch buffers that already passed the scan, per vGPU.  Protected by
+ * vgpu_lock, like the rest of the submission state.
+ */
+struct intel_vgpu_bb_cache {
+	DECLARE_HASHTABLE(gma_table, GVT_BB_CACHE_HASH_BITS);
+	DECLARE_HASHTABLE(hash_table, GVT_BB_CACHE_HASH_BITS);
+	struct list_head lru;
+	unsigned int nr_entries;
+	unsigned long bytes;
+
+	u64 lookups;
+	u64 hits;
+	u64 stale;
+	u64 uncacheable;
+	u64 evictions;
+	u64 scan_bytes_avoided;
+};
+
+struct intel_vgpu;
+struct seq_file;
+
+void intel_vgpu_init_bb_cache(struct intel_vgpu *vgpu);
+
+void intel_vgpu_clean_bb_cache(struct intel_vgpu *vgpu);
+
+void intel_vgpu_bb_cache_show(struct intel_vgpu *vgpu, struct seq_file *m);
+
 void intel_gvt_clean_cmd_parser(struct intel_gvt *gvt);
 
 int intel_gvt_init_cmd_parser(struct intel_gvt *gvt);
@@ -22,6 +22,7 @@
  */
 #include <linux/debugfs.h>
 #include <linux/list_sort.h>
+#include <linux/sort.h>
 #include "i915_drv.h"
 #include "gvt.h"
 
@@ -186,6 +187,174 @@ DEFINE_SIMPLE_ATTRIBUTE(vgpu_scan_nonprivbb_fops,
 			vgpu_scan_nonprivbb_get, vgpu_scan_nonprivbb_set,
 			"0x%llx\n");
 
+/* Most expensive first. */
+static int mmio_hit_ns_compare(const void *a, const void *b)
+{
+	const struct intel_vgpu_mmio_hit *ha = a, *hb = b;
+
+	if (ha->ns > hb->ns)
+		return -1;
+	else if (ha->ns < hb->ns)
+		return 1;
+	return 0;
+}
+
+static int vgpu_mmio_hits_show(struct seq_file *s, void *unused)
+{
+	struct intel_vgpu *vgpu = s->private;
+	struct intel_vgpu_mmio_hit *hits, *hit;
+	unsigned int gtt = vgpu->gvt->device_info.gtt_start_offset;
+	int i, bkt, n = 0;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	hits = kvmalloc_array(max(vgpu->mmio.nr_hits, 1U), sizeof(*hits),
+			      GFP_KERNEL);
+	if (!hits) {
+		mutex_unlock(&vgpu->vgpu_lock);
+		return -ENOMEM;
+	}
+	hash_for_each(vgpu->mmio.hits, bkt, hit, node)
+		hits[n++] = *hit;
+	mutex_unlock(&vgpu->vgpu_lock);
+
+	sort(hits, n, sizeof(*hits), mmio_hit_ns_compare, NULL);
+
+	seq_printf(s, "%-8s %12s %12s %14s %8s\n",
+		   "Offset", "Reads", "Writes", "Total(ns)", "Avg(ns)");
+	for (i = 0; i < n; i++) {
+		hit = &hits[i];
+		if (hit->offset == gtt)
+			seq_printf(s, "%-8s", "GGTT");
+		else
+			seq_printf(s, "%08x", hit->offset);
+		seq_printf(s, " %12llu %12llu %14llu %8llu\n",
+			   hit->reads, hit->writes, hit->ns,
+			   div64_u64(hit->ns, hit->reads + hit->writes));
+	}
+	kvfree(hits);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_mmio_hits);
+
+static int
+vgpu_track_mmio_hits_get(void *data, u64 *val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+	*val = vgpu->mmio.track_hits;
+	return 0;
+}
+
+/*
+ * Writing non-zero starts counting trapped MMIO accesses per offset, zero
+ * stops.  Either way the counters shown in mmio_hits are reset.
+ */
+static int
+vgpu_track_mmio_hits_set(void *data, u64 val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	intel_vgpu_mmio_track_hits(vgpu, !!val);
+	mutex_unlock(&vgpu->vgpu_lock);
+	return 0;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(vgpu_track_mmio_hits_fops,
+			vgpu_track_mmio_hits_get, vgpu_track_mmio_hits_set,
+			"%llu\n");
+
+static int vgpu_shadow_stats_show(struct seq_file *s, void *unused)
+{
+	struct intel_vgpu *vgpu = s->private;
+	struct intel_vgpu_submission *sub = &vgpu->submission;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	seq_printf(s, "ctx_populate: %lu\n", sub->ctx_populate_cnt);
+	seq_printf(s, "ctx_populate_skipped: %lu\n", sub->ctx_populate_skip_cnt);
+	seq_printf(s, "ppgtt_wp_traps: %lu\n", vgpu->gtt.stats.wp_traps);
+	seq_printf(s, "ppgtt_partial_writes: %lu\n",
+		   vgpu->gtt.stats.partial_writes);
+	seq_printf(s, "ppgtt_oos_enter: %lu\n", vgpu->gtt.stats.oos_enter);
+	seq_printf(s, "ppgtt_oos_sync: %lu\n", vgpu->gtt.stats.oos_sync);
+	/* each of these would otherwise have cost a write-protect trap */
+	seq_printf(s, "ppgtt_wp_traps_avoided: %lu\n",
+		   vgpu->gtt.stats.oos_entries);
+	mutex_unlock(&vgpu->vgpu_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_shadow_stats);
+
+static int vgpu_bb_scan_cache_show(struct seq_file *s, void *unused)
+{
+	struct intel_vgpu *vgpu = s->private;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	intel_vgpu_bb_cache_show(vgpu, s);
+	mutex_unlock(&vgpu->vgpu_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_bb_scan_cache);
+
+static int vgpu_sched_stats_show(struct seq_file *s, void *unused)
+{
+	intel_vgpu_sched_show(s->private, s);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_sched_stats);
+
+static int
+vgpu_sched_weight_get(void *data, u64 *val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+	*val = vgpu->sched_ctl.weight;
+	return 0;
+}
+
+static int
+vgpu_sched_weight_set(void *data, u64 val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+	struct vgpu_sched_ctl ctl = vgpu->sched_ctl;
+
+	if (val > VGPU_MAX_WEIGHT)
+		return -EINVAL;
+	ctl.weight = val;
+	return intel_vgpu_set_sched_ctl(vgpu, &ctl);
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(vgpu_sched_weight_fops,
+			vgpu_sched_weight_get, vgpu_sched_weight_set,
+			"%llu\n");
+
+static int
+vgpu_sched_latency_prio_get(void *data, u64 *val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+	*val = vgpu->sched_ctl.latency_prio;
+	return 0;
+}
+
+/*
+ * Only used by the wfq scheduling policy: a vGPU with higher latency
+ * priority is scheduled ahead of its fair share for a short while and
+ * preempts lower priority vGPUs, e.g. for interactive guests.
+ */
+static int
+vgpu_sched_latency_prio_set(void *data, u64 val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+	struct vgpu_sched_ctl ctl = vgpu->sched_ctl;
+
+	if (val > VGPU_MAX_LATENCY_PRIO)
+		return -EINVAL;
+	ctl.latency_prio = val;
+	return intel_vgpu_set_sched_ctl(vgpu, &ctl);
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(vgpu_sched_latency_prio_fops,
+			vgpu_sched_latency_prio_get,
+			vgpu_sched_latency_prio_set, "%llu\n");
+
 /**
  * intel_gvt_debugfs_add_vgpu - register debugfs entries for a vGPU
  * @vgpu: a vGPU
@@ -202,6 +371,20 @@ void intel_gvt_debugfs_add_vgpu(struct intel_vgpu *vgpu)
 			    &vgpu_mmio_diff_fops);
 	debugfs_create_file("scan_nonprivbb", 0644, vgpu->debugfs, vgpu,
 			    &vgpu_scan_nonprivbb_fops);
+	debugfs_create_file("mmio_hits", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_mmio_hits_fops);
+	debugfs_create_file("track_mmio_hits", 0644, vgpu->debugfs, vgpu,
+			    &vgpu_track_mmio_hits_fops);
+	debugfs_create_file("sched_stats", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_sched_stats_fops);
+	debugfs_create_file("shadow_stats", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_shadow_stats_fops);
+	debugfs_create_file("bb_scan_cache", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_bb_scan_cache_fops);
+	debugfs_create_file("sched_weight", 0644, vgpu->debugfs, vgpu,
+			    &vgpu_sched_weight_fops);
+	debugfs_create_file("sched_latency_prio", 0644, vgpu->debugfs, vgpu,
+			    &vgpu_sched_latency_prio_fops);
 }
 
 /**
@@ -729,7 +729,7 @@ static void free_spt(struct intel_vgpu_ppgtt_spt *spt)
 	kfree(spt);
 }
 
-static int detach_oos_page(struct intel_vgpu *vgpu,
+static void release_oos_page(struct intel_vgpu *vgpu,
 		struct intel_vgpu_oos_page *oos_page);
 
 static void ppgtt_free_spt(struct intel_vgpu_ppgtt_spt *spt)
@@ -745,7 +745,7 @@ static void ppgtt_free_spt(struct intel_vgpu_ppgtt_spt *spt)
 
 	if (spt->guest_page.gfn) {
 		if (spt->guest_page.oos_page)
-			detach_oos_page(spt->vgpu, spt->guest_page.oos_page);
+			release_oos_page(spt->vgpu, spt->guest_page.oos_page);
 
 		intel_vgpu_unregister_page_track(spt->vgpu, spt->guest_page.gfn);
 	}
@@ -787,6 +787,8 @@ static int ppgtt_write_protection_handler(
 	if (bytes != 4 && bytes != 8)
 		return -EINVAL;
 
+	spt->vgpu->gtt.stats.wp_traps++;
+
 	ret = ppgtt_handle_guest_write_page_table_bytes(spt, gpa, data, bytes);
 	if (ret)
 		return ret;
@@ -1418,6 +1420,10 @@ static int ppgtt_handle_guest_entry_add(struct intel_vgpu_ppgtt_spt *spt,
 	return ret;
 }
 
+static int ppgtt_handle_guest_write_page_table(
+		struct intel_vgpu_ppgtt_spt *spt,
+		struct intel_gvt_gtt_entry *we, unsigned long index);
+
 static int sync_oos_page(struct intel_vgpu *vgpu,
 		struct intel_vgpu_oos_page *oos_page)
 {
@@ -1449,7 +1455,11 @@ static int sync_oos_page(struct intel_vgpu *vgpu,
 				spt, spt->guest_page.type,
 				new.val64, index);
 
-		ret = ppgtt_populate_shadow_entry(vgpu, spt, index, &new);
+		if (old.val64 != new.val64)
+			vgpu->gtt.stats.oos_entries++;
+
+		/* drops the shadow of the old entry, unlike a plain populate */
+		ret = ppgtt_handle_guest_write_page_table(spt, &new, index);
 		if (ret)
 			return ret;
 
@@ -1458,13 +1468,17 @@ static int sync_oos_page(struct intel_vgpu *vgpu,
 
 	spt->guest_page.write_cnt = 0;
 	list_del_init(&spt->post_shadow_list);
+	vgpu->gtt.stats.oos_sync++;
 	return 0;
 }
 
+/*
+ * The page stays on the use list, reserved for the caller: it is either
+ * attached to another spt right away or released.
+ */
 static int detach_oos_page(struct intel_vgpu *vgpu,
 		struct intel_vgpu_oos_page *oos_page)
 {
-	struct intel_gvt *gvt = vgpu->gvt;
 	struct intel_vgpu_ppgtt_spt *spt = oos_page->spt;
 
 	trace_oos_change(vgpu->id, "detach", oos_page->id,
@@ -1472,14 +1486,24 @@ static int detach_oos_page(struct intel_vgpu *vgpu,
 
 	spt->guest_page.write_cnt = 0;
 	spt->guest_page.oos_page = NULL;
-	oos_page->spt = NULL;
+	WRITE_ONCE(oos_page->spt, NULL);
 
 	list_del_init(&oos_page->vm_list);
-	list_move_tail(&oos_page->list, &gvt->gtt.oos_page_free_list_head);
-
 	return 0;
 }
 
+static void release_oos_page(struct intel_vgpu *vgpu,
+		struct intel_vgpu_oos_page *oos_page)
+{
+	struct intel_gvt *gvt = vgpu->gvt;
+
+	detach_oos_page(vgpu, oos_page);
+
+	spin_lock(&gvt->gtt.oos_page_lock);
+	list_move_tail(&oos_page->list, &gvt->gtt.oos_page_free_list_head);
+	spin_unlock(&gvt->gtt.oos_page_lock);
+}
+
 static int attach_oos_page(struct intel_vgpu_oos_page *oos_page,
 		struct intel_vgpu_ppgtt_spt *spt)
 {
@@ -1489,14 +1513,16 @@ static int attach_oos_page(struct intel_vgpu_oos_page *oos_page,
 	ret = intel_gvt_hypervisor_read_gpa(spt->vgpu,
 			spt->guest_page.gfn << I915_GTT_PAGE_SHIFT,
 			oos_page->mem, I915_GTT_PAGE_SIZE);
-	if (ret)
+	if (ret) {
+		spin_lock(&gvt->gtt.oos_page_lock);
+		list_move(&oos_page->list, &gvt->gtt.oos_page_free_list_head);
+		spin_unlock(&gvt->gtt.oos_page_lock);
 		return ret;
+	}
 
-	oos_page->spt = spt;
+	WRITE_ONCE(oos_page->spt, spt);
 	spt->guest_page.oos_page = oos_page;
 
-	list_move_tail(&oos_page->list, &gvt->gtt.oos_page_use_list_head);
-
 	trace_oos_change(spt->vgpu->id, "attach", oos_page->id,
 			 spt, spt->guest_page.type);
 	return 0;
@@ -1518,27 +1544,60 @@ static int ppgtt_set_guest_page_sync(struct intel_vgpu_ppgtt_spt *spt)
 	return sync_oos_page(spt->vgpu, oos_page);
 }
 
+/*
+ * Take a free oos page, or else the least recently attached one of this
+ * vGPU: pages of other vGPUs are protected by their own vgpu_lock.
+ */
+static struct intel_vgpu_oos_page *get_oos_page(struct intel_vgpu *vgpu)
+{
+	struct intel_gvt_gtt *gtt = &vgpu->gvt->gtt;
+	struct intel_vgpu_oos_page *oos_page;
+
+	spin_lock(&gtt->oos_page_lock);
+	oos_page = list_first_entry_or_null(&gtt->oos_page_free_list_head,
+					    struct intel_vgpu_oos_page, list);
+	if (!oos_page) {
+		/*
+		 * Pages without an spt are reserved by another caller, the spt
+		 * of another vGPU's page may change under us.
+		 */
+		list_for_each_entry(oos_page, &gtt->oos_page_use_list_head,
+				    list) {
+			struct intel_vgpu_ppgtt_spt *spt = READ_ONCE(oos_page->spt);
+
+			if (spt && spt->vgpu == vgpu)
+				goto out;
+		}
+		oos_page = NULL;
+	}
+out:
+	/* reserved by moving it to the tail of the use list */
+	if (oos_page)
+		list_move_tail(&oos_page->list, &gtt->oos_page_use_list_head);
+	spin_unlock(&gtt->oos_page_lock);
+
+	return oos_page;
+}
+
 static int ppgtt_allocate_oos_page(struct intel_vgpu_ppgtt_spt *spt)
 {
-	struct intel_gvt *gvt = spt->vgpu->gvt;
-	struct intel_gvt_gtt *gtt = &gvt->gtt;
 	struct intel_vgpu_oos_page *oos_page = spt->guest_page.oos_page;
 	int ret;
 
 	WARN(oos_page, "shadow PPGTT page has already has a oos page\n");
 
-	if (list_empty(&gtt->oos_page_free_list_head)) {
-		oos_page = container_of(gtt->oos_page_use_list_head.next,
-			struct intel_vgpu_oos_page, list);
+	oos_page = get_oos_page(spt->vgpu);
+	if (!oos_page)
+		return -ENOSPC;
+
+	if (oos_page->spt) {
 		ret = ppgtt_set_guest_page_sync(oos_page->spt);
 		if (ret)
 			return ret;
 		ret = detach_oos_page(spt->vgpu, oos_page);
 		if (ret)
 			return ret;
-	} else
-		oos_page = container_of(gtt->oos_page_free_list_head.next,
-			struct intel_vgpu_oos_page, list);
+	}
 	return attach_oos_page(oos_page, spt);
 }
 
@@ -1552,6 +1611,7 @@ static int ppgtt_set_guest_page_oos(struct intel_vgpu_ppgtt_spt *spt)
 	trace_oos_change(spt->vgpu->id, "set page out of sync", oos_page->id,
 			 spt, spt->guest_page.type);
 
+	spt->vgpu->gtt.stats.oos_enter++;
 	list_add_tail(&oos_page->vm_list, &spt->vgpu->gtt.oos_page_list_head);
 	return intel_vgpu_disable_page_track(spt->vgpu, spt->guest_page.gfn);
 }
@@ -1745,6 +1805,7 @@ static int ppgtt_handle_guest_write_page_table_bytes(
 		if (ret)
 			return ret;
 	} else {
+		vgpu->gtt.stats.partial_writes++;
 		if (!test_bit(index, spt->post_shadow_bitmap)) {
 			int type = spt->shadow_page.type;
 
@@ -1768,8 +1829,10 @@ static int ppgtt_handle_guest_write_page_table_bytes(
 				false, 0, vgpu);
 
 	if (can_do_out_of_sync(spt)) {
-		if (!spt->guest_page.oos_page)
-			ppgtt_allocate_oos_page(spt);
+		/* out of oos pages: stay write-protected */
+		if (!spt->guest_page.oos_page &&
+		    ppgtt_allocate_oos_page(spt))
+			return 0;
 
 		ret = ppgtt_set_guest_page_oos(spt);
 		if (ret < 0)
@@ -2583,6 +2646,7 @@ static int setup_spt_oos(struct intel_gvt *gvt)
 
 	INIT_LIST_HEAD(&gtt->oos_page_free_list_head);
 	INIT_LIST_HEAD(&gtt->oos_page_use_list_head);
+	spin_lock_init(&gtt->oos_page_lock);
 
 	for (i = 0; i < preallocated_oos_pages; i++) {
 		oos_page = kzalloc(sizeof(*oos_page), GFP_KERNEL);
@@ -2736,6 +2800,7 @@ int intel_gvt_init_gtt(struct intel_gvt *gvt)
 	gvt->gtt.scratch_page = virt_to_page(page);
 	gvt->gtt.scratch_mfn = (unsigned long)(daddr >> I915_GTT_PAGE_SHIFT);
 
+	enable_out_of_sync = i915_modparams.gvt_ppgtt_oos;
 	if (enable_out_of_sync) {
 		ret = setup_spt_oos(gvt);
 		if (ret) {
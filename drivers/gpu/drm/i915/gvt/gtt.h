@@ -88,6 +88,7 @@ struct intel_gvt_gtt {
 	void (*mm_free_page_table)(struct intel_vgpu_mm *mm);
 	struct list_head oos_page_use_list_head;
 	struct list_head oos_page_free_list_head;
+	spinlock_t oos_page_lock; /* protects the two lists above */
 	struct mutex ppgtt_mm_lock;
 	struct list_head ppgtt_mm_lru_list_head;
 
@@ -203,6 +204,15 @@ struct intel_vgpu_gtt {
 	struct list_head oos_page_list_head;
 	struct list_head post_shadow_list_head;
 	struct intel_vgpu_scratch_pt scratch_pt[GTT_TYPE_MAX];
+
+	/* page table write-protection statistics, protected by vgpu_lock */
+	struct {
+		unsigned long wp_traps;		/* trapped guest PTE writes */
+		unsigned long partial_writes;	/* of these, partial PTE updates */
+		unsigned long oos_enter;	/* page tables left out of sync */
+		unsigned long oos_sync;		/* page tables resynced */
+		unsigned long oos_entries;	/* entries changed while untrapped */
+	} stats;
 };
 
 int intel_vgpu_init_gtt(struct intel_vgpu *vgpu);
@@ -108,8 +108,16 @@ struct intel_vgpu_fence {
 	u32 size;
 };
 
+#define INTEL_GVT_MMIO_HIT_HASH_BITS 8
+/* cap on tracked offsets, to bound memory when a guest sweeps the BAR */
+#define INTEL_GVT_MMIO_HIT_MAX 4096
+
 struct intel_vgpu_mmio {
 	void *vreg;
+	/* trap statistics, protected by vgpu_lock, see mmio_hits in debugfs */
+	bool track_hits;
+	unsigned int nr_hits;
+	DECLARE_HASHTABLE(hits, INTEL_GVT_MMIO_HIT_HASH_BITS);
 };
 
 #define INTEL_GVT_MAX_BAR_NUM 4
@@ -146,8 +154,13 @@ struct intel_vgpu_opregion {
 
 #define vgpu_opregion(vgpu) (&(vgpu->opregion))
 
+#define VGPU_MAX_WEIGHT 16
+/* latency priorities range from 0 (default) to VGPU_MAX_LATENCY_PRIO */
+#define VGPU_MAX_LATENCY_PRIO 3
+
 struct vgpu_sched_ctl {
 	int weight;
+	int latency_prio;
 };
 
 enum {
@@ -162,6 +175,20 @@ struct intel_vgpu_submission_ops {
 	void (*reset)(struct intel_vgpu *vgpu, intel_engine_mask_t engine_mask);
 };
 
+/*
+ * Guest context image held by a shadow context.  The guest pages past the
+ * ring context are write protected while it is valid, so that a guest
+ * write to them drops it.
+ */
+struct intel_vgpu_shadow_ctx_cache {
+	struct intel_vgpu *vgpu;
+	u32 lrca;
+	u64 ring_context_gpa;
+	unsigned long *gfns;
+	unsigned int nr_gfns;
+	bool valid;
+};
+
 struct intel_vgpu_submission {
 	struct intel_vgpu_execlist execlist[I915_NUM_ENGINES];
 	struct list_head workload_q_head[I915_NUM_ENGINES];
@@ -174,8 +201,12 @@ struct intel_vgpu_submission {
 	};
 	DECLARE_BITMAP(shadow_ctx_desc_updated, I915_NUM_ENGINES);
 	DECLARE_BITMAP(tlb_handle_pending, I915_NUM_ENGINES);
+	struct intel_vgpu_shadow_ctx_cache ctx_cache[I915_NUM_ENGINES];
+	unsigned long ctx_populate_cnt;
+	unsigned long ctx_populate_skip_cnt;
 	void *ring_scan_buffer[I915_NUM_ENGINES];
 	int ring_scan_buffer_size[I915_NUM_ENGINES];
+	struct intel_vgpu_bb_cache bb_cache;
 	const struct intel_vgpu_submission_ops *ops;
 	int virtual_submission_interface;
 	bool active;
@@ -57,6 +57,63 @@ int intel_vgpu_gpa_to_mmio_offset(struct intel_vgpu *vgpu, u64 gpa)
 	(reg >= gvt->device_info.gtt_start_offset \
 	 && reg < gvt->device_info.gtt_start_offset + gvt_ggtt_sz(gvt))
 
+static void mmio_account_hit(struct intel_vgpu *vgpu, unsigned int offset,
+			     bool read, u64 start)
+{
+	struct intel_gvt *gvt = vgpu->gvt;
+	struct intel_vgpu_mmio_hit *hit;
+
+	if (reg_is_gtt(gvt, offset))
+		offset = gvt->device_info.gtt_start_offset;
+
+	hash_for_each_possible(vgpu->mmio.hits, hit, node, offset)
+		if (hit->offset == offset)
+			goto found;
+
+	if (vgpu->mmio.nr_hits >= INTEL_GVT_MMIO_HIT_MAX)
+		return;
+	/* the emulation path runs in process context, under vgpu_lock */
+	hit = kzalloc(sizeof(*hit), GFP_KERNEL);
+	if (!hit)
+		return;
+	hit->offset = offset;
+	hash_add(vgpu->mmio.hits, &hit->node, offset);
+	vgpu->mmio.nr_hits++;
+found:
+	if (read)
+		hit->reads++;
+	else
+		hit->writes++;
+	hit->ns += ktime_get_ns() - start;
+}
+
+static void mmio_clear_hits(struct intel_vgpu *vgpu)
+{
+	struct intel_vgpu_mmio_hit *hit;
+	struct hlist_node *tmp;
+	int i;
+
+	hash_for_each_safe(vgpu->mmio.hits, i, tmp, hit, node) {
+		hash_del(&hit->node);
+		kfree(hit);
+	}
+	vgpu->mmio.nr_hits = 0;
+}
+
+/**
+ * intel_vgpu_mmio_track_hits - start or stop counting trapped MMIO accesses
+ * @vgpu: a vGPU
+ * @enable: whether to count
+ *
+ * Either way the counters collected so far are dropped.  Caller must hold
+ * vgpu_lock.
+ */
+void intel_vgpu_mmio_track_hits(struct intel_vgpu *vgpu, bool enable)
+{
+	mmio_clear_hits(vgpu);
+	vgpu->mmio.track_hits = enable;
+}
+
 static void failsafe_emulate_mmio_rw(struct intel_vgpu *vgpu, u64 pa,
 		void *p_data, unsigned int bytes, bool read)
 {
@@ -104,6 +161,7 @@ int intel_vgpu_emulate_mmio_read(struct intel_vgpu *vgpu, u64 pa,
 {
 	struct intel_gvt *gvt = vgpu->gvt;
 	unsigned int offset = 0;
+	u64 start = 0;
 	int ret = -EINVAL;
 
 	if (vgpu->failsafe) {
@@ -111,6 +169,8 @@ int intel_vgpu_emulate_mmio_read(struct intel_vgpu *vgpu, u64 pa,
 		return 0;
 	}
 	mutex_lock(&vgpu->vgpu_lock);
+	if (vgpu->mmio.track_hits)
+		start = ktime_get_ns();
 
 	offset = intel_vgpu_gpa_to_mmio_offset(vgpu, pa);
 
@@ -157,6 +217,8 @@ int intel_vgpu_emulate_mmio_read(struct intel_vgpu *vgpu, u64 pa,
 	gvt_vgpu_err("fail to emulate MMIO read %08x len %d\n",
 			offset, bytes);
 out:
+	if (start)
+		mmio_account_hit(vgpu, offset, true, start);
 	mutex_unlock(&vgpu->vgpu_lock);
 	return ret;
 }
@@ -176,6 +238,7 @@ int intel_vgpu_emulate_mmio_write(struct intel_vgpu *vgpu, u64 pa,
 {
 	struct intel_gvt *gvt = vgpu->gvt;
 	unsigned int offset = 0;
+	u64 start = 0;
 	int ret = -EINVAL;
 
 	if (vgpu->failsafe) {
@@ -184,6 +247,8 @@ int intel_vgpu_emulate_mmio_write(struct intel_vgpu *vgpu, u64 pa,
 	}
 
 	mutex_lock(&vgpu->vgpu_lock);
+	if (vgpu->mmio.track_hits)
+		start = ktime_get_ns();
 
 	offset = intel_vgpu_gpa_to_mmio_offset(vgpu, pa);
 
@@ -221,6 +286,8 @@ int intel_vgpu_emulate_mmio_write(struct intel_vgpu *vgpu, u64 pa,
 	gvt_vgpu_err("fail to emulate MMIO write %08x len %d\n", offset,
 		     bytes);
 out:
+	if (start)
+		mmio_account_hit(vgpu, offset, false, start);
 	mutex_unlock(&vgpu->vgpu_lock);
 	return ret;
 }
@@ -341,6 +408,8 @@ int intel_vgpu_init_mmio(struct intel_vgpu *vgpu)
 	if (!vgpu->mmio.vreg)
 		return -ENOMEM;
 
+	hash_init(vgpu->mmio.hits);
+
 	intel_vgpu_reset_mmio(vgpu, true);
 
 	return 0;
@@ -353,6 +422,7 @@ int intel_vgpu_init_mmio(struct intel_vgpu *vgpu)
  */
 void intel_vgpu_clean_mmio(struct intel_vgpu *vgpu)
 {
+	mmio_clear_hits(vgpu);
 	vfree(vgpu->mmio.vreg);
 	vgpu->mmio.vreg = NULL;
 }
@@ -67,6 +67,15 @@ struct intel_gvt_mmio_info {
 	struct hlist_node node;
 };
 
+/* trapped accesses to one MMIO offset, all GGTT accesses share one entry */
+struct intel_vgpu_mmio_hit {
+	u32 offset;
+	u64 reads;
+	u64 writes;
+	u64 ns;
+	struct hlist_node node;
+};
+
 int intel_gvt_render_mmio_to_ring_id(struct intel_gvt *gvt,
 		unsigned int reg);
 unsigned long intel_gvt_get_device_type(struct intel_gvt *gvt);
@@ -81,6 +90,7 @@ int intel_gvt_for_each_tracked_mmio(struct intel_gvt *gvt,
 int intel_vgpu_init_mmio(struct intel_vgpu *vgpu);
 void intel_vgpu_reset_mmio(struct intel_vgpu *vgpu, bool dmlr);
 void intel_vgpu_clean_mmio(struct intel_vgpu *vgpu);
+void intel_vgpu_mmio_track_hits(struct intel_vgpu *vgpu, bool enable);
 
 int intel_vgpu_gpa_to_mmio_offset(struct intel_vgpu *vgpu, u64 gpa);
 
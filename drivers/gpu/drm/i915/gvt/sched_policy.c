@@ -31,6 +31,8 @@
  *
  */
 
+#include <linux/seq_file.h>
+
 #include "i915_drv.h"
 #include "gvt.h"
 
@@ -61,6 +63,18 @@ struct vgpu_sched_data {
 	ktime_t left_ts;
 	ktime_t allocated_ts;
 
+	/* weighted-fair policy */
+	u64 vtime;
+	ktime_t slice_start;
+	bool busy;
+	bool idle;
+
+	/* utilization accounting */
+	ktime_t util_sched_time;
+	unsigned int util_permille;
+	unsigned long nr_sched_in;
+	unsigned long nr_preempt;
+
 	struct vgpu_sched_ctl sched_ctl;
 };
 
@@ -70,8 +84,89 @@ struct gvt_sched_data {
 	unsigned long period;
 	struct list_head lru_runq_head;
 	ktime_t expire_time;
+	ktime_t util_start;
+	u64 min_vtime;
+	bool (*has_work)(struct vgpu_sched_data *vgpu_data);
 };
 
+static bool vgpu_data_has_work(struct vgpu_sched_data *vgpu_data)
+{
+	return vgpu_has_pending_workload(vgpu_data->vgpu);
+}
+
+/*
+ * Weighted-fair queueing: every vGPU accumulates virtual time at a rate
+ * inversely proportional to its weight while it owns the GPU, and the busy
+ * vGPU with the least virtual time runs next.  A higher latency priority
+ * lets a vGPU run GVT_WFQ_LATENCY_CREDIT ahead of its fair share per level
+ * and preempt a lower priority vGPU before its minimum slice is over.  The
+ * long run share still follows the weights.
+ */
+#define GVT_WFQ_WEIGHT_SCALE	VGPU_MAX_WEIGHT
+#define GVT_WFQ_MIN_SLICE	(2 * NSEC_PER_MSEC)
+#define GVT_WFQ_LATENCY_CREDIT	(2 * NSEC_PER_MSEC * GVT_WFQ_WEIGHT_SCALE)
+/* credit a vGPU keeps over the busy ones when it wakes up from idle */
+#define GVT_WFQ_WAKEUP_CREDIT	(GVT_WFQ_MIN_SLICE * GVT_WFQ_WEIGHT_SCALE)
+
+static void wfq_charge(struct vgpu_sched_data *vgpu_data, u64 delta_ns)
+{
+	vgpu_data->vtime += div_u64(delta_ns * GVT_WFQ_WEIGHT_SCALE,
+				    vgpu_data->sched_ctl.weight);
+}
+
+static s64 wfq_key(struct vgpu_sched_data *vgpu_data)
+{
+	return (s64)vgpu_data->vtime -
+		(s64)vgpu_data->sched_ctl.latency_prio * GVT_WFQ_LATENCY_CREDIT;
+}
+
+/*
+ * Pick the vGPU to run after @cur (NULL when idle), NULL if none has work.
+ * @cur keeps the GPU for at least GVT_WFQ_MIN_SLICE unless a vGPU of higher
+ * latency priority has work.
+ */
+static struct vgpu_sched_data *wfq_pick(struct gvt_sched_data *sched_data,
+					struct vgpu_sched_data *cur,
+					ktime_t now)
+{
+	struct vgpu_sched_data *vgpu_data, *best = NULL;
+	u64 min_vtime = U64_MAX;
+
+	list_for_each_entry(vgpu_data, &sched_data->lru_runq_head, lru_list) {
+		vgpu_data->busy = sched_data->has_work(vgpu_data);
+		if (vgpu_data->busy && !vgpu_data->idle)
+			min_vtime = min(min_vtime, vgpu_data->vtime);
+	}
+	if (min_vtime != U64_MAX && min_vtime > sched_data->min_vtime)
+		sched_data->min_vtime = min_vtime;
+
+	list_for_each_entry(vgpu_data, &sched_data->lru_runq_head, lru_list) {
+		if (!vgpu_data->busy) {
+			vgpu_data->idle = true;
+			continue;
+		}
+
+		/* no credit for the time spent without work */
+		if (vgpu_data->idle) {
+			if (vgpu_data->vtime + GVT_WFQ_WAKEUP_CREDIT <
+			    sched_data->min_vtime)
+				vgpu_data->vtime = sched_data->min_vtime -
+					GVT_WFQ_WAKEUP_CREDIT;
+			vgpu_data->idle = false;
+		}
+
+		if (!best || wfq_key(vgpu_data) < wfq_key(best))
+			best = vgpu_data;
+	}
+
+	if (cur && cur->busy && best != cur &&
+	    best->sched_ctl.latency_prio <= cur->sched_ctl.latency_prio &&
+	    ktime_sub(now, cur->slice_start) < GVT_WFQ_MIN_SLICE)
+		return cur;
+
+	return best;
+}
+
 static void vgpu_update_timeslice(struct intel_vgpu *vgpu, ktime_t cur_time)
 {
 	ktime_t delta_ts;
@@ -85,6 +180,28 @@ static void vgpu_update_timeslice(struct intel_vgpu *vgpu, ktime_t cur_time)
 	vgpu_data->sched_time = ktime_add(vgpu_data->sched_time, delta_ts);
 	vgpu_data->left_ts = ktime_sub(vgpu_data->left_ts, delta_ts);
 	vgpu_data->sched_in_time = cur_time;
+	wfq_charge(vgpu_data, delta_ts);
+}
+
+#define GVT_UTIL_PERIOD_MS 1000
+
+static void gvt_update_utilization(struct gvt_sched_data *sched_data,
+				   ktime_t cur_time)
+{
+	struct vgpu_sched_data *vgpu_data;
+	s64 period = ktime_sub(cur_time, sched_data->util_start);
+
+	if (period < GVT_UTIL_PERIOD_MS * NSEC_PER_MSEC)
+		return;
+
+	list_for_each_entry(vgpu_data, &sched_data->lru_runq_head, lru_list) {
+		s64 busy = ktime_sub(vgpu_data->sched_time,
+				     vgpu_data->util_sched_time);
+
+		vgpu_data->util_permille = div64_s64(busy * 1000, period);
+		vgpu_data->util_sched_time = vgpu_data->sched_time;
+	}
+	sched_data->util_start = cur_time;
 }
 
 #define GVT_TS_BALANCE_PERIOD_MS 100
@@ -161,6 +278,8 @@ static void try_to_schedule_next_vgpu(struct intel_gvt *gvt)
 	vgpu_update_timeslice(scheduler->current_vgpu, cur_time);
 	vgpu_data = scheduler->next_vgpu->sched_data;
 	vgpu_data->sched_in_time = cur_time;
+	vgpu_data->slice_start = cur_time;
+	vgpu_data->nr_sched_in++;
 
 	/* switch current vgpu */
 	scheduler->current_vgpu = scheduler->next_vgpu;
@@ -237,26 +356,63 @@ static void tbs_sched_func(struct gvt_sched_data *sched_data)
 		try_to_schedule_next_vgpu(gvt);
 }
 
+static void tbs_schedule(struct intel_gvt *gvt, bool tick, ktime_t cur_time)
+{
+	struct gvt_sched_data *sched_data = gvt->scheduler.sched_data;
+
+	if (tick && cur_time >= sched_data->expire_time) {
+		gvt_balance_timeslice(sched_data);
+		sched_data->expire_time = ktime_add_ms(
+			cur_time, GVT_TS_BALANCE_PERIOD_MS);
+	}
+
+	tbs_sched_func(sched_data);
+}
+
+static void wfq_schedule(struct intel_gvt *gvt, bool tick, ktime_t cur_time)
+{
+	struct gvt_sched_data *sched_data = gvt->scheduler.sched_data;
+	struct intel_gvt_workload_scheduler *scheduler = &gvt->scheduler;
+	struct vgpu_sched_data *cur = NULL, *next;
+
+	/* no active vgpu or has already had a target */
+	if (list_empty(&sched_data->lru_runq_head) || scheduler->next_vgpu)
+		goto out;
+
+	if (scheduler->current_vgpu &&
+	    scheduler->current_vgpu != gvt->idle_vgpu)
+		cur = scheduler->current_vgpu->sched_data;
+
+	next = wfq_pick(sched_data, cur, cur_time);
+	if (next) {
+		if (cur && cur->busy && next != cur &&
+		    next->sched_ctl.latency_prio > cur->sched_ctl.latency_prio)
+			next->nr_preempt++;
+		scheduler->next_vgpu = next->vgpu;
+	} else {
+		scheduler->next_vgpu = gvt->idle_vgpu;
+	}
+out:
+	if (scheduler->next_vgpu)
+		try_to_schedule_next_vgpu(gvt);
+}
+
 void intel_gvt_schedule(struct intel_gvt *gvt)
 {
 	struct gvt_sched_data *sched_data = gvt->scheduler.sched_data;
 	ktime_t cur_time;
+	bool tick;
 
 	mutex_lock(&gvt->sched_lock);
 	cur_time = ktime_get();
 
-	if (test_and_clear_bit(INTEL_GVT_REQUEST_SCHED,
-				(void *)&gvt->service_request)) {
-		if (cur_time >= sched_data->expire_time) {
-			gvt_balance_timeslice(sched_data);
-			sched_data->expire_time = ktime_add_ms(
-				cur_time, GVT_TS_BALANCE_PERIOD_MS);
-		}
-	}
+	tick = test_and_clear_bit(INTEL_GVT_REQUEST_SCHED,
+				  (void *)&gvt->service_request);
 	clear_bit(INTEL_GVT_REQUEST_EVENT_SCHED, (void *)&gvt->service_request);
 
 	vgpu_update_timeslice(gvt->scheduler.current_vgpu, cur_time);
-	tbs_sched_func(sched_data);
+	gvt_update_utilization(sched_data, cur_time);
+	gvt->scheduler.sched_ops->schedule(gvt, tick, cur_time);
 
 	mutex_unlock(&gvt->sched_lock);
 }
@@ -289,6 +445,8 @@ static int tbs_sched_init(struct intel_gvt *gvt)
 	hrtimer_init(&data->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
 	data->timer.function = tbs_timer_fn;
 	data->period = GVT_DEFAULT_TIME_SLICE;
+	data->util_start = ktime_get();
+	data->has_work = vgpu_data_has_work;
 	data->gvt = gvt;
 
 	scheduler->sched_data = data;
@@ -316,7 +474,7 @@ static int tbs_sched_init_vgpu(struct intel_vgpu *vgpu)
 	if (!data)
 		return -ENOMEM;
 
-	data->sched_ctl.weight = vgpu->sched_ctl.weight;
+	data->sched_ctl = vgpu->sched_ctl;
 	data->vgpu = vgpu;
 	INIT_LIST_HEAD(&data->lru_list);
 
@@ -368,24 +526,72 @@ static void tbs_sched_stop_schedule(struct intel_vgpu *vgpu)
 	vgpu_data->active = false;
 }
 
+static void wfq_sched_start_schedule(struct intel_vgpu *vgpu)
+{
+	struct gvt_sched_data *sched_data = vgpu->gvt->scheduler.sched_data;
+	struct vgpu_sched_data *vgpu_data = vgpu->sched_data;
+
+	/* join at the current virtual time instead of claiming the past */
+	vgpu_data->vtime = max(vgpu_data->vtime, sched_data->min_vtime);
+	vgpu_data->idle = false;
+	tbs_sched_start_schedule(vgpu);
+}
+
 static struct intel_gvt_sched_policy_ops tbs_schedule_ops = {
+	.name = "tbs",
 	.init = tbs_sched_init,
 	.clean = tbs_sched_clean,
 	.init_vgpu = tbs_sched_init_vgpu,
 	.clean_vgpu = tbs_sched_clean_vgpu,
 	.start_schedule = tbs_sched_start_schedule,
 	.stop_schedule = tbs_sched_stop_schedule,
+	.schedule = tbs_schedule,
+};
+
+static struct intel_gvt_sched_policy_ops wfq_schedule_ops = {
+	.name = "wfq",
+	.init = tbs_sched_init,
+	.clean = tbs_sched_clean,
+	.init_vgpu = tbs_sched_init_vgpu,
+	.clean_vgpu = tbs_sched_clean_vgpu,
+	.start_schedule = wfq_sched_start_schedule,
+	.stop_schedule = tbs_sched_stop_schedule,
+	.schedule = wfq_schedule,
 };
 
+static struct intel_gvt_sched_policy_ops *gvt_sched_policies[] = {
+	&tbs_schedule_ops,
+	&wfq_schedule_ops,
+};
+
+static struct intel_gvt_sched_policy_ops *find_sched_policy(const char *name)
+{
+	int i;
+
+	if (!name || !*name)
+		return &tbs_schedule_ops;
+
+	for (i = 0; i < ARRAY_SIZE(gvt_sched_policies); i++)
+		if (!strcmp(gvt_sched_policies[i]->name, name))
+			return gvt_sched_policies[i];
+
+	gvt_err("unknown scheduling policy %s, using %s\n",
+		name, tbs_schedule_ops.name);
+	return &tbs_schedule_ops;
+}
+
 int intel_gvt_init_sched_policy(struct intel_gvt *gvt)
 {
 	int ret;
 
 	mutex_lock(&gvt->sched_lock);
-	gvt->scheduler.sched_ops = &tbs_schedule_ops;
+	gvt->scheduler.sched_ops =
+		find_sched_policy(i915_modparams.gvt_sched_policy);
 	ret = gvt->scheduler.sched_ops->init(gvt);
 	mutex_unlock(&gvt->sched_lock);
 
+	gvt_dbg_core("scheduling policy %s\n", gvt->scheduler.sched_ops->name);
+
 	return ret;
 }
 
@@ -433,6 +639,59 @@ void intel_vgpu_start_schedule(struct intel_vgpu *vgpu)
 	mutex_unlock(&vgpu->gvt->sched_lock);
 }
 
+/**
+ * intel_vgpu_set_sched_ctl - change the scheduling parameters of a vGPU
+ * @vgpu: a vGPU
+ * @ctl: the new weight and latency priority
+ *
+ * Returns:
+ * Zero on success, negative error code if a parameter is out of range.
+ */
+int intel_vgpu_set_sched_ctl(struct intel_vgpu *vgpu,
+			     const struct vgpu_sched_ctl *ctl)
+{
+	struct vgpu_sched_data *vgpu_data = vgpu->sched_data;
+
+	if (ctl->weight < 1 || ctl->weight > VGPU_MAX_WEIGHT ||
+	    ctl->latency_prio < 0 ||
+	    ctl->latency_prio > VGPU_MAX_LATENCY_PRIO)
+		return -EINVAL;
+
+	mutex_lock(&vgpu->gvt->sched_lock);
+	vgpu->sched_ctl = *ctl;
+	vgpu_data->sched_ctl = *ctl;
+	mutex_unlock(&vgpu->gvt->sched_lock);
+
+	return 0;
+}
+
+/**
+ * intel_vgpu_sched_show - print the scheduling statistics of a vGPU
+ * @vgpu: a vGPU
+ * @m: the seq_file to print to
+ *
+ * Busy time is the time the vGPU owned the GPU, utilization its share of
+ * the last accounting period.
+ */
+void intel_vgpu_sched_show(struct intel_vgpu *vgpu, struct seq_file *m)
+{
+	struct vgpu_sched_data *vgpu_data = vgpu->sched_data;
+
+	mutex_lock(&vgpu->gvt->sched_lock);
+	seq_printf(m, "policy: %s\n", vgpu->gvt->scheduler.sched_ops->name);
+	seq_printf(m, "weight: %d\n", vgpu_data->sched_ctl.weight);
+	seq_printf(m, "latency_prio: %d\n", vgpu_data->sched_ctl.latency_prio);
+	seq_printf(m, "active: %s\n", yesno(vgpu_data->active));
+	seq_printf(m, "busy_ns: %lld\n", ktime_to_ns(vgpu_data->sched_time));
+	seq_printf(m, "utilization: %u.%u%%\n",
+		   vgpu_data->util_permille / 10,
+		   vgpu_data->util_permille % 10);
+	seq_printf(m, "vtime: %llu\n", vgpu_data->vtime);
+	seq_printf(m, "sched_in: %lu\n", vgpu_data->nr_sched_in);
+	seq_printf(m, "preempt: %lu\n", vgpu_data->nr_preempt);
+	mutex_unlock(&vgpu->gvt->sched_lock);
+}
+
 void intel_gvt_kick_schedule(struct intel_gvt *gvt)
 {
 	mutex_lock(&gvt->sched_lock);
@@ -477,3 +736,7 @@ void intel_vgpu_stop_schedule(struct intel_vgpu *vgpu)
 	intel_runtime_pm_put_unchecked(&dev_priv->runtime_pm);
 	mutex_unlock(&vgpu->gvt->sched_lock);
 }
+
+#if IS_ENABLED(CONFIG_DRM_I915_SELFTEST)
+#include "selftest_sched_policy.c"
+#endif
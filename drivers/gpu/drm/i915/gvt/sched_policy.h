@@ -34,13 +34,19 @@
 #ifndef __GVT_SCHED_POLICY__
 #define __GVT_SCHED_POLICY__
 
+struct seq_file;
+struct vgpu_sched_ctl;
+
 struct intel_gvt_sched_policy_ops {
+	const char *name;
 	int (*init)(struct intel_gvt *gvt);
 	void (*clean)(struct intel_gvt *gvt);
 	int (*init_vgpu)(struct intel_vgpu *vgpu);
 	void (*clean_vgpu)(struct intel_vgpu *vgpu);
 	void (*start_schedule)(struct intel_vgpu *vgpu);
 	void (*stop_schedule)(struct intel_vgpu *vgpu);
+	/* pick the next vGPU, @tick is set on the periodic timer */
+	void (*schedule)(struct intel_gvt *gvt, bool tick, ktime_t cur_time);
 };
 
 void intel_gvt_schedule(struct intel_gvt *gvt);
@@ -59,4 +65,9 @@ void intel_vgpu_stop_schedule(struct intel_vgpu *vgpu);
 
 void intel_gvt_kick_schedule(struct intel_gvt *gvt);
 
+int intel_vgpu_set_sched_ctl(struct intel_vgpu *vgpu,
+			     const struct vgpu_sched_ctl *ctl);
+
+void intel_vgpu_sched_show(struct intel_vgpu *vgpu, struct seq_file *m);
+
 #endif
@@ -125,17 +125,101 @@ static void sr_oa_regs(struct intel_vgpu_workload *workload,
 	}
 }
 
+static unsigned long shadow_context_page_num(struct intel_gvt *gvt, int ring_id)
+{
+	if (IS_BROADWELL(gvt->dev_priv) && ring_id == RCS0)
+		return 19;
+
+	return gvt->dev_priv->engine[ring_id]->context_size >> PAGE_SHIFT;
+}
+
+static void
+shadow_ctx_cache_invalidate(struct intel_vgpu_shadow_ctx_cache *cache)
+{
+	unsigned int i;
+
+	for (i = 0; i < cache->nr_gfns; i++)
+		intel_vgpu_unregister_page_track(cache->vgpu, cache->gfns[i]);
+
+	cache->nr_gfns = 0;
+	cache->valid = false;
+}
+
+static int shadow_ctx_cache_write_handler(
+		struct intel_vgpu_page_track *page_track,
+		u64 gpa, void *data, int bytes)
+{
+	shadow_ctx_cache_invalidate(page_track->priv_data);
+	return 0;
+}
+
+/* Write protect @gfn, a page of the guest image held by @cache. */
+static int shadow_ctx_cache_track(struct intel_vgpu_shadow_ctx_cache *cache,
+				  unsigned long gfn)
+{
+	int ret;
+
+	ret = intel_vgpu_register_page_track(cache->vgpu, gfn,
+					     shadow_ctx_cache_write_handler,
+					     cache);
+	if (ret)
+		return ret;
+
+	ret = intel_vgpu_enable_page_track(cache->vgpu, gfn);
+	if (ret) {
+		intel_vgpu_unregister_page_track(cache->vgpu, gfn);
+		return ret;
+	}
+
+	cache->gfns[cache->nr_gfns++] = gfn;
+	return 0;
+}
+
+/*
+ * The rest of the image only changes when the context runs, and
+ * update_guest_context() writes it back to the guest when that workload
+ * completes.  So if the shadow context still holds the image of this guest
+ * context, from the same guest pages, and the guest hasn't written to those,
+ * they have nothing new.
+ */
+static bool shadow_ctx_cache_hit(struct intel_vgpu_workload *workload,
+				 struct intel_vgpu_shadow_ctx_cache *cache,
+				 unsigned long page_num)
+{
+	struct intel_vgpu *vgpu = workload->vgpu;
+	unsigned long context_gpa;
+	int i;
+
+	if (!cache->valid ||
+	    cache->lrca != workload->ctx_desc.lrca ||
+	    cache->ring_context_gpa != workload->ring_context_gpa)
+		return false;
+
+	for (i = 2; i < page_num; i++) {
+		context_gpa = intel_vgpu_gma_to_gpa(vgpu->gtt.ggtt_mm,
+				(u32)((workload->ctx_desc.lrca + i) <<
+				I915_GTT_PAGE_SHIFT));
+		if (context_gpa == INTEL_GVT_INVALID_ADDR ||
+		    context_gpa >> PAGE_SHIFT != cache->gfns[i - 2])
+			return false;
+	}
+
+	return true;
+}
+
 static int populate_shadow_context(struct intel_vgpu_workload *workload)
 {
 	struct intel_vgpu *vgpu = workload->vgpu;
-	struct intel_gvt *gvt = vgpu->gvt;
+	struct intel_vgpu_submission *s = &vgpu->submission;
 	int ring_id = workload->ring_id;
+	struct intel_vgpu_shadow_ctx_cache *cache = &s->ctx_cache[ring_id];
 	struct drm_i915_gem_object *ctx_obj =
 		workload->req->hw_context->state->obj;
 	struct execlist_ring_context *shadow_ring_context;
 	struct page *page;
 	void *dst;
-	unsigned long context_gpa, context_page_num;
+	unsigned long context_gpa, page_num;
+	bool protect;
 	int i;
 
 	page = i915_gem_object_get_page(ctx_obj, LRC_STATE_PN);
@@ -173,29 +257,51 @@ static int populate_shadow_context(struct intel_vgpu_workload *workload)
 	sr_oa_regs(workload, (u32 *)shadow_ring_context, false);
 	kunmap(page);
 
-	if (IS_RESTORE_INHIBIT(shadow_ring_context->ctx_ctrl.val))
+	if (IS_RESTORE_INHIBIT(shadow_ring_context->ctx_ctrl.val)) {
+		shadow_ctx_cache_invalidate(cache);
 		return 0;
+	}
 
-	gvt_dbg_sched("ring id %d workload lrca %x", ring_id,
-			workload->ctx_desc.lrca);
+	page_num = shadow_context_page_num(vgpu->gvt, ring_id);
 
-	context_page_num = gvt->dev_priv->engine[ring_id]->context_size;
+	if (shadow_ctx_cache_hit(workload, cache, page_num)) {
+		s->ctx_populate_skip_cnt++;
+		return 0;
+	}
 
-	context_page_num = context_page_num >> PAGE_SHIFT;
+	shadow_ctx_cache_invalidate(cache);
+	s->ctx_populate_cnt++;
 
-	if (IS_BROADWELL(gvt->dev_priv) && ring_id == RCS0)
-		context_page_num = 19;
+	gvt_dbg_sched("ring id %d workload lrca %x", ring_id,
+			workload->ctx_desc.lrca);
+
+	if (!cache->gfns)
+		cache->gfns = kcalloc(page_num, sizeof(*cache->gfns),
+				      GFP_KERNEL);
+	protect = cache->gfns;
 
 	i = 2;
-	while (i < context_page_num) {
+	while (i < page_num) {
 		context_gpa = intel_vgpu_gma_to_gpa(vgpu->gtt.ggtt_mm,
 				(u32)((workload->ctx_desc.lrca + i) <<
 				I915_GTT_PAGE_SHIFT));
 		if (context_gpa == INTEL_GVT_INVALID_ADDR) {
 			gvt_vgpu_err("Invalid guest context descriptor\n");
+			shadow_ctx_cache_invalidate(cache);
 			return -EFAULT;
 		}
 
+		/*
+		 * Protect the page before reading it, so that no guest write
+		 * can slip in between.  A page that can't be protected, e.g.
+		 * one already tracked, leaves the image uncached.
+		 */
+		if (protect &&
+		    shadow_ctx_cache_track(cache, context_gpa >> PAGE_SHIFT)) {
+			shadow_ctx_cache_invalidate(cache);
+			protect = false;
+		}
+
 		page = i915_gem_object_get_page(ctx_obj, i);
 		dst = kmap(page);
 		intel_gvt_hypervisor_read_gpa(vgpu, context_gpa, dst,
@@ -203,6 +309,12 @@ static int populate_shadow_context(struct intel_vgpu_workload *workload)
 		kunmap(page);
 		i++;
 	}
+
+	if (protect) {
+		cache->lrca = workload->ctx_desc.lrca;
+		cache->ring_context_gpa = workload->ring_context_gpa;
+		cache->valid = true;
+	}
 	return 0;
 }
 
@@ -841,11 +953,7 @@ static void update_guest_context(struct intel_vgpu_workload *workload)
 	vgpu_vreg_t(vgpu, RING_TAIL(ring_base)) = tail;
 	vgpu_vreg_t(vgpu, RING_HEAD(ring_base)) = head;
 
-	context_page_num = rq->engine->context_size;
-	context_page_num = context_page_num >> PAGE_SHIFT;
-
-	if (IS_BROADWELL(gvt->dev_priv) && rq->engine->id == RCS0)
-		context_page_num = 19;
+	context_page_num = shadow_context_page_num(gvt, rq->engine->id);
 
 	i = 2;
 
@@ -855,6 +963,9 @@ static void update_guest_context(struct intel_vgpu_workload *workload)
 					I915_GTT_PAGE_SHIFT));
 		if (context_gpa == INTEL_GVT_INVALID_ADDR) {
 			gvt_vgpu_err("invalid guest context descriptor\n");
+			/* the guest image no longer matches the shadow one */
+			shadow_ctx_cache_invalidate(
+				&vgpu->submission.ctx_cache[rq->engine->id]);
 			return;
 		}
 
@@ -978,6 +1089,9 @@ static void complete_current_workload(struct intel_gvt *gvt, int ring_id)
 		 * the workload clean up here doesn't have any impact.
 		 **/
 		intel_vgpu_clean_workloads(vgpu, BIT(ring_id));
+
+		/* the guest never got the image the hardware saved */
+		shadow_ctx_cache_invalidate(&s->ctx_cache[ring_id]);
 	}
 
 	workload->complete(workload);
@@ -1188,9 +1302,15 @@ void intel_vgpu_clean_submission(struct intel_vgpu *vgpu)
 	intel_vgpu_select_submission_ops(vgpu, ALL_ENGINES, 0);
 
 	i915_context_ppgtt_root_restore(s, i915_vm_to_ppgtt(s->shadow[0]->vm));
-	for_each_engine(engine, vgpu->gvt->dev_priv, id)
+	for_each_engine(engine, vgpu->gvt->dev_priv, id) {
 		intel_context_unpin(s->shadow[id]);
 
+		shadow_ctx_cache_invalidate(&s->ctx_cache[id]);
+		kfree(s->ctx_cache[id].gfns);
+		s->ctx_cache[id].gfns = NULL;
+	}
+
+	intel_vgpu_clean_bb_cache(vgpu);
 	kmem_cache_destroy(s->workloads);
 }
 
@@ -1207,11 +1327,19 @@ void intel_vgpu_reset_submission(struct intel_vgpu *vgpu,
 				 intel_engine_mask_t engine_mask)
 {
 	struct intel_vgpu_submission *s = &vgpu->submission;
+	struct intel_engine_cs *engine;
+	intel_engine_mask_t tmp;
 
 	if (!s->active)
 		return;
 
+	for_each_engine_masked(engine, &vgpu->gvt->dev_priv->gt,
+			       engine_mask, tmp)
+		shadow_ctx_cache_invalidate(&s->ctx_cache[engine->id]);
+
 	intel_vgpu_clean_workloads(vgpu, engine_mask);
+	if (engine_mask == ALL_ENGINES)
+		intel_vgpu_clean_bb_cache(vgpu);
 	s->ops->reset(vgpu, engine_mask);
 }
 
@@ -1267,6 +1395,7 @@ int intel_vgpu_setup_submission(struct intel_vgpu *vgpu)
 
 		INIT_LIST_HEAD(&s->workload_q_head[i]);
 		s->shadow[i] = ERR_PTR(-EINVAL);
+		s->ctx_cache[i].vgpu = vgpu;
 
 		ce = intel_context_create(ctx, engine);
 		if (IS_ERR(ce)) {
@@ -1304,6 +1433,7 @@ int intel_vgpu_setup_submission(struct intel_vgpu *vgpu)
 
 	atomic_set(&s->running_workload_num, 0);
 	bitmap_zero(s->tlb_handle_pending, I915_NUM_ENGINES);
+	intel_vgpu_init_bb_cache(vgpu);
 
 	i915_vm_put(&ppgtt->vm);
 	i915_gem_context_put(ctx);
@@ -0,0 +1,204 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright © 2020 Intel Corporation
+ */
+
+#include "../i915_selftest.h"
+
+/*
+ * Mock workloads for the weighted-fair policy: each mock vGPU has a number
+ * of 1ms workloads queued (or an endless supply) and the scheduler is
+ * ticked every millisecond, charging the picked vGPU for the tick.
+ */
+#define MOCK_TICK_NS	NSEC_PER_MSEC
+#define MOCK_ENDLESS	UINT_MAX
+
+struct mock_vgpu {
+	struct vgpu_sched_data data;
+	unsigned int work;
+	unsigned int ran;
+};
+
+static bool mock_has_work(struct vgpu_sched_data *vgpu_data)
+{
+	return container_of(vgpu_data, struct mock_vgpu, data)->work;
+}
+
+static void mock_sched_init(struct gvt_sched_data *sched_data)
+{
+	memset(sched_data, 0, sizeof(*sched_data));
+	INIT_LIST_HEAD(&sched_data->lru_runq_head);
+	sched_data->has_work = mock_has_work;
+}
+
+static void mock_vgpu_add(struct gvt_sched_data *sched_data,
+			  struct mock_vgpu *mv, int weight, int latency_prio,
+			  unsigned int work)
+{
+	memset(mv, 0, sizeof(*mv));
+	mv->data.sched_ctl.weight = weight;
+	mv->data.sched_ctl.latency_prio = latency_prio;
+	mv->data.vtime = sched_data->min_vtime;
+	mv->work = work;
+	list_add_tail(&mv->data.lru_list, &sched_data->lru_runq_head);
+}
+
+/* Run one tick and return the vGPU that ran it, NULL if idle. */
+static struct mock_vgpu *mock_tick(struct gvt_sched_data *sched_data,
+				   struct mock_vgpu *cur, ktime_t now)
+{
+	struct vgpu_sched_data *next;
+	struct mock_vgpu *mv;
+
+	next = wfq_pick(sched_data, cur ? &cur->data : NULL, now);
+	if (!next)
+		return NULL;
+
+	mv = container_of(next, struct mock_vgpu, data);
+	if (mv != cur)
+		next->slice_start = now;
+	wfq_charge(next, MOCK_TICK_NS);
+	mv->ran++;
+	if (mv->work != MOCK_ENDLESS)
+		mv->work--;
+
+	return mv;
+}
+
+static bool share_ok(unsigned int ran, unsigned int expected)
+{
+	unsigned int slack = expected / 20 + 2;
+
+	return ran + slack >= expected && ran <= expected + slack;
+}
+
+static int igt_wfq_weights(void *ignored)
+{
+	static const int weights[] = { 1, 2, 4, 16 };
+	struct mock_vgpu mv[ARRAY_SIZE(weights)];
+	struct gvt_sched_data sched_data;
+	struct mock_vgpu *cur = NULL;
+	unsigned int ticks = 0, total_weight = 0;
+	int i;
+
+	mock_sched_init(&sched_data);
+	for (i = 0; i < ARRAY_SIZE(weights); i++) {
+		mock_vgpu_add(&sched_data, &mv[i], weights[i], 0, MOCK_ENDLESS);
+		total_weight += weights[i];
+	}
+
+	for (ticks = 0; ticks < 100 * total_weight; ticks++)
+		cur = mock_tick(&sched_data, cur, ticks * MOCK_TICK_NS);
+
+	for (i = 0; i < ARRAY_SIZE(weights); i++) {
+		unsigned int expected = ticks / total_weight * weights[i];
+
+		if (!share_ok(mv[i].ran, expected)) {
+			pr_err("vGPU of weight %d ran %u of %u ticks, expected %u\n",
+			       weights[i], mv[i].ran, ticks, expected);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int igt_wfq_no_idle_credit(void *ignored)
+{
+	struct gvt_sched_data sched_data;
+	struct mock_vgpu a, b, *cur = NULL;
+	unsigned int t, ran;
+
+	mock_sched_init(&sched_data);
+	mock_vgpu_add(&sched_data, &a, 1, 0, 0);
+	mock_vgpu_add(&sched_data, &b, 1, 0, MOCK_ENDLESS);
+
+	for (t = 0; t < 1000; t++)
+		cur = mock_tick(&sched_data, cur, t * MOCK_TICK_NS);
+
+	/* a wakes up after idling and must not claim the last second */
+	a.work = MOCK_ENDLESS;
+	ran = a.ran;
+	for (; t < 1100; t++)
+		cur = mock_tick(&sched_data, cur, t * MOCK_TICK_NS);
+
+	if (a.ran - ran > 60) {
+		pr_err("vGPU woken from idle ran %u of 100 ticks\n",
+		       a.ran - ran);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int igt_wfq_latency(void *ignored)
+{
+	struct gvt_sched_data sched_data;
+	struct mock_vgpu bg, fg, *cur = NULL;
+	unsigned int t, arrived = 0, wait, max_wait = 0;
+	unsigned int queued_at = 0;
+
+	mock_sched_init(&sched_data);
+	mock_vgpu_add(&sched_data, &bg, 4, 0, MOCK_ENDLESS);
+	mock_vgpu_add(&sched_data, &fg, 1, 2, 0);
+
+	for (t = 0; t < 1600; t++) {
+		/* a frame of interactive work every 16ms */
+		if (!(t % 16) && !fg.work) {
+			fg.work = 1;
+			queued_at = t;
+			arrived++;
+		}
+
+		cur = mock_tick(&sched_data, cur, t * MOCK_TICK_NS);
+		if (cur == &fg) {
+			wait = t - queued_at;
+			max_wait = max(max_wait, wait);
+		}
+	}
+
+	if (fg.ran != arrived || max_wait > 1) {
+		pr_err("interactive vGPU ran %u of %u frames, max wait %ums\n",
+		       fg.ran, arrived, max_wait);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int igt_wfq_latency_fair(void *ignored)
+{
+	struct gvt_sched_data sched_data;
+	struct mock_vgpu lo, hi, *cur = NULL;
+	unsigned int t;
+
+	mock_sched_init(&sched_data);
+	mock_vgpu_add(&sched_data, &lo, 4, 0, MOCK_ENDLESS);
+	mock_vgpu_add(&sched_data, &hi, 4, VGPU_MAX_LATENCY_PRIO,
+		      MOCK_ENDLESS);
+
+	/* latency priority must not buy a larger share when both are busy */
+	for (t = 0; t < 2000; t++)
+		cur = mock_tick(&sched_data, cur, t * MOCK_TICK_NS);
+
+	if (!share_ok(lo.ran, t / 2) || !share_ok(hi.ran, t / 2)) {
+		pr_err("equal weights ran %u and %u of %u ticks\n",
+		       lo.ran, hi.ran, t);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int intel_gvt_sched_mock_selftests(void)
+{
+	static const struct i915_subtest tests[] = {
+		SUBTEST(igt_wfq_weights),
+		SUBTEST(igt_wfq_no_idle_credit),
+		SUBTEST(igt_wfq_latency),
+		SUBTEST(igt_wfq_latency_fair),
+	};
+
+	return i915_subtests(tests, NULL);
+}
@@ -25,6 +25,8 @@
  *
  */
 
+#include <linux/jhash.h>
+
 #include "gt/intel_engine.h"
 
 #include "i915_drv.h"
@@ -929,6 +931,154 @@ static void fini_hash_table(struct intel_engine_cs *engine)
 	}
 }
 
+/*
+ * Userspace submits the same batches over and over, e.g. every frame. The
+ * batches that passed the parser are remembered per engine by their content,
+ * so the next copy of one only needs comparing against the cached copy.
+ * Whether a batch is accepted depends on nothing but the engine and its
+ * commands as long as it doesn't contain MI_BATCH_BUFFER_START, whose
+ * target is checked against the submission's addresses; only batches
+ * ending in MI_BATCH_BUFFER_END are cached.  The cache holds copies rather
+ * than trusting the hash, so a collision can't smuggle a batch past the
+ * parser, and since lookups work on the shadow copy there is nothing to
+ * invalidate when userspace rewrites its batch.
+ */
+#define CMD_CACHE_HASH_BITS	6
+#define CMD_CACHE_MAX_LEN	SZ_64K
+#define CMD_CACHE_MAX_BYTES	SZ_1M
+
+struct cmd_cache_entry {
+	struct hlist_node node;
+	struct list_head link;
+	u32 hash;
+	u32 len;
+	u32 end;	/* offset of MI_BATCH_BUFFER_END, in dwords */
+	u32 cmds[];
+};
+
+struct intel_engine_cmd_cache {
+	struct mutex lock;
+	DECLARE_HASHTABLE(table, CMD_CACHE_HASH_BITS);
+	struct list_head lru;
+	unsigned long bytes;
+
+	u64 lookups;
+	u64 hits;
+	u64 scan_bytes_avoided;
+};
+
+static struct intel_engine_cmd_cache *cmd_cache_create(void)
+{
+	struct intel_engine_cmd_cache *cache;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return NULL;
+
+	mutex_init(&cache->lock);
+	hash_init(cache->table);
+	INIT_LIST_HEAD(&cache->lru);
+
+	return cache;
+}
+
+static void cmd_cache_remove(struct intel_engine_cmd_cache *cache,
+			     struct cmd_cache_entry *e)
+{
+	hash_del(&e->node);
+	list_del(&e->link);
+	cache->bytes -= e->len;
+	kvfree(e);
+}
+
+static void cmd_cache_destroy(struct intel_engine_cmd_cache *cache)
+{
+	struct cmd_cache_entry *e, *n;
+
+	if (!cache)
+		return;
+
+	list_for_each_entry_safe(e, n, &cache->lru, link)
+		cmd_cache_remove(cache, e);
+	mutex_destroy(&cache->lock);
+	kfree(cache);
+}
+
+static u32 cmd_cache_hash(const u32 *cmd, u32 len)
+{
+	return jhash2(cmd, len / sizeof(u32), len);
+}
+
+/* Returns the offset of MI_BATCH_BUFFER_END if @cmd is known good, or -1 */
+static int cmd_cache_lookup(struct intel_engine_cmd_cache *cache,
+			    const u32 *cmd, u32 len, u32 hash)
+{
+	struct cmd_cache_entry *e;
+	int end = -1;
+
+	mutex_lock(&cache->lock);
+	cache->lookups++;
+	hash_for_each_possible(cache->table, e, node, hash) {
+		if (e->hash != hash || e->len != len ||
+		    memcmp(e->cmds, cmd, len))
+			continue;
+
+		list_move(&e->link, &cache->lru);
+		cache->hits++;
+		cache->scan_bytes_avoided += e->end * sizeof(u32);
+		end = e->end;
+		break;
+	}
+	mutex_unlock(&cache->lock);
+
+	return end;
+}
+
+static void cmd_cache_insert(struct intel_engine_cmd_cache *cache,
+			     const u32 *cmd, u32 len, u32 hash, u32 end)
+{
+	struct cmd_cache_entry *e;
+
+	e = kvmalloc(struct_size(e, cmds, len / sizeof(u32)), GFP_KERNEL);
+	if (!e)
+		return;
+
+	e->hash = hash;
+	e->len = len;
+	e->end = end;
+	memcpy(e->cmds, cmd, len);
+
+	mutex_lock(&cache->lock);
+	hash_add(cache->table, &e->node, hash);
+	list_add(&e->link, &cache->lru);
+	cache->bytes += len;
+	while (cache->bytes > CMD_CACHE_MAX_BYTES)
+		cmd_cache_remove(cache, list_last_entry(&cache->lru,
+							struct cmd_cache_entry,
+							link));
+	mutex_unlock(&cache->lock);
+}
+
+/**
+ * intel_engine_print_cmd_cache() - show the command parser cache statistics
+ * @engine: the engine
+ * @m: where to print them
+ */
+void intel_engine_print_cmd_cache(struct intel_engine_cs *engine,
+				  struct drm_printer *m)
+{
+	struct intel_engine_cmd_cache *cache = engine->cmd_cache;
+
+	if (!cache)
+		return;
+
+	mutex_lock(&cache->lock);
+	drm_printf(m, "\tCmd parser cache: %lu bytes, %llu of %llu batches hit, %llu bytes not parsed\n",
+		   cache->bytes, cache->hits, cache->lookups,
+		   cache->scan_bytes_avoided);
+	mutex_unlock(&cache->lock);
+}
+
 /**
  * intel_engine_init_cmd_parser() - set cmd parser related fields for an engine
  * @engine: the engine to initialize
@@ -1030,6 +1180,9 @@ void intel_engine_init_cmd_parser(struct intel_engine_cs *engine)
 		return;
 	}
 
+	/* Parsing just isn't cached if this fails */
+	engine->cmd_cache = cmd_cache_create();
+
 	engine->flags |= I915_ENGINE_USING_CMD_PARSER;
 }
 
@@ -1045,6 +1198,8 @@ void intel_engine_cleanup_cmd_parser(struct intel_engine_cs *engine)
 	if (!intel_engine_using_cmd_parser(engine))
 		return;
 
+	cmd_cache_destroy(engine->cmd_cache);
+	engine->cmd_cache = NULL;
 	fini_hash_table(engine);
 }
 
@@ -1433,10 +1588,13 @@ int intel_engine_cmd_parser(struct i915_gem_context *ctx,
 			    struct drm_i915_gem_object *shadow_batch_obj,
 			    u64 shadow_batch_start)
 {
-	u32 *cmd, *batch_end, offset = 0;
+	struct intel_engine_cmd_cache *cache = engine->cmd_cache;
+	u32 *batch, *cmd, *batch_end, offset = 0;
 	struct drm_i915_cmd_descriptor default_desc = noop_desc;
 	const struct drm_i915_cmd_descriptor *desc = &default_desc;
 	bool needs_clflush_after = false;
+	bool cacheable = false;
+	u32 hash = 0;
 	int ret = 0;
 
 	cmd = copy_batch(shadow_batch_obj, batch_obj,
@@ -1446,6 +1604,20 @@ int intel_engine_cmd_parser(struct i915_gem_context *ctx,
 		DRM_DEBUG_DRIVER("CMD: Failed to copy batch\n");
 		return PTR_ERR(cmd);
 	}
+	batch = cmd;
+
+	if (cache && batch_len <= CMD_CACHE_MAX_LEN &&
+	    IS_ALIGNED(batch_len, sizeof(u32))) {
+		int end;
+
+		hash = cmd_cache_hash(cmd, batch_len);
+		end = cmd_cache_lookup(cache, cmd, batch_len, hash);
+		if (end >= 0) {
+			cmd += end;
+			goto out;
+		}
+		cacheable = true;
+	}
 
 	init_whitelist(ctx, batch_len);
 
@@ -1495,6 +1667,7 @@ int intel_engine_cmd_parser(struct i915_gem_context *ctx,
 
 			if (ret)
 				goto err;
+			cacheable = false;
 			break;
 		}
 
@@ -1510,6 +1683,10 @@ int intel_engine_cmd_parser(struct i915_gem_context *ctx,
 		}
 	} while (1);
 
+	if (cacheable)
+		cmd_cache_insert(cache, batch, batch_len, hash, offset);
+
+out:
 	if (needs_clflush_after) {
 		void *ptr = page_mask_bits(shadow_batch_obj->mm.mapping);
 
@@ -377,12 +377,28 @@ static void print_context_stats(struct seq_file *m,
 static int i915_gem_object_info(struct seq_file *m, void *data)
 {
 	struct drm_i915_private *i915 = node_to_i915(m->private);
+	struct i915_page_pool *pool = &i915->mm.internal_pool;
+	u64 count;
 
 	seq_printf(m, "%u shrinkable [%u free] objects, %llu bytes\n",
 		   i915->mm.shrink_count,
 		   atomic_read(&i915->mm.free_count),
 		   i915->mm.shrink_memory);
 
+	seq_printf(m, "%lu internal pages pooled, %lu hits, %lu misses\n",
+		   READ_ONCE(pool->count),
+		   READ_ONCE(pool->hits),
+		   READ_ONCE(pool->misses));
+
+	count = atomic64_read(&i915->mm.populate.count);
+	seq_printf(m, "%llu large objects populated on first use, avg %lluus, max %lluus\n",
+		   count,
+		   count ? div64_u64(atomic64_read(&i915->mm.populate.total_ns),
+				     count * NSEC_PER_USEC) : 0,
+		   div_u64(READ_ONCE(i915->mm.populate.max_ns), NSEC_PER_USEC));
+	seq_printf(m, "%lld pages populated ahead of use\n",
+		   atomic64_read(&i915->mm.populate.prefault_pages));
+
 	seq_putc(m, '\n');
 
 	print_context_stats(m, i915);
@@ -2764,10 +2780,31 @@ static int i915_rcs_topology(struct seq_file *m, void *unused)
 static int i915_shrinker_info(struct seq_file *m, void *unused)
 {
 	struct drm_i915_private *i915 = node_to_i915(m->private);
+	int i;
 
 	seq_printf(m, "seeks = %d\n", i915->mm.shrinker.seeks);
 	seq_printf(m, "batch = %lu\n", i915->mm.shrinker.batch);
 
+	seq_puts(m, "latency          no-wait     wait\n");
+	for (i = 0; i < I915_SHRINK_HIST_BUCKETS; i++) {
+		s64 nowait = atomic64_read(&i915->mm.shrink_stats.latency[0][i]);
+		s64 wait = atomic64_read(&i915->mm.shrink_stats.latency[1][i]);
+
+		if (!nowait && !wait)
+			continue;
+
+		if (i == I915_SHRINK_HIST_BUCKETS - 1)
+			seq_printf(m, "  >= %8luus", BIT(i - 1));
+		else
+			seq_printf(m, "  <  %8luus", BIT(i));
+		seq_printf(m, " %8lld %8lld\n", nowait, wait);
+	}
+
+	seq_printf(m, "young = %lld\n",
+		   atomic64_read(&i915->mm.shrink_stats.young));
+	seq_printf(m, "writeback = %lld\n",
+		   atomic64_read(&i915->mm.shrink_stats.writeback));
+
 	return 0;
 }
 
@@ -571,6 +571,19 @@ struct intel_l3_parity {
 	int which_slice;
 };
 
+/*
+ * Pages of freed internal objects, sorted by allocation order, that are
+ * handed to the next internal objects instead of going back to the page
+ * allocator.
+ */
+struct i915_page_pool {
+	spinlock_t lock;
+	struct list_head free[MAX_ORDER];
+	unsigned long count; /* in pages */
+	unsigned long hits;
+	unsigned long misses;
+};
+
 struct i915_gem_mm {
 	/** Memory allocator for GTT stolen memory */
 	struct drm_mm stolen;
@@ -607,6 +620,11 @@ struct i915_gem_mm {
 	 */
 	struct pagestash wc_stash;
 
+	/**
+	 * Pages recycled between internal objects
+	 */
+	struct i915_page_pool internal_pool;
+
 	/**
 	 * tmpfs instance used for shmem backed objects
 	 */
@@ -625,10 +643,41 @@ struct i915_gem_mm {
 	 */
 	struct workqueue_struct *userptr_wq;
 
+	/**
+	 * Workqueue to populate the pages of large objects ahead of their
+	 * first use, in parallel chunks.
+	 */
+	struct workqueue_struct *populate_wq;
+
+	/**
+	 * Latency of populating large objects when first used, and the
+	 * work done for them ahead of time.
+	 */
+	struct {
+		atomic64_t count;
+		atomic64_t total_ns;
+		u64 max_ns;
+		atomic64_t prefault_pages;
+	} populate;
+
+	/**
+	 * Objects whose released pages are written back to swap by
+	 * @writeback_work, instead of by the reclaimer that shrank them.
+	 */
+	struct llist_head writeback_list;
+	struct work_struct writeback_work;
+
 	/* shrinker accounting, also useful for userland debugging */
 	u64 shrink_memory;
 	u32 shrink_count;
 
+	struct {
+		/* latency of i915_gem_shrink(), without and with waiting */
+		atomic64_t latency[2][I915_SHRINK_HIST_BUCKETS];
+		atomic64_t young; /* recently used objects left bound */
+		atomic64_t writeback; /* objects written back by the worker */
+	} shrink_stats;
+
 #if IS_ENABLED(CONFIG_DRM_I915_MEMTRACK)
 	size_t phys_mem_total;
 #endif
@@ -1824,6 +1873,8 @@ int i915_getparam_ioctl(struct drm_device *dev, void *data,
 /* i915_gem.c */
 int i915_gem_init_userptr(struct drm_i915_private *dev_priv);
 void i915_gem_cleanup_userptr(struct drm_i915_private *dev_priv);
+int i915_gem_init_populate(struct drm_i915_private *dev_priv);
+void i915_gem_cleanup_populate(struct drm_i915_private *dev_priv);
 void i915_gem_init_early(struct drm_i915_private *dev_priv);
 void i915_gem_cleanup_early(struct drm_i915_private *dev_priv);
 int i915_gem_freeze(struct drm_i915_private *dev_priv);
@@ -1971,6 +2022,8 @@ int i915_gem_evict_vm(struct i915_address_space *vm);
 struct drm_i915_gem_object *
 i915_gem_object_create_internal(struct drm_i915_private *dev_priv,
 				phys_addr_t size);
+void i915_gem_init__internal(struct drm_i915_private *i915);
+unsigned long i915_gem_internal_pool_drain(struct drm_i915_private *i915);
 
 /* i915_gem_tiling.c */
 static inline bool i915_gem_object_needs_bit17_swizzle(struct drm_i915_gem_object *obj)
@@ -2005,6 +2058,8 @@ const char *i915_cache_level_str(struct drm_i915_private *i915, int type);
 int i915_cmd_parser_get_version(struct drm_i915_private *dev_priv);
 void intel_engine_init_cmd_parser(struct intel_engine_cs *engine);
 void intel_engine_cleanup_cmd_parser(struct intel_engine_cs *engine);
+void intel_engine_print_cmd_cache(struct intel_engine_cs *engine,
+				  struct drm_printer *m);
 int intel_engine_cmd_parser(struct i915_gem_context *cxt,
 			    struct intel_engine_cs *engine,
 			    struct drm_i915_gem_object *batch_obj,
@@ -2061,6 +2116,18 @@ int i915_reg_read_ioctl(struct drm_device *dev, void *data,
 #define I915_READ_FW(reg__) __I915_REG_OP(read_fw, dev_priv, (reg__))
 #define I915_WRITE_FW(reg__, val__) __I915_REG_OP(write_fw, dev_priv, (reg__), (val__))
 
+/*
+ * Record a display register write in a DSB, or do it right away with
+ * I915_WRITE_FW when there is no DSB.
+ */
+#define I915_WRITE_FW_DSB(dsb__, reg__, val__) do { \
+	struct intel_dsb *__dsb = (dsb__); \
+	if (__dsb) \
+		intel_dsb_reg_write(__dsb, (reg__), (val__)); \
+	else \
+		I915_WRITE_FW((reg__), (val__)); \
+} while (0)
+
 /* register wait wrappers for display regs */
 #define intel_de_wait_for_register(dev_priv_, reg_, mask_, value_, timeout_) \
 	intel_wait_for_register(&(dev_priv_)->uncore, \
@@ -1028,6 +1028,8 @@ i915_gem_create(struct drm_file *file,
 	if (IS_ERR(obj))
 		return PTR_ERR(obj);
 
+	i915_gem_object_populate_async(obj);
+
 	ret = drm_gem_handle_create(file, &obj->base, &handle);
 	/* drop reference from allocate - handle holds it now */
 	i915_gem_object_put(obj);
@@ -2053,6 +2055,12 @@ int i915_gem_init(struct drm_i915_private *dev_priv)
 	if (ret)
 		return ret;
 
+	ret = i915_gem_init_populate(dev_priv);
+	if (ret) {
+		i915_gem_cleanup_userptr(dev_priv);
+		return ret;
+	}
+
 	intel_uc_fetch_firmwares(&dev_priv->gt.uc);
 	intel_wopcm_init(&dev_priv->wopcm);
 
@@ -2161,6 +2169,7 @@ int i915_gem_init(struct drm_i915_private *dev_priv)
 
 	if (ret != -EIO) {
 		intel_uc_cleanup_firmwares(&dev_priv->gt.uc);
+		i915_gem_cleanup_populate(dev_priv);
 		i915_gem_cleanup_userptr(dev_priv);
 	}
 
@@ -2224,6 +2233,7 @@ void i915_gem_driver_release(struct drm_i915_private *dev_priv)
 	intel_wa_list_free(&dev_priv->gt_wa_list);
 
 	intel_uc_cleanup_firmwares(&dev_priv->gt.uc);
+	i915_gem_cleanup_populate(dev_priv);
 	i915_gem_cleanup_userptr(dev_priv);
 
 	i915_gem_drain_freed_objects(dev_priv);
@@ -2241,6 +2251,7 @@ static void i915_gem_init__mm(struct drm_i915_private *i915)
 	INIT_LIST_HEAD(&i915->mm.shrink_list);
 
 	i915_gem_init__objects(i915);
+	i915_gem_init__internal(i915);
 }
 
 void i915_gem_init_early(struct drm_i915_private *dev_priv)
@@ -2256,6 +2267,8 @@ void i915_gem_cleanup_early(struct drm_i915_private *dev_priv)
 	GEM_BUG_ON(!llist_empty(&dev_priv->mm.free_list));
 	GEM_BUG_ON(atomic_read(&dev_priv->mm.free_count));
 	WARN_ON(dev_priv->mm.shrink_count);
+
+	i915_gem_internal_pool_drain(dev_priv);
 }
 
 int i915_gem_freeze(struct drm_i915_private *dev_priv)
@@ -170,6 +170,9 @@ i915_param_named_unsafe(dmc_firmware_path, charp, 0400,
 i915_param_named_unsafe(enable_dp_mst, bool, 0600,
 	"Enable multi-stream transport (MST) for new DisplayPort sinks. (default: true)");
 
+i915_param_named_unsafe(enable_dsb_planes, bool, 0600,
+	"Program plane updates through the Display State Buffer, where available. (default: true)");
+
 #if IS_ENABLED(CONFIG_DRM_I915_DEBUG)
 i915_param_named_unsafe(inject_probe_failure, uint, 0400,
 	"Force an error after a number of failure check points (0:disabled (default), N:force failure at the Nth failure check point)");
@@ -182,6 +185,15 @@ i915_param_named(enable_dpcd_backlight, int, 0600,
 #if IS_ENABLED(CONFIG_DRM_I915_GVT)
 i915_param_named(enable_gvt, bool, 0400,
 	"Enable support for Intel GVT-g graphics virtualization host support(default:false)");
+
+i915_param_named(gvt_sched_policy, charp, 0400,
+	"GVT-g vGPU scheduling policy "
+	"(tbs=time-based round-robin [default], wfq=weighted-fair with latency priority)");
+
+i915_param_named(gvt_ppgtt_oos, bool, 0400,
+	"Let GVT-g guest PPGTT page tables that are written repeatedly go out of "
+	"sync, resyncing them before each workload instead of trapping every "
+	"write (default:false)");
 #endif
 
 #if IS_ENABLED(CONFIG_DRM_I915_UNSTABLE_FAKE_LMEM)
@@ -79,7 +79,10 @@ struct drm_printer;
 	param(bool, verbose_state_checks, true) \
 	param(bool, nuclear_pageflip, false) \
 	param(bool, enable_dp_mst, true) \
-	param(bool, enable_gvt, false)
+	param(bool, enable_dsb_planes, true) \
+	param(bool, enable_gvt, false) \
+	param(char *, gvt_sched_policy, "tbs") \
+	param(bool, gvt_ppgtt_oos, false)
 
 #define MEMBER(T, member, ...) T member;
 struct i915_params {
@@ -467,6 +467,8 @@ config_status(struct drm_i915_private *i915, u64 config)
 			return -ENODEV;
 		break;
 	case I915_PMU_INTERRUPTS:
+	case I915_PMU_SEMAPHORE_WAITS:
+	case I915_PMU_CPU_DEPENDENCIES:
 		break;
 	case I915_PMU_RC6_RESIDENCY:
 		if (!HAS_RC6(i915))
@@ -567,6 +569,12 @@ static u64 __i915_pmu_event_read(struct perf_event *event)
 		case I915_PMU_INTERRUPTS:
 			val = count_interrupts(i915);
 			break;
+		case I915_PMU_SEMAPHORE_WAITS:
+			val = atomic64_read(&pmu->semaphore_waits);
+			break;
+		case I915_PMU_CPU_DEPENDENCIES:
+			val = atomic64_read(&pmu->cpu_dependencies);
+			break;
 		case I915_PMU_RC6_RESIDENCY:
 			val = get_rc6(&i915->gt);
 			break;
@@ -852,6 +860,8 @@ create_event_attributes(struct i915_pmu *pmu)
 		__event(I915_PMU_REQUESTED_FREQUENCY, "requested-frequency", "M"),
 		__event(I915_PMU_INTERRUPTS, "interrupts", NULL),
 		__event(I915_PMU_RC6_RESIDENCY, "rc6-residency", "ns"),
+		__event(I915_PMU_SEMAPHORE_WAITS, "semaphore-waits", NULL),
+		__event(I915_PMU_CPU_DEPENDENCIES, "cpu-dependencies", NULL),
 	};
 	static const struct {
 		enum drm_i915_pmu_engine_sample sample;
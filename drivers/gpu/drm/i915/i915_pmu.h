@@ -104,6 +104,16 @@ struct i915_pmu {
 	 * @sleep_last: Last time GT parked for RC6 estimation.
 	 */
 	ktime_t sleep_last;
+	/**
+	 * @semaphore_waits: Inter-request dependencies resolved by the GPU
+	 * polling a semaphore.
+	 */
+	atomic64_t semaphore_waits;
+	/**
+	 * @cpu_dependencies: Inter-request dependencies resolved by the CPU
+	 * waiting for the signal before submitting the waiter.
+	 */
+	atomic64_t cpu_dependencies;
 	/**
 	 * @i915_attr: Memory block holding device attributes.
 	 */
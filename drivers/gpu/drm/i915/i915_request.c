@@ -23,6 +23,7 @@
  */
 
 #include <linux/dma-fence-array.h>
+#include <linux/dma-fence-chain.h>
 #include <linux/irq_work.h>
 #include <linux/prefetch.h>
 #include <linux/sched.h>
@@ -869,9 +870,11 @@ emit_semaphore_wait(struct i915_request *to,
 	intel_ring_advance(to, cs);
 	to->sched.semaphores |= from->engine->mask;
 	to->sched.flags |= I915_SCHED_HAS_SEMAPHORE_CHAIN;
+	atomic64_inc(&to->i915->pmu.semaphore_waits);
 	return 0;
 
 await_fence:
+	atomic64_inc(&to->i915->pmu.cpu_dependencies);
 	return i915_sw_fence_await_dma_fence(&to->submit,
 					     &from->fence, 0,
 					     I915_FENCE_GFP);
@@ -904,6 +907,7 @@ i915_request_await_request(struct i915_request *to, struct i915_request *from)
 		   to->gem_context->sched.priority >= I915_PRIORITY_NORMAL) {
 		ret = emit_semaphore_wait(to, from, I915_FENCE_GFP);
 	} else {
+		atomic64_inc(&to->i915->pmu.cpu_dependencies);
 		ret = i915_sw_fence_await_dma_fence(&to->submit,
 						    &from->fence, 0,
 						    I915_FENCE_GFP);
@@ -922,6 +926,34 @@ i915_request_await_request(struct i915_request *to, struct i915_request *from)
 	return 0;
 }
 
+static int
+i915_request_await_dma_fence_chain(struct i915_request *rq,
+				   struct dma_fence *fence)
+{
+	struct dma_fence *iter;
+	int ret = 0;
+
+	/*
+	 * A timeline syncobj point signals once its own fence and all the
+	 * earlier points have signaled. Wait on each of those fences in turn
+	 * rather than on the chain node itself, so that our own requests
+	 * along the timeline can still be waited upon with a semaphore.
+	 * Walking the chain drops the nodes that have already signaled.
+	 */
+	dma_fence_chain_for_each(iter, fence) {
+		struct dma_fence_chain *chain = to_dma_fence_chain(iter);
+
+		ret = i915_request_await_dma_fence(rq,
+						   chain ? chain->fence : iter);
+		if (ret < 0) {
+			dma_fence_put(iter);
+			break;
+		}
+	}
+
+	return ret;
+}
+
 int
 i915_request_await_dma_fence(struct i915_request *rq, struct dma_fence *fence)
 {
@@ -929,6 +961,9 @@ i915_request_await_dma_fence(struct i915_request *rq, struct dma_fence *fence)
 	unsigned int nchild = 1;
 	int ret;
 
+	if (to_dma_fence_chain(fence))
+		return i915_request_await_dma_fence_chain(rq, fence);
+
 	/*
 	 * Note that if the fence-array was created in signal-on-any mode,
 	 * we should *not* decompose it into its individual fences. However,
@@ -964,12 +999,14 @@ i915_request_await_dma_fence(struct i915_request *rq, struct dma_fence *fence)
 						 fence))
 			continue;
 
-		if (dma_fence_is_i915(fence))
+		if (dma_fence_is_i915(fence)) {
 			ret = i915_request_await_request(rq, to_request(fence));
-		else
+		} else {
+			atomic64_inc(&rq->i915->pmu.cpu_dependencies);
 			ret = i915_sw_fence_await_dma_fence(&rq->submit, fence,
 							    fence->context ? I915_FENCE_TIMEOUT : 0,
 							    I915_FENCE_GFP);
+		}
 		if (ret < 0)
 			return ret;
 
@@ -412,6 +412,30 @@ TRACE_EVENT(i915_pipe_update_end,
 		      __entry->scanline)
 );
 
+TRACE_EVENT(i915_pipe_update_evaded_time,
+	    TP_PROTO(struct intel_crtc *crtc, ktime_t end_time),
+	    TP_ARGS(crtc, end_time),
+
+	    TP_STRUCT__entry(
+			     __field(enum pipe, pipe)
+			     __field(u32, frame)
+			     __field(s64, ns)
+			     __field(u32, dsb_bytes)
+			     ),
+
+	    TP_fast_assign(
+			   __entry->pipe = crtc->pipe;
+			   __entry->frame = crtc->debug.start_vbl_count;
+			   __entry->ns = ktime_to_ns(ktime_sub(end_time,
+						crtc->debug.start_vbl_time));
+			   __entry->dsb_bytes = crtc->debug.dsb_bytes;
+			   ),
+
+	    TP_printk("pipe %c, frame=%u, time=%lldns, dsb=%u bytes",
+		      pipe_name(__entry->pipe), __entry->frame,
+		      __entry->ns, __entry->dsb_bytes)
+);
+
 /* object tracking */
 
 TRACE_EVENT(i915_gem_object_create,
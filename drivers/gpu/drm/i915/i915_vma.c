@@ -1120,6 +1120,7 @@ int i915_vma_move_to_active(struct i915_vma *vma,
 	}
 	obj->read_domains |= I915_GEM_GPU_DOMAINS;
 	obj->mm.dirty = true;
+	WRITE_ONCE(obj->mm.last_use, jiffies);
 
 	GEM_BUG_ON(!i915_vma_is_active(vma));
 	return 0;
@@ -5076,13 +5076,14 @@ static int skl_build_pipe_wm(struct intel_crtc_state *crtc_state)
 }
 
 static void skl_ddb_entry_write(struct drm_i915_private *dev_priv,
-				i915_reg_t reg,
+				struct intel_dsb *dsb, i915_reg_t reg,
 				const struct skl_ddb_entry *entry)
 {
 	if (entry->end)
-		I915_WRITE_FW(reg, (entry->end - 1) << 16 | entry->start);
+		I915_WRITE_FW_DSB(dsb, reg,
+				  (entry->end - 1) << 16 | entry->start);
 	else
-		I915_WRITE_FW(reg, 0);
+		I915_WRITE_FW_DSB(dsb, reg, 0);
 }
 
 static inline uint32_t skl_calc_wm_level(const struct skl_wm_level *level)
@@ -5100,12 +5101,12 @@ static inline uint32_t skl_calc_wm_level(const struct skl_wm_level *level)
 }
 
 static void skl_write_wm_level(struct drm_i915_private *dev_priv,
-			       i915_reg_t reg,
+			       struct intel_dsb *dsb, i915_reg_t reg,
 			       const struct skl_wm_level *level)
 {
 	uint32_t val = skl_calc_wm_level(level);
 
-	I915_WRITE_FW(reg, val);
+	I915_WRITE_FW_DSB(dsb, reg, val);
 }
 
 void skl_write_plane_wm(struct intel_plane *plane,
@@ -5140,11 +5141,12 @@ void skl_write_plane_wm(struct intel_plane *plane,
 	}
 #endif
 	for (level = 0; level <= max_level; level++) {
-		skl_write_wm_level(dev_priv, PLANE_WM(pipe, plane_id, level),
+		skl_write_wm_level(dev_priv, crtc_state->dsb,
+				   PLANE_WM(pipe, plane_id, level),
 				   &wm->wm[level]);
 	}
-	skl_write_wm_level(dev_priv, PLANE_WM_TRANS(pipe, plane_id),
-			   &wm->trans_wm);
+	skl_write_wm_level(dev_priv, crtc_state->dsb,
+			   PLANE_WM_TRANS(pipe, plane_id), &wm->trans_wm);
 
 #if IS_ENABLED(CONFIG_DRM_I915_GVT)
 	/* In GVT direct display, we only use the statically allocated ddb */
@@ -5153,7 +5155,7 @@ void skl_write_plane_wm(struct intel_plane *plane,
 #endif
 
 	if (INTEL_GEN(dev_priv) >= 11) {
-		skl_ddb_entry_write(dev_priv,
+		skl_ddb_entry_write(dev_priv, crtc_state->dsb,
 				    PLANE_BUF_CFG(pipe, plane_id), ddb_y);
 		return;
 	}
@@ -5161,9 +5163,9 @@ void skl_write_plane_wm(struct intel_plane *plane,
 	if (wm->is_planar)
 		swap(ddb_y, ddb_uv);
 
-	skl_ddb_entry_write(dev_priv,
+	skl_ddb_entry_write(dev_priv, crtc_state->dsb,
 			    PLANE_BUF_CFG(pipe, plane_id), ddb_y);
-	skl_ddb_entry_write(dev_priv,
+	skl_ddb_entry_write(dev_priv, crtc_state->dsb,
 			    PLANE_NV12_BUF_CFG(pipe, plane_id), ddb_uv);
 }
 
@@ -5195,10 +5197,10 @@ void skl_write_cursor_wm(struct intel_plane *plane,
 #endif
 
 	for (level = 0; level <= max_level; level++) {
-		skl_write_wm_level(dev_priv, CUR_WM(pipe, level),
+		skl_write_wm_level(dev_priv, NULL, CUR_WM(pipe, level),
 				   &wm->wm[level]);
 	}
-	skl_write_wm_level(dev_priv, CUR_WM_TRANS(pipe), &wm->trans_wm);
+	skl_write_wm_level(dev_priv, NULL, CUR_WM_TRANS(pipe), &wm->trans_wm);
 
 #if IS_ENABLED(CONFIG_DRM_I915_GVT)
 	/* In GVT direct display, we only use the statically allocated ddb */
@@ -5206,7 +5208,7 @@ void skl_write_cursor_wm(struct intel_plane *plane,
 		return;
 #endif
 
-	skl_ddb_entry_write(dev_priv, CUR_BUF_CFG(pipe), ddb);
+	skl_ddb_entry_write(dev_priv, NULL, CUR_BUF_CFG(pipe), ddb);
 }
 
 bool skl_wm_level_equals(const struct skl_wm_level *l1,
@@ -27,3 +27,6 @@ selftest(hugepages, i915_gem_huge_page_mock_selftests)
 selftest(contexts, i915_gem_context_mock_selftests)
 selftest(buddy, i915_buddy_mock_selftests)
 selftest(memory_region, intel_memory_region_mock_selftests)
+#if IS_ENABLED(CONFIG_DRM_I915_GVT)
+selftest(gvt_sched, intel_gvt_sched_mock_selftests)
+#endif
@@ -1063,6 +1063,100 @@ static int live_sequential_engines(void *arg)
 	return err;
 }
 
+static int __live_timeline_point(struct intel_engine_cs *signal,
+				 struct intel_engine_cs *waiter)
+{
+	struct i915_request *rq, *wait;
+	struct dma_fence_chain *chain;
+	struct i915_sw_fence *submit;
+	int err;
+
+	submit = heap_fence_create(GFP_KERNEL);
+	if (!submit)
+		return -ENOMEM;
+
+	/* Hold back the signaler so that its fence is still pending */
+	rq = i915_request_create(signal->kernel_context);
+	if (IS_ERR(rq)) {
+		err = PTR_ERR(rq);
+		goto out_submit;
+	}
+
+	err = i915_sw_fence_await_sw_fence_gfp(&rq->submit, submit,
+					       GFP_KERNEL);
+	i915_request_get(rq);
+	i915_request_add(rq);
+	if (err < 0)
+		goto out_rq;
+
+	chain = kmalloc(sizeof(*chain), GFP_KERNEL);
+	if (!chain) {
+		err = -ENOMEM;
+		goto out_rq;
+	}
+	dma_fence_chain_init(chain, NULL, dma_fence_get(&rq->fence), 1);
+
+	wait = i915_request_create(waiter->kernel_context);
+	if (IS_ERR(wait)) {
+		err = PTR_ERR(wait);
+		goto out_chain;
+	}
+
+	err = i915_request_await_dma_fence(wait, &chain->base);
+	if (err == 0 &&
+	    !intel_timeline_sync_is_later(i915_request_timeline(wait),
+					  &rq->fence)) {
+		pr_err("%s: timeline point of %s not awaited on the request\n",
+		       waiter->name, signal->name);
+		err = -EINVAL;
+	}
+	i915_request_add(wait);
+
+out_chain:
+	dma_fence_put(&chain->base);
+out_rq:
+	i915_request_put(rq);
+out_submit:
+	i915_sw_fence_commit(submit);
+	heap_fence_put(submit);
+	return err;
+}
+
+static int live_timeline_point(void *arg)
+{
+	struct drm_i915_private *i915 = arg;
+	struct intel_engine_cs *signal, *waiter;
+	struct igt_live_test t;
+	int err;
+
+	/*
+	 * A timeline syncobj point wraps its fence inside a dma_fence_chain.
+	 * Check that when the point is one of our requests, we unwrap the
+	 * chain and wait upon the request itself (so that we may use a
+	 * semaphore) rather than treating the chain as a foreign fence.
+	 */
+
+	err = igt_live_test_begin(&t, i915, __func__, "");
+	if (err)
+		return err;
+
+	for_each_uabi_engine(signal, i915) {
+		for_each_uabi_engine(waiter, i915) {
+			if (waiter == signal)
+				continue;
+
+			err = __live_timeline_point(signal, waiter);
+			if (err)
+				goto out;
+		}
+	}
+
+out:
+	if (igt_live_test_end(&t))
+		err = -EIO;
+	return err;
+}
+
 static int __live_parallel_engine1(void *arg)
 {
 	struct intel_engine_cs *engine = arg;
@@ -1444,6 +1538,7 @@ int i915_request_live_selftests(struct drm_i915_private *i915)
 		SUBTEST(live_all_engines),
 		SUBTEST(live_sequential_engines),
 		SUBTEST(live_parallel_engines),
+		SUBTEST(live_timeline_point),
 		SUBTEST(live_empty_request),
 		SUBTEST(live_breadcrumbs_smoketest),
 	};
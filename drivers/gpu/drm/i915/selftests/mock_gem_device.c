@@ -67,6 +67,7 @@ static void mock_device_release(struct drm_device *dev)
 
 	drain_workqueue(i915->wq);
 	i915_gem_drain_freed_objects(i915);
+	i915_gem_internal_pool_drain(i915);
 
 	mock_fini_ggtt(&i915->ggtt);
 	destroy_workqueue(i915->wq);
@@ -25,3 +25,5 @@ selftest(highest, igt_highest)
 selftest(color, igt_color)
 selftest(color_evict, igt_color_evict)
 selftest(color_evict_range, igt_color_evict_range)
+selftest(insert_batch, igt_insert_batch)
+selftest(bench_insert, igt_bench_insert)
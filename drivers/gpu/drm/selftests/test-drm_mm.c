@@ -5,6 +5,7 @@
 
 #define pr_fmt(fmt) "drm_mm: " fmt
 
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/prime_numbers.h>
 #include <linux/slab.h>
@@ -27,6 +28,7 @@ enum {
 	BOTTOMUP,
 	TOPDOWN,
 	EVICT,
+	FIT,
 };
 
 static const struct insert_mode {
@@ -37,6 +39,7 @@ static const struct insert_mode {
 	[BOTTOMUP] = { "bottom-up", DRM_MM_INSERT_LOW },
 	[TOPDOWN] = { "top-down", DRM_MM_INSERT_HIGH },
 	[EVICT] = { "evict", DRM_MM_INSERT_EVICT },
+	[FIT] = { "fit", DRM_MM_INSERT_FIT },
 	{}
 }, evict_modes[] = {
 	{ "bottom-up", DRM_MM_INSERT_LOW },
@@ -2350,6 +2353,231 @@ static int igt_color_evict_range(void *ignored)
 	return ret;
 }
 
+static int igt_insert_batch(void *ignored)
+{
+	const unsigned int count = min_t(unsigned int, BIT(10), max_iterations);
+	const u64 size = 4096;
+	const struct insert_mode *mode;
+	struct drm_mm_node *nodes, **ptrs, *node, *next;
+	struct drm_mm_node extra = {}, *extra_ptr = &extra;
+	struct drm_mm mm;
+	unsigned int n;
+	int ret, err;
+
+	/* Batches of nodes should fill the range just as single inserts do */
+
+	ret = -ENOMEM;
+	nodes = vzalloc(array_size(count, sizeof(*nodes)));
+	if (!nodes)
+		goto err;
+
+	ptrs = kmalloc_array(count, sizeof(*ptrs), GFP_KERNEL);
+	if (!ptrs)
+		goto err_nodes;
+
+	for (n = 0; n < count; n++)
+		ptrs[n] = &nodes[n];
+
+	ret = -EINVAL;
+	drm_mm_init(&mm, 0, count * size);
+
+	for (mode = insert_modes; mode->name; mode++) {
+		err = drm_mm_insert_nodes_in_range(&mm, ptrs, count,
+						   size, 0, mode - insert_modes,
+						   0, U64_MAX, mode->mode);
+		if (err) {
+			pr_err("%s batch insert of %u nodes failed, err=%d\n",
+			       mode->name, count, err);
+			goto out;
+		}
+
+		for (n = 0; n < count; n++) {
+			if (!assert_node(&nodes[n], &mm, size, 0,
+					 mode - insert_modes)) {
+				pr_err("%s batch node %u incorrect\n",
+				       mode->name, n);
+				goto out;
+			}
+		}
+
+		if (!assert_continuous(&mm, size))
+			goto out;
+
+		/* A batch that does not fit must leave nothing behind */
+		drm_mm_remove_node(&nodes[0]);
+		ptrs[0] = &extra;
+		ptrs[1] = &nodes[0];
+		err = drm_mm_insert_nodes_in_range(&mm, ptrs, 2,
+						   size, 0, 0,
+						   0, U64_MAX, mode->mode);
+		ptrs[0] = &nodes[0];
+		ptrs[1] = &nodes[1];
+		if (err != -ENOSPC) {
+			pr_err("%s impossible batch insert returned %d\n",
+			       mode->name, err);
+			goto out;
+		}
+
+		if (drm_mm_node_allocated(&extra)) {
+			pr_err("%s failed batch insert left a node behind\n",
+			       mode->name);
+			goto out;
+		}
+
+		err = drm_mm_insert_nodes_in_range(&mm, &extra_ptr, 1,
+						   size, 0, 0,
+						   0, U64_MAX, mode->mode);
+		if (err) {
+			pr_err("%s batch refill of the only hole failed, err=%d\n",
+			       mode->name, err);
+			goto out;
+		}
+
+		if (!assert_continuous(&mm, size))
+			goto out;
+
+		drm_mm_for_each_node_safe(node, next, &mm)
+			drm_mm_remove_node(node);
+		DRM_MM_BUG_ON(!drm_mm_clean(&mm));
+
+		cond_resched();
+	}
+
+	ret = 0;
+out:
+	drm_mm_for_each_node_safe(node, next, &mm)
+		drm_mm_remove_node(node);
+	drm_mm_takedown(&mm);
+	kfree(ptrs);
+err_nodes:
+	vfree(nodes);
+err:
+	return ret;
+}
+
+static u64 random_size(struct rnd_state *prng)
+{
+	return (1 + prandom_u32_state(prng) % 64) * 4096;
+}
+
+static int igt_bench_insert(void *ignored)
+{
+	const unsigned int count = min_t(unsigned int, BIT(12), max_iterations);
+	const unsigned int bench_modes[] = { BEST, FIT };
+	struct drm_mm_node *fill, *nodes, **ptrs, *node, *next;
+	struct drm_mm mm;
+	unsigned int i, n;
+	ktime_t dt;
+	int ret;
+
+	/*
+	 * Not a pass/fail test: report the cost of inserting into a
+	 * fragmented range by the size tree and by the size classes, and
+	 * of inserting a batch of nodes one by one and at once.
+	 */
+
+	ret = -ENOMEM;
+	fill = vzalloc(array_size(2 * count, sizeof(*fill)));
+	if (!fill)
+		goto err;
+
+	nodes = vzalloc(array_size(count, sizeof(*nodes)));
+	if (!nodes)
+		goto err_fill;
+
+	ptrs = kmalloc_array(count, sizeof(*ptrs), GFP_KERNEL);
+	if (!ptrs)
+		goto err_nodes;
+
+	for (n = 0; n < count; n++)
+		ptrs[n] = &nodes[n];
+
+	ret = -EINVAL;
+	drm_mm_init(&mm, 0, U64_MAX);
+
+	/* Leave a hole of random size between every other node */
+	{
+		DRM_RND_STATE(prng, random_seed);
+
+		for (n = 0; n < 2 * count; n++) {
+			if (drm_mm_insert_node_generic(&mm, &fill[n],
+						       random_size(&prng), 0, 0,
+						       DRM_MM_INSERT_LOW)) {
+				pr_err("failed to fragment the range\n");
+				goto out;
+			}
+		}
+		for (n = 0; n < 2 * count; n += 2)
+			drm_mm_remove_node(&fill[n]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bench_modes); i++) {
+		const struct insert_mode *mode = &insert_modes[bench_modes[i]];
+		DRM_RND_STATE(prng, random_seed + 1);
+
+		dt = ktime_get();
+		for (n = 0; n < count; n++) {
+			if (drm_mm_insert_node_generic(&mm, &nodes[n],
+						       random_size(&prng), 0, 0,
+						       mode->mode)) {
+				pr_err("%s insert into fragmented range failed\n",
+				       mode->name);
+				goto out;
+			}
+		}
+		dt = ktime_sub(ktime_get(), dt);
+
+		pr_info("%s: %u inserts among %u holes, %lluns each\n",
+			mode->name, count, count,
+			div_u64(ktime_to_ns(dt), count));
+
+		for (n = 0; n < count; n++)
+			drm_mm_remove_node(&nodes[n]);
+
+		cond_resched();
+	}
+
+	drm_mm_for_each_node_safe(node, next, &mm)
+		drm_mm_remove_node(node);
+
+	dt = ktime_get();
+	for (n = 0; n < count; n++) {
+		if (drm_mm_insert_node(&mm, &nodes[n], 4096)) {
+			pr_err("single insert failed\n");
+			goto out;
+		}
+	}
+	dt = ktime_sub(ktime_get(), dt);
+	pr_info("%u single inserts, %lluns each\n",
+		count, div_u64(ktime_to_ns(dt), count));
+
+	for (n = 0; n < count; n++)
+		drm_mm_remove_node(&nodes[n]);
+
+	dt = ktime_get();
+	if (drm_mm_insert_nodes_in_range(&mm, ptrs, count, 4096, 0, 0,
+					 0, U64_MAX, DRM_MM_INSERT_BEST)) {
+		pr_err("batch insert failed\n");
+		goto out;
+	}
+	dt = ktime_sub(ktime_get(), dt);
+	pr_info("batch of %u inserts, %lluns each\n",
+		count, div_u64(ktime_to_ns(dt), count));
+
+	ret = 0;
+out:
+	drm_mm_for_each_node_safe(node, next, &mm)
+		drm_mm_remove_node(node);
+	drm_mm_takedown(&mm);
+	kfree(ptrs);
+err_nodes:
+	vfree(nodes);
+err_fill:
+	vfree(fill);
+err:
+	return ret;
+}
+
 #include "drm_selftest.c"
 
 static int __init test_drm_mm_init(void)
@@ -37,12 +37,41 @@
 #include <drm/drm_vma_manager.h>
 #include <linux/mm.h>
 #include <linux/pfn_t.h>
+#include <linux/seq_file.h>
 #include <linux/rbtree.h>
 #include <linux/module.h>
 #include <linux/uaccess.h>
 #include <linux/mem_encrypt.h>
 
 #define TTM_BO_VM_NUM_PREFAULT 16
+#define TTM_BO_VM_MAX_PREFAULT (PMD_SIZE >> PAGE_SHIFT)
+
+static atomic64_t ttm_bo_vm_faults;
+static atomic64_t ttm_bo_vm_pages;
+
+/*
+ * Number of pages to prefault. Faults continuing where the previous fault
+ * on the bo stopped double the number, up to the size of a PMD, and other
+ * faults reset it. Once at the maximum, prefaulting stops at PMD
+ * boundaries so that sequential access fills one page table per fault.
+ */
+static unsigned long ttm_bo_vm_num_prefault(struct ttm_buffer_object *bo,
+					    unsigned long address,
+					    unsigned long page_offset)
+{
+	unsigned long num_prefault = TTM_BO_VM_NUM_PREFAULT;
+
+	if (page_offset == bo->vm_fault_next)
+		num_prefault = clamp_t(unsigned long, bo->vm_prefault * 2,
+				       TTM_BO_VM_NUM_PREFAULT,
+				       TTM_BO_VM_MAX_PREFAULT);
+
+	if (num_prefault == TTM_BO_VM_MAX_PREFAULT)
+		num_prefault = (ALIGN(address + 1, PMD_SIZE) - address) >>
+			PAGE_SHIFT;
+
+	return num_prefault;
+}
 
 static vm_fault_t ttm_bo_vm_fault_idle(struct ttm_buffer_object *bo,
 				struct vm_fault *vmf)
@@ -114,6 +143,7 @@ static vm_fault_t ttm_bo_vm_fault(struct vm_fault *vmf)
 	struct ttm_bo_device *bdev = bo->bdev;
 	unsigned long page_offset;
 	unsigned long page_last;
+	unsigned long num_prefault;
 	unsigned long pfn;
 	struct ttm_tt *ttm = NULL;
 	struct page *page;
@@ -254,7 +284,8 @@ static vm_fault_t ttm_bo_vm_fault(struct vm_fault *vmf)
 	 * Speculatively prefault a number of pages. Only error on
 	 * first page.
 	 */
-	for (i = 0; i < TTM_BO_VM_NUM_PREFAULT; ++i) {
+	num_prefault = ttm_bo_vm_num_prefault(bo, address, page_offset);
+	for (i = 0; i < num_prefault; ++i) {
 		if (bo->mem.bus.is_iomem) {
 			/* Iomem should not be marked encrypted */
 			cvma.vm_page_prot = pgprot_decrypted(cvma.vm_page_prot);
@@ -287,9 +318,17 @@ static vm_fault_t ttm_bo_vm_fault(struct vm_fault *vmf)
 		}
 
 		address += PAGE_SIZE;
-		if (unlikely(++page_offset >= page_last))
+		if (unlikely(++page_offset >= page_last)) {
+			++i;
 			break;
+		}
 	}
+
+	/* i is the number of pages mapped */
+	bo->vm_fault_next = page_offset;
+	bo->vm_prefault = i;
+	atomic64_inc(&ttm_bo_vm_faults);
+	atomic64_add(i, &ttm_bo_vm_pages);
 	ret = VM_FAULT_NOPAGE;
 out_io_unlock:
 	ttm_mem_io_unlock(man);
@@ -486,3 +525,22 @@ int ttm_fbdev_mmap(struct vm_area_struct *vma, struct ttm_buffer_object *bo)
 	return 0;
 }
 EXPORT_SYMBOL(ttm_fbdev_mmap);
+
+int ttm_bo_vm_debugfs(struct seq_file *m, void *data)
+{
+	u64 faults = atomic64_read(&ttm_bo_vm_faults);
+	u64 pages = atomic64_read(&ttm_bo_vm_pages);
+	u64 per_mib = 0;
+	u32 rem;
+
+	/* In hundredths */
+	if (pages)
+		per_mib = div64_u64(faults * 100 << (20 - PAGE_SHIFT), pages);
+
+	seq_printf(m, "faults: %llu\n", faults);
+	seq_printf(m, "pages mapped: %llu\n", pages);
+	per_mib = div_u64_rem(per_mib, 100, &rem);
+	seq_printf(m, "faults per MiB mapped: %llu.%02u\n", per_mib, rem);
+	return 0;
+}
+EXPORT_SYMBOL(ttm_bo_vm_debugfs);
@@ -39,6 +39,7 @@
 #include <linux/mm_types.h>
 #include <linux/module.h>
 #include <linux/mm.h>
+#include <linux/ktime.h>
 #include <linux/seq_file.h> /* for seq_printf */
 #include <linux/slab.h>
 #include <linux/dma-mapping.h>
@@ -50,6 +51,8 @@
 #include <drm/ttm/ttm_set_memory.h>
 
 #define NUM_PAGES_TO_ALLOC		(PAGE_SIZE/sizeof(struct page *))
+/* pages to change the caching of at once when allocating */
+#define NUM_PAGES_TO_CACHE		(16 * NUM_PAGES_TO_ALLOC)
 #define SMALL_ALLOCATION		16
 #define FREE_ALL_PAGES			(~0U)
 /* times are in msecs */
@@ -65,6 +68,9 @@
  * @list: Pool of free uc/wc pages for fast reuse.
  * @gfp_flags: Flags to pass for alloc_page.
  * @npages: Number of pages in pool.
+ * @nhits: Number of allocations served from the pool.
+ * @nmisses: Number of allocations the pool could not serve.
+ * @nid: NUMA node the pool holds pages of.
  */
 struct ttm_page_pool {
 	spinlock_t		lock;
@@ -75,7 +81,10 @@ struct ttm_page_pool {
 	char			*name;
 	unsigned long		nfrees;
 	unsigned long		nrefills;
+	unsigned long		nhits;
+	unsigned long		nmisses;
 	unsigned int		order;
+	int			nid;
 };
 
 /**
@@ -92,6 +101,25 @@ struct ttm_pool_opts {
 
 #define NUM_POOLS 6
 
+/**
+ * struct ttm_node_pools - The pools of one NUMA node
+ *
+ * @pools: All pool objects of the node.
+ */
+struct ttm_node_pools {
+	union {
+		struct ttm_page_pool	pools[NUM_POOLS];
+		struct {
+			struct ttm_page_pool	wc_pool;
+			struct ttm_page_pool	uc_pool;
+			struct ttm_page_pool	wc_pool_dma32;
+			struct ttm_page_pool	uc_pool_dma32;
+			struct ttm_page_pool	wc_pool_huge;
+			struct ttm_page_pool	uc_pool_huge;
+		} ;
+	};
+};
+
 /**
  * struct ttm_pool_manager - Holds memory pools for fst allocation
  *
@@ -102,25 +130,24 @@ struct ttm_pool_opts {
  * @work: Work that is used to shrink the pool. Work is only run when there is
  * some pages to free.
  * @small_allocation: Limit in number of pages what is small allocation.
+ * @caching_calls: Number of page caching attribute changes.
+ * @caching_pages: Number of pages whose caching attribute was changed.
+ * @caching_ns: Time spent changing page caching attributes.
  *
- * @pools: All pool objects in use.
+ * @nodes: The pools of each NUMA node. Pages are returned to the pools of
+ * the node they are on, and allocations served from the pools of the
+ * nearest node with memory.
  **/
 struct ttm_pool_manager {
 	struct kobject		kobj;
 	struct shrinker		mm_shrink;
 	struct ttm_pool_opts	options;
 
-	union {
-		struct ttm_page_pool	pools[NUM_POOLS];
-		struct {
-			struct ttm_page_pool	wc_pool;
-			struct ttm_page_pool	uc_pool;
-			struct ttm_page_pool	wc_pool_dma32;
-			struct ttm_page_pool	uc_pool_dma32;
-			struct ttm_page_pool	wc_pool_huge;
-			struct ttm_page_pool	uc_pool_huge;
-		} ;
-	};
+	atomic64_t		caching_calls;
+	atomic64_t		caching_pages;
+	atomic64_t		caching_ns;
+
+	struct ttm_node_pools	nodes[];
 };
 
 static struct attribute ttm_page_pool_max = {
@@ -147,7 +174,7 @@ static void ttm_pool_kobj_release(struct kobject *kobj)
 {
 	struct ttm_pool_manager *m =
 		container_of(kobj, struct ttm_pool_manager, kobj);
-	kfree(m);
+	kvfree(m);
 }
 
 static ssize_t ttm_pool_store(struct kobject *kobj,
@@ -218,7 +245,7 @@ static struct ttm_pool_manager *_manager;
 
 /**
  * Select the right pool or requested caching state and ttm flags. */
-static struct ttm_page_pool *ttm_get_pool(int flags, bool huge,
+static struct ttm_page_pool *ttm_get_pool(int nid, int flags, bool huge,
 					  enum ttm_caching_state cstate)
 {
 	int pool_index;
@@ -240,7 +267,24 @@ static struct ttm_page_pool *ttm_get_pool(int flags, bool huge,
 		pool_index |= 0x4;
 	}
 
-	return &_manager->pools[pool_index];
+	return &_manager->nodes[nid].pools[pool_index];
+}
+
+/*
+ * options.max_size limits each pool over all nodes, so the pool of a node
+ * gets its share of it.
+ */
+static unsigned ttm_pool_node_max_size(void)
+{
+	return _manager->options.max_size / num_node_state(N_MEMORY);
+}
+
+static void ttm_account_caching(unsigned int npages, ktime_t start)
+{
+	atomic64_inc(&_manager->caching_calls);
+	atomic64_add(npages, &_manager->caching_pages);
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), start)),
+		     &_manager->caching_ns);
 }
 
 /* set memory back to wb and free the pages. */
@@ -248,6 +292,7 @@ static void ttm_pages_put(struct page *pages[], unsigned npages,
 		unsigned int order)
 {
 	unsigned int i, pages_nr = (1 << order);
+	ktime_t start = ktime_get();
 
 	if (order == 0) {
 		if (ttm_set_pages_array_wb(pages, npages))
@@ -261,6 +306,8 @@ static void ttm_pages_put(struct page *pages[], unsigned npages,
 		}
 		__free_pages(pages[i], order);
 	}
+
+	ttm_account_caching(npages << order, start);
 }
 
 static void ttm_pool_update_free_locked(struct ttm_page_pool *pool,
@@ -372,6 +419,9 @@ static int ttm_page_pool_free(struct ttm_page_pool *pool, unsigned nr_free,
  * XXX: (dchinner) Deadlock warning!
  *
  * This code is crying out for a shrinker per pool....
+ *
+ * The shrinker is NUMA aware and only frees the pools of the node that is
+ * under pressure.
  */
 static unsigned long
 ttm_pool_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
@@ -380,6 +430,7 @@ ttm_pool_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 	static unsigned start_pool;
 	unsigned i;
 	unsigned pool_offset;
+	struct ttm_page_pool *pools = _manager->nodes[sc->nid].pools;
 	struct ttm_page_pool *pool;
 	int shrink_pages = sc->nr_to_scan;
 	unsigned long freed = 0;
@@ -396,7 +447,7 @@ ttm_pool_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 		if (shrink_pages == 0)
 			break;
 
-		pool = &_manager->pools[(i + pool_offset)%NUM_POOLS];
+		pool = &pools[(i + pool_offset)%NUM_POOLS];
 		page_nr = (1 << pool->order);
 		/* OK to use static buffer since global mutex is held. */
 		nr_free_pool = roundup(nr_free, page_nr) >> pool->order;
@@ -419,7 +470,7 @@ ttm_pool_shrink_count(struct shrinker *shrink, struct shrink_control *sc)
 	struct ttm_page_pool *pool;
 
 	for (i = 0; i < NUM_POOLS; ++i) {
-		pool = &_manager->pools[i];
+		pool = &_manager->nodes[sc->nid].pools[i];
 		count += (pool->npages << pool->order);
 	}
 
@@ -431,6 +482,7 @@ static int ttm_pool_mm_shrink_init(struct ttm_pool_manager *manager)
 	manager->mm_shrink.count_objects = ttm_pool_shrink_count;
 	manager->mm_shrink.scan_objects = ttm_pool_shrink_scan;
 	manager->mm_shrink.seeks = 1;
+	manager->mm_shrink.flags = SHRINKER_NUMA_AWARE;
 	return register_shrinker(&manager->mm_shrink);
 }
 
@@ -442,6 +494,7 @@ static void ttm_pool_mm_shrink_fini(struct ttm_pool_manager *manager)
 static int ttm_set_pages_caching(struct page **pages,
 		enum ttm_caching_state cstate, unsigned cpages)
 {
+	ktime_t start = ktime_get();
 	int r = 0;
 	/* Set page caching */
 	switch (cstate) {
@@ -456,8 +509,9 @@ static int ttm_set_pages_caching(struct page **pages,
 			pr_err("Failed to set %d pages to wc!\n", cpages);
 		break;
 	default:
-		break;
+		return 0;
 	}
+	ttm_account_caching(cpages, start);
 	return r;
 }
 
@@ -483,21 +537,24 @@ static void ttm_handle_caching_state_failure(struct list_head *pages,
  *
  * This function is reentrant if caller updates count depending on number of
  * pages returned in pages array.
+ *
+ * Changing the caching attribute flushes the TLBs and caches of all CPUs, so
+ * the caching of up to NUM_PAGES_TO_CACHE pages is changed at once.
  */
 static int ttm_alloc_new_pages(struct list_head *pages, gfp_t gfp_flags,
 			       int ttm_flags, enum ttm_caching_state cstate,
-			       unsigned count, unsigned order)
+			       unsigned count, unsigned order, int nid)
 {
 	struct page **caching_array;
 	struct page *p;
 	int r = 0;
 	unsigned i, j, cpages;
 	unsigned npages = 1 << order;
-	unsigned max_cpages = min(count << order, (unsigned)NUM_PAGES_TO_ALLOC);
+	unsigned max_cpages = min(count << order, (unsigned)NUM_PAGES_TO_CACHE);
 
 	/* allocate array for page caching change */
-	caching_array = kmalloc_array(max_cpages, sizeof(struct page *),
-				      GFP_KERNEL);
+	caching_array = kvmalloc_array(max_cpages, sizeof(struct page *),
+				       GFP_KERNEL);
 
 	if (!caching_array) {
 		pr_debug("Unable to allocate table for new pages\n");
@@ -505,7 +562,7 @@ static int ttm_alloc_new_pages(struct list_head *pages, gfp_t gfp_flags,
 	}
 
 	for (i = 0, cpages = 0; i < count; ++i) {
-		p = alloc_pages(gfp_flags, order);
+		p = alloc_pages_node(nid, gfp_flags, order);
 
 		if (!p) {
 			pr_debug("Unable to get page %u\n", i);
@@ -559,7 +616,7 @@ static int ttm_alloc_new_pages(struct list_head *pages, gfp_t gfp_flags,
 					caching_array, cpages);
 	}
 out:
-	kfree(caching_array);
+	kvfree(caching_array);
 
 	return r;
 }
@@ -600,7 +657,7 @@ static void ttm_page_pool_fill_locked(struct ttm_page_pool *pool, int ttm_flags,
 
 		INIT_LIST_HEAD(&new_pages);
 		r = ttm_alloc_new_pages(&new_pages, pool->gfp_flags, ttm_flags,
-					cstate, alloc_size, 0);
+					cstate, alloc_size, 0, pool->nid);
 		spin_lock_irqsave(&pool->lock, *irq_flags);
 
 		if (!r) {
@@ -645,8 +702,10 @@ static int ttm_page_pool_get_pages(struct ttm_page_pool *pool,
 	if (count >= pool->npages) {
 		/* take all pages from the pool */
 		list_splice_init(&pool->list, pages);
+		pool->nhits += pool->npages;
 		count -= pool->npages;
 		pool->npages = 0;
+		pool->nmisses += count;
 		goto out;
 	}
 	/* find the last pages to include for requested number of pages. Split
@@ -667,6 +726,7 @@ static int ttm_page_pool_get_pages(struct ttm_page_pool *pool,
 	/* Cut 'count' number of pages from the pool */
 	list_cut_position(pages, &pool->list, p);
 	pool->npages -= count;
+	pool->nhits += count;
 	count = 0;
 out:
 	spin_unlock_irqrestore(&pool->lock, irq_flags);
@@ -698,62 +758,23 @@ static int ttm_page_pool_get_pages(struct ttm_page_pool *pool,
 		 * multiple requests in parallel.
 		 **/
 		r = ttm_alloc_new_pages(pages, gfp_flags, ttm_flags, cstate,
-					count, order);
+					count, order, pool->nid);
 	}
 
 	return r;
 }
 
-/* Put all pages in pages list to correct pool to wait for reuse */
-static void ttm_put_pages(struct page **pages, unsigned npages, int flags,
-			  enum ttm_caching_state cstate)
+/* Put pages that are all on node nid to the pools of that node */
+static void ttm_put_pages_node(struct page **pages, unsigned npages, int nid,
+			       int flags, enum ttm_caching_state cstate)
 {
-	struct ttm_page_pool *pool = ttm_get_pool(flags, false, cstate);
+	struct ttm_page_pool *pool = ttm_get_pool(nid, flags, false, cstate);
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
-	struct ttm_page_pool *huge = ttm_get_pool(flags, true, cstate);
+	struct ttm_page_pool *huge = ttm_get_pool(nid, flags, true, cstate);
 #endif
 	unsigned long irq_flags;
 	unsigned i;
 
-	if (pool == NULL) {
-		/* No pool for this memory type so free the pages */
-		i = 0;
-		while (i < npages) {
-#ifdef CONFIG_TRANSPARENT_HUGEPAGE
-			struct page *p = pages[i];
-#endif
-			unsigned order = 0, j;
-
-			if (!pages[i]) {
-				++i;
-				continue;
-			}
-
-#ifdef CONFIG_TRANSPARENT_HUGEPAGE
-			if (!(flags & TTM_PAGE_FLAG_DMA32) &&
-			    (npages - i) >= HPAGE_PMD_NR) {
-				for (j = 1; j < HPAGE_PMD_NR; ++j)
-					if (++p != pages[i + j])
-					    break;
-
-				if (j == HPAGE_PMD_NR)
-					order = HPAGE_PMD_ORDER;
-			}
-#endif
-
-			if (page_count(pages[i]) != 1)
-				pr_err("Erroneous page count. Leaking pages.\n");
-			__free_pages(pages[i], order);
-
-			j = 1 << order;
-			while (j) {
-				pages[i++] = NULL;
-				--j;
-			}
-		}
-		return;
-	}
-
 	i = 0;
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	if (huge) {
@@ -782,7 +803,7 @@ static void ttm_put_pages(struct page **pages, unsigned npages, int flags,
 		}
 
 		/* Check that we don't go over the pool limit */
-		max_size = _manager->options.max_size;
+		max_size = ttm_pool_node_max_size();
 		max_size /= HPAGE_PMD_NR;
 		if (huge->npages > max_size)
 			n2free = huge->npages - max_size;
@@ -807,8 +828,8 @@ static void ttm_put_pages(struct page **pages, unsigned npages, int flags,
 	}
 	/* Check that we don't go over the pool limit */
 	npages = 0;
-	if (pool->npages > _manager->options.max_size) {
-		npages = pool->npages - _manager->options.max_size;
+	if (pool->npages > ttm_pool_node_max_size()) {
+		npages = pool->npages - ttm_pool_node_max_size();
 		/* free at least NUM_PAGES_TO_ALLOC number of pages
 		 * to reduce calls to set_memory_wb */
 		if (npages < NUM_PAGES_TO_ALLOC)
@@ -819,6 +840,69 @@ static void ttm_put_pages(struct page **pages, unsigned npages, int flags,
 		ttm_page_pool_free(pool, npages, false);
 }
 
+/* Put all pages in pages list to correct pool to wait for reuse */
+static void ttm_put_pages(struct page **pages, unsigned npages, int flags,
+			  enum ttm_caching_state cstate)
+{
+	unsigned i, j;
+
+	if (ttm_get_pool(0, flags, false, cstate) == NULL) {
+		/* No pool for this memory type so free the pages */
+		i = 0;
+		while (i < npages) {
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+			struct page *p = pages[i];
+#endif
+			unsigned order = 0;
+
+			if (!pages[i]) {
+				++i;
+				continue;
+			}
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+			if (!(flags & TTM_PAGE_FLAG_DMA32) &&
+			    (npages - i) >= HPAGE_PMD_NR) {
+				for (j = 1; j < HPAGE_PMD_NR; ++j)
+					if (++p != pages[i + j])
+					    break;
+
+				if (j == HPAGE_PMD_NR)
+					order = HPAGE_PMD_ORDER;
+			}
+#endif
+
+			if (page_count(pages[i]) != 1)
+				pr_err("Erroneous page count. Leaking pages.\n");
+			__free_pages(pages[i], order);
+
+			j = 1 << order;
+			while (j) {
+				pages[i++] = NULL;
+				--j;
+			}
+		}
+		return;
+	}
+
+	/* Return the pages to the pools of the node they are on */
+	for (i = 0; i < npages; i = j) {
+		int nid;
+
+		if (!pages[i]) {
+			j = i + 1;
+			continue;
+		}
+
+		nid = page_to_nid(pages[i]);
+		for (j = i + 1; j < npages; ++j)
+			if (pages[j] && page_to_nid(pages[j]) != nid)
+				break;
+
+		ttm_put_pages_node(pages + i, j - i, nid, flags, cstate);
+	}
+}
+
 /*
  * On success pages list will hold count number of correctly
  * cached pages.
@@ -826,9 +910,10 @@ static void ttm_put_pages(struct page **pages, unsigned npages, int flags,
 static int ttm_get_pages(struct page **pages, unsigned npages, int flags,
 			 enum ttm_caching_state cstate)
 {
-	struct ttm_page_pool *pool = ttm_get_pool(flags, false, cstate);
+	int nid = numa_mem_id();
+	struct ttm_page_pool *pool = ttm_get_pool(nid, flags, false, cstate);
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
-	struct ttm_page_pool *huge = ttm_get_pool(flags, true, cstate);
+	struct ttm_page_pool *huge = ttm_get_pool(nid, flags, true, cstate);
 #endif
 	struct list_head plist;
 	struct page *p = NULL;
@@ -940,7 +1025,7 @@ static int ttm_get_pages(struct page **pages, unsigned npages, int flags,
 }
 
 static void ttm_page_pool_init_locked(struct ttm_page_pool *pool, gfp_t flags,
-		char *name, unsigned int order)
+		char *name, unsigned int order, int nid)
 {
 	spin_lock_init(&pool->lock);
 	pool->fill_lock = false;
@@ -949,46 +1034,55 @@ static void ttm_page_pool_init_locked(struct ttm_page_pool *pool, gfp_t flags,
 	pool->gfp_flags = flags;
 	pool->name = name;
 	pool->order = order;
+	pool->nid = nid;
 }
 
-int ttm_page_alloc_init(struct ttm_mem_global *glob, unsigned max_pages)
+static void ttm_node_pools_init(struct ttm_node_pools *node, int nid)
 {
-	int ret;
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	unsigned order = HPAGE_PMD_ORDER;
 #else
 	unsigned order = 0;
 #endif
 
-	WARN_ON(_manager);
+	ttm_page_pool_init_locked(&node->wc_pool, GFP_HIGHUSER, "wc", 0, nid);
 
-	pr_info("Initializing pool allocator\n");
+	ttm_page_pool_init_locked(&node->uc_pool, GFP_HIGHUSER, "uc", 0, nid);
 
-	_manager = kzalloc(sizeof(*_manager), GFP_KERNEL);
-	if (!_manager)
-		return -ENOMEM;
+	ttm_page_pool_init_locked(&node->wc_pool_dma32,
+				  GFP_USER | GFP_DMA32, "wc dma", 0, nid);
 
-	ttm_page_pool_init_locked(&_manager->wc_pool, GFP_HIGHUSER, "wc", 0);
+	ttm_page_pool_init_locked(&node->uc_pool_dma32,
+				  GFP_USER | GFP_DMA32, "uc dma", 0, nid);
 
-	ttm_page_pool_init_locked(&_manager->uc_pool, GFP_HIGHUSER, "uc", 0);
-
-	ttm_page_pool_init_locked(&_manager->wc_pool_dma32,
-				  GFP_USER | GFP_DMA32, "wc dma", 0);
-
-	ttm_page_pool_init_locked(&_manager->uc_pool_dma32,
-				  GFP_USER | GFP_DMA32, "uc dma", 0);
-
-	ttm_page_pool_init_locked(&_manager->wc_pool_huge,
+	ttm_page_pool_init_locked(&node->wc_pool_huge,
 				  (GFP_TRANSHUGE_LIGHT | __GFP_NORETRY |
 				   __GFP_KSWAPD_RECLAIM) &
 				  ~(__GFP_MOVABLE | __GFP_COMP),
-				  "wc huge", order);
+				  "wc huge", order, nid);
 
-	ttm_page_pool_init_locked(&_manager->uc_pool_huge,
+	ttm_page_pool_init_locked(&node->uc_pool_huge,
 				  (GFP_TRANSHUGE_LIGHT | __GFP_NORETRY |
 				   __GFP_KSWAPD_RECLAIM) &
 				  ~(__GFP_MOVABLE | __GFP_COMP)
-				  , "uc huge", order);
+				  , "uc huge", order, nid);
+}
+
+int ttm_page_alloc_init(struct ttm_mem_global *glob, unsigned max_pages)
+{
+	int ret, nid;
+
+	WARN_ON(_manager);
+
+	pr_info("Initializing pool allocator\n");
+
+	_manager = kvzalloc(struct_size(_manager, nodes, nr_node_ids),
+			    GFP_KERNEL);
+	if (!_manager)
+		return -ENOMEM;
+
+	for (nid = 0; nid < nr_node_ids; ++nid)
+		ttm_node_pools_init(&_manager->nodes[nid], nid);
 
 	_manager->options.max_size = max_pages;
 	_manager->options.small = SMALL_ALLOCATION;
@@ -1012,14 +1106,16 @@ int ttm_page_alloc_init(struct ttm_mem_global *glob, unsigned max_pages)
 
 void ttm_page_alloc_fini(void)
 {
-	int i;
+	int i, nid;
 
 	pr_info("Finalizing pool allocator\n");
 	ttm_pool_mm_shrink_fini(_manager);
 
 	/* OK to use static buffer since global mutex is no longer used. */
-	for (i = 0; i < NUM_POOLS; ++i)
-		ttm_page_pool_free(&_manager->pools[i], FREE_ALL_PAGES, true);
+	for (nid = 0; nid < nr_node_ids; ++nid)
+		for (i = 0; i < NUM_POOLS; ++i)
+			ttm_page_pool_free(&_manager->nodes[nid].pools[i],
+					   FREE_ALL_PAGES, true);
 
 	kobject_put(&_manager->kobj);
 	_manager = NULL;
@@ -1170,20 +1266,36 @@ int ttm_page_alloc_debugfs(struct seq_file *m, void *data)
 {
 	struct ttm_page_pool *p;
 	unsigned i;
-	char *h[] = {"pool", "refills", "pages freed", "size"};
+	int nid;
+	u64 calls, ns;
+	char *h[] = {"pool", "node", "refills", "pages freed", "size",
+		     "hits", "misses"};
 	if (!_manager) {
 		seq_printf(m, "No pool allocator running.\n");
 		return 0;
 	}
-	seq_printf(m, "%7s %12s %13s %8s\n",
-			h[0], h[1], h[2], h[3]);
-	for (i = 0; i < NUM_POOLS; ++i) {
-		p = &_manager->pools[i];
+	seq_printf(m, "%7s %4s %12s %13s %8s %12s %12s\n",
+			h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
+	for (nid = 0; nid < nr_node_ids; ++nid) {
+		for (i = 0; i < NUM_POOLS; ++i) {
+			p = &_manager->nodes[nid].pools[i];
+
+			/* Skip the pools of nodes that were never used */
+			if (nid && !p->nhits && !p->nmisses && !p->npages)
+				continue;
 
-		seq_printf(m, "%7s %12ld %13ld %8d\n",
-				p->name, p->nrefills,
-				p->nfrees, p->npages);
+			seq_printf(m, "%7s %4d %12ld %13ld %8d %12ld %12ld\n",
+					p->name, nid, p->nrefills,
+					p->nfrees, p->npages,
+					p->nhits, p->nmisses);
+		}
 	}
+
+	calls = atomic64_read(&_manager->caching_calls);
+	ns = atomic64_read(&_manager->caching_ns);
+	seq_printf(m, "caching changes: %llu calls, %llu pages, %llu ns (%llu ns per call)\n",
+		   calls, (u64)atomic64_read(&_manager->caching_pages), ns,
+		   calls ? div64_u64(ns, calls) : 0);
 	return 0;
 }
 EXPORT_SYMBOL(ttm_page_alloc_debugfs);
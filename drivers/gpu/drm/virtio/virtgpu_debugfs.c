@@ -47,6 +47,7 @@ static int virtio_gpu_features(struct seq_file *m, void *data)
 
 	virtio_add_bool(m, "virgl", vgdev->has_virgl_3d);
 	virtio_add_bool(m, "edid", vgdev->has_edid);
+	virtio_add_bool(m, "blob resources", vgdev->has_resource_blob);
 	virtio_add_int(m, "cap sets", vgdev->num_capsets);
 	virtio_add_int(m, "scanouts", vgdev->num_scanouts);
 	return 0;
@@ -64,9 +65,37 @@ virtio_gpu_debugfs_irq_info(struct seq_file *m, void *data)
 	return 0;
 }
 
+static void virtio_gpu_debugfs_queue(struct seq_file *m, const char *name,
+				     struct virtio_gpu_queue *q)
+{
+	u64 cmds, notifies, fences, coalesced;
+
+	spin_lock(&q->qlock);
+	cmds = q->num_cmds;
+	notifies = q->num_notifies;
+	fences = q->num_fences;
+	coalesced = q->num_coalesced_fences;
+	spin_unlock(&q->qlock);
+
+	seq_printf(m, "%s: commands %llu notifies %llu fences %llu coalesced %llu\n",
+		   name, cmds, notifies, fences, coalesced);
+}
+
+static int
+virtio_gpu_debugfs_queues(struct seq_file *m, void *data)
+{
+	struct drm_info_node *node = (struct drm_info_node *) m->private;
+	struct virtio_gpu_device *vgdev = node->minor->dev->dev_private;
+
+	virtio_gpu_debugfs_queue(m, "control", &vgdev->ctrlq);
+	virtio_gpu_debugfs_queue(m, "cursor", &vgdev->cursorq);
+	return 0;
+}
+
 static struct drm_info_list virtio_gpu_debugfs_list[] = {
 	{ "virtio-gpu-features", virtio_gpu_features },
 	{ "virtio-gpu-irq-fence", virtio_gpu_debugfs_irq_info, 0, NULL },
+	{ "virtio-gpu-queues", virtio_gpu_debugfs_queues, 0, NULL },
 };
 
 #define VIRTIO_GPU_DEBUGFS_ENTRIES ARRAY_SIZE(virtio_gpu_debugfs_list)
@@ -201,6 +201,9 @@ static int virtio_gpu_getparam_ioctl(struct drm_device *dev, void *data,
 	case VIRTGPU_PARAM_CAPSET_QUERY_FIX:
 		value = 1;
 		break;
+	case VIRTGPU_PARAM_RESOURCE_BLOB:
+		value = vgdev->has_resource_blob == true ? 1 : 0;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -274,6 +277,110 @@ static int virtio_gpu_resource_create_ioctl(struct drm_device *dev, void *data,
 	return 0;
 }
 
+#define VIRTGPU_BLOB_FLAG_USE_MASK (VIRTGPU_BLOB_FLAG_USE_MAPPABLE | \
+				    VIRTGPU_BLOB_FLAG_USE_SHAREABLE | \
+				    VIRTGPU_BLOB_FLAG_USE_CROSS_DEVICE)
+
+static int verify_blob(struct virtio_gpu_device *vgdev,
+		       struct virtio_gpu_fpriv *vfpriv,
+		       struct virtio_gpu_object_params *params,
+		       struct drm_virtgpu_resource_create_blob *rc_blob)
+{
+	if (!vgdev->has_resource_blob)
+		return -EINVAL;
+
+	if ((rc_blob->blob_flags & ~VIRTGPU_BLOB_FLAG_USE_MASK) ||
+	    !rc_blob->blob_flags)
+		return -EINVAL;
+
+	if (rc_blob->pad)
+		return -EINVAL;
+
+	/* no cross device sharing without a way to name the resource */
+	if (rc_blob->blob_flags & VIRTGPU_BLOB_FLAG_USE_CROSS_DEVICE)
+		return -EINVAL;
+
+	switch (rc_blob->blob_mem) {
+	case VIRTGPU_BLOB_MEM_GUEST:
+		if (rc_blob->blob_id || rc_blob->cmd_size)
+			return -EINVAL;
+		break;
+	case VIRTGPU_BLOB_MEM_HOST3D_GUEST:
+		if (!vgdev->has_virgl_3d || !vfpriv)
+			return -EINVAL;
+		/* the optional command is a stream of dwords */
+		if (rc_blob->cmd_size % 4 != 0)
+			return -EINVAL;
+		params->ctx_id = vfpriv->ctx_id;
+		params->blob_id = rc_blob->blob_id;
+		break;
+	default:
+		/* host allocated memory can't be mapped by the guest yet */
+		return -EINVAL;
+	}
+
+	if (!rc_blob->size)
+		return -EINVAL;
+
+	params->blob = true;
+	params->size = rc_blob->size;
+	params->blob_mem = rc_blob->blob_mem;
+	params->blob_flags = rc_blob->blob_flags;
+	return 0;
+}
+
+static int virtio_gpu_resource_create_blob_ioctl(struct drm_device *dev,
+						 void *data,
+						 struct drm_file *file)
+{
+	struct virtio_gpu_device *vgdev = dev->dev_private;
+	struct virtio_gpu_fpriv *vfpriv = file->driver_priv;
+	struct drm_virtgpu_resource_create_blob *rc_blob = data;
+	struct virtio_gpu_object_params params = { 0 };
+	struct virtio_gpu_fence *fence;
+	struct virtio_gpu_object *bo;
+	struct drm_gem_object *obj;
+	uint32_t handle = 0;
+	int ret;
+
+	ret = verify_blob(vgdev, vfpriv, &params, rc_blob);
+	if (ret)
+		return ret;
+
+	if (rc_blob->cmd_size) {
+		void *buf;
+
+		/* freed when the ring has consumed it */
+		buf = vmemdup_user(u64_to_user_ptr(rc_blob->cmd),
+				   rc_blob->cmd_size);
+		if (IS_ERR(buf))
+			return PTR_ERR(buf);
+
+		virtio_gpu_cmd_submit(vgdev, buf, rc_blob->cmd_size,
+				      vfpriv->ctx_id, NULL, NULL);
+	}
+
+	fence = virtio_gpu_fence_alloc(vgdev);
+	if (!fence)
+		return -ENOMEM;
+	ret = virtio_gpu_object_create(vgdev, &params, &bo, fence);
+	dma_fence_put(&fence->f);
+	if (ret < 0)
+		return ret;
+	obj = &bo->base.base;
+
+	ret = drm_gem_handle_create(file, obj, &handle);
+	if (ret) {
+		drm_gem_object_release(obj);
+		return ret;
+	}
+	drm_gem_object_put_unlocked(obj);
+
+	rc_blob->res_handle = bo->hw_res_handle;
+	rc_blob->bo_handle = handle;
+	return 0;
+}
+
 static int virtio_gpu_resource_info_ioctl(struct drm_device *dev, void *data,
 					  struct drm_file *file_priv)
 {
@@ -511,4 +618,8 @@ struct drm_ioctl_desc virtio_gpu_ioctls[DRM_VIRTIO_NUM_IOCTLS] = {
 
 	DRM_IOCTL_DEF_DRV(VIRTGPU_GET_CAPS, virtio_gpu_get_caps_ioctl,
 			  DRM_RENDER_ALLOW),
+
+	DRM_IOCTL_DEF_DRV(VIRTGPU_RESOURCE_CREATE_BLOB,
+			  virtio_gpu_resource_create_blob_ioctl,
+			  DRM_RENDER_ALLOW),
 };
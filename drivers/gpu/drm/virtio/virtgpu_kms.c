@@ -41,9 +41,11 @@ static void virtio_gpu_config_changed_work_func(struct work_struct *work)
 	virtio_cread(vgdev->vdev, struct virtio_gpu_config,
 		     events_read, &events_read);
 	if (events_read & VIRTIO_GPU_EVENT_DISPLAY) {
+		virtio_gpu_batch_begin(vgdev);
 		if (vgdev->has_edid)
 			virtio_gpu_cmd_get_edids(vgdev);
 		virtio_gpu_cmd_get_display_info(vgdev);
+		virtio_gpu_batch_end(vgdev);
 		drm_helper_hpd_irq_event(vgdev->ddev);
 		events_clear |= VIRTIO_GPU_EVENT_DISPLAY;
 	}
@@ -73,9 +75,13 @@ static void virtio_gpu_context_destroy(struct virtio_gpu_device *vgdev,
 static void virtio_gpu_init_vq(struct virtio_gpu_queue *vgvq,
 			       void (*work_func)(struct work_struct *work))
 {
+	static struct lock_class_key batch_key;
+
 	spin_lock_init(&vgvq->qlock);
 	init_waitqueue_head(&vgvq->ack_queue);
 	INIT_WORK(&vgvq->dequeue_work, work_func);
+	INIT_LIST_HEAD(&vgvq->batch);
+	lockdep_init_map(&vgvq->batch_map, "virtio_gpu_batch", &batch_key, 0);
 }
 
 static void virtio_gpu_get_capsets(struct virtio_gpu_device *vgdev,
@@ -164,6 +170,10 @@ int virtio_gpu_init(struct drm_device *dev)
 		vgdev->has_edid = true;
 		DRM_INFO("EDID support available.\n");
 	}
+	if (virtio_has_feature(vgdev->vdev, VIRTIO_GPU_F_RESOURCE_BLOB)) {
+		vgdev->has_resource_blob = true;
+		DRM_INFO("resource blob support available.\n");
+	}
 
 	ret = virtio_find_vqs(vgdev->vdev, 2, vqs, callbacks, names, NULL);
 	if (ret) {
@@ -201,9 +211,12 @@ int virtio_gpu_init(struct drm_device *dev)
 
 	if (num_capsets)
 		virtio_gpu_get_capsets(vgdev, num_capsets);
+	virtio_gpu_batch_begin(vgdev);
 	if (vgdev->has_edid)
 		virtio_gpu_cmd_get_edids(vgdev);
 	virtio_gpu_cmd_get_display_info(vgdev);
+	virtio_gpu_batch_end(vgdev);
+	virtio_gpu_assert_not_batching(vgdev);
 	wait_event_timeout(vgdev->resp_wq, !vgdev->display_info_pending,
 			   5 * HZ);
 	return 0;
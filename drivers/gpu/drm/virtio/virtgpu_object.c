@@ -61,24 +61,47 @@ static void virtio_gpu_resource_id_put(struct virtio_gpu_device *vgdev, uint32_t
 	}
 }
 
+/*
+ * Release what is left of an object once the host no longer knows it:
+ * either it was never created there, or its UNREF has completed.
+ */
+void virtio_gpu_cleanup_object(struct virtio_gpu_object *bo)
+{
+	struct virtio_gpu_device *vgdev = bo->base.base.dev->dev_private;
+
+	if (bo->pages)
+		virtio_gpu_object_put_pages(vgdev, bo);
+	virtio_gpu_resource_id_put(vgdev, bo->hw_res_handle);
+
+	drm_gem_shmem_free_object(&bo->base.base);
+}
+
 static void virtio_gpu_free_object(struct drm_gem_object *obj)
 {
 	struct virtio_gpu_object *bo = gem_to_virtio_gpu_obj(obj);
 	struct virtio_gpu_device *vgdev = bo->base.base.dev->dev_private;
 
-	if (bo->pages)
+	/*
+	 * Blob backing can't be detached, the host keeps using the pages
+	 * until it has destroyed the resource.
+	 */
+	if (!bo->blob && bo->pages)
 		virtio_gpu_object_detach(vgdev, bo);
-	if (bo->created)
-		virtio_gpu_cmd_unref_resource(vgdev, bo->hw_res_handle);
-	virtio_gpu_resource_id_put(vgdev, bo->hw_res_handle);
 
-	drm_gem_shmem_free_object(obj);
+	if (bo->created) {
+		/* virtio_gpu_cmd_unref_cb() cleans up */
+		virtio_gpu_cmd_unref_resource(vgdev, bo);
+		return;
+	}
+
+	virtio_gpu_cleanup_object(bo);
 }
 
 static const struct drm_gem_object_funcs virtio_gpu_gem_funcs = {
 	.free = virtio_gpu_free_object,
 	.open = virtio_gpu_gem_object_open,
 	.close = virtio_gpu_gem_object_close,
+	.export = virtgpu_gem_prime_export,
 
 	.print_info = drm_gem_shmem_print_info,
 	.pin = drm_gem_shmem_pin,
@@ -109,7 +132,9 @@ int virtio_gpu_object_create(struct virtio_gpu_device *vgdev,
 {
 	struct virtio_gpu_object_array *objs = NULL;
 	struct drm_gem_shmem_object *shmem_obj;
+	struct virtio_gpu_mem_entry *ents = NULL;
 	struct virtio_gpu_object *bo;
+	unsigned int nents = 0;
 	int ret;
 
 	*bo_ptr = NULL;
@@ -126,11 +151,24 @@ int virtio_gpu_object_create(struct virtio_gpu_device *vgdev,
 
 	bo->dumb = params->dumb;
 
+	if (params->blob) {
+		bo->blob = true;
+		bo->blob_mem = params->blob_mem;
+		bo->blob_flags = params->blob_flags;
+	}
+
+	/* pin before a batch is opened, nothing may wait while it is */
+	if (!params->blob || bo->blob_mem != VIRTIO_GPU_BLOB_MEM_HOST3D) {
+		ret = virtio_gpu_object_get_ents(vgdev, bo, &ents, &nents);
+		if (ret)
+			goto err_put_id;
+	}
+
 	if (fence) {
 		ret = -ENOMEM;
 		objs = virtio_gpu_array_alloc(1);
 		if (!objs)
-			goto err_put_id;
+			goto err_free_ents;
 		virtio_gpu_array_add_obj(objs, &bo->base.base);
 
 		ret = virtio_gpu_array_lock_resv(objs);
@@ -138,6 +176,15 @@ int virtio_gpu_object_create(struct virtio_gpu_device *vgdev,
 			goto err_put_objs;
 	}
 
+	if (params->blob) {
+		/* ents are freed when the ring has consumed them */
+		virtio_gpu_cmd_resource_create_blob(vgdev, bo, params, ents,
+						    nents, objs, fence);
+		*bo_ptr = bo;
+		return 0;
+	}
+
+	virtio_gpu_batch_begin(vgdev);
 	if (params->virgl) {
 		virtio_gpu_cmd_resource_create_3d(vgdev, bo, params,
 						  objs, fence);
@@ -145,18 +192,19 @@ int virtio_gpu_object_create(struct virtio_gpu_device *vgdev,
 		virtio_gpu_cmd_create_resource(vgdev, bo, params,
 					       objs, fence);
 	}
-
-	ret = virtio_gpu_object_attach(vgdev, bo, NULL);
-	if (ret != 0) {
-		virtio_gpu_free_object(&shmem_obj->base);
-		return ret;
-	}
+	virtio_gpu_cmd_resource_attach_backing(vgdev, bo->hw_res_handle,
+					       ents, nents, NULL);
+	virtio_gpu_batch_end(vgdev);
 
 	*bo_ptr = bo;
 	return 0;
 
 err_put_objs:
 	virtio_gpu_array_put_free(objs);
+err_free_ents:
+	kfree(ents);
+	if (bo->pages)
+		virtio_gpu_object_put_pages(vgdev, bo);
 err_put_id:
 	virtio_gpu_resource_id_put(vgdev, bo->hw_res_handle);
 err_free_gem:
@@ -119,6 +119,7 @@ static void virtio_gpu_primary_plane_update(struct drm_plane *plane,
 	if (WARN_ON(!output))
 		return;
 
+	virtio_gpu_batch_begin(vgdev);
 	if (plane->state->fb && output->enabled) {
 		vgfb = to_virtio_gpu_framebuffer(plane->state->fb);
 		bo = gem_to_virtio_gpu_obj(vgfb->base.obj[0]);
@@ -128,7 +129,7 @@ static void virtio_gpu_primary_plane_update(struct drm_plane *plane,
 
 			objs = virtio_gpu_array_alloc(1);
 			if (!objs)
-				return;
+				goto out;
 			virtio_gpu_array_add_obj(objs, vgfb->base.obj[0]);
 			virtio_gpu_cmd_transfer_to_host_2d
 				(vgdev, 0,
@@ -160,6 +161,8 @@ static void virtio_gpu_primary_plane_update(struct drm_plane *plane,
 					      plane->state->src_y >> 16,
 					      plane->state->src_w >> 16,
 					      plane->state->src_h >> 16);
+out:
+	virtio_gpu_batch_end(vgdev);
 }
 
 static int virtio_gpu_cursor_prepare_fb(struct drm_plane *plane,
@@ -26,6 +26,18 @@
 
 #include "virtgpu_drv.h"
 
+struct dma_buf *virtgpu_gem_prime_export(struct drm_gem_object *obj,
+					 int flags)
+{
+	struct virtio_gpu_object *bo = gem_to_virtio_gpu_obj(obj);
+
+	/* the host only allows blobs created shareable to be shared */
+	if (bo->blob && !(bo->blob_flags & VIRTIO_GPU_BLOB_FLAG_USE_SHAREABLE))
+		return ERR_PTR(-EINVAL);
+
+	return drm_gem_prime_export(obj, flags);
+}
+
 /* Empty Implementations as there should not be any other driver for a virtual
  * device that might share buffers with virtgpu
  */
@@ -329,7 +329,13 @@ static bool virtio_gpu_queue_ctrl_buffer_locked(struct virtio_gpu_device *vgdev,
 retry:
 	ret = virtqueue_add_sgs(vq, sgs, outcnt, incnt, vbuf, GFP_ATOMIC);
 	if (ret == -ENOSPC) {
+		/* commands queued but not notified yet must not wait on us */
+		notify = virtqueue_kick_prepare(vq);
+		if (notify)
+			vgdev->ctrlq.num_notifies++;
 		spin_unlock(&vgdev->ctrlq.qlock);
+		if (notify)
+			virtqueue_notify(vq);
 		wait_event(vgdev->ctrlq.ack_queue, vq->num_free >= outcnt + incnt);
 		spin_lock(&vgdev->ctrlq.qlock);
 		goto retry;
@@ -337,11 +343,132 @@ static bool virtio_gpu_queue_ctrl_buffer_locked(struct virtio_gpu_device *vgdev,
 		trace_virtio_gpu_cmd_queue(vq,
 			(struct virtio_gpu_ctrl_hdr *)vbuf->buf);
 
+		vgdev->ctrlq.num_cmds++;
 		notify = virtqueue_kick_prepare(vq);
 	}
 	return notify;
 }
 
+/* Add a command held back by a batch to the virtqueue. */
+static bool virtio_gpu_queue_batched_locked(struct virtio_gpu_device *vgdev,
+					    struct virtio_gpu_vbuffer *vbuf)
+		__releases(&vgdev->ctrlq.qlock)
+		__acquires(&vgdev->ctrlq.qlock)
+{
+	struct scatterlist *vout = NULL, sg;
+	bool notify;
+
+	if (vbuf->data_sgt) {
+		vout = vbuf->data_sgt->sgl;
+	} else if (vbuf->data_size) {
+		sg_init_one(&sg, vbuf->data_buf, vbuf->data_size);
+		vout = &sg;
+	}
+
+	notify = virtio_gpu_queue_ctrl_buffer_locked(vgdev, vbuf, vout);
+
+	if (vbuf->data_sgt) {
+		sg_free_table(vbuf->data_sgt);
+		kfree(vbuf->data_sgt);
+		vbuf->data_sgt = NULL;
+	}
+	return notify;
+}
+
+/**
+ * virtio_gpu_batch_begin - hold back control commands
+ * @vgdev: the device
+ *
+ * Until the matching virtio_gpu_batch_end(), control commands are not
+ * added to the virtqueue, so that they can be submitted with a single
+ * notification of the host. Batches nest and hold back the commands of
+ * all callers, which keeps fence ids in submission order. Nothing may wait
+ * for the completion of a command while a batch is open, see
+ * virtio_gpu_assert_not_batching().
+ */
+void virtio_gpu_batch_begin(struct virtio_gpu_device *vgdev)
+{
+	lock_map_acquire_read(&vgdev->ctrlq.batch_map);
+
+	spin_lock(&vgdev->ctrlq.qlock);
+	vgdev->ctrlq.batching++;
+	spin_unlock(&vgdev->ctrlq.qlock);
+}
+
+/**
+ * virtio_gpu_batch_end - submit the held back control commands
+ * @vgdev: the device
+ *
+ * When the outermost batch ends, all held back commands are added to the
+ * virtqueue and the host is notified once. The host processes the control
+ * queue in order and reports the highest completed fence id, so only the
+ * last fenced command of the batch asks the host for a fence; the fences of
+ * the earlier commands signal with it.
+ */
+void virtio_gpu_batch_end(struct virtio_gpu_device *vgdev)
+{
+	struct virtio_gpu_queue *q = &vgdev->ctrlq;
+	struct virtio_gpu_ctrl_hdr *hdr, *fenced = NULL;
+	struct virtio_gpu_vbuffer *vbuf;
+	bool notify = false;
+
+	lock_map_release(&q->batch_map);
+
+	spin_lock(&q->qlock);
+	if (WARN_ON(!q->batching) || --q->batching) {
+		spin_unlock(&q->qlock);
+		return;
+	}
+
+	list_for_each_entry(vbuf, &q->batch, list) {
+		hdr = (struct virtio_gpu_ctrl_hdr *)vbuf->buf;
+		if (!(hdr->flags & cpu_to_le32(VIRTIO_GPU_FLAG_FENCE)))
+			continue;
+
+		if (fenced) {
+			fenced->flags &= ~cpu_to_le32(VIRTIO_GPU_FLAG_FENCE);
+			fenced->fence_id = 0;
+			q->num_coalesced_fences++;
+		}
+		fenced = hdr;
+	}
+
+	/*
+	 * Batch again while adding, so that commands queued while we wait
+	 * for space in the virtqueue are added after ours.
+	 */
+	q->batching++;
+	while (!list_empty(&q->batch)) {
+		vbuf = list_first_entry(&q->batch, struct virtio_gpu_vbuffer,
+					list);
+		list_del(&vbuf->list);
+		notify |= virtio_gpu_queue_batched_locked(vgdev, vbuf);
+	}
+	q->batching--;
+
+	if (notify)
+		q->num_notifies++;
+	spin_unlock(&q->qlock);
+
+	if (notify)
+		virtqueue_notify(q->vq);
+}
+
+/**
+ * virtio_gpu_assert_not_batching - check that the caller may wait for the host
+ * @vgdev: the device
+ *
+ * The commands of an open batch only reach the host when the batch ends, so
+ * a task that waits for the host from within its own batch waits forever.
+ */
+void virtio_gpu_assert_not_batching(struct virtio_gpu_device *vgdev)
+{
+	might_sleep();
+#ifdef CONFIG_LOCKDEP
+	WARN_ON_ONCE(lock_is_held(&vgdev->ctrlq.batch_map));
+#endif
+}
+
 static void virtio_gpu_queue_fenced_ctrl_buffer(struct virtio_gpu_device *vgdev,
 						struct virtio_gpu_vbuffer *vbuf,
 						struct virtio_gpu_ctrl_hdr *hdr,
@@ -378,7 +505,7 @@ static void virtio_gpu_queue_fenced_ctrl_buffer(struct virtio_gpu_device *vgdev,
 	 * to wait for free space, which can result in fence ids being
 	 * submitted out-of-order.
 	 */
-	if (vq->num_free < 2 + outcnt) {
+	if (!vgdev->ctrlq.batching && vq->num_free < 2 + outcnt) {
 		spin_unlock(&vgdev->ctrlq.qlock);
 		wait_event(vgdev->ctrlq.ack_queue, vq->num_free >= 3);
 		goto again;
@@ -386,12 +513,24 @@ static void virtio_gpu_queue_fenced_ctrl_buffer(struct virtio_gpu_device *vgdev,
 
 	if (hdr && fence) {
 		virtio_gpu_fence_emit(vgdev, hdr, fence);
+		vgdev->ctrlq.num_fences++;
 		if (vbuf->objs) {
 			virtio_gpu_array_add_fence(vbuf->objs, &fence->f);
 			virtio_gpu_array_unlock_resv(vbuf->objs);
 		}
 	}
+
+	if (vgdev->ctrlq.batching) {
+		/* added to the virtqueue by virtio_gpu_batch_end() */
+		vbuf->data_sgt = sgt;
+		list_add_tail(&vbuf->list, &vgdev->ctrlq.batch);
+		spin_unlock(&vgdev->ctrlq.qlock);
+		return;
+	}
+
 	notify = virtio_gpu_queue_ctrl_buffer_locked(vgdev, vbuf, vout);
+	if (notify)
+		vgdev->ctrlq.num_notifies++;
 	spin_unlock(&vgdev->ctrlq.qlock);
 	if (notify)
 		virtqueue_notify(vgdev->ctrlq.vq);
@@ -408,6 +547,22 @@ static void virtio_gpu_queue_ctrl_buffer(struct virtio_gpu_device *vgdev,
 	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, NULL, NULL);
 }
 
+/*
+ * The 3D commands come one per ioctl, but from the many threads and
+ * contexts of the guest at once. Queue them in a batch of their own, so
+ * that those racing each other are added to the virtqueue together, with a
+ * single notification of the host and a single host fence.
+ */
+static void virtio_gpu_queue_3d_ctrl_buffer(struct virtio_gpu_device *vgdev,
+					    struct virtio_gpu_vbuffer *vbuf,
+					    struct virtio_gpu_ctrl_hdr *hdr,
+					    struct virtio_gpu_fence *fence)
+{
+	virtio_gpu_batch_begin(vgdev);
+	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, hdr, fence);
+	virtio_gpu_batch_end(vgdev);
+}
+
 static void virtio_gpu_queue_cursor(struct virtio_gpu_device *vgdev,
 				    struct virtio_gpu_vbuffer *vbuf)
 {
@@ -436,7 +591,10 @@ static void virtio_gpu_queue_cursor(struct virtio_gpu_device *vgdev,
 		trace_virtio_gpu_cmd_queue(vq,
 			(struct virtio_gpu_ctrl_hdr *)vbuf->buf);
 
+		vgdev->cursorq.num_cmds++;
 		notify = virtqueue_kick_prepare(vq);
+		if (notify)
+			vgdev->cursorq.num_notifies++;
 	}
 
 	spin_unlock(&vgdev->cursorq.qlock);
@@ -473,19 +631,65 @@ void virtio_gpu_cmd_create_resource(struct virtio_gpu_device *vgdev,
 	bo->created = true;
 }
 
+/* create a blob resource, backed by ents unless it is host memory */
+void
+virtio_gpu_cmd_resource_create_blob(struct virtio_gpu_device *vgdev,
+				    struct virtio_gpu_object *bo,
+				    struct virtio_gpu_object_params *params,
+				    struct virtio_gpu_mem_entry *ents,
+				    uint32_t nents,
+				    struct virtio_gpu_object_array *objs,
+				    struct virtio_gpu_fence *fence)
+{
+	struct virtio_gpu_resource_create_blob *cmd_p;
+	struct virtio_gpu_vbuffer *vbuf;
+
+	cmd_p = virtio_gpu_alloc_cmd(vgdev, &vbuf, sizeof(*cmd_p));
+	memset(cmd_p, 0, sizeof(*cmd_p));
+	vbuf->objs = objs;
+
+	cmd_p->hdr.type = cpu_to_le32(VIRTIO_GPU_CMD_RESOURCE_CREATE_BLOB);
+	cmd_p->hdr.ctx_id = cpu_to_le32(params->ctx_id);
+	cmd_p->resource_id = cpu_to_le32(bo->hw_res_handle);
+	cmd_p->blob_mem = cpu_to_le32(params->blob_mem);
+	cmd_p->blob_flags = cpu_to_le32(params->blob_flags);
+	cmd_p->blob_id = cpu_to_le64(params->blob_id);
+	cmd_p->size = cpu_to_le64(params->size);
+	cmd_p->nr_entries = cpu_to_le32(nents);
+
+	vbuf->data_buf = ents;
+	vbuf->data_size = sizeof(*ents) * nents;
+
+	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
+	bo->created = true;
+}
+
+static void virtio_gpu_cmd_unref_cb(struct virtio_gpu_device *vgdev,
+				    struct virtio_gpu_vbuffer *vbuf)
+{
+	struct virtio_gpu_object *bo = vbuf->resp_cb_data;
+
+	/* the host has destroyed the resource and is done with its pages */
+	virtio_gpu_cleanup_object(bo);
+}
+
 void virtio_gpu_cmd_unref_resource(struct virtio_gpu_device *vgdev,
-				   uint32_t resource_id)
+				   struct virtio_gpu_object *bo)
 {
 	struct virtio_gpu_resource_unref *cmd_p;
 	struct virtio_gpu_vbuffer *vbuf;
 
-	cmd_p = virtio_gpu_alloc_cmd(vgdev, &vbuf, sizeof(*cmd_p));
+	cmd_p = virtio_gpu_alloc_cmd_resp(vgdev, virtio_gpu_cmd_unref_cb, &vbuf,
+					  sizeof(*cmd_p),
+					  sizeof(struct virtio_gpu_ctrl_hdr),
+					  NULL);
 	memset(cmd_p, 0, sizeof(*cmd_p));
 
 	cmd_p->hdr.type = cpu_to_le32(VIRTIO_GPU_CMD_RESOURCE_UNREF);
-	cmd_p->resource_id = cpu_to_le32(resource_id);
+	cmd_p->resource_id = cpu_to_le32(bo->hw_res_handle);
+	vbuf->resp_cb_data = bo;
 
-	virtio_gpu_queue_ctrl_buffer(vgdev, vbuf);
+	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, NULL);
 }
 
 static void virtio_gpu_cmd_resource_inval_backing(struct virtio_gpu_device *vgdev,
@@ -579,7 +783,7 @@ void virtio_gpu_cmd_transfer_to_host_2d(struct virtio_gpu_device *vgdev,
 	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
 }
 
-static void
+void
 virtio_gpu_cmd_resource_attach_backing(struct virtio_gpu_device *vgdev,
 				       uint32_t resource_id,
 				       struct virtio_gpu_mem_entry *ents,
@@ -991,7 +1195,7 @@ void virtio_gpu_cmd_transfer_to_host_3d(struct virtio_gpu_device *vgdev,
 	cmd_p->offset = cpu_to_le64(offset);
 	cmd_p->level = cpu_to_le32(level);
 
-	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
+	virtio_gpu_queue_3d_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
 }
 
 void virtio_gpu_cmd_transfer_from_host_3d(struct virtio_gpu_device *vgdev,
@@ -1017,7 +1221,7 @@ void virtio_gpu_cmd_transfer_from_host_3d(struct virtio_gpu_device *vgdev,
 	cmd_p->offset = cpu_to_le64(offset);
 	cmd_p->level = cpu_to_le32(level);
 
-	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
+	virtio_gpu_queue_3d_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
 }
 
 void virtio_gpu_cmd_submit(struct virtio_gpu_device *vgdev,
@@ -1040,20 +1244,20 @@ void virtio_gpu_cmd_submit(struct virtio_gpu_device *vgdev,
 	cmd_p->hdr.ctx_id = cpu_to_le32(ctx_id);
 	cmd_p->size = cpu_to_le32(data_size);
 
-	virtio_gpu_queue_fenced_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
+	virtio_gpu_queue_3d_ctrl_buffer(vgdev, vbuf, &cmd_p->hdr, fence);
 }
 
-int virtio_gpu_object_attach(struct virtio_gpu_device *vgdev,
-			     struct virtio_gpu_object *obj,
-			     struct virtio_gpu_fence *fence)
+/* Pin the pages of obj and describe them to the host. */
+int virtio_gpu_object_get_ents(struct virtio_gpu_device *vgdev,
+			       struct virtio_gpu_object *obj,
+			       struct virtio_gpu_mem_entry **ents_p,
+			       unsigned int *nents_p)
 {
 	bool use_dma_api = !virtio_has_iommu_quirk(vgdev->vdev);
 	struct virtio_gpu_mem_entry *ents;
 	struct scatterlist *sg;
 	int si, nents, ret;
 
-	if (WARN_ON_ONCE(!obj->created))
-		return -EINVAL;
 	if (WARN_ON_ONCE(obj->pages))
 		return -EINVAL;
 
@@ -1081,6 +1285,7 @@ int virtio_gpu_object_attach(struct virtio_gpu_device *vgdev,
 			     GFP_KERNEL);
 	if (!ents) {
 		DRM_ERROR("failed to allocate ent list\n");
+		virtio_gpu_object_put_pages(vgdev, obj);
 		return -ENOMEM;
 	}
 
@@ -1092,12 +1297,28 @@ int virtio_gpu_object_attach(struct virtio_gpu_device *vgdev,
 		ents[si].padding = 0;
 	}
 
-	virtio_gpu_cmd_resource_attach_backing(vgdev, obj->hw_res_handle,
-					       ents, nents,
-					       fence);
+	*ents_p = ents;
+	*nents_p = nents;
 	return 0;
 }
 
+/* Undo virtio_gpu_object_get_ents(), once the host no longer uses the pages. */
+void virtio_gpu_object_put_pages(struct virtio_gpu_device *vgdev,
+				 struct virtio_gpu_object *obj)
+{
+	if (obj->mapped) {
+		dma_unmap_sg(vgdev->vdev->dev.parent,
+			     obj->pages->sgl, obj->mapped,
+			     DMA_TO_DEVICE);
+		obj->mapped = 0;
+	}
+
+	sg_free_table(obj->pages);
+	obj->pages = NULL;
+
+	drm_gem_shmem_unpin(&obj->base.base);
+}
+
 void virtio_gpu_object_detach(struct virtio_gpu_device *vgdev,
 			      struct virtio_gpu_object *obj)
 {
@@ -1108,24 +1329,18 @@ void virtio_gpu_object_detach(struct virtio_gpu_device *vgdev,
 
 	if (use_dma_api && obj->mapped) {
 		struct virtio_gpu_fence *fence = virtio_gpu_fence_alloc(vgdev);
+
+		virtio_gpu_assert_not_batching(vgdev);
 		/* detach backing and wait for the host process it ... */
 		virtio_gpu_cmd_resource_inval_backing(vgdev, obj->hw_res_handle, fence);
 		dma_fence_wait(&fence->f, true);
 		dma_fence_put(&fence->f);
-
-		/* ... then tear down iommu mappings */
-		dma_unmap_sg(vgdev->vdev->dev.parent,
-			     obj->pages->sgl, obj->mapped,
-			     DMA_TO_DEVICE);
-		obj->mapped = 0;
 	} else {
 		virtio_gpu_cmd_resource_inval_backing(vgdev, obj->hw_res_handle, NULL);
 	}
 
-	sg_free_table(obj->pages);
-	obj->pages = NULL;
-
-	drm_gem_shmem_unpin(&obj->base.base);
+	/* ... then tear down iommu mappings */
+	virtio_gpu_object_put_pages(vgdev, obj);
 }
 
 void virtio_gpu_cursor_ping(struct virtio_gpu_device *vgdev,
@@ -9,6 +9,8 @@
 #include <linux/blkdev.h>
 #include <linux/blk-mq.h>
 #include <linux/blk-mq-pci.h>
+#include <linux/debugfs.h>
+#include <linux/dim.h>
 #include <linux/dmi.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
@@ -18,6 +20,7 @@
 #include <linux/mutex.h>
 #include <linux/once.h>
 #include <linux/pci.h>
+#include <linux/seq_file.h>
 #include <linux/suspend.h>
 #include <linux/t10-pi.h>
 #include <linux/types.h>
@@ -78,6 +81,35 @@ static unsigned int poll_queues;
 module_param(poll_queues, uint, 0644);
 MODULE_PARM_DESC(poll_queues, "Number of queues to use for polled IO.");
 
+static char *irq_dim;
+module_param(irq_dim, charp, 0444);
+MODULE_PARM_DESC(irq_dim,
+	"Adaptive interrupt coalescing algorithm for I/O queues, e.g. "
+	"\"latency\" or \"rdma\" (default: off)");
+
+static unsigned int irq_dim_lat_us = 200;
+module_param(irq_dim_lat_us, uint, 0444);
+MODULE_PARM_DESC(irq_dim_lat_us,
+	"p99 completion latency target in usec for irq_dim=latency");
+
+/*
+ * Interrupt coalescing profiles for adaptive moderation: aggregation time
+ * in 100us units and 0's based aggregation threshold, as programmed with
+ * Set Features (Interrupt Coalescing).  Profile 0 is coalescing off.
+ */
+static const struct {
+	u8 time;
+	u8 thr;
+} nvme_dim_profiles[] = {
+	{ 0, 0 },
+	{ 1, 3 },
+	{ 1, 7 },
+	{ 2, 15 },
+	{ 4, 31 },
+};
+
+static struct dentry *nvme_debugfs_root;
+
 struct nvme_dev;
 struct nvme_queue;
 
@@ -131,6 +163,12 @@ struct nvme_dev {
 	unsigned int nr_allocated_queues;
 	unsigned int nr_write_queues;
 	unsigned int nr_poll_queues;
+
+	/* adaptive interrupt coalescing */
+	struct work_struct dim_work;
+	atomic_t dim_inflight;
+	u8 dim_level;
+	struct dentry *debugfs_dir;
 };
 
 static int io_queue_depth_set(const char *val, const struct kernel_param *kp)
@@ -187,11 +225,14 @@ struct nvme_queue {
 #define NVMEQ_SQ_CMB		1
 #define NVMEQ_DELETE_ERROR	2
 #define NVMEQ_POLLED		3
+#define NVMEQ_DIM		4
 	u32 *dbbuf_sq_db;
 	u32 *dbbuf_cq_db;
 	u32 *dbbuf_sq_ei;
 	u32 *dbbuf_cq_ei;
 	struct completion delete_done;
+	struct dim dim;
+	bool dim_cd;	/* coalescing disabled for this vector */
 };
 
 /*
@@ -211,6 +252,7 @@ struct nvme_iod {
 	unsigned int dma_len;	/* length of single DMA segment mapping */
 	dma_addr_t meta_dma;
 	struct scatterlist *sg;
+	u64 dim_start_ns;	/* submission time, for adaptive coalescing */
 };
 
 static inline unsigned int nvme_dbbuf_size(struct nvme_dev *dev)
@@ -889,6 +931,7 @@ static blk_status_t nvme_queue_rq(struct blk_mq_hw_ctx *hctx,
 			goto out_unmap_data;
 	}
 
+	iod->dim_start_ns = nvmeq->dim.lat ? ktime_get_ns() : 0;
 	blk_mq_start_request(req);
 	nvme_submit_cmd(nvmeq, &cmnd, bd->last);
 	return BLK_STS_OK;
@@ -936,7 +979,7 @@ static inline struct blk_mq_tags *nvme_queue_tagset(struct nvme_queue *nvmeq)
 	return nvmeq->dev->tagset.tags[nvmeq->qid - 1];
 }
 
-static inline void nvme_handle_cqe(struct nvme_queue *nvmeq, u16 idx)
+static inline void nvme_handle_cqe(struct nvme_queue *nvmeq, u16 idx, u64 now)
 {
 	volatile struct nvme_completion *cqe = &nvmeq->cqes[idx];
 	struct request *req;
@@ -962,14 +1005,23 @@ static inline void nvme_handle_cqe(struct nvme_queue *nvmeq, u16 idx)
 	}
 
 	req = blk_mq_tag_to_rq(nvme_queue_tagset(nvmeq), cqe->command_id);
+	if (now) {
+		struct nvme_iod *iod = blk_mq_rq_to_pdu(req);
+
+		if (iod->dim_start_ns && now > iod->dim_start_ns)
+			dim_lat_record(&nvmeq->dim,
+				div_u64(now - iod->dim_start_ns, NSEC_PER_USEC));
+	}
 	trace_nvme_sq(req, cqe->sq_head, nvmeq->sq_tail);
 	nvme_end_request(req, cqe->status, cqe->result);
 }
 
 static void nvme_complete_cqes(struct nvme_queue *nvmeq, u16 start, u16 end)
 {
+	u64 now = nvmeq->dim.lat && start != end ? ktime_get_ns() : 0;
+
 	while (start != end) {
-		nvme_handle_cqe(nvmeq, start);
+		nvme_handle_cqe(nvmeq, start, now);
 		if (++start == nvmeq->q_depth)
 			start = 0;
 	}
@@ -1008,6 +1060,7 @@ static irqreturn_t nvme_irq(int irq, void *data)
 	struct nvme_queue *nvmeq = data;
 	irqreturn_t ret = IRQ_NONE;
 	u16 start, end;
+	int found;
 
 	/*
 	 * The rmb/wmb pair ensures we see all updates from a previous run of
@@ -1016,12 +1069,15 @@ static irqreturn_t nvme_irq(int irq, void *data)
 	rmb();
 	if (nvmeq->cq_head != nvmeq->last_cq_head)
 		ret = IRQ_HANDLED;
-	nvme_process_cq(nvmeq, &start, &end, -1);
+	found = nvme_process_cq(nvmeq, &start, &end, -1);
 	nvmeq->last_cq_head = nvmeq->cq_head;
 	wmb();
 
 	if (start != end) {
 		nvme_complete_cqes(nvmeq, start, end);
+		if (test_bit(NVMEQ_DIM, &nvmeq->flags))
+			dim_run_comps(&nvmeq->dim, found,
+				      ARRAY_SIZE(nvme_dim_profiles));
 		return IRQ_HANDLED;
 	}
 
@@ -1359,6 +1415,190 @@ static void nvme_free_queues(struct nvme_dev *dev, int lowest)
 	}
 }
 
+struct nvme_dim_cmd {
+	struct nvme_command cmd;
+	struct nvme_dev *dev;
+	struct nvme_queue *nvmeq;	/* NULL for the coalescing feature */
+	u8 level;
+	bool cd;
+};
+
+/*
+ * The new setting is only recorded once the controller has accepted it, so
+ * that a failed command is retried on the next DIM decision.
+ */
+static void nvme_dim_end_io(struct request *req, blk_status_t error)
+{
+	struct nvme_dim_cmd *c = req->end_io_data;
+	struct nvme_dev *dev = c->dev;
+	bool ok = !error && !nvme_req(req)->status &&
+		  dev->ctrl.state == NVME_CTRL_LIVE;
+
+	if (ok && c->nvmeq)
+		c->nvmeq->dim_cd = c->cd;
+	else if (ok)
+		dev->dim_level = c->level;
+
+	/* Pick up any decision made while the command was in flight */
+	if (atomic_dec_and_test(&dev->dim_inflight) && ok)
+		queue_work(nvme_wq, &dev->dim_work);
+
+	kfree(c);
+	blk_mq_free_request(req);
+}
+
+/*
+ * Coalescing changes are issued without waiting for them, so that
+ * cancelling the DIM works never has to wait on the admin queue.
+ */
+static void nvme_dim_set_feature(struct nvme_dev *dev, u32 fid, u32 dword11,
+				 struct nvme_queue *nvmeq, u8 level, bool cd)
+{
+	struct nvme_dim_cmd *c;
+	struct request *req;
+
+	c = kzalloc(sizeof(*c), GFP_KERNEL);
+	if (!c)
+		return;
+	c->cmd.features.opcode = nvme_admin_set_features;
+	c->cmd.features.fid = cpu_to_le32(fid);
+	c->cmd.features.dword11 = cpu_to_le32(dword11);
+	c->dev = dev;
+	c->nvmeq = nvmeq;
+	c->level = level;
+	c->cd = cd;
+
+	req = nvme_alloc_request(dev->ctrl.admin_q, &c->cmd, BLK_MQ_REQ_NOWAIT,
+				 NVME_QID_ANY);
+	if (IS_ERR(req)) {
+		kfree(c);
+		return;
+	}
+	req->timeout = ADMIN_TIMEOUT;
+	req->end_io_data = c;
+	atomic_inc(&dev->dim_inflight);
+	blk_execute_rq_nowait(req->q, NULL, req, false, nvme_dim_end_io);
+}
+
+/*
+ * Interrupt coalescing is a controller-wide setting, while each I/O queue
+ * runs its own DIM instance.  The controller gets the lowest non-zero
+ * profile any queue asked for, and queues that want no moderation at all
+ * opt out through the coalescing disable bit of their interrupt vector.
+ */
+static void nvme_dim_apply_work(struct work_struct *work)
+{
+	struct nvme_dev *dev = container_of(work, struct nvme_dev, dim_work);
+	u8 level = U8_MAX;
+	int i;
+
+	if (dev->ctrl.state != NVME_CTRL_LIVE || !dev->ctrl.admin_q)
+		return;
+
+	/*
+	 * Commands may complete out of order, so let the ones in flight
+	 * finish before deciding on the next; the last one requeues us.
+	 */
+	if (atomic_read(&dev->dim_inflight))
+		return;
+
+	for (i = 1; i < dev->ctrl.queue_count; i++) {
+		struct nvme_queue *nvmeq = &dev->queues[i];
+		u8 ix = READ_ONCE(nvmeq->dim.profile_ix);
+
+		if (test_bit(NVMEQ_DIM, &nvmeq->flags) && ix)
+			level = min(level, ix);
+	}
+	if (level == U8_MAX)
+		level = 0;
+
+	if (level != dev->dim_level)
+		nvme_dim_set_feature(dev, NVME_FEAT_IRQ_COALESCE,
+				     nvme_dim_profiles[level].time << 8 |
+				     nvme_dim_profiles[level].thr,
+				     NULL, level, false);
+
+	for (i = 1; i < dev->ctrl.queue_count; i++) {
+		struct nvme_queue *nvmeq = &dev->queues[i];
+		bool cd = !READ_ONCE(nvmeq->dim.profile_ix);
+
+		if (!test_bit(NVMEQ_DIM, &nvmeq->flags) || cd == nvmeq->dim_cd)
+			continue;
+		nvme_dim_set_feature(dev, NVME_FEAT_IRQ_CONFIG,
+				     (cd ? 1 << 16 : 0) | nvmeq->cq_vector,
+				     nvmeq, 0, cd);
+	}
+}
+
+static void nvme_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct nvme_queue *nvmeq = container_of(dim, struct nvme_queue, dim);
+
+	queue_work(nvme_wq, &nvmeq->dev->dim_work);
+	dim->state = DIM_START_MEASURE;
+}
+
+/*
+ * Only queues with an interrupt vector of their own are moderated; the
+ * per-vector coalescing disable would otherwise also hit the admin queue.
+ */
+static void nvme_dim_init_queue(struct nvme_queue *nvmeq)
+{
+	if (!irq_dim || !*irq_dim || !nvmeq->qid ||
+	    nvmeq->cq_vector != nvmeq->qid)
+		return;
+
+	memset(&nvmeq->dim, 0, sizeof(nvmeq->dim));
+	INIT_WORK(&nvmeq->dim.work, nvme_dim_work);
+	nvmeq->dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+	nvmeq->dim_cd = false;
+
+	if (dim_set_algo(&nvmeq->dim, irq_dim)) {
+		dev_warn_once(nvmeq->dev->ctrl.device,
+			      "unknown irq_dim algorithm \"%s\"\n", irq_dim);
+		return;
+	}
+	if (!strcmp(irq_dim, "latency") &&
+	    dim_lat_enable(&nvmeq->dim, irq_dim_lat_us, GFP_KERNEL)) {
+		dim_put_algo(&nvmeq->dim);
+		return;
+	}
+	set_bit(NVMEQ_DIM, &nvmeq->flags);
+}
+
+/* called once the queue's interrupt has been freed */
+static void nvme_dim_stop_queue(struct nvme_queue *nvmeq)
+{
+	if (!test_and_clear_bit(NVMEQ_DIM, &nvmeq->flags))
+		return;
+
+	cancel_work_sync(&nvmeq->dim.work);
+	dim_lat_disable(&nvmeq->dim);
+	dim_put_algo(&nvmeq->dim);
+}
+
+static int nvme_dim_stats_show(struct seq_file *m, void *unused)
+{
+	struct nvme_dev *dev = m->private;
+	u64 data[DIM_STATS_NUM];
+	int i, j;
+
+	seq_printf(m, "coalesce_profile: %u\n", dev->dim_level);
+	for (i = 1; i < dev->ctrl.queue_count; i++) {
+		struct nvme_queue *nvmeq = &dev->queues[i];
+
+		if (!test_bit(NVMEQ_DIM, &nvmeq->flags))
+			continue;
+		dim_get_stats(&nvmeq->dim, data);
+		for (j = 0; j < DIM_STATS_NUM; j++)
+			seq_printf(m, "q%d_%s: %llu\n", i,
+				   dim_stat_strings[j], data[j]);
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(nvme_dim_stats);
+
 /**
  * nvme_suspend_queue - put queue into suspended state
  * @nvmeq: queue to suspend
@@ -1376,6 +1616,7 @@ static int nvme_suspend_queue(struct nvme_queue *nvmeq)
 		blk_mq_quiesce_queue(nvmeq->dev->ctrl.admin_q);
 	if (!test_and_clear_bit(NVMEQ_POLLED, &nvmeq->flags))
 		pci_free_irq(to_pci_dev(nvmeq->dev->dev), nvmeq->cq_vector, nvmeq);
+	nvme_dim_stop_queue(nvmeq);
 	return 0;
 }
 
@@ -1561,9 +1802,12 @@ static int nvme_create_queue(struct nvme_queue *nvmeq, int qid, bool polled)
 	nvme_init_queue(nvmeq, qid);
 
 	if (!polled) {
+		nvme_dim_init_queue(nvmeq);
 		result = queue_request_irq(nvmeq);
-		if (result < 0)
+		if (result < 0) {
+			nvme_dim_stop_queue(nvmeq);
 			goto release_sq;
+		}
 	}
 
 	set_bit(NVMEQ_ENABLED, &nvmeq->flags);
@@ -2451,6 +2695,8 @@ static void nvme_dev_disable(struct nvme_dev *dev, bool shutdown)
 	}
 	nvme_suspend_io_queues(dev);
 	nvme_suspend_queue(&dev->queues[0]);
+	cancel_work_sync(&dev->dim_work);
+	dev->dim_level = 0;
 	nvme_pci_disable(dev);
 	nvme_reap_pending_cqes(dev);
 
@@ -2821,6 +3067,7 @@ static int nvme_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 
 	INIT_WORK(&dev->ctrl.reset_work, nvme_reset_work);
 	INIT_WORK(&dev->remove_work, nvme_remove_dead_ctrl_work);
+	INIT_WORK(&dev->dim_work, nvme_dim_apply_work);
 	mutex_init(&dev->shutdown_lock);
 
 	result = nvme_setup_prp_pools(dev);
@@ -2853,6 +3100,13 @@ static int nvme_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 
 	dev_info(dev->ctrl.device, "pci function %s\n", dev_name(&pdev->dev));
 
+	if (irq_dim && *irq_dim) {
+		dev->debugfs_dir = debugfs_create_dir(dev_name(dev->ctrl.device),
+						      nvme_debugfs_root);
+		debugfs_create_file("dim_stats", 0444, dev->debugfs_dir, dev,
+				    &nvme_dim_stats_fops);
+	}
+
 	nvme_reset_ctrl(&dev->ctrl);
 	nvme_get_ctrl(&dev->ctrl);
 	async_schedule(nvme_async_probe, dev);
@@ -2919,6 +3173,7 @@ static void nvme_remove(struct pci_dev *pdev)
 	}
 
 	flush_work(&dev->ctrl.reset_work);
+	debugfs_remove_recursive(dev->debugfs_dir);
 	nvme_stop_ctrl(&dev->ctrl);
 	nvme_remove_namespaces(&dev->ctrl);
 	nvme_dev_disable(dev, true);
@@ -3177,6 +3432,7 @@ static int __init nvme_init(void)
 	BUILD_BUG_ON(sizeof(struct nvme_create_sq) != 64);
 	BUILD_BUG_ON(sizeof(struct nvme_delete_queue) != 64);
 	BUILD_BUG_ON(IRQ_AFFINITY_MAX_SETS < 2);
+	nvme_debugfs_root = debugfs_create_dir("nvme", NULL);
 	return pci_register_driver(&nvme_driver);
 }
 
@@ -3184,6 +3440,7 @@ static void __exit nvme_exit(void)
 {
 	pci_unregister_driver(&nvme_driver);
 	flush_workqueue(nvme_wq);
+	debugfs_remove_recursive(nvme_debugfs_root);
 }
 
 MODULE_AUTHOR("Matthew Wilcox <willy@linux.intel.com>");
@@ -689,6 +689,47 @@ int acrn_ioreq_attach_client(int client_id, bool check_kthread_stop)
 }
 EXPORT_SYMBOL_GPL(acrn_ioreq_attach_client);
 
+int acrn_ioreq_wait_vcpu(int client_id, int vcpu, bool check_kthread_stop)
+{
+	struct ioreq_client *client;
+
+	if (client_id < 0 || client_id >= MAX_CLIENT) {
+		pr_err("vhm-ioreq: no client for id %d\n", client_id);
+		return -EFAULT;
+	}
+	if (vcpu < 0 || vcpu >= VHM_REQUEST_MAX)
+		return -EINVAL;
+	client = acrn_ioreq_get_client(client_id);
+	if (!client) {
+		pr_err("vhm-ioreq: no client for id %d\n", client_id);
+		return -EFAULT;
+	}
+	if (client->vhm_create_kthread) {
+		acrn_ioreq_put_client(client);
+		return -EINVAL;
+	}
+
+	clear_bit(IOREQ_CLIENT_EXIT, &client->flags);
+	might_sleep();
+
+	wait_event_freezable(client->wq,
+		((check_kthread_stop && kthread_should_stop()) ||
+		test_bit(vcpu, client->ioreqs_map) ||
+		is_destroying(client)));
+	if (check_kthread_stop && kthread_should_stop())
+		set_bit(IOREQ_CLIENT_EXIT, &client->flags);
+
+	if (is_destroying(client)) {
+		set_bit(IOREQ_CLIENT_EXIT, &client->flags);
+		acrn_ioreq_put_client(client);
+		return 1;
+	}
+
+	acrn_ioreq_put_client(client);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(acrn_ioreq_wait_vcpu);
+
 void acrn_ioreq_intercept_bdf(int client_id, int bus, int dev, int func)
 {
 	struct ioreq_client *client;
@@ -8,16 +8,35 @@
 #include "fsverity_private.h"
 
 #include <crypto/hash.h>
+#include <crypto/hash_batch.h>
 #include <linux/mount.h>
 #include <linux/pagemap.h>
 #include <linux/sched/signal.h>
 #include <linux/uaccess.h>
 
+/* Hash the pages queued on @batch, then drop the references to them */
+static int flush_hash_batch(struct inode *inode,
+			    struct crypto_hash_batch *batch,
+			    struct page **batch_pages)
+{
+	unsigned int nr = crypto_hash_batch_count(batch);
+	int err;
+
+	err = crypto_hash_batch_flush(batch);
+	if (err)
+		fsverity_err(inode, "Error %d computing page hashes", err);
+	while (nr)
+		put_page(batch_pages[--nr]);
+	return err;
+}
+
 static int build_merkle_tree_level(struct inode *inode, unsigned int level,
 				   u64 num_blocks_to_hash,
 				   const struct merkle_tree_params *params,
 				   u8 *pending_hashes,
-				   struct ahash_request *req)
+				   struct ahash_request *req,
+				   struct crypto_hash_batch *batch,
+				   struct page **batch_pages)
 {
 	const struct fsverity_operations *vops = inode->i_sb->s_vop;
 	unsigned int pending_size = 0;
@@ -38,6 +57,7 @@ static int build_merkle_tree_level(struct inode *inode, unsigned int level,
 
 	for (i = 0; i < num_blocks_to_hash; i++) {
 		struct page *src_page;
+		bool last_in_block;
 
 		if ((pgoff_t)i % 10000 == 0 || i + 1 == num_blocks_to_hash)
 			pr_debug("Hashing block %llu of %llu for level %u\n",
@@ -51,7 +71,7 @@ static int build_merkle_tree_level(struct inode *inode, unsigned int level,
 				fsverity_err(inode,
 					     "Error %d reading data page %llu",
 					     err, i);
-				return err;
+				goto out_put;
 			}
 		} else {
 			/* Non-leaf: hashing hash block from level below */
@@ -62,22 +82,38 @@ static int build_merkle_tree_level(struct inode *inode, unsigned int level,
 				fsverity_err(inode,
 					     "Error %d reading Merkle tree page %llu",
 					     err, params->level_start[level - 1] + i);
-				return err;
+				goto out_put;
 			}
 		}
 
-		err = fsverity_hash_page(params, inode, req, src_page,
-					 &pending_hashes[pending_size]);
-		put_page(src_page);
-		if (err)
-			return err;
+		if (batch) {
+			/* The hash lands in its slot when the batch is flushed */
+			batch_pages[crypto_hash_batch_count(batch)] = src_page;
+			crypto_hash_batch_add_page(batch, src_page, 0, PAGE_SIZE,
+						   &pending_hashes[pending_size]);
+		} else {
+			err = fsverity_hash_page(params, inode, req, src_page,
+						 &pending_hashes[pending_size]);
+			put_page(src_page);
+			if (err)
+				return err;
+		}
 		pending_size += params->digest_size;
 
+		last_in_block =
+			pending_size + params->digest_size > params->block_size ||
+			i + 1 == num_blocks_to_hash;
+
+		if (batch && (last_in_block || crypto_hash_batch_full(batch))) {
+			err = flush_hash_batch(inode, batch, batch_pages);
+			if (err)
+				return err;
+		}
+
 		if (level == params->num_levels) /* Root hash? */
 			return 0;
 
-		if (pending_size + params->digest_size > params->block_size ||
-		    i + 1 == num_blocks_to_hash) {
+		if (last_in_block) {
 			/* Flush the pending hash block */
 			memset(&pending_hashes[pending_size], 0,
 			       params->block_size - pending_size);
@@ -95,11 +131,23 @@ static int build_merkle_tree_level(struct inode *inode, unsigned int level,
 			pending_size = 0;
 		}
 
-		if (fatal_signal_pending(current))
-			return -EINTR;
+		if (fatal_signal_pending(current)) {
+			err = -EINTR;
+			goto out_put;
+		}
 		cond_resched();
 	}
 	return 0;
+
+out_put:
+	if (batch) {
+		unsigned int nr = crypto_hash_batch_count(batch);
+
+		while (nr)
+			put_page(batch_pages[--nr]);
+		crypto_hash_batch_reset(batch);
+	}
+	return err;
 }
 
 /*
@@ -116,6 +164,8 @@ static int build_merkle_tree(struct inode *inode,
 {
 	u8 *pending_hashes;
 	struct ahash_request *req;
+	struct crypto_hash_batch *batch;
+	struct page *batch_pages[FS_VERITY_HASH_BATCH];
 	u64 blocks;
 	unsigned int level;
 	int err = -ENOMEM;
@@ -126,11 +176,15 @@ static int build_merkle_tree(struct inode *inode,
 		return 0;
 	}
 
+	batch = NULL;
 	pending_hashes = kmalloc(params->block_size, GFP_KERNEL);
 	req = ahash_request_alloc(params->hash_alg->tfm, GFP_KERNEL);
 	if (!pending_hashes || !req)
 		goto out;
 
+	/* Without a batch, pages are hashed one at a time */
+	batch = fsverity_alloc_hash_batch(params, GFP_KERNEL);
+
 	/*
 	 * Build each level of the Merkle tree, starting at the leaf level
 	 * (level 0) and ascending to the root node (level 'num_levels - 1').
@@ -140,7 +194,8 @@ static int build_merkle_tree(struct inode *inode,
 		 params->log_blocksize;
 	for (level = 0; level <= params->num_levels; level++) {
 		err = build_merkle_tree_level(inode, level, blocks, params,
-					      pending_hashes, req);
+					      pending_hashes, req, batch,
+					      batch_pages);
 		if (err)
 			goto out;
 		blocks = (blocks + params->hashes_per_block - 1) >>
@@ -149,6 +204,7 @@ static int build_merkle_tree(struct inode *inode,
 	memcpy(root_hash, pending_hashes, params->digest_size);
 	err = 0;
 out:
+	crypto_hash_batch_free(batch);
 	kfree(pending_hashes);
 	ahash_request_free(req);
 	return err;
@@ -18,6 +18,9 @@
 #include <linux/fsverity.h>
 
 struct ahash_request;
+struct crypto_hash_batch;
+struct crypto_hash_batch_stats;
+struct crypto_hash_batch_tfm;
 
 /*
  * Implementation limit: maximum depth of the Merkle tree.  For now 8 is plenty;
@@ -31,9 +34,18 @@ struct ahash_request;
  */
 #define FS_VERITY_MAX_DIGEST_SIZE	SHA512_DIGEST_SIZE
 
+/*
+ * Number of pages hashed together when building or verifying a Merkle tree.
+ * Enough to fill two passes of an 8-lane multi-buffer implementation, or to
+ * keep an offload engine busy.
+ */
+#define FS_VERITY_HASH_BATCH		16
+
 /* A hash algorithm supported by fs-verity */
 struct fsverity_hash_alg {
 	struct crypto_ahash *tfm; /* hash tfm, allocated on demand */
+	/* tfm for hashing many pages at once, or NULL if unavailable */
+	struct crypto_hash_batch_tfm *batch_tfm;
 	const char *name;	  /* crypto API name, e.g. sha256 */
 	unsigned int digest_size; /* digest size in bytes, e.g. 32 for SHA-256 */
 	unsigned int block_size;  /* block size in bytes, e.g. 64 for SHA-256 */
@@ -113,6 +125,7 @@ struct fsverity_signed_digest {
 /* hash_algs.c */
 
 extern struct fsverity_hash_alg fsverity_hash_algs[];
+extern struct crypto_hash_batch_stats fsverity_hash_stats;
 
 const struct fsverity_hash_alg *fsverity_get_hash_alg(const struct inode *inode,
 						      unsigned int num);
@@ -123,6 +136,8 @@ int fsverity_hash_page(const struct merkle_tree_params *params,
 		       struct ahash_request *req, struct page *page, u8 *out);
 int fsverity_hash_buffer(const struct fsverity_hash_alg *alg,
 			 const void *data, size_t size, u8 *out);
+struct crypto_hash_batch *
+fsverity_alloc_hash_batch(const struct merkle_tree_params *params, gfp_t gfp);
 void __init fsverity_check_hash_algs(void);
 
 /* init.c */
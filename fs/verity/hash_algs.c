@@ -8,8 +8,12 @@
 #include "fsverity_private.h"
 
 #include <crypto/hash.h>
+#include <crypto/hash_batch.h>
+#include <linux/ktime.h>
 #include <linux/scatterlist.h>
 
+DEFINE_CRYPTO_HASH_BATCH_STATS(fsverity_hash_stats, "fs-verity");
+
 /* The hash algorithms supported by fs-verity */
 struct fsverity_hash_alg fsverity_hash_algs[] = {
 	[FS_VERITY_HASH_ALG_SHA256] = {
@@ -41,6 +45,7 @@ const struct fsverity_hash_alg *fsverity_get_hash_alg(const struct inode *inode,
 {
 	struct fsverity_hash_alg *alg;
 	struct crypto_ahash *tfm;
+	struct crypto_hash_batch_tfm *batch_tfm;
 	int err;
 
 	if (num >= ARRAY_SIZE(fsverity_hash_algs) ||
@@ -50,8 +55,8 @@ const struct fsverity_hash_alg *fsverity_get_hash_alg(const struct inode *inode,
 	}
 	alg = &fsverity_hash_algs[num];
 
-	/* pairs with cmpxchg() below */
-	tfm = READ_ONCE(alg->tfm);
+	/* pairs with cmpxchg() below; also orders the ->batch_tfm load */
+	tfm = smp_load_acquire(&alg->tfm);
 	if (likely(tfm != NULL))
 		return alg;
 	/*
@@ -81,7 +86,23 @@ const struct fsverity_hash_alg *fsverity_get_hash_alg(const struct inode *inode,
 	pr_info("%s using implementation \"%s\"\n",
 		alg->name, crypto_ahash_driver_name(tfm));
 
-	/* pairs with READ_ONCE() above */
+	/*
+	 * Allocate the batch tfm by driver name so that it can import the
+	 * salted hash states exported from @tfm.  Not having one only costs
+	 * performance: pages are then hashed one at a time.
+	 */
+	batch_tfm = crypto_alloc_hash_batch_tfm(crypto_ahash_driver_name(tfm));
+	if (IS_ERR(batch_tfm)) {
+		batch_tfm = NULL;
+	} else {
+		pr_info("%s batching with \"%s\" (%s)\n", alg->name,
+			crypto_hash_batch_driver_name(batch_tfm),
+			crypto_hash_batch_impl_name(batch_tfm->impl));
+	}
+	if (cmpxchg(&alg->batch_tfm, NULL, batch_tfm) != NULL)
+		crypto_free_hash_batch_tfm(batch_tfm);
+
+	/* pairs with smp_load_acquire() above */
 	if (cmpxchg(&alg->tfm, NULL, tfm) != NULL)
 		crypto_free_ahash(tfm);
 
@@ -168,6 +189,13 @@ const u8 *fsverity_prepare_hash_state(const struct fsverity_hash_alg *alg,
 	goto out;
 }
 
+static enum crypto_hash_batch_impl fsverity_ahash_impl(struct crypto_ahash *tfm)
+{
+	if (crypto_ahash_tfm(tfm)->__crt_alg->cra_flags & CRYPTO_ALG_ASYNC)
+		return CRYPTO_HASH_BATCH_ASYNC;
+	return CRYPTO_HASH_BATCH_SYNC;
+}
+
 /**
  * fsverity_hash_page() - hash a single data or hash page
  * @params: the Merkle tree's parameters
@@ -187,11 +215,14 @@ int fsverity_hash_page(const struct merkle_tree_params *params,
 {
 	struct scatterlist sg;
 	DECLARE_CRYPTO_WAIT(wait);
+	u64 start;
 	int err;
 
 	if (WARN_ON(params->block_size != PAGE_SIZE))
 		return -EINVAL;
 
+	start = ktime_get_ns();
+
 	sg_init_table(&sg, 1);
 	sg_set_page(&sg, page, PAGE_SIZE, 0);
 	ahash_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP |
@@ -212,9 +243,44 @@ int fsverity_hash_page(const struct merkle_tree_params *params,
 	}
 
 	err = crypto_wait_req(err, &wait);
-	if (err)
+	if (err) {
 		fsverity_err(inode, "Error %d computing page hash", err);
-	return err;
+		return err;
+	}
+
+	crypto_hash_batch_account(&fsverity_hash_stats,
+				  fsverity_ahash_impl(params->hash_alg->tfm),
+				  1, PAGE_SIZE, ktime_get_ns() - start);
+	return 0;
+}
+
+/**
+ * fsverity_alloc_hash_batch() - allocate a batch for hashing many pages
+ * @params: the Merkle tree's parameters
+ * @gfp: allocation flags
+ *
+ * The batch starts each digest from the Merkle tree's salted hash state, if
+ * any, and accounts its hashing time to the fs-verity statistics.
+ *
+ * Return: the batch, or NULL if batching is unavailable, in which case pages
+ *	   must be hashed one at a time with fsverity_hash_page()
+ */
+struct crypto_hash_batch *
+fsverity_alloc_hash_batch(const struct merkle_tree_params *params, gfp_t gfp)
+{
+	struct crypto_hash_batch_tfm *tfm = params->hash_alg->batch_tfm;
+	struct crypto_hash_batch *batch;
+
+	if (!tfm)
+		return NULL;
+
+	batch = crypto_hash_batch_alloc(tfm, FS_VERITY_HASH_BATCH, gfp);
+	if (!batch)
+		return NULL;
+
+	crypto_hash_batch_set_hashstate(batch, params->hashstate);
+	crypto_hash_batch_set_stats(batch, &fsverity_hash_stats);
+	return batch;
 }
 
 /**
@@ -7,6 +7,7 @@
 
 #include "fsverity_private.h"
 
+#include <crypto/hash_batch.h>
 #include <linux/ratelimit.h>
 
 void fsverity_msg(const struct inode *inode, const char *level,
@@ -36,6 +37,7 @@ static int __init fsverity_init(void)
 	int err;
 
 	fsverity_check_hash_algs();
+	crypto_hash_batch_stats_register(&fsverity_hash_stats);
 
 	err = fsverity_init_info_cache();
 	if (err)
@@ -8,6 +8,7 @@
 #include "fsverity_private.h"
 
 #include <crypto/hash.h>
+#include <crypto/hash_batch.h>
 #include <linux/bio.h>
 #include <linux/ratelimit.h>
 
@@ -81,10 +82,14 @@ static inline int cmp_hashes(const struct fsverity_info *vi,
  * Note that multiple processes may race to verify a hash page and mark it
  * Checked, but it doesn't matter; the result will be the same either way.
  *
+ * @data_hash is the already computed hash of @data_page, or NULL to compute it
+ * here.
+ *
  * Return: true if the page is valid, else false.
  */
 static bool verify_page(struct inode *inode, const struct fsverity_info *vi,
-			struct ahash_request *req, struct page *data_page)
+			struct ahash_request *req, struct page *data_page,
+			const u8 *data_hash)
 {
 	const struct merkle_tree_params *params = &vi->tree_params;
 	const unsigned int hsize = params->digest_size;
@@ -165,10 +170,14 @@ static bool verify_page(struct inode *inode, const struct fsverity_info *vi,
 	}
 
 	/* Finally, verify the data page */
-	err = fsverity_hash_page(params, inode, req, data_page, real_hash);
-	if (err)
-		goto out;
-	err = cmp_hashes(vi, want_hash, real_hash, index, -1);
+	if (!data_hash) {
+		err = fsverity_hash_page(params, inode, req, data_page,
+					 real_hash);
+		if (err)
+			goto out;
+		data_hash = real_hash;
+	}
+	err = cmp_hashes(vi, want_hash, data_hash, index, -1);
 out:
 	for (; level > 0; level--)
 		put_page(hpages[level - 1]);
@@ -195,7 +204,7 @@ bool fsverity_verify_page(struct page *page)
 	if (unlikely(!req))
 		return false;
 
-	valid = verify_page(inode, vi, req, page);
+	valid = verify_page(inode, vi, req, page, NULL);
 
 	ahash_request_free(req);
 
@@ -204,6 +213,27 @@ bool fsverity_verify_page(struct page *page)
 EXPORT_SYMBOL_GPL(fsverity_verify_page);
 
 #ifdef CONFIG_BLOCK
+/* Verify @nr pages whose data hashes are queued on @batch */
+static void verify_pages_batched(struct inode *inode,
+				 const struct fsverity_info *vi,
+				 struct ahash_request *req,
+				 struct crypto_hash_batch *batch,
+				 struct page **pages, const u8 *hashes,
+				 unsigned int nr)
+{
+	const unsigned int hsize = vi->tree_params.digest_size;
+	unsigned int i;
+	int err;
+
+	/* On failure, let verify_page() hash and report each page itself */
+	err = crypto_hash_batch_flush(batch);
+
+	for (i = 0; i < nr; i++)
+		if (!verify_page(inode, vi, req, pages[i],
+				 err ? NULL : &hashes[i * hsize]))
+			SetPageError(pages[i]);
+}
+
 /**
  * fsverity_verify_bio() - verify a 'read' bio that has just completed
  *
@@ -222,9 +252,14 @@ void fsverity_verify_bio(struct bio *bio)
 {
 	struct inode *inode = bio_first_page_all(bio)->mapping->host;
 	const struct fsverity_info *vi = inode->i_verity_info;
+	const unsigned int hsize = vi->tree_params.digest_size;
+	struct page *pages[FS_VERITY_HASH_BATCH];
+	struct crypto_hash_batch *batch;
 	struct ahash_request *req;
 	struct bio_vec *bv;
 	struct bvec_iter_all iter_all;
+	unsigned int nr = 0;
+	u8 *hashes = NULL;
 
 	req = ahash_request_alloc(vi->tree_params.hash_alg->tfm, GFP_NOFS);
 	if (unlikely(!req)) {
@@ -233,13 +268,45 @@ void fsverity_verify_bio(struct bio *bio)
 		return;
 	}
 
+	/*
+	 * Hash the data pages in batches up front.  If that isn't possible,
+	 * verify_page() hashes each page itself.
+	 */
+	batch = fsverity_alloc_hash_batch(&vi->tree_params, GFP_NOFS);
+	if (batch) {
+		hashes = kmalloc_array(FS_VERITY_HASH_BATCH, hsize, GFP_NOFS);
+		if (!hashes) {
+			crypto_hash_batch_free(batch);
+			batch = NULL;
+		}
+	}
+
 	bio_for_each_segment_all(bv, bio, iter_all) {
 		struct page *page = bv->bv_page;
 
-		if (!PageError(page) && !verify_page(inode, vi, req, page))
-			SetPageError(page);
+		if (PageError(page))
+			continue;
+
+		if (!batch) {
+			if (!verify_page(inode, vi, req, page, NULL))
+				SetPageError(page);
+			continue;
+		}
+
+		crypto_hash_batch_add_page(batch, page, 0, PAGE_SIZE,
+					   &hashes[nr * hsize]);
+		pages[nr++] = page;
+		if (nr == FS_VERITY_HASH_BATCH) {
+			verify_pages_batched(inode, vi, req, batch, pages,
+					     hashes, nr);
+			nr = 0;
+		}
 	}
+	if (nr)
+		verify_pages_batched(inode, vi, req, batch, pages, hashes, nr);
 
+	kfree(hashes);
+	crypto_hash_batch_free(batch);
 	ahash_request_free(req);
 }
 EXPORT_SYMBOL_GPL(fsverity_verify_bio);
@@ -41,6 +41,8 @@ struct acomp_req {
  * @decompress:		Function performs a de-compress operation
  * @dst_free:		Frees destination buffer if allocated inside the
  *			algorithm
+ * @setlevel:		Selects the compression level, may be NULL
+ * @setdict:		Loads a compression dictionary, may be NULL
  * @reqsize:		Context size for (de)compression requests
  * @base:		Common crypto API algorithm data structure
  */
@@ -48,6 +50,9 @@ struct crypto_acomp {
 	int (*compress)(struct acomp_req *req);
 	int (*decompress)(struct acomp_req *req);
 	void (*dst_free)(struct scatterlist *dst);
+	int (*setlevel)(struct crypto_acomp *tfm, int level);
+	int (*setdict)(struct crypto_acomp *tfm, const u8 *dict,
+		       unsigned int len);
 	unsigned int reqsize;
 	struct crypto_tfm base;
 };
@@ -58,6 +63,8 @@ struct crypto_acomp {
  * @compress:	Function performs a compress operation
  * @decompress:	Function performs a de-compress operation
  * @dst_free:	Frees destination buffer if allocated inside the algorithm
+ * @setlevel:	Optional. Selects the compression level of the tfm
+ * @setdict:	Optional. Loads a dictionary used for both directions
  * @init:	Initialize the cryptographic transformation object.
  *		This function is used to initialize the cryptographic
  *		transformation object. This function is called only once at
@@ -77,6 +84,9 @@ struct acomp_alg {
 	int (*compress)(struct acomp_req *req);
 	int (*decompress)(struct acomp_req *req);
 	void (*dst_free)(struct scatterlist *dst);
+	int (*setlevel)(struct crypto_acomp *tfm, int level);
+	int (*setdict)(struct crypto_acomp *tfm, const u8 *dict,
+		       unsigned int len);
 	int (*init)(struct crypto_acomp *tfm);
 	void (*exit)(struct crypto_acomp *tfm);
 	unsigned int reqsize;
@@ -273,4 +283,48 @@ static inline int crypto_acomp_decompress(struct acomp_req *req)
 	return ret;
 }
 
+/**
+ * crypto_acomp_setlevel() -- Select the compression level
+ *
+ * Function selects the level used by all subsequent compress operations
+ * on the tfm. It must be called from process context, before any request
+ * is allocated on the tfm.
+ *
+ * @tfm:	ACOMPRESS tfm handle
+ * @level:	algorithm specific level, zero selects the default
+ *
+ * Return:	zero on success; -EOPNOTSUPP if the algorithm has no levels;
+ *		error code in case of error
+ */
+static inline int crypto_acomp_setlevel(struct crypto_acomp *tfm, int level)
+{
+	if (!tfm->setlevel)
+		return -EOPNOTSUPP;
+
+	return tfm->setlevel(tfm, level);
+}
+
+/**
+ * crypto_acomp_setdict() -- Load a compression dictionary
+ *
+ * Function loads a dictionary used by both compress and decompress
+ * operations on the tfm. The same context rules as for
+ * crypto_acomp_setlevel() apply.
+ *
+ * @tfm:	ACOMPRESS tfm handle
+ * @dict:	dictionary contents, copied by the algorithm
+ * @len:	length of @dict, zero removes the dictionary
+ *
+ * Return:	zero on success; -EOPNOTSUPP if the algorithm has no dictionary
+ *		support; error code in case of error
+ */
+static inline int crypto_acomp_setdict(struct crypto_acomp *tfm,
+				       const u8 *dict, unsigned int len)
+{
+	if (!tfm->setdict)
+		return -EOPNOTSUPP;
+
+	return tfm->setdict(tfm, dict, len);
+}
+
 #endif
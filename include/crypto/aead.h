@@ -110,6 +110,8 @@ struct aead_request {
  * @setkey: see struct skcipher_alg
  * @encrypt: see struct skcipher_alg
  * @decrypt: see struct skcipher_alg
+ * @encrypt_batch: see struct skcipher_alg
+ * @decrypt_batch: see struct skcipher_alg
  * @ivsize: see struct skcipher_alg
  * @chunksize: see struct skcipher_alg
  * @init: Initialize the cryptographic transformation object. This function
@@ -125,7 +127,8 @@ struct aead_request {
  *	  @init.
  * @base: Definition of a generic crypto cipher algorithm.
  *
- * All fields except @ivsize is mandatory and must be filled.
+ * All fields except @ivsize and the batch operations are mandatory and must
+ * be filled.
  */
 struct aead_alg {
 	int (*setkey)(struct crypto_aead *tfm, const u8 *key,
@@ -133,6 +136,10 @@ struct aead_alg {
 	int (*setauthsize)(struct crypto_aead *tfm, unsigned int authsize);
 	int (*encrypt)(struct aead_request *req);
 	int (*decrypt)(struct aead_request *req);
+	int (*encrypt_batch)(struct aead_request **reqs, int *errs,
+			     unsigned int nr);
+	int (*decrypt_batch)(struct aead_request **reqs, int *errs,
+			     unsigned int nr);
 	int (*init)(struct crypto_aead *tfm);
 	void (*exit)(struct crypto_aead *tfm);
 
@@ -343,6 +350,36 @@ int crypto_aead_encrypt(struct aead_request *req);
  */
 int crypto_aead_decrypt(struct aead_request *req);
 
+/**
+ * crypto_aead_encrypt_batch() - encrypt a list of requests
+ * @reqs: array of @nr aead_request handles, all allocated for the same
+ *	  AEAD handle
+ * @errs: array of @nr integers receiving the result of each request
+ * @nr: number of requests
+ *
+ * Submit several independent encryption requests in one call; see
+ * crypto_skcipher_encrypt_batch() for the semantics.
+ *
+ * Return: 0 if all requests were successful or the first error found in @errs
+ */
+int crypto_aead_encrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr);
+
+/**
+ * crypto_aead_decrypt_batch() - decrypt a list of requests
+ * @reqs: array of @nr aead_request handles, all allocated for the same
+ *	  AEAD handle
+ * @errs: array of @nr integers receiving the result of each request
+ * @nr: number of requests
+ *
+ * Decryption counterpart to crypto_aead_encrypt_batch(). An entry of @errs is
+ * -EBADMSG if the authentication of that request failed.
+ *
+ * Return: 0 if all requests were successful or the first error found in @errs
+ */
+int crypto_aead_decrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr);
+
 /**
  * DOC: Asynchronous AEAD Request Handle
  *
@@ -22,6 +22,12 @@
 #define MAX_CIPHER_BLOCKSIZE		16
 #define MAX_CIPHER_ALIGNMASK		15
 
+/*
+ * Maximum number of requests handed to an encrypt_batch/decrypt_batch
+ * operation at once.  Longer lists are split by the core.
+ */
+#define MAX_CRYPTO_BATCH		16
+
 struct crypto_aead;
 struct crypto_instance;
 struct module;
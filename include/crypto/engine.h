@@ -19,16 +19,18 @@
 #include <crypto/kpp.h>
 
 #define ENGINE_NAME_LEN	30
+#define CRYPTO_ENGINE_NR_FLOWS	8
+
 /*
  * struct crypto_engine - crypto hardware engine
  * @name: the engine name
  * @idling: the engine is entering idle state
  * @busy: request pump is busy
  * @running: the engine is on working
- * @cur_req_prepared: current request is prepared
  * @list: link with the global crypto engine list
  * @queue_lock: spinlock to syncronise access to request queue
- * @queue: the crypto queue of the engine
+ * @queue: queue limits; @queue.max_qlen bounds and @queue.qlen counts the
+ * requests queued on all flows together
  * @rt: whether this queue is set to run as a realtime task
  * @prepare_crypt_hardware: a request will soon arrive from the queue
  * so the subsystem requests the driver to prepare the hardware
@@ -36,17 +38,23 @@
  * @unprepare_crypt_hardware: there are currently no more requests on the
  * queue so the subsystem notifies the driver that it may relax the
  * hardware by issuing this call
+ * @do_batch_requests: called after the pump has handed one or more requests
+ * to do_one_request(), so the driver can start them all at once, e.g. with a
+ * single doorbell write
  * @kworker: kthread worker struct for request pump
  * @pump_requests: work struct for scheduling work to the request pump
  * @priv_data: the engine private data
- * @cur_req: the current request which is on processing
+ * @max_inflight: number of requests the driver accepts at the same time
+ * @inflight: number of requests handed to the driver and not yet finalized
+ * @flows: requests are spread over the flows by tfm and the flows are served
+ * round-robin, so one busy tfm cannot starve the others
+ * @cur_flow: the flow to serve next
  */
 struct crypto_engine {
 	char			name[ENGINE_NAME_LEN];
 	bool			idling;
 	bool			busy;
 	bool			running;
-	bool			cur_req_prepared;
 
 	struct list_head	list;
 	spinlock_t		queue_lock;
@@ -57,12 +65,17 @@ struct crypto_engine {
 
 	int (*prepare_crypt_hardware)(struct crypto_engine *engine);
 	int (*unprepare_crypt_hardware)(struct crypto_engine *engine);
+	int (*do_batch_requests)(struct crypto_engine *engine);
 
 	struct kthread_worker           *kworker;
 	struct kthread_work             pump_requests;
 
 	void				*priv_data;
-	struct crypto_async_request	*cur_req;
+
+	unsigned int			max_inflight;
+	unsigned int			inflight;
+	struct crypto_queue		flows[CRYPTO_ENGINE_NR_FLOWS];
+	unsigned int			cur_flow;
 };
 
 /*
@@ -111,6 +124,10 @@ void crypto_finalize_kpp_request(struct crypto_engine *engine,
 int crypto_engine_start(struct crypto_engine *engine);
 int crypto_engine_stop(struct crypto_engine *engine);
 struct crypto_engine *crypto_engine_alloc_init(struct device *dev, bool rt);
+struct crypto_engine *crypto_engine_alloc_init_and_set(struct device *dev,
+						       unsigned int max_inflight,
+						       int (*cbk_do_batch)(struct crypto_engine *engine),
+						       bool rt, int qlen);
 int crypto_engine_exit(struct crypto_engine *engine);
 
 #endif /* _CRYPTO_ENGINE_H */
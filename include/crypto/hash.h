@@ -169,6 +169,11 @@ struct shash_desc {
  * @export: see struct ahash_alg
  * @import: see struct ahash_alg
  * @setkey: see struct ahash_alg
+ * @digest_batch: Compute the message digests of several independent messages
+ *		  of the same length in one call. Implementations may hash the
+ *		  messages in parallel, e.g. one message per SIMD lane. The
+ *		  descriptor is used as scratch state only. If not provided,
+ *		  the messages are hashed one after the other with @digest.
  * @digestsize: see struct ahash_alg
  * @statesize: see struct ahash_alg
  * @descsize: Size of the operational state for the message digest. This state
@@ -189,6 +194,8 @@ struct shash_alg {
 	int (*import)(struct shash_desc *desc, const void *in);
 	int (*setkey)(struct crypto_shash *tfm, const u8 *key,
 		      unsigned int keylen);
+	int (*digest_batch)(struct shash_desc *desc, const u8 * const *data,
+			    unsigned int len, u8 * const *out, unsigned int nr);
 
 	unsigned int descsize;
 
@@ -842,6 +849,36 @@ int crypto_shash_setkey(struct crypto_shash *tfm, const u8 *key,
 int crypto_shash_digest(struct shash_desc *desc, const u8 *data,
 			unsigned int len, u8 *out);
 
+/**
+ * crypto_shash_digest_batch() - calculate message digests for many buffers
+ * @desc: see crypto_shash_final()
+ * @data: array of @nr source buffers
+ * @len: length of every source buffer
+ * @out: array of @nr output buffers, each large enough for one digest
+ * @nr: number of buffers
+ *
+ * Equivalent to calling crypto_shash_digest() for each buffer in turn, but
+ * allows the implementation to hash the independent buffers in parallel.
+ * This is intended for callers that hash many fixed-size blocks, such as
+ * Merkle tree leaves.
+ *
+ * Context: Any context.
+ * Return: 0 if all message digests were created successfully; < 0 if an
+ *	   error occurred
+ */
+int crypto_shash_digest_batch(struct shash_desc *desc, const u8 * const *data,
+			      unsigned int len, u8 * const *out,
+			      unsigned int nr);
+
+/**
+ * crypto_shash_has_digest_batch() - check for a native batch implementation
+ * @tfm: hash algorithm handle
+ *
+ * Return: true if the driver implements ->digest_batch() itself, false if
+ *	   crypto_shash_digest_batch() falls back to one digest per buffer
+ */
+bool crypto_shash_has_digest_batch(struct crypto_shash *tfm);
+
 /**
  * crypto_shash_export() - extract operational state for message digest
  * @desc: reference to the operational state handle whose state is exported
@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Batched hashing of independent blocks
+ *
+ * Callers such as fs-verity hash many small, independent blocks.  Rather than
+ * issuing one synchronous digest per block, they queue the blocks on a
+ * struct crypto_hash_batch and flush them together.  On flush the blocks are
+ * hashed by whichever of the following the transform resolved to:
+ *
+ *  - an asynchronous ahash driver (e.g. an offload engine), with every block
+ *    in flight at once;
+ *  - a synchronous shash driver implementing ->digest_batch(), hashing
+ *    several blocks per call in parallel SIMD lanes;
+ *  - any other synchronous shash driver, one block after the other.
+ *
+ * The highest priority driver for the requested algorithm decides which of
+ * these is used, so the choice follows the crypto API's usual ranking.
+ */
+#ifndef _CRYPTO_HASH_BATCH_H
+#define _CRYPTO_HASH_BATCH_H
+
+#include <linux/atomic.h>
+#include <linux/completion.h>
+#include <linux/list.h>
+#include <linux/types.h>
+
+struct ahash_request;
+struct crypto_ahash;
+struct crypto_shash;
+struct page;
+struct scatterlist;
+struct shash_desc;
+
+enum crypto_hash_batch_impl {
+	CRYPTO_HASH_BATCH_SYNC,		/* one shash digest per block */
+	CRYPTO_HASH_BATCH_MB,		/* shash ->digest_batch() */
+	CRYPTO_HASH_BATCH_ASYNC,	/* asynchronous ahash */
+	CRYPTO_HASH_BATCH_NR_IMPLS,
+};
+
+/**
+ * struct crypto_hash_batch_stats - per-subsystem hashing statistics
+ * @name: subsystem name, shown in debugfs
+ * @list: entry in the list of registered statistics
+ * @hashes: number of digests computed
+ * @bytes: number of bytes hashed
+ * @ns: time spent hashing, in nanoseconds
+ * @impl: number of digests computed by each implementation
+ *
+ * Registered statistics are shown in debugfs under hash_batch/stats.
+ */
+struct crypto_hash_batch_stats {
+	const char *name;
+	struct list_head list;
+	atomic64_t hashes;
+	atomic64_t bytes;
+	atomic64_t ns;
+	atomic64_t impl[CRYPTO_HASH_BATCH_NR_IMPLS];
+};
+
+#define DEFINE_CRYPTO_HASH_BATCH_STATS(_var, _name)			\
+	struct crypto_hash_batch_stats _var = {				\
+		.name = _name,						\
+		.list = LIST_HEAD_INIT(_var.list),			\
+	}
+
+/**
+ * struct crypto_hash_batch_tfm - transform used for batched hashing
+ * @impl: how blocks are hashed, see enum crypto_hash_batch_impl
+ * @shash: the shash transform, for CRYPTO_HASH_BATCH_SYNC and _MB
+ * @ahash: the ahash transform, for CRYPTO_HASH_BATCH_ASYNC
+ * @digestsize: digest size of the algorithm
+ */
+struct crypto_hash_batch_tfm {
+	enum crypto_hash_batch_impl impl;
+	union {
+		struct crypto_shash *shash;
+		struct crypto_ahash *ahash;
+	};
+	unsigned int digestsize;
+};
+
+typedef void (*crypto_hash_batch_done_t)(void *data, unsigned int idx,
+					 int err);
+
+struct crypto_hash_batch_item {
+	struct crypto_hash_batch *batch;
+	struct page *page;
+	const u8 *data;
+	unsigned int offset;
+	unsigned int len;
+	u8 *out;
+	struct ahash_request *req;
+	struct scatterlist *sg;
+};
+
+/**
+ * struct crypto_hash_batch - a set of blocks queued for hashing
+ * @tfm: the transform the blocks are hashed with
+ * @hashstate: exported state every digest starts from, or NULL
+ * @stats: statistics to account the flushed blocks to, or NULL
+ * @done: called once for every block as it completes, or NULL
+ * @done_data: first argument of @done
+ * @nr: number of queued blocks
+ * @max: maximum number of queued blocks
+ * @items: the queued blocks
+ * @desc: shash descriptor for the synchronous implementations
+ * @inflight: asynchronous requests not yet completed, plus one
+ * @completion: completed when @inflight drops to zero
+ * @err: first error of the asynchronous requests
+ */
+struct crypto_hash_batch {
+	struct crypto_hash_batch_tfm *tfm;
+	const u8 *hashstate;
+	struct crypto_hash_batch_stats *stats;
+	crypto_hash_batch_done_t done;
+	void *done_data;
+	unsigned int nr;
+	unsigned int max;
+	struct crypto_hash_batch_item *items;
+	struct shash_desc *desc;
+	atomic_t inflight;
+	struct completion completion;
+	int err;
+};
+
+struct crypto_hash_batch_tfm *crypto_alloc_hash_batch_tfm(const char *alg_name);
+void crypto_free_hash_batch_tfm(struct crypto_hash_batch_tfm *tfm);
+const char *crypto_hash_batch_driver_name(struct crypto_hash_batch_tfm *tfm);
+const char *crypto_hash_batch_impl_name(enum crypto_hash_batch_impl impl);
+
+struct crypto_hash_batch *crypto_hash_batch_alloc(
+		struct crypto_hash_batch_tfm *tfm, unsigned int max, gfp_t gfp);
+void crypto_hash_batch_free(struct crypto_hash_batch *batch);
+
+int crypto_hash_batch_add_page(struct crypto_hash_batch *batch,
+			       struct page *page, unsigned int offset,
+			       unsigned int len, u8 *out);
+int crypto_hash_batch_add(struct crypto_hash_batch *batch, const void *data,
+			  unsigned int len, u8 *out);
+int crypto_hash_batch_flush(struct crypto_hash_batch *batch);
+
+void crypto_hash_batch_stats_register(struct crypto_hash_batch_stats *stats);
+void crypto_hash_batch_stats_unregister(struct crypto_hash_batch_stats *stats);
+void crypto_hash_batch_account(struct crypto_hash_batch_stats *stats,
+			       enum crypto_hash_batch_impl impl,
+			       unsigned int hashes, u64 bytes, u64 ns);
+
+/**
+ * crypto_hash_batch_set_hashstate() - start every digest from a given state
+ * @batch: the batch
+ * @hashstate: state exported from a transform of the same driver, or NULL
+ *
+ * Used for salted hashes.  Digests then cannot use ->digest_batch() and are
+ * computed one at a time by the synchronous implementations.
+ */
+static inline void crypto_hash_batch_set_hashstate(
+		struct crypto_hash_batch *batch, const u8 *hashstate)
+{
+	batch->hashstate = hashstate;
+}
+
+/**
+ * crypto_hash_batch_set_callback() - set the per-block completion callback
+ * @batch: the batch
+ * @done: called with @data, the block's index and its result
+ * @data: first argument of @done
+ *
+ * For asynchronous transforms @done may run in softirq context.
+ */
+static inline void crypto_hash_batch_set_callback(
+		struct crypto_hash_batch *batch, crypto_hash_batch_done_t done,
+		void *data)
+{
+	batch->done = done;
+	batch->done_data = data;
+}
+
+static inline void crypto_hash_batch_set_stats(
+		struct crypto_hash_batch *batch,
+		struct crypto_hash_batch_stats *stats)
+{
+	batch->stats = stats;
+}
+
+static inline unsigned int crypto_hash_batch_count(
+		const struct crypto_hash_batch *batch)
+{
+	return batch->nr;
+}
+
+/* Drop the queued blocks without hashing them */
+static inline void crypto_hash_batch_reset(struct crypto_hash_batch *batch)
+{
+	batch->nr = 0;
+}
+
+static inline bool crypto_hash_batch_full(const struct crypto_hash_batch *batch)
+{
+	return batch->nr == batch->max;
+}
+
+#endif	/* _CRYPTO_HASH_BATCH_H */
@@ -23,6 +23,8 @@ struct crypto_scomp {
  * @free_ctx:	Function frees context allocated with alloc_ctx
  * @compress:	Function performs a compress operation
  * @decompress:	Function performs a de-compress operation
+ * @setlevel:	Optional. Selects the compression level of the tfm
+ * @setdict:	Optional. Loads a dictionary used for both directions
  * @base:	Common crypto API algorithm data structure
  */
 struct scomp_alg {
@@ -34,6 +36,9 @@ struct scomp_alg {
 	int (*decompress)(struct crypto_scomp *tfm, const u8 *src,
 			  unsigned int slen, u8 *dst, unsigned int *dlen,
 			  void *ctx);
+	int (*setlevel)(struct crypto_scomp *tfm, int level);
+	int (*setdict)(struct crypto_scomp *tfm, const u8 *dict,
+		       unsigned int len);
 	struct crypto_alg base;
 };
 
@@ -39,6 +39,10 @@ struct crypto_skcipher {
 	              unsigned int keylen);
 	int (*encrypt)(struct skcipher_request *req);
 	int (*decrypt)(struct skcipher_request *req);
+	int (*encrypt_batch)(struct skcipher_request **reqs, int *errs,
+			     unsigned int nr);
+	int (*decrypt_batch)(struct skcipher_request **reqs, int *errs,
+			     unsigned int nr);
 
 	unsigned int ivsize;
 	unsigned int reqsize;
@@ -86,6 +90,13 @@ struct crypto_sync_skcipher {
  *	     be called in parallel with the same transformation object.
  * @decrypt: Decrypt a single block. This is a reverse counterpart to @encrypt
  *	     and the conditions are exactly the same.
+ * @encrypt_batch: Optional. Encrypt @nr independent requests issued on the
+ *		   same transformation object, storing the result of each in
+ *		   @errs. This lets an implementation amortise per-call setup
+ *		   such as saving the FPU state over the whole list. The
+ *		   conditions of @encrypt apply to every request. Returns the
+ *		   first non-zero entry of @errs, or zero.
+ * @decrypt_batch: Optional. Counterpart to @encrypt_batch for decryption.
  * @init: Initialize the cryptographic transformation object. This function
  *	  is used to initialize the cryptographic transformation object.
  *	  This function is called only once at the instantiation time, right
@@ -106,13 +117,18 @@ struct crypto_sync_skcipher {
  * 	      in parallel. Should be a multiple of chunksize.
  * @base: Definition of a generic crypto algorithm.
  *
- * All fields except @ivsize are mandatory and must be filled.
+ * All fields except @ivsize and the batch operations are mandatory and must
+ * be filled.
  */
 struct skcipher_alg {
 	int (*setkey)(struct crypto_skcipher *tfm, const u8 *key,
 	              unsigned int keylen);
 	int (*encrypt)(struct skcipher_request *req);
 	int (*decrypt)(struct skcipher_request *req);
+	int (*encrypt_batch)(struct skcipher_request **reqs, int *errs,
+			     unsigned int nr);
+	int (*decrypt_batch)(struct skcipher_request **reqs, int *errs,
+			     unsigned int nr);
 	int (*init)(struct crypto_skcipher *tfm);
 	void (*exit)(struct crypto_skcipher *tfm);
 
@@ -464,6 +480,39 @@ int crypto_skcipher_encrypt(struct skcipher_request *req);
  */
 int crypto_skcipher_decrypt(struct skcipher_request *req);
 
+/**
+ * crypto_skcipher_encrypt_batch() - encrypt a list of requests
+ * @reqs: array of @nr skcipher_request handles, all allocated for the same
+ *	  skcipher handle
+ * @errs: array of @nr integers receiving the result of each request
+ * @nr: number of requests
+ *
+ * Submit several independent encryption requests in one call. Each request
+ * completes exactly as if it had been passed to crypto_skcipher_encrypt(),
+ * including asynchronous completion when its entry in @errs is -EINPROGRESS
+ * or -EBUSY. Implementations that provide a batch operation may process the
+ * whole list while holding per-call resources such as the FPU; all others
+ * fall back to submitting the requests one at a time.
+ *
+ * Return: 0 if all requests were successful or the first error found in @errs
+ */
+int crypto_skcipher_encrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr);
+
+/**
+ * crypto_skcipher_decrypt_batch() - decrypt a list of requests
+ * @reqs: array of @nr skcipher_request handles, all allocated for the same
+ *	  skcipher handle
+ * @errs: array of @nr integers receiving the result of each request
+ * @nr: number of requests
+ *
+ * Decryption counterpart to crypto_skcipher_encrypt_batch().
+ *
+ * Return: 0 if all requests were successful or the first error found in @errs
+ */
+int crypto_skcipher_decrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr);
+
 /**
  * DOC: Symmetric Key Cipher Request Handle
  *
@@ -61,9 +61,10 @@
  * a number of search trees. These trees are oranised by size, by address and
  * in most recent eviction order. This allows the user to find either the
  * smallest hole to reuse, the lowest or highest address to reuse, or simply
- * reuse the most recent eviction that fits. When allocating the &drm_mm_node
- * from within the hole, the &drm_mm_insert_mode also dictate whether to
- * allocate the lowest matching address or the highest.
+ * reuse the most recent eviction that fits. Holes are also kept on lists by
+ * power-of-two size class, for finding a hole that fits in constant time. When
+ * allocating the &drm_mm_node from within the hole, the &drm_mm_insert_mode
+ * also dictate whether to allocate the lowest matching address or the highest.
  */
 enum drm_mm_insert_mode {
 	/**
@@ -110,6 +111,21 @@ enum drm_mm_insert_mode {
 	 */
 	DRM_MM_INSERT_EVICT,
 
+	/**
+	 * @DRM_MM_INSERT_FIT:
+	 *
+	 * Search for a hole (within the search range) in the smallest
+	 * non-empty size class whose holes are all large enough for the
+	 * desired node, before trying the larger classes and finally the
+	 * holes that are only possibly large enough. Unlike
+	 * DRM_MM_INSERT_BEST, finding the first candidate does not depend
+	 * on the number of holes, at the cost of a possibly larger hole
+	 * than the best fit.
+	 *
+	 * Allocates the node from the bottom of the found hole.
+	 */
+	DRM_MM_INSERT_FIT,
+
 	/**
 	 * @DRM_MM_INSERT_ONCE:
 	 *
@@ -163,6 +179,7 @@ struct drm_mm_node {
 	struct drm_mm *mm;
 	struct list_head node_list;
 	struct list_head hole_stack;
+	struct list_head hole_class;
 	struct rb_node rb;
 	struct rb_node rb_hole_size;
 	struct rb_node rb_hole_addr;
@@ -208,6 +225,10 @@ struct drm_mm {
 	struct rb_root_cached interval_tree;
 	struct rb_root_cached holes_size;
 	struct rb_root holes_addr;
+	/* Holes by size class, [n] holding those of [2^n, 2^(n+1)) */
+	struct list_head holes_class[64];
+	/* Bitmask of the non-empty holes_class[] */
+	u64 holes_class_mask;
 
 	unsigned long scan_active;
 };
@@ -459,6 +480,16 @@ static inline int drm_mm_insert_node(struct drm_mm *mm,
 	return drm_mm_insert_node_generic(mm, node, size, 0, 0, 0);
 }
 
+int drm_mm_insert_nodes_in_range(struct drm_mm *mm,
+				 struct drm_mm_node **nodes,
+				 unsigned int count,
+				 u64 size,
+				 u64 alignment,
+				 unsigned long color,
+				 u64 start,
+				 u64 end,
+				 enum drm_mm_insert_mode mode);
+
 void drm_mm_remove_node(struct drm_mm_node *node);
 void drm_mm_replace_node(struct drm_mm_node *old, struct drm_mm_node *new);
 void drm_mm_init(struct drm_mm *mm, u64 start, u64 size);
@@ -42,6 +42,8 @@
 #include <linux/bitmap.h>
 #include <linux/dma-resv.h>
 
+struct seq_file;
+
 struct ttm_bo_global;
 
 struct ttm_bo_device;
@@ -152,6 +154,9 @@ struct ttm_tt;
  * @ddestroy: List head for the delayed destroy list.
  * @swap: List head for swap LRU list.
  * @moving: Fence set when BO is moving
+ * @vm_fault_next: Page offset following the pages mapped by the last CPU
+ * fault.
+ * @vm_prefault: Number of pages the last CPU fault mapped.
  * @offset: The current GPU offset, which can have different meanings
  * depending on the memory type. For SYSTEM type memory, it should be 0.
  * @cur_placement: Hint of current placement.
@@ -219,6 +224,8 @@ struct ttm_buffer_object {
 
 	struct dma_fence *moving;
 	unsigned priority;
+	unsigned long vm_fault_next;
+	unsigned int vm_prefault;
 
 	/**
 	 * Special members that are protected by the reserve lock
@@ -734,6 +741,17 @@ int ttm_fbdev_mmap(struct vm_area_struct *vma, struct ttm_buffer_object *bo);
 int ttm_bo_mmap(struct file *filp, struct vm_area_struct *vma,
 		struct ttm_bo_device *bdev);
 
+/**
+ * ttm_bo_vm_debugfs - print CPU fault statistics of ttm buffer objects.
+ *
+ * @m:         seq_file to print to.
+ * @data:      Unused.
+ *
+ * Prints the number of CPU faults on mmapped buffer objects and the number
+ * of pages they mapped. Intended to be used as a drm_info_list callback.
+ */
+int ttm_bo_vm_debugfs(struct seq_file *m, void *data);
+
 void *ttm_kmap_atomic_prot(struct page *page, pgprot_t prot);
 
 void ttm_kunmap_atomic_prot(void *addr, pgprot_t prot);
@@ -161,6 +161,9 @@ struct crypto_async_request {
 	struct crypto_tfm *tfm;
 
 	u32 flags;
+#ifdef CONFIG_CRYPTO_STATS
+	u64 queue_ns;	/* when the request was queued, for latency stats */
+#endif
 };
 
 struct ablkcipher_request {
@@ -330,14 +333,21 @@ struct cipher_alg {
  * @coa_decompress: Decompress the source buffer, storing the uncompressed
  *		    data in the specified buffer. The length of the data is
  *		    returned in dlen.
+ * @coa_setlevel: Optional. Select the compression level used by this
+ *		  transformation object. Zero selects the algorithm default.
+ * @coa_setdict: Optional. Load a dictionary used by both compression and
+ *		 decompression. A zero length removes the dictionary.
  *
- * All fields are mandatory.
+ * All fields except @coa_setlevel and @coa_setdict are mandatory.
  */
 struct compress_alg {
 	int (*coa_compress)(struct crypto_tfm *tfm, const u8 *src,
 			    unsigned int slen, u8 *dst, unsigned int *dlen);
 	int (*coa_decompress)(struct crypto_tfm *tfm, const u8 *src,
 			      unsigned int slen, u8 *dst, unsigned int *dlen);
+	int (*coa_setlevel)(struct crypto_tfm *tfm, int level);
+	int (*coa_setdict)(struct crypto_tfm *tfm, const u8 *dict,
+			   unsigned int len);
 };
 
 #ifdef CONFIG_CRYPTO_STATS
@@ -448,6 +458,27 @@ struct crypto_istat_rng {
 	atomic64_t seed_cnt;
 	atomic64_t err_cnt;
 };
+
+/*
+ * struct crypto_istat_queue - statistics for algorithms that queue requests
+ * @enqueue_cnt:	number of requests accepted into the queue
+ * @backlog_cnt:	number of requests put on the backlog
+ * @drop_cnt:		number of requests rejected because the queue was full
+ * @depth_max:		largest number of requests queued or in flight seen by
+ *			a newly queued request
+ * @complete_cnt:	number of queued requests that completed
+ * @latency_ns:		total time from queueing to completion
+ * @latency_max_ns:	longest time from queueing to completion
+ */
+struct crypto_istat_queue {
+	atomic64_t enqueue_cnt;
+	atomic64_t backlog_cnt;
+	atomic64_t drop_cnt;
+	atomic64_t depth_max;
+	atomic64_t complete_cnt;
+	atomic64_t latency_ns;
+	atomic64_t latency_max_ns;
+};
 #endif /* CONFIG_CRYPTO_STATS */
 
 #define cra_ablkcipher	cra_u.ablkcipher
@@ -542,6 +573,8 @@ struct crypto_istat_rng {
  * @stats.hash:		statistics for hash algorithm
  * @stats.rng:		statistics for rng algorithm
  * @stats.kpp:		statistics for KPP algorithm
+ * @qstats:		queueing statistics, used by asynchronous algorithms
+ *			that defer requests to a queue (e.g. cryptd)
  *
  * The struct crypto_alg describes a generic Crypto API algorithm and is common
  * for all of the transformations. Any variable not documented here shall not
@@ -587,6 +620,7 @@ struct crypto_alg {
 		struct crypto_istat_rng rng;
 		struct crypto_istat_kpp kpp;
 	} stats;
+	struct crypto_istat_queue qstats;
 #endif /* CONFIG_CRYPTO_STATS */
 
 } CRYPTO_MINALIGN_ATTR;
@@ -613,6 +647,10 @@ void crypto_stats_rng_seed(struct crypto_alg *alg, int ret);
 void crypto_stats_rng_generate(struct crypto_alg *alg, unsigned int dlen, int ret);
 void crypto_stats_skcipher_encrypt(unsigned int cryptlen, int ret, struct crypto_alg *alg);
 void crypto_stats_skcipher_decrypt(unsigned int cryptlen, int ret, struct crypto_alg *alg);
+void crypto_stats_queue(struct crypto_alg *alg, int ret);
+void crypto_stats_queue_depth(struct crypto_alg *alg, unsigned int depth);
+void crypto_stats_queue_start(struct crypto_async_request *req);
+void crypto_stats_queue_complete(struct crypto_async_request *req);
 #else
 static inline void crypto_stats_init(struct crypto_alg *alg)
 {}
@@ -656,6 +694,14 @@ static inline void crypto_stats_skcipher_encrypt(unsigned int cryptlen, int ret,
 {}
 static inline void crypto_stats_skcipher_decrypt(unsigned int cryptlen, int ret, struct crypto_alg *alg)
 {}
+static inline void crypto_stats_queue(struct crypto_alg *alg, int ret)
+{}
+static inline void crypto_stats_queue_depth(struct crypto_alg *alg, unsigned int depth)
+{}
+static inline void crypto_stats_queue_start(struct crypto_async_request *req)
+{}
+static inline void crypto_stats_queue_complete(struct crypto_async_request *req)
+{}
 #endif
 /*
  * A helper struct for waiting for completion of async crypto ops
@@ -751,6 +797,9 @@ struct compress_tfm {
 	int (*cot_decompress)(struct crypto_tfm *tfm,
 	                      const u8 *src, unsigned int slen,
 	                      u8 *dst, unsigned int *dlen);
+	int (*cot_setlevel)(struct crypto_tfm *tfm, int level);
+	int (*cot_setdict)(struct crypto_tfm *tfm,
+			   const u8 *dict, unsigned int len);
 };
 
 #define crt_ablkcipher	crt_u.ablkcipher
@@ -1847,5 +1896,41 @@ static inline int crypto_comp_decompress(struct crypto_comp *tfm,
 						    src, slen, dst, dlen);
 }
 
+/**
+ * crypto_comp_setlevel() - select the compression level
+ * @tfm: compression handle
+ * @level: algorithm specific level, zero selects the default
+ *
+ * Must be called from process context and not concurrently with any other
+ * operation on @tfm.
+ *
+ * Return: 0 on success, -EOPNOTSUPP if the algorithm has no levels, -EINVAL
+ *	   if @level is out of range or another negative error code
+ */
+static inline int crypto_comp_setlevel(struct crypto_comp *tfm, int level)
+{
+	return crypto_comp_crt(tfm)->cot_setlevel(crypto_comp_tfm(tfm), level);
+}
+
+/**
+ * crypto_comp_setdict() - load a compression dictionary
+ * @tfm: compression handle
+ * @dict: dictionary contents, copied by the algorithm
+ * @len: length of @dict, zero removes a previously loaded dictionary
+ *
+ * Data compressed with a dictionary can only be decompressed by a handle
+ * holding the same dictionary. The same context rules as for
+ * crypto_comp_setlevel() apply.
+ *
+ * Return: 0 on success, -EOPNOTSUPP if the algorithm has no dictionary
+ *	   support or another negative error code
+ */
+static inline int crypto_comp_setdict(struct crypto_comp *tfm,
+				      const u8 *dict, unsigned int len)
+{
+	return crypto_comp_crt(tfm)->cot_setdict(crypto_comp_tfm(tfm),
+						 dict, len);
+}
+
 #endif	/* _LINUX_CRYPTO_H */
 
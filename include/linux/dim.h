@@ -4,6 +4,8 @@
 #ifndef DIM_H
 #define DIM_H
 
+#include <linux/list.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 
 /**
@@ -74,6 +76,62 @@ struct dim_stats {
 	int cpe_ratio; /* ratio of completions to events */
 };
 
+/**
+ * Completion latency histogram, used by the latency-target algorithm.
+ * Buckets are logarithmic with 2^DIM_LAT_SUB_BITS steps per power of two,
+ * so each bucket is at most 25% wide; the last bucket also collects
+ * everything beyond its range.
+ *
+ * @buckets: Sample counts, indexed by dim_lat_bucket()
+ * @count: Number of samples since the last decision
+ * @target_us: p99 latency goal in usec
+ */
+#define DIM_LAT_SUB_BITS 2
+#define DIM_LAT_BUCKETS 64
+
+struct dim_lat_hist {
+	u32 buckets[DIM_LAT_BUCKETS];
+	u32 count;
+	u32 target_us;
+};
+
+/**
+ * Structure for DIM counters.
+ * Exported to consumers through dim_get_stats().
+ *
+ * @decisions: Number of completed measurement iterations
+ * @profile_changes: Number of iterations that moved to another profile
+ * @lat_violations: Number of iterations whose p99 exceeded the target
+ * @last_p99_us: p99 latency measured in the last iteration
+ */
+struct dim_counters {
+	u64 decisions;
+	u64 profile_changes;
+	u64 lat_violations;
+	u32 last_p99_us;
+};
+
+struct dim;
+
+/**
+ * Structure for a DIM decision algorithm.
+ * The built-in net, rdma and latency algorithms are always available;
+ * modules may register more with dim_register_algo().
+ *
+ * @list: Entry in the list of registered algorithms
+ * @name: Name used to select the algorithm
+ * @owner: Module providing the algorithm
+ * @decide: Evaluate the stats of a finished iteration, move
+ * dim->profile_ix within [0, nr_profiles) and return true if it changed
+ */
+struct dim_algo {
+	struct list_head list;
+	const char *name;
+	struct module *owner;
+	bool (*decide)(struct dim *dim, struct dim_stats *curr_stats,
+		       u8 nr_profiles);
+};
+
 /**
  * Main structure for dynamic interrupt moderation (DIM).
  * Used for holding all information about a specific DIM instance.
@@ -89,6 +147,9 @@ struct dim_stats {
  * @steps_right: Number of steps taken towards higher moderation
  * @steps_left: Number of steps taken towards lower moderation
  * @tired: Parking depth counter
+ * @algo: Decision algorithm, NULL for the consumer's default
+ * @lat: Latency histogram, allocated by dim_lat_enable()
+ * @counters: Exported counters
  */
 struct dim {
 	u8 state;
@@ -103,6 +164,9 @@ struct dim {
 	u8 steps_right;
 	u8 steps_left;
 	u8 tired;
+	const struct dim_algo *algo;
+	struct dim_lat_hist *lat;
+	struct dim_counters counters;
 };
 
 /**
@@ -270,6 +334,129 @@ dim_update_sample_with_comps(u16 event_ctr, u64 packets, u64 bytes, u64 comps,
 	s->comp_ctr = comps;
 }
 
+/**
+ *	dim_decide - run the decision step of an iteration
+ *	@dim: DIM context
+ *	@curr_stats: stats of the finished iteration
+ *	@def: algorithm to use if none was selected with dim_set_algo()
+ *	@nr_profiles: number of profiles of the consumer
+ *
+ * Returns true if a new profile has to be applied.
+ */
+bool dim_decide(struct dim *dim, struct dim_stats *curr_stats,
+		const struct dim_algo *def, u8 nr_profiles);
+
+/**
+ *	dim_register_algo - make a DIM algorithm selectable by name
+ *	@algo: algorithm to register
+ */
+int dim_register_algo(struct dim_algo *algo);
+
+/**
+ *	dim_unregister_algo - remove a registered DIM algorithm
+ *	@algo: algorithm to remove
+ */
+void dim_unregister_algo(struct dim_algo *algo);
+
+/**
+ *	dim_set_algo - select the decision algorithm of a DIM instance
+ *	@dim: DIM context
+ *	@name: algorithm name, NULL or "" for the consumer's default
+ *
+ * Takes a reference on the module providing the algorithm, which is
+ * dropped by dim_put_algo() or the next dim_set_algo() call. The tuning
+ * state is reset, the current profile is kept.
+ */
+int dim_set_algo(struct dim *dim, const char *name);
+
+/**
+ *	dim_put_algo - release the algorithm selected by dim_set_algo()
+ *	@dim: DIM context
+ */
+void dim_put_algo(struct dim *dim);
+
+/**
+ *	dim_lat_enable - start collecting completion latencies
+ *	@dim: DIM context
+ *	@target_us: p99 latency goal in usec
+ *	@gfp: allocation flags
+ */
+int dim_lat_enable(struct dim *dim, u32 target_us, gfp_t gfp);
+
+/**
+ *	dim_lat_disable - stop collecting completion latencies
+ *	@dim: DIM context
+ */
+void dim_lat_disable(struct dim *dim);
+
+/**
+ *	dim_lat_percentile - latency below which a given share of samples fell
+ *	@lat: latency histogram
+ *	@pct: percentile, 1..100
+ *
+ * Returns the upper bound of the bucket holding the percentile, in usec.
+ */
+u32 dim_lat_percentile(const struct dim_lat_hist *lat, unsigned int pct);
+
+static inline unsigned int dim_lat_bucket(u32 usec)
+{
+	unsigned int msb, ix;
+
+	if (usec < (1U << DIM_LAT_SUB_BITS))
+		return usec;
+
+	msb = ilog2(usec);
+	ix = ((msb - DIM_LAT_SUB_BITS + 1) << DIM_LAT_SUB_BITS) +
+	     ((usec >> (msb - DIM_LAT_SUB_BITS)) &
+	      ((1U << DIM_LAT_SUB_BITS) - 1));
+	return min_t(unsigned int, ix, DIM_LAT_BUCKETS - 1);
+}
+
+/**
+ *	dim_lat_record - account one completion latency
+ *	@dim: DIM context
+ *	@usec: latency of the completion in usec
+ *
+ * Must be called from the same context as the consumer's DIM entry point.
+ */
+static inline void dim_lat_record(struct dim *dim, u32 usec)
+{
+	struct dim_lat_hist *lat = dim->lat;
+
+	if (lat) {
+		lat->buckets[dim_lat_bucket(usec)]++;
+		lat->count++;
+	}
+}
+
+/*
+ * Exported per-instance state, laid out like ethtool statistics so that
+ * drivers can copy dim_stat_strings into their ETH_SS_STATS strings.
+ */
+#define DIM_STAT_STRING_LEN 32
+
+enum {
+	DIM_STAT_PROFILE_IX,
+	DIM_STAT_TUNE_STATE,
+	DIM_STAT_DECISIONS,
+	DIM_STAT_PROFILE_CHANGES,
+	DIM_STAT_EPMS,
+	DIM_STAT_CPMS,
+	DIM_STAT_LAT_TARGET_US,
+	DIM_STAT_LAT_P99_US,
+	DIM_STAT_LAT_VIOLATIONS,
+	DIM_STATS_NUM,
+};
+
+extern const char dim_stat_strings[DIM_STATS_NUM][DIM_STAT_STRING_LEN];
+
+/**
+ *	dim_get_stats - snapshot the exported state of a DIM instance
+ *	@dim: DIM context
+ *	@data: array of DIM_STATS_NUM values, in dim_stat_strings order
+ */
+void dim_get_stats(const struct dim *dim, u64 *data);
+
 /* Net DIM */
 
 /**
@@ -330,4 +517,20 @@ void net_dim(struct dim *dim, struct dim_sample end_sample);
  */
 void rdma_dim(struct dim *dim, u64 completions);
 
+/**
+ * dim_run_comps - completion-driven moderation for any profile table
+ * @dim: The moderation struct.
+ * @completions: The number of completions collected in this round.
+ * @nr_profiles: Number of profiles of the consumer.
+ *
+ * Same sampling as rdma_dim(), for consumers with their own profile
+ * table; the rdma algorithm is used unless another one was selected.
+ */
+void dim_run_comps(struct dim *dim, u64 completions, u8 nr_profiles);
+
+/* Built-in algorithms */
+extern struct dim_algo dim_net_algo;
+extern struct dim_algo dim_rdma_algo;
+extern struct dim_algo dim_lat_algo;
+
 #endif /* DIM_H */
@@ -292,6 +292,10 @@ int LZ4_decompress_fast(const char *source, char *dest, int originalSize);
 int LZ4_decompress_safe(const char *source, char *dest, int compressedSize,
 	int maxDecompressedSize);
 
+/* LZ4_decompress_safe() without the wide copies, only built for TEST_LZ4 */
+int LZ4_decompress_safe_wildCopy8(const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize);
+
 /**
  * LZ4_decompress_safe_partial() - Decompress a block of size 'compressedSize'
  *	at position 'source' into buffer 'dest'
@@ -142,6 +142,20 @@ struct vhm_request *acrn_ioreq_get_reqbuf(int client_id);
  */
 int acrn_ioreq_attach_client(int client_id, bool check_kthread_stop);
 
+/**
+ * acrn_ioreq_wait_vcpu - wait for a request of one vcpu
+ * Like acrn_ioreq_attach_client() for a client without handler, but only
+ * returns once @vcpu has a pending request, so that several threads can
+ * each serve their own vcpus of the same client.
+ *
+ * @client_id: client id to identify ioreq client
+ * @vcpu: the vcpu whose request to wait for
+ * @check_kthread_stop: whether check current kthread should be stopped
+ *
+ * Return: 0 on success, <0 on error, 1 if ioreq client is destroying
+ */
+int acrn_ioreq_wait_vcpu(int client_id, int vcpu, bool check_kthread_stop);
+
 /**
  * acrn_ioreq_distribute_request - deliver request to corresponding client
  *
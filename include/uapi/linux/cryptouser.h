@@ -64,6 +64,7 @@ enum crypto_attr_type_t {
 	CRYPTOCFGA_STAT_AKCIPHER,	/* struct crypto_stat */
 	CRYPTOCFGA_STAT_KPP,		/* struct crypto_stat */
 	CRYPTOCFGA_STAT_ACOMP,		/* struct crypto_stat */
+	CRYPTOCFGA_STAT_QUEUE,		/* struct crypto_stat_queue */
 	__CRYPTOCFGA_MAX
 
 #define CRYPTOCFGA_MAX (__CRYPTOCFGA_MAX - 1)
@@ -144,6 +145,17 @@ struct crypto_stat_larval {
 	char type[CRYPTO_MAX_NAME];
 };
 
+struct crypto_stat_queue {
+	char type[CRYPTO_MAX_NAME];
+	__u64 stat_enqueue_cnt;
+	__u64 stat_backlog_cnt;
+	__u64 stat_drop_cnt;
+	__u64 stat_depth_max;
+	__u64 stat_complete_cnt;
+	__u64 stat_latency_ns;
+	__u64 stat_latency_max_ns;
+};
+
 struct crypto_report_larval {
 	char type[CRYPTO_MAX_NAME];
 };
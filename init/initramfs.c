@@ -10,6 +10,16 @@
 #include <linux/syscalls.h>
 #include <linux/utime.h>
 #include <linux/file.h>
+#include <linux/async.h>
+#include <linux/atomic.h>
+#include <linux/completion.h>
+#include <linux/crc32.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/lz4.h>
+#include <linux/mm.h>
+
+#include <asm/unaligned.h>
 
 static ssize_t __init xwrite(int fd, const char *p, size_t count)
 {
@@ -440,12 +450,411 @@ static unsigned long my_inptr; /* index of next byte to be processed in inbuf */
 
 #include <linux/decompress/generic.h>
 
+/*
+ * Parallel unpacking of multi-member images.
+ *
+ * An image may be a concatenation of several compressed cpio archives, but
+ * where one member ends is only known once it has been decompressed.  So
+ * before unpacking, every offset carrying a known compression magic and a
+ * plausible header is recorded as a candidate, and worker threads
+ * speculatively decompress from the candidates into memory.  The unpacker
+ * then walks the image in order exactly as before; when the next member
+ * starts at a candidate a worker has decoded (or is decoding), the buffered
+ * output is fed to the cpio parser instead of decompressing the member
+ * again.  Candidates that turn out to lie inside another member are
+ * cancelled and their output dropped, so the result is the same as a
+ * sequential unpack.
+ */
+#define UNPACK_MIN_SIZE		(1UL << 20)
+#define UNPACK_MAX_CANDIDATES	1024
+#define UNPACK_MAX_THREADS	8
+/* largest LZMA dictionary accepted for a candidate, as with xz -9 */
+#define UNPACK_MAX_LZMA_DICT	(64UL << 20)
+/* largest compressed LZ4 block, as unlz4 accepts for its 8MB chunks */
+#define UNPACK_MAX_LZ4_BLOCK	LZ4_COMPRESSBOUND(8 << 20)
+
+enum unpack_spec_state {
+	SPEC_PENDING,		/* not picked up yet */
+	SPEC_RUNNING,		/* a worker is decompressing it */
+	SPEC_DONE,		/* output buffered in @chunks */
+	SPEC_FAILED,		/* not a valid member, or cancelled */
+	SPEC_CLAIMED,		/* handled (or skipped) by the unpacker */
+};
+
+struct unpack_chunk {
+	struct list_head list;
+	unsigned long len;
+	char data[];
+};
+
+struct unpack_spec {
+	unsigned long offset;
+	atomic_t state;
+	bool cancel;
+	long consumed;
+	struct list_head chunks;
+	struct completion done;
+};
+
+struct unpack_worker {
+	struct task_struct *task;
+	struct unpack_spec *spec;
+	bool failed;
+};
+
+static __initdata struct {
+	unsigned char *buf;
+	unsigned long len;
+	struct unpack_spec *specs;
+	unsigned int nr_specs;
+	unsigned int next_skip;
+	atomic_t next;
+	bool stop;
+	atomic_long_t buffered;
+	long max_buffered;
+	struct unpack_worker workers[UNPACK_MAX_THREADS];
+	unsigned int nr_workers;
+} punpack;
+
+static __initdata ASYNC_DOMAIN_EXCLUSIVE(unpack_domain);
+
+/* per-image phase timings, reported once the image is unpacked */
+static __initdata struct {
+	unsigned int members;
+	unsigned int replayed;
+	unsigned long out_bytes;
+	u64 scan_ns;
+	u64 inline_ns;
+	u64 wait_ns;
+	u64 replay_ns;
+} unpack_stats;
+
+static unsigned int initramfs_threads __initdata = UINT_MAX;
+static int __init initramfs_threads_param(char *str)
+{
+	return kstrtouint(str, 0, &initramfs_threads) == 0;
+}
+__setup("initramfs_threads=", initramfs_threads_param);
+
+static u64 __init unpack_ns_since(ktime_t start)
+{
+	return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+static struct unpack_worker __init *unpack_current_worker(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < punpack.nr_workers; i++)
+		if (punpack.workers[i].task == current)
+			return &punpack.workers[i];
+	return NULL;
+}
+
+static void __init unpack_free_chunks(struct unpack_spec *spec)
+{
+	struct unpack_chunk *chunk, *tmp;
+
+	list_for_each_entry_safe(chunk, tmp, &spec->chunks, list) {
+		atomic_long_sub(chunk->len, &punpack.buffered);
+		list_del(&chunk->list);
+		kvfree(chunk);
+	}
+}
+
+static long __init spec_flush(void *bufv, unsigned long len)
+{
+	struct unpack_worker *w = unpack_current_worker();
+	struct unpack_spec *spec = w->spec;
+	struct unpack_chunk *chunk;
+
+	if (READ_ONCE(spec->cancel) || READ_ONCE(punpack.stop))
+		return -1;
+	if (atomic_long_add_return(len, &punpack.buffered) >
+	    punpack.max_buffered) {
+		atomic_long_sub(len, &punpack.buffered);
+		return -1;
+	}
+
+	chunk = kvmalloc(struct_size(chunk, data, len), GFP_KERNEL);
+	if (!chunk) {
+		atomic_long_sub(len, &punpack.buffered);
+		return -1;
+	}
+	chunk->len = len;
+	memcpy(chunk->data, bufv, len);
+	list_add_tail(&chunk->list, &spec->chunks);
+	return len;
+}
+
+static void __init spec_error(char *x)
+{
+	unpack_current_worker()->failed = true;
+}
+
+static void __init unpack_worker_fn(void *data, async_cookie_t cookie)
+{
+	struct unpack_worker *w = data;
+
+	WRITE_ONCE(w->task, current);
+	for (;;) {
+		unsigned int idx = atomic_inc_return(&punpack.next) - 1;
+		struct unpack_spec *spec;
+		decompress_fn decompress;
+		int res;
+
+		if (idx >= punpack.nr_specs || READ_ONCE(punpack.stop))
+			break;
+		spec = &punpack.specs[idx];
+		if (atomic_cmpxchg(&spec->state, SPEC_PENDING,
+				   SPEC_RUNNING) != SPEC_PENDING)
+			continue;
+
+		w->spec = spec;
+		w->failed = false;
+		decompress = decompress_method(punpack.buf + spec->offset,
+					       punpack.len - spec->offset, NULL);
+		res = decompress(punpack.buf + spec->offset,
+				 punpack.len - spec->offset, NULL, spec_flush,
+				 NULL, &spec->consumed, spec_error);
+		if (res || w->failed) {
+			unpack_free_chunks(spec);
+			atomic_set(&spec->state, SPEC_FAILED);
+		} else {
+			atomic_set(&spec->state, SPEC_DONE);
+		}
+		complete_all(&spec->done);
+	}
+	WRITE_ONCE(w->task, NULL);
+}
+
+/*
+ * The magics are only two bytes long, so plenty of offsets inside compressed
+ * data match one.  Check the fixed fields, sizes and checksums of the header
+ * as well, so that workers don't start a decoder on garbage: bunzip2 sets up
+ * 3.6MB for a level 9 stream, unlz4 16MB of buffers, and unlzma allocates
+ * its dictionary with the size the header claims.
+ */
+static bool __init unpack_header_valid(const unsigned char *p, long len)
+{
+	u64 size;
+	u32 dict;
+
+	if (len < 13)
+		return false;
+
+	switch (p[0]) {
+	case 0x1f:	/* gzip: deflate, no reserved flags, known XFL and OS */
+		return p[2] == 8 && !(p[3] & 0xe0) &&
+		       (p[8] == 0 || p[8] == 2 || p[8] == 4) &&
+		       (p[9] <= 13 || p[9] == 255);
+	case 0x42:	/* bzip2: "BZh", a block size and a block or end magic */
+		return p[2] == 'h' && p[3] >= '1' && p[3] <= '9' &&
+		       (!memcmp(p + 4, "\x31\x41\x59\x26\x53\x59", 6) ||
+			!memcmp(p + 4, "\x17\x72\x45\x38\x50\x90", 6));
+	case 0x5d:	/* lzma: a dictionary as the lzma tools write it */
+		dict = get_unaligned_le32(p + 1);
+		if (dict < 4096 || dict > UNPACK_MAX_LZMA_DICT)
+			return false;
+		/* 2^n or 2^n + 2^(n-1) */
+		if (!is_power_of_2(dict) &&
+		    !(dict % 3 == 0 && is_power_of_2(dict / 3)))
+			return false;
+		/* unknown, or no more than fits in memory */
+		size = get_unaligned_le64(p + 5);
+		return size == U64_MAX ||
+		       size <= (u64)totalram_pages() << PAGE_SHIFT;
+	case 0xfd:	/* xz: full magic, a known check type, flags CRC32 */
+		return !memcmp(p, "\xfd" "7zXZ\0", 6) && !p[6] &&
+		       (p[7] == 0x00 || p[7] == 0x01 || p[7] == 0x04 ||
+			p[7] == 0x0a) &&
+		       ~crc32_le(~0, p + 6, 2) == get_unaligned_le32(p + 8);
+	case 0x89:	/* lzo: full magic */
+		return !memcmp(p, "\x89" "LZO\0\r\n\x1a\n", 9);
+	case 0x02:	/* lz4 legacy: full magic, a plausible first block */
+		return p[2] == 0x4c && p[3] == 0x18 &&
+		       get_unaligned_le32(p + 4) &&
+		       get_unaligned_le32(p + 4) <= UNPACK_MAX_LZ4_BLOCK;
+	default:
+		return false;
+	}
+}
+
+static bool __init unpack_is_candidate(const unsigned char *p, long len)
+{
+	/* cheap first-byte filter before the magic table lookup */
+	switch (p[0]) {
+	case 0x1f: case 0x42: case 0x5d: case 0xfd: case 0x89: case 0x02:
+		return unpack_header_valid(p, len) &&
+		       decompress_method(p, len, NULL) != NULL;
+	default:
+		return false;
+	}
+}
+
+static void __init unpack_start(unsigned char *buf, unsigned long len)
+{
+	unsigned int threads = initramfs_threads;
+	ktime_t start = ktime_get();
+	unsigned long off;
+	unsigned int i;
+
+	memset(&punpack, 0, sizeof(punpack));
+	memset(&unpack_stats, 0, sizeof(unpack_stats));
+
+	if (threads == UINT_MAX)
+		threads = num_online_cpus() - 1;
+	threads = min_t(unsigned int, threads, UNPACK_MAX_THREADS);
+	if (!threads || len < UNPACK_MIN_SIZE)
+		return;
+
+	punpack.specs = kvcalloc(UNPACK_MAX_CANDIDATES, sizeof(*punpack.specs),
+				 GFP_KERNEL);
+	if (!punpack.specs)
+		goto out;
+
+	/*
+	 * The first member is decompressed in line, so start past it.  The
+	 * members following a compressed one need not be aligned.
+	 */
+	for (off = 1; off + 2 <= len; off++) {
+		struct unpack_spec *spec;
+
+		if (!unpack_is_candidate(buf + off, len - off))
+			continue;
+		if (punpack.nr_specs == UNPACK_MAX_CANDIDATES) {
+			pr_info("initramfs: more than %u candidate members, unpacking sequentially\n",
+				UNPACK_MAX_CANDIDATES);
+			punpack.nr_specs = 0;
+			break;
+		}
+		spec = &punpack.specs[punpack.nr_specs++];
+		spec->offset = off;
+		atomic_set(&spec->state, SPEC_PENDING);
+		INIT_LIST_HEAD(&spec->chunks);
+		init_completion(&spec->done);
+	}
+	if (!punpack.nr_specs) {
+		kvfree(punpack.specs);
+		punpack.specs = NULL;
+		goto out;
+	}
+
+	punpack.buf = buf;
+	punpack.len = len;
+	punpack.max_buffered = (totalram_pages() / 4) << PAGE_SHIFT;
+	punpack.nr_workers = min_t(unsigned int, threads, punpack.nr_specs);
+	for (i = 0; i < punpack.nr_workers; i++)
+		async_schedule_domain(unpack_worker_fn, &punpack.workers[i],
+				      &unpack_domain);
+out:
+	unpack_stats.scan_ns = unpack_ns_since(start);
+}
+
+static struct unpack_spec __init *unpack_find_spec(unsigned long off)
+{
+	struct unpack_spec *specs = punpack.specs;
+	unsigned int lo = 0, hi = punpack.nr_specs;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (specs[mid].offset == off)
+			return &specs[mid];
+		if (specs[mid].offset < off)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+/*
+ * Everything before @off has been unpacked: candidates in that range lie
+ * inside a member (or were just replayed) and are dropped.
+ */
+static void __init unpack_skip_specs(unsigned long off)
+{
+	while (punpack.next_skip < punpack.nr_specs) {
+		struct unpack_spec *spec = &punpack.specs[punpack.next_skip];
+
+		if (spec->offset >= off)
+			break;
+		punpack.next_skip++;
+		if (atomic_cmpxchg(&spec->state, SPEC_PENDING,
+				   SPEC_CLAIMED) == SPEC_PENDING)
+			continue;
+		WRITE_ONCE(spec->cancel, true);
+		if (atomic_read(&spec->state) == SPEC_DONE)
+			unpack_free_chunks(spec);
+	}
+}
+
+/*
+ * Feed the buffered output of the member starting at @off to the cpio
+ * parser.  Returns false if the member has to be decompressed in line.
+ */
+static bool __init unpack_replay(unsigned long off)
+{
+	struct unpack_spec *spec = unpack_find_spec(off);
+	struct unpack_chunk *chunk;
+	ktime_t start;
+
+	if (!spec)
+		return false;
+
+	start = ktime_get();
+	if (atomic_cmpxchg(&spec->state, SPEC_PENDING,
+			   SPEC_CLAIMED) == SPEC_PENDING)
+		return false;
+	wait_for_completion(&spec->done);
+	unpack_stats.wait_ns += unpack_ns_since(start);
+	if (atomic_read(&spec->state) != SPEC_DONE)
+		return false;
+
+	start = ktime_get();
+	list_for_each_entry(chunk, &spec->chunks, list) {
+		unpack_stats.out_bytes += chunk->len;
+		if (flush_buffer(chunk->data, chunk->len) < 0)
+			break;
+	}
+	unpack_free_chunks(spec);
+	my_inptr = spec->consumed;
+	unpack_stats.replay_ns += unpack_ns_since(start);
+	unpack_stats.replayed++;
+	return true;
+}
+
+static void __init unpack_finish(void)
+{
+	unsigned int i;
+
+	if (!punpack.specs)
+		return;
+
+	WRITE_ONCE(punpack.stop, true);
+	async_synchronize_full_domain(&unpack_domain);
+	for (i = 0; i < punpack.nr_specs; i++)
+		unpack_free_chunks(&punpack.specs[i]);
+	kvfree(punpack.specs);
+	punpack.specs = NULL;
+	punpack.nr_specs = 0;
+}
+
+static long __init inline_flush(void *bufv, unsigned long len)
+{
+	unpack_stats.out_bytes += len;
+	return flush_buffer(bufv, len);
+}
+
 static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 {
 	long written;
 	decompress_fn decompress;
 	const char *compress_name;
 	static __initdata char msg_buf[64];
+	char *image = buf;
+	ktime_t start = ktime_get();
 
 	header_buf = kmalloc(110, GFP_KERNEL);
 	symlink_buf = kmalloc(PATH_MAX + N_ALIGN(PATH_MAX) + 1, GFP_KERNEL);
@@ -457,6 +866,7 @@ static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 	state = Start;
 	this_header = 0;
 	message = NULL;
+	unpack_start((unsigned char *)buf, len);
 	while (!message && len) {
 		loff_t saved_offset = this_header;
 		if (*buf == '0' && !(this_header & 3)) {
@@ -464,6 +874,7 @@ static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 			written = write_buffer(buf, len);
 			buf += written;
 			len -= written;
+			unpack_skip_specs(buf - image);
 			continue;
 		}
 		if (!*buf) {
@@ -476,10 +887,15 @@ static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 		decompress = decompress_method(buf, len, &compress_name);
 		pr_debug("Detected %s compressed data\n", compress_name);
 		if (decompress) {
-			int res = decompress(buf, len, NULL, flush_buffer, NULL,
-				   &my_inptr, error);
-			if (res)
-				error("decompressor failed");
+			unpack_stats.members++;
+			if (!unpack_replay(buf - image)) {
+				ktime_t t = ktime_get();
+				int res = decompress(buf, len, NULL, inline_flush,
+					   NULL, &my_inptr, error);
+				if (res)
+					error("decompressor failed");
+				unpack_stats.inline_ns += unpack_ns_since(t);
+			}
 		} else if (compress_name) {
 			if (!message) {
 				snprintf(msg_buf, sizeof msg_buf,
@@ -494,7 +910,18 @@ static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 		this_header = saved_offset + my_inptr;
 		buf += my_inptr;
 		len -= my_inptr;
+		unpack_skip_specs(buf - image);
 	}
+	unpack_finish();
+	if (unpack_stats.members)
+		pr_info("initramfs: unpacked %lu KiB from %u compressed members (%u on %u threads) in %llu us: scan %llu us, in-line %llu us, wait %llu us, replay %llu us\n",
+			unpack_stats.out_bytes >> 10, unpack_stats.members,
+			unpack_stats.replayed, punpack.nr_workers,
+			div_u64(unpack_ns_since(start), NSEC_PER_USEC),
+			div_u64(unpack_stats.scan_ns, NSEC_PER_USEC),
+			div_u64(unpack_stats.inline_ns, NSEC_PER_USEC),
+			div_u64(unpack_stats.wait_ns, NSEC_PER_USEC),
+			div_u64(unpack_stats.replay_ns, NSEC_PER_USEC));
 	dir_utime();
 	kfree(name_buf);
 	kfree(symlink_buf);
@@ -643,7 +1070,45 @@ static void __init populate_initrd_image(char *err)
 }
 #endif /* CONFIG_BLK_DEV_RAM */
 
-static int __init populate_rootfs(void)
+static bool initramfs_async __initdata = true;
+static int __init initramfs_async_setup(char *str)
+{
+	strtobool(str, &initramfs_async);
+	return 1;
+}
+__setup("initramfs_async=", initramfs_async_setup);
+
+static async_cookie_t initramfs_cookie;
+static ASYNC_DOMAIN_EXCLUSIVE(initramfs_domain);
+
+/*
+ * Unpacking runs asynchronously so that it overlaps with device and driver
+ * initcalls.  Anything that needs files from the initramfs (the console
+ * and init itself, usermode helpers, firmware loading) must call this
+ * first.
+ */
+void wait_for_initramfs(void)
+{
+	ktime_t start;
+
+	if (!initramfs_cookie) {
+		/*
+		 * Called before populate_rootfs(): nothing has been queued
+		 * yet and waiting would not make the files appear.
+		 */
+		pr_warn_once("wait_for_initramfs() called before rootfs_initcalls\n");
+		return;
+	}
+
+	start = ktime_get();
+	async_synchronize_cookie_domain(initramfs_cookie + 1, &initramfs_domain);
+	pr_debug("initramfs: %pS waited %lld us for unpacking\n",
+		 __builtin_return_address(0),
+		 ktime_us_delta(ktime_get(), start));
+}
+EXPORT_SYMBOL_GPL(wait_for_initramfs);
+
+static void __init do_populate_rootfs(void *unused, async_cookie_t cookie)
 {
 	/* Load the built in initramfs */
 	char *err = unpack_to_rootfs(__initramfs_start, __initramfs_size);
@@ -675,6 +1140,14 @@ static int __init populate_rootfs(void)
 	initrd_end = 0;
 
 	flush_delayed_fput();
+}
+
+static int __init populate_rootfs(void)
+{
+	initramfs_cookie = async_schedule_domain(do_populate_rootfs, NULL,
+						 &initramfs_domain);
+	if (!initramfs_async)
+		wait_for_initramfs();
 	return 0;
 }
 rootfs_initcall(populate_rootfs);
@@ -19,6 +19,7 @@
 #include <linux/mount.h>
 #include <linux/kernel.h>
 #include <linux/init.h>
+#include <linux/initrd.h>
 #include <linux/resource.h>
 #include <linux/notifier.h>
 #include <linux/suspend.h>
@@ -81,6 +82,9 @@ static int call_usermodehelper_exec_async(void *data)
 	 */
 	set_user_nice(current, 0);
 
+	/* The helper binary may live in an initramfs still being unpacked */
+	wait_for_initramfs();
+
 	retval = -ENOMEM;
 	new = prepare_kernel_cred(current);
 	if (!new)
@@ -4,6 +4,9 @@
  */
 
 #include <linux/dim.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/string.h>
 
 bool dim_on_top(struct dim *dim)
 {
@@ -81,3 +84,183 @@ void dim_calc_stats(struct dim_sample *start, struct dim_sample *end,
 
 }
 EXPORT_SYMBOL(dim_calc_stats);
+
+bool dim_decide(struct dim *dim, struct dim_stats *curr_stats,
+		const struct dim_algo *def, u8 nr_profiles)
+{
+	const struct dim_algo *algo = dim->algo ?: def;
+	bool changed = algo->decide(dim, curr_stats, nr_profiles);
+
+	dim->counters.decisions++;
+	if (changed)
+		dim->counters.profile_changes++;
+	return changed;
+}
+EXPORT_SYMBOL(dim_decide);
+
+static struct dim_algo *const dim_builtin_algos[] = {
+	&dim_net_algo,
+	&dim_rdma_algo,
+	&dim_lat_algo,
+};
+
+static LIST_HEAD(dim_algo_list);
+static DEFINE_MUTEX(dim_algo_mutex);
+
+static struct dim_algo *dim_find_algo(const char *name)
+{
+	struct dim_algo *algo;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dim_builtin_algos); i++)
+		if (!strcmp(dim_builtin_algos[i]->name, name))
+			return dim_builtin_algos[i];
+
+	list_for_each_entry(algo, &dim_algo_list, list)
+		if (!strcmp(algo->name, name))
+			return algo;
+
+	return NULL;
+}
+
+int dim_register_algo(struct dim_algo *algo)
+{
+	int ret = 0;
+
+	if (!algo->name || !algo->decide)
+		return -EINVAL;
+
+	mutex_lock(&dim_algo_mutex);
+	if (dim_find_algo(algo->name))
+		ret = -EEXIST;
+	else
+		list_add_tail(&algo->list, &dim_algo_list);
+	mutex_unlock(&dim_algo_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL(dim_register_algo);
+
+void dim_unregister_algo(struct dim_algo *algo)
+{
+	mutex_lock(&dim_algo_mutex);
+	list_del(&algo->list);
+	mutex_unlock(&dim_algo_mutex);
+}
+EXPORT_SYMBOL(dim_unregister_algo);
+
+void dim_put_algo(struct dim *dim)
+{
+	if (dim->algo)
+		module_put(dim->algo->owner);
+	dim->algo = NULL;
+}
+EXPORT_SYMBOL(dim_put_algo);
+
+int dim_set_algo(struct dim *dim, const char *name)
+{
+	struct dim_algo *algo = NULL;
+
+	if (name && *name) {
+		mutex_lock(&dim_algo_mutex);
+		algo = dim_find_algo(name);
+		if (algo && !try_module_get(algo->owner))
+			algo = NULL;
+		mutex_unlock(&dim_algo_mutex);
+		if (!algo)
+			return -ENOENT;
+	}
+
+	dim_put_algo(dim);
+	dim->algo = algo;
+
+	/*
+	 * The algorithms read the tuning state in their own way, e.g. the
+	 * latency algorithm parks with tired == 0 where net_dim expects a
+	 * countdown; start the new one afresh.
+	 */
+	dim->tune_state = DIM_PARKING_ON_TOP;
+	dim->steps_left = 0;
+	dim->steps_right = 0;
+	dim->tired = 0;
+	return 0;
+}
+EXPORT_SYMBOL(dim_set_algo);
+
+int dim_lat_enable(struct dim *dim, u32 target_us, gfp_t gfp)
+{
+	if (!dim->lat) {
+		dim->lat = kzalloc(sizeof(*dim->lat), gfp);
+		if (!dim->lat)
+			return -ENOMEM;
+	}
+	dim->lat->target_us = target_us;
+	return 0;
+}
+EXPORT_SYMBOL(dim_lat_enable);
+
+void dim_lat_disable(struct dim *dim)
+{
+	kfree(dim->lat);
+	dim->lat = NULL;
+}
+EXPORT_SYMBOL(dim_lat_disable);
+
+static u32 dim_lat_bucket_max(unsigned int ix)
+{
+	unsigned int shift;
+
+	if (ix < (1U << DIM_LAT_SUB_BITS))
+		return ix;
+	if (ix == DIM_LAT_BUCKETS - 1)
+		return U32_MAX;
+
+	shift = (ix >> DIM_LAT_SUB_BITS) - 1;
+	return ((((1U << DIM_LAT_SUB_BITS) +
+		  (ix & ((1U << DIM_LAT_SUB_BITS) - 1))) + 1) << shift) - 1;
+}
+
+u32 dim_lat_percentile(const struct dim_lat_hist *lat, unsigned int pct)
+{
+	u64 want = DIV_ROUND_UP_ULL((u64)lat->count * pct, 100);
+	u64 seen = 0;
+	unsigned int i;
+
+	if (!lat->count)
+		return 0;
+
+	for (i = 0; i < DIM_LAT_BUCKETS; i++) {
+		seen += lat->buckets[i];
+		if (seen >= want)
+			return dim_lat_bucket_max(i);
+	}
+	return U32_MAX;
+}
+EXPORT_SYMBOL(dim_lat_percentile);
+
+const char dim_stat_strings[DIM_STATS_NUM][DIM_STAT_STRING_LEN] = {
+	[DIM_STAT_PROFILE_IX]		= "dim_profile_ix",
+	[DIM_STAT_TUNE_STATE]		= "dim_tune_state",
+	[DIM_STAT_DECISIONS]		= "dim_decisions",
+	[DIM_STAT_PROFILE_CHANGES]	= "dim_profile_changes",
+	[DIM_STAT_EPMS]			= "dim_events_per_msec",
+	[DIM_STAT_CPMS]			= "dim_comps_per_msec",
+	[DIM_STAT_LAT_TARGET_US]	= "dim_lat_target_us",
+	[DIM_STAT_LAT_P99_US]		= "dim_lat_p99_us",
+	[DIM_STAT_LAT_VIOLATIONS]	= "dim_lat_violations",
+};
+EXPORT_SYMBOL(dim_stat_strings);
+
+void dim_get_stats(const struct dim *dim, u64 *data)
+{
+	data[DIM_STAT_PROFILE_IX] = dim->profile_ix;
+	data[DIM_STAT_TUNE_STATE] = dim->tune_state;
+	data[DIM_STAT_DECISIONS] = dim->counters.decisions;
+	data[DIM_STAT_PROFILE_CHANGES] = dim->counters.profile_changes;
+	data[DIM_STAT_EPMS] = dim->prev_stats.epms;
+	data[DIM_STAT_CPMS] = dim->prev_stats.cpms;
+	data[DIM_STAT_LAT_TARGET_US] = dim->lat ? dim->lat->target_us : 0;
+	data[DIM_STAT_LAT_P99_US] = dim->counters.last_p99_us;
+	data[DIM_STAT_LAT_VIOLATIONS] = dim->counters.lat_violations;
+}
+EXPORT_SYMBOL(dim_get_stats);
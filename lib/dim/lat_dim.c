@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0 OR Linux-OpenIB
+/*
+ * Latency-target DIM: use the highest moderation profile (fewest
+ * interrupts) whose p99 completion latency stays within the target set
+ * with dim_lat_enable().
+ *
+ * Moving right trades latency for fewer interrupts, so one step right is
+ * probed whenever the measured p99 leaves enough headroom.  A miss steps
+ * back left, or straight to the first profile when the target is missed
+ * by more than 2x.  A miss right after a probe doubles the number of
+ * iterations spent parked before the next probe (tracked in @tired, the
+ * countdown in @steps_left), so a profile just above the target is not
+ * retried every iteration.
+ *
+ * The p99 of a short iteration is little more than its maximum, and its
+ * noise alone would flip the profile back and forth.  So a decision waits
+ * for enough samples to make the p99 meaningful, and after every profile
+ * change the new profile is kept for a minimum number of iterations before
+ * the next probe; a probe only counts as held once that dwell is over.
+ */
+
+#include <linux/dim.h>
+
+/* probe right only while p99 is below this share of the target */
+#define DIM_LAT_HEADROOM_PCT	80
+/* iterations with fewer samples keep accumulating */
+#define DIM_LAT_MIN_SAMPLES	512
+/* at most 2^DIM_LAT_MAX_BACKOFF parked iterations between probes */
+#define DIM_LAT_MAX_BACKOFF	6
+/* parked iterations after any profile change before the next probe */
+#define DIM_LAT_MIN_DWELL	8
+
+static bool dim_lat_decide(struct dim *dim, struct dim_stats *curr_stats,
+			   u8 nr_profiles)
+{
+	struct dim_lat_hist *lat = dim->lat;
+	int prev_ix = dim->profile_ix;
+	u32 p99;
+
+	if (!lat || lat->count < DIM_LAT_MIN_SAMPLES)
+		return false;
+
+	p99 = dim_lat_percentile(lat, 99);
+	memset(lat->buckets, 0, sizeof(lat->buckets));
+	lat->count = 0;
+	dim->counters.last_p99_us = p99;
+	dim->prev_stats = *curr_stats;
+
+	if (p99 > lat->target_us) {
+		dim->counters.lat_violations++;
+		if (dim->tune_state == DIM_GOING_RIGHT &&
+		    dim->tired < DIM_LAT_MAX_BACKOFF)
+			dim->tired++;
+		if (p99 / 2 > lat->target_us)
+			dim->profile_ix = 0;
+		else if (dim->profile_ix)
+			dim->profile_ix--;
+		dim->tune_state = DIM_GOING_LEFT;
+		dim->steps_left = max(DIM_LAT_MIN_DWELL, 1 << dim->tired);
+		return dim->profile_ix != prev_ix;
+	}
+
+	/* a probe stays on trial until its dwell is over */
+	if (dim->steps_left) {
+		dim->steps_left--;
+		if (dim->tune_state != DIM_GOING_RIGHT)
+			dim->tune_state = DIM_PARKING_TIRED;
+		return false;
+	}
+
+	/* the last probe held: forget earlier misses */
+	if (dim->tune_state == DIM_GOING_RIGHT)
+		dim->tired = 0;
+
+	if ((u64)p99 * 100 < (u64)lat->target_us * DIM_LAT_HEADROOM_PCT &&
+	    dim->profile_ix < nr_profiles - 1) {
+		dim->profile_ix++;
+		dim->steps_right++;
+		dim->steps_left = DIM_LAT_MIN_DWELL;
+		dim->tune_state = DIM_GOING_RIGHT;
+	} else {
+		dim->tune_state = DIM_PARKING_ON_TOP;
+	}
+
+	return dim->profile_ix != prev_ix;
+}
+
+struct dim_algo dim_lat_algo = {
+	.name	= "latency",
+	.owner	= THIS_MODULE,
+	.decide	= dim_lat_decide,
+};
@@ -101,9 +101,9 @@ net_dim_get_def_tx_moderation(u8 cq_period_mode)
 }
 EXPORT_SYMBOL(net_dim_get_def_tx_moderation);
 
-static int net_dim_step(struct dim *dim)
+static int net_dim_step(struct dim *dim, u8 nr_profiles)
 {
-	if (dim->tired == (NET_DIM_PARAMS_NUM_PROFILES * 2))
+	if (dim->tired == (nr_profiles * 2))
 		return DIM_TOO_TIRED;
 
 	switch (dim->tune_state) {
@@ -111,7 +111,7 @@ static int net_dim_step(struct dim *dim)
 	case DIM_PARKING_TIRED:
 		break;
 	case DIM_GOING_RIGHT:
-		if (dim->profile_ix == (NET_DIM_PARAMS_NUM_PROFILES - 1))
+		if (dim->profile_ix >= (nr_profiles - 1))
 			return DIM_ON_EDGE;
 		dim->profile_ix++;
 		dim->steps_right++;
@@ -128,10 +128,10 @@ static int net_dim_step(struct dim *dim)
 	return DIM_STEPPED;
 }
 
-static void net_dim_exit_parking(struct dim *dim)
+static void net_dim_exit_parking(struct dim *dim, u8 nr_profiles)
 {
 	dim->tune_state = dim->profile_ix ? DIM_GOING_LEFT : DIM_GOING_RIGHT;
-	net_dim_step(dim);
+	net_dim_step(dim, nr_profiles);
 }
 
 static int net_dim_stats_compare(struct dim_stats *curr,
@@ -162,7 +162,8 @@ static int net_dim_stats_compare(struct dim_stats *curr,
 	return DIM_STATS_SAME;
 }
 
-static bool net_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
+static bool net_dim_decision(struct dim_stats *curr_stats, struct dim *dim,
+			     u8 nr_profiles)
 {
 	int prev_state = dim->tune_state;
 	int prev_ix = dim->profile_ix;
@@ -174,13 +175,13 @@ static bool net_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
 		stats_res = net_dim_stats_compare(curr_stats,
 						  &dim->prev_stats);
 		if (stats_res != DIM_STATS_SAME)
-			net_dim_exit_parking(dim);
+			net_dim_exit_parking(dim, nr_profiles);
 		break;
 
 	case DIM_PARKING_TIRED:
 		dim->tired--;
 		if (!dim->tired)
-			net_dim_exit_parking(dim);
+			net_dim_exit_parking(dim, nr_profiles);
 		break;
 
 	case DIM_GOING_RIGHT:
@@ -195,7 +196,7 @@ static bool net_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
 			break;
 		}
 
-		step_res = net_dim_step(dim);
+		step_res = net_dim_step(dim, nr_profiles);
 		switch (step_res) {
 		case DIM_ON_EDGE:
 			dim_park_on_top(dim);
@@ -215,6 +216,18 @@ static bool net_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
 	return dim->profile_ix != prev_ix;
 }
 
+static bool net_dim_algo_decide(struct dim *dim, struct dim_stats *curr_stats,
+				u8 nr_profiles)
+{
+	return net_dim_decision(curr_stats, dim, nr_profiles);
+}
+
+struct dim_algo dim_net_algo = {
+	.name	= "net",
+	.owner	= THIS_MODULE,
+	.decide	= net_dim_algo_decide,
+};
+
 void net_dim(struct dim *dim, struct dim_sample end_sample)
 {
 	struct dim_stats curr_stats;
@@ -228,7 +241,8 @@ void net_dim(struct dim *dim, struct dim_sample end_sample)
 		if (nevents < DIM_NEVENTS)
 			break;
 		dim_calc_stats(&dim->start_sample, &end_sample, &curr_stats);
-		if (net_dim_decision(&curr_stats, dim)) {
+		if (dim_decide(dim, &curr_stats, &dim_net_algo,
+			       NET_DIM_PARAMS_NUM_PROFILES)) {
 			dim->state = DIM_APPLY_NEW_PROFILE;
 			schedule_work(&dim->work);
 			break;
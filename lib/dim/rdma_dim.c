@@ -5,10 +5,10 @@
 
 #include <linux/dim.h>
 
-static int rdma_dim_step(struct dim *dim)
+static int rdma_dim_step(struct dim *dim, u8 nr_profiles)
 {
 	if (dim->tune_state == DIM_GOING_RIGHT) {
-		if (dim->profile_ix == (RDMA_DIM_PARAMS_NUM_PROFILES - 1))
+		if (dim->profile_ix == (nr_profiles - 1))
 			return DIM_ON_EDGE;
 		dim->profile_ix++;
 		dim->steps_right++;
@@ -41,7 +41,8 @@ static int rdma_dim_stats_compare(struct dim_stats *curr,
 	return DIM_STATS_SAME;
 }
 
-static bool rdma_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
+static bool rdma_dim_decision(struct dim_stats *curr_stats, struct dim *dim,
+			      u8 nr_profiles)
 {
 	int prev_ix = dim->profile_ix;
 	u8 state = dim->tune_state;
@@ -61,7 +62,7 @@ static bool rdma_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
 			dim_turn(dim);
 			/* fall through */
 		case DIM_STATS_BETTER:
-			step_res = rdma_dim_step(dim);
+			step_res = rdma_dim_step(dim, nr_profiles);
 			if (step_res == DIM_ON_EDGE)
 				dim_turn(dim);
 			break;
@@ -73,7 +74,19 @@ static bool rdma_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
 	return dim->profile_ix != prev_ix;
 }
 
-void rdma_dim(struct dim *dim, u64 completions)
+static bool rdma_dim_algo_decide(struct dim *dim, struct dim_stats *curr_stats,
+				 u8 nr_profiles)
+{
+	return rdma_dim_decision(curr_stats, dim, nr_profiles);
+}
+
+struct dim_algo dim_rdma_algo = {
+	.name	= "rdma",
+	.owner	= THIS_MODULE,
+	.decide	= rdma_dim_algo_decide,
+};
+
+void dim_run_comps(struct dim *dim, u64 completions, u8 nr_profiles)
 {
 	struct dim_sample *curr_sample = &dim->measuring_sample;
 	struct dim_stats curr_stats;
@@ -89,7 +102,7 @@ void rdma_dim(struct dim *dim, u64 completions)
 		if (nevents < DIM_NEVENTS)
 			break;
 		dim_calc_stats(&dim->start_sample, curr_sample, &curr_stats);
-		if (rdma_dim_decision(&curr_stats, dim)) {
+		if (dim_decide(dim, &curr_stats, &dim_rdma_algo, nr_profiles)) {
 			dim->state = DIM_APPLY_NEW_PROFILE;
 			schedule_work(&dim->work);
 			break;
@@ -105,4 +118,10 @@ void rdma_dim(struct dim *dim, u64 completions)
 		break;
 	}
 }
+EXPORT_SYMBOL(dim_run_comps);
+
+void rdma_dim(struct dim *dim, u64 completions)
+{
+	dim_run_comps(dim, completions, RDMA_DIM_PARAMS_NUM_PROFILES);
+}
 EXPORT_SYMBOL(rdma_dim);
@@ -77,7 +77,9 @@ static FORCE_INLINE int LZ4_decompress_generic(
 	 /* only if dict == usingExtDict */
 	 const BYTE * const dictStart,
 	 /* note : = 0 if noDict */
-	 const size_t dictSize
+	 const size_t dictSize,
+	 /* wildCopy8, wildCopy32 */
+	 wildCopy_directive wideCopy
 	 )
 {
 	const BYTE *ip = (const BYTE *) src;
@@ -268,8 +270,18 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			if (!partialDecoding || (cpy == oend))
 				break;
 		} else {
-			/* may overwrite up to WILDCOPYLENGTH beyond cpy */
-			LZ4_wildCopy(op, ip, cpy);
+			/*
+			 * Long literal runs well clear of both buffer ends
+			 * take the wide copy; near the ends fall back to
+			 * the 8-byte one, which may overwrite up to
+			 * WILDCOPYLENGTH beyond cpy.
+			 */
+			if ((wideCopy) && (endOnInput) && length > 16 &&
+			    cpy <= oend - WILDCOPYLENGTH32 &&
+			    ip + length <= iend - WILDCOPYLENGTH32)
+				LZ4_wildCopy32(op, ip, cpy);
+			else
+				LZ4_wildCopy(op, ip, cpy);
 			ip += length;
 			op = cpy;
 		}
@@ -426,8 +438,13 @@ static FORCE_INLINE int LZ4_decompress_generic(
 				*op++ = *match++;
 		} else {
 			LZ4_copy8(op, match);
-			if (length > 16)
-				LZ4_wildCopy(op + 8, match + 8, cpy);
+			if (length > 16) {
+				if ((wideCopy) &&
+				    cpy <= oend - WILDCOPYLENGTH32)
+					LZ4_wildCopy32(op + 8, match + 8, cpy);
+				else
+					LZ4_wildCopy(op + 8, match + 8, cpy);
+			}
 		}
 		op = cpy; /* wildcopy correction */
 	}
@@ -452,7 +469,8 @@ int LZ4_decompress_safe(const char *source, char *dest,
 	return LZ4_decompress_generic(source, dest,
 				      compressedSize, maxDecompressedSize,
 				      endOnInputSize, decode_full_block,
-				      noDict, (BYTE *)dest, NULL, 0);
+				      noDict, (BYTE *)dest, NULL, 0,
+				      wildCopy32);
 }
 
 int LZ4_decompress_safe_partial(const char *src, char *dst,
@@ -461,7 +479,8 @@ int LZ4_decompress_safe_partial(const char *src, char *dst,
 	dstCapacity = min(targetOutputSize, dstCapacity);
 	return LZ4_decompress_generic(src, dst, compressedSize, dstCapacity,
 				      endOnInputSize, partial_decode,
-				      noDict, (BYTE *)dst, NULL, 0);
+				      noDict, (BYTE *)dst, NULL, 0,
+				      wildCopy32);
 }
 
 int LZ4_decompress_fast(const char *source, char *dest, int originalSize)
@@ -469,7 +488,8 @@ int LZ4_decompress_fast(const char *source, char *dest, int originalSize)
 	return LZ4_decompress_generic(source, dest, 0, originalSize,
 				      endOnOutputSize, decode_full_block,
 				      withPrefix64k,
-				      (BYTE *)dest - 64 * KB, NULL, 0);
+				      (BYTE *)dest - 64 * KB, NULL, 0,
+				      wildCopy32);
 }
 
 /* ===== Instantiate a few more decoding cases, used more than once. ===== */
@@ -481,7 +501,8 @@ int LZ4_decompress_safe_withPrefix64k(const char *source, char *dest,
 				      compressedSize, maxOutputSize,
 				      endOnInputSize, decode_full_block,
 				      withPrefix64k,
-				      (BYTE *)dest - 64 * KB, NULL, 0);
+				      (BYTE *)dest - 64 * KB, NULL, 0,
+				      wildCopy32);
 }
 
 static int LZ4_decompress_safe_withSmallPrefix(const char *source, char *dest,
@@ -493,7 +514,8 @@ static int LZ4_decompress_safe_withSmallPrefix(const char *source, char *dest,
 				      compressedSize, maxOutputSize,
 				      endOnInputSize, decode_full_block,
 				      noDict,
-				      (BYTE *)dest - prefixSize, NULL, 0);
+				      (BYTE *)dest - prefixSize, NULL, 0,
+				      wildCopy32);
 }
 
 int LZ4_decompress_safe_forceExtDict(const char *source, char *dest,
@@ -504,7 +526,8 @@ int LZ4_decompress_safe_forceExtDict(const char *source, char *dest,
 				      compressedSize, maxOutputSize,
 				      endOnInputSize, decode_full_block,
 				      usingExtDict, (BYTE *)dest,
-				      (const BYTE *)dictStart, dictSize);
+				      (const BYTE *)dictStart, dictSize,
+				      wildCopy32);
 }
 
 static int LZ4_decompress_fast_extDict(const char *source, char *dest,
@@ -515,7 +538,8 @@ static int LZ4_decompress_fast_extDict(const char *source, char *dest,
 				      0, originalSize,
 				      endOnOutputSize, decode_full_block,
 				      usingExtDict, (BYTE *)dest,
-				      (const BYTE *)dictStart, dictSize);
+				      (const BYTE *)dictStart, dictSize,
+				      wildCopy32);
 }
 
 /*
@@ -533,7 +557,8 @@ int LZ4_decompress_safe_doubleDict(const char *source, char *dest,
 				      compressedSize, maxOutputSize,
 				      endOnInputSize, decode_full_block,
 				      usingExtDict, (BYTE *)dest - prefixSize,
-				      (const BYTE *)dictStart, dictSize);
+				      (const BYTE *)dictStart, dictSize,
+				      wildCopy32);
 }
 
 static FORCE_INLINE
@@ -545,7 +570,8 @@ int LZ4_decompress_fast_doubleDict(const char *source, char *dest,
 				      0, originalSize,
 				      endOnOutputSize, decode_full_block,
 				      usingExtDict, (BYTE *)dest - prefixSize,
-				      (const BYTE *)dictStart, dictSize);
+				      (const BYTE *)dictStart, dictSize,
+				      wildCopy32);
 }
 
 /* ===== streaming decompression functions ===== */
@@ -694,6 +720,23 @@ int LZ4_decompress_fast_usingDict(const char *source, char *dest,
 		dictStart, dictSize);
 }
 
+#if !defined(STATIC) && IS_ENABLED(CONFIG_TEST_LZ4)
+/*
+ * LZ4_decompress_safe() restricted to the 8-byte wild copies, for
+ * lib/test_lz4.c to measure the wide copies against.
+ */
+int LZ4_decompress_safe_wildCopy8(const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize)
+{
+	return LZ4_decompress_generic(source, dest,
+				      compressedSize, maxDecompressedSize,
+				      endOnInputSize, decode_full_block,
+				      noDict, (BYTE *)dest, NULL, 0,
+				      wildCopy8);
+}
+EXPORT_SYMBOL_GPL(LZ4_decompress_safe_wildCopy8);
+#endif
+
 #ifndef STATIC
 EXPORT_SYMBOL(LZ4_decompress_safe);
 EXPORT_SYMBOL(LZ4_decompress_safe_partial);
@@ -81,6 +81,13 @@ typedef uintptr_t uptrval;
  */
 #define MATCH_SAFEGUARD_DISTANCE  ((2 * WILDCOPYLENGTH) - MINMATCH)
 
+/*
+ * LZ4_wildCopy32() may write up to this many bytes beyond its end pointer
+ * and read as many beyond the matching source position; the decoder only
+ * takes it when that much slack is left in both buffers.
+ */
+#define WILDCOPYLENGTH32 32
+
 /* Increase this value ==> compression run slower on incompressible data */
 #define LZ4_SKIPTRIGGER 6
 
@@ -170,6 +177,30 @@ static FORCE_INLINE void LZ4_wildCopy(void *dstPtr,
 	} while (d < e);
 }
 
+/*
+ * wide variant of LZ4_wildCopy(), moving 32 bytes per iteration,
+ * which can overwrite up to 31 bytes beyond dstEnd.
+ * Each 8-byte word is loaded and stored before the next one is loaded,
+ * so overlapping copies behave exactly as with LZ4_wildCopy() and only
+ * need an offset of at least 8.
+ */
+static FORCE_INLINE void LZ4_wildCopy32(void *dstPtr,
+	const void *srcPtr, void *dstEnd)
+{
+	BYTE *d = (BYTE *)dstPtr;
+	const BYTE *s = (const BYTE *)srcPtr;
+	BYTE *const e = (BYTE *)dstEnd;
+
+	do {
+		LZ4_copy8(d, s);
+		LZ4_copy8(d + 8, s + 8);
+		LZ4_copy8(d + 16, s + 16);
+		LZ4_copy8(d + 24, s + 24);
+		d += 32;
+		s += 32;
+	} while (d < e);
+}
+
 static FORCE_INLINE unsigned int LZ4_NbCommonBytes(register size_t val)
 {
 #if LZ4_LITTLE_ENDIAN
@@ -228,6 +259,7 @@ typedef enum { noDictIssue = 0, dictSmall } dictIssue_directive;
 
 typedef enum { endOnOutputSize = 0, endOnInputSize = 1 } endCondition_directive;
 typedef enum { decode_full_block = 0, partial_decode = 1 } earlyEnd_directive;
+typedef enum { wildCopy8 = 0, wildCopy32 = 1 } wildCopy_directive;
 
 #define LZ4_STATIC_ASSERT(c)	BUILD_BUG_ON(!(c))
 
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Test and benchmark module for the LZ4 decompressor.
+ *
+ * Round-trips a few representative corpora through LZ4_compress_default()
+ * and the safe/fast/partial decoders, feeds bit-flipped streams to the safe
+ * decoder checking it never writes past the output capacity, and reports
+ * decompression throughput per corpus with and without the wide copies.
+ */
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/lz4.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+#define TEST_LZ4_MAX	65536
+#define TEST_LZ4_GUARD	64
+#define TEST_LZ4_POISON	0x5a
+#define TEST_LZ4_BLOCK	4096
+#define TEST_LZ4_NBLOCK	64
+
+static unsigned int fuzz_rounds = 64;
+module_param(fuzz_rounds, uint, 0444);
+MODULE_PARM_DESC(fuzz_rounds, "Corrupted streams decoded per buffer");
+
+static unsigned int bench_iters = 200;
+module_param(bench_iters, uint, 0444);
+MODULE_PARM_DESC(bench_iters, "Passes over the benchmark blocks (0 disables)");
+
+enum test_lz4_corpus {
+	CORPUS_TEXT,
+	CORPUS_RANDOM,
+	CORPUS_ZERO,
+	CORPUS_MIXED,
+	CORPUS_MAX,
+};
+
+static const char * const corpus_names[CORPUS_MAX] = {
+	[CORPUS_TEXT]	= "text",
+	[CORPUS_RANDOM]	= "random",
+	[CORPUS_ZERO]	= "zero",
+	[CORPUS_MIXED]	= "mixed",
+};
+
+static const char * const words[] = {
+	"the ", "kernel ", "page ", "struct ", "return ", "\n\t", "static ",
+	"int ", "buffer ", "{", "}", "; ", "lock ", "0x", "unsigned long ",
+};
+
+static u32 rnd_state;
+
+static u32 test_lz4_rand(void)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return rnd_state >> 8;
+}
+
+static int fill_words(char *buf, int pos, int len)
+{
+	const char *w = words[test_lz4_rand() % ARRAY_SIZE(words)];
+
+	while (*w && pos < len)
+		buf[pos++] = *w++;
+	return pos;
+}
+
+static void fill_corpus(char *buf, int len, enum test_lz4_corpus kind)
+{
+	int i = 0;
+
+	switch (kind) {
+	case CORPUS_TEXT:
+		while (i < len)
+			i = fill_words(buf, i, len);
+		break;
+	case CORPUS_RANDOM:
+		for (; i < len; i++)
+			buf[i] = test_lz4_rand();
+		break;
+	case CORPUS_ZERO:
+		memset(buf, 0, len);
+		break;
+	case CORPUS_MIXED:
+		while (i < len) {
+			if ((i / 512) & 1)
+				buf[i++] = test_lz4_rand();
+			else
+				i = fill_words(buf, i, len);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+struct test_lz4_bufs {
+	char *src;
+	char *comp;
+	char *dst;
+	void *wrkmem;
+};
+
+static bool guard_intact(const char *dst, int cap)
+{
+	int i;
+
+	for (i = cap; i < cap + TEST_LZ4_GUARD; i++)
+		if (dst[i] != TEST_LZ4_POISON)
+			return false;
+	return true;
+}
+
+static int __init test_lz4_roundtrip(struct test_lz4_bufs *b,
+				     enum test_lz4_corpus kind, int len)
+{
+	int clen, ret, target, i;
+
+	fill_corpus(b->src, len, kind);
+	clen = LZ4_compress_default(b->src, b->comp, len,
+				    LZ4_compressBound(TEST_LZ4_MAX), b->wrkmem);
+	if (clen <= 0) {
+		pr_err("%s/%d: compression failed\n", corpus_names[kind], len);
+		return -EINVAL;
+	}
+
+	memset(b->dst, TEST_LZ4_POISON, len + TEST_LZ4_GUARD);
+	ret = LZ4_decompress_safe(b->comp, b->dst, clen, len);
+	if (ret != len || memcmp(b->dst, b->src, len) ||
+	    !guard_intact(b->dst, len)) {
+		pr_err("%s/%d: safe decode mismatch (%d)\n",
+		       corpus_names[kind], len, ret);
+		return -EINVAL;
+	}
+
+	memset(b->dst, TEST_LZ4_POISON, len + TEST_LZ4_GUARD);
+	ret = LZ4_decompress_safe_wildCopy8(b->comp, b->dst, clen, len);
+	if (ret != len || memcmp(b->dst, b->src, len) ||
+	    !guard_intact(b->dst, len)) {
+		pr_err("%s/%d: wildCopy8 decode mismatch (%d)\n",
+		       corpus_names[kind], len, ret);
+		return -EINVAL;
+	}
+
+	memset(b->dst, TEST_LZ4_POISON, len + TEST_LZ4_GUARD);
+	ret = LZ4_decompress_fast(b->comp, b->dst, len);
+	if (ret != clen || memcmp(b->dst, b->src, len)) {
+		pr_err("%s/%d: fast decode mismatch (%d)\n",
+		       corpus_names[kind], len, ret);
+		return -EINVAL;
+	}
+
+	target = len / 2;
+	memset(b->dst, TEST_LZ4_POISON, len + TEST_LZ4_GUARD);
+	ret = LZ4_decompress_safe_partial(b->comp, b->dst, clen, target, len);
+	if (ret < target || ret > len || memcmp(b->dst, b->src, ret)) {
+		pr_err("%s/%d: partial decode mismatch (%d)\n",
+		       corpus_names[kind], len, ret);
+		return -EINVAL;
+	}
+
+	/*
+	 * Corrupted streams may decode to anything or fail, but must never
+	 * write beyond the capacity handed to the decoder.
+	 */
+	for (i = 0; i < fuzz_rounds; i++) {
+		int flips = 1 + test_lz4_rand() % 4;
+		int cap = len;
+		char saved[4];
+		int pos[4];
+		int j;
+
+		if (test_lz4_rand() & 1)
+			cap -= test_lz4_rand() % (len + 1);
+
+		for (j = 0; j < flips; j++) {
+			pos[j] = test_lz4_rand() % clen;
+			saved[j] = b->comp[pos[j]];
+			b->comp[pos[j]] ^= 1 << (test_lz4_rand() % 8);
+		}
+
+		memset(b->dst, TEST_LZ4_POISON, len + TEST_LZ4_GUARD);
+		ret = LZ4_decompress_safe(b->comp, b->dst, clen, cap);
+
+		for (j = flips - 1; j >= 0; j--)
+			b->comp[pos[j]] = saved[j];
+
+		if (ret > cap || !guard_intact(b->dst, cap)) {
+			pr_err("%s/%d: corrupted stream overran capacity %d (%d)\n",
+			       corpus_names[kind], len, cap, ret);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+typedef int (*test_lz4_decode_t)(const char *source, char *dest,
+				 int compressedSize, int maxDecompressedSize);
+
+/* Returns the MB/s of @decode over the benchmark blocks. */
+static u64 __init test_lz4_time(struct test_lz4_bufs *b, const int *clen,
+				test_lz4_decode_t decode)
+{
+	int bound = LZ4_compressBound(TEST_LZ4_BLOCK);
+	u64 bytes = 0, ns;
+	ktime_t start;
+	unsigned int it;
+	int i;
+
+	start = ktime_get();
+	for (it = 0; it < bench_iters; it++) {
+		for (i = 0; i < TEST_LZ4_NBLOCK; i++) {
+			int ret = decode(b->comp + i * bound, b->dst, clen[i],
+					 TEST_LZ4_BLOCK);
+			if (ret > 0)
+				bytes += ret;
+		}
+		cond_resched();
+	}
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	return ns ? div64_u64(bytes * 1000, ns) : 0;
+}
+
+static void __init test_lz4_bench(struct test_lz4_bufs *b,
+				  enum test_lz4_corpus kind)
+{
+	int clen[TEST_LZ4_NBLOCK];
+	int bound = LZ4_compressBound(TEST_LZ4_BLOCK);
+	u64 narrow, wide;
+	int i;
+
+	for (i = 0; i < TEST_LZ4_NBLOCK; i++) {
+		fill_corpus(b->src + i * TEST_LZ4_BLOCK, TEST_LZ4_BLOCK, kind);
+		clen[i] = LZ4_compress_default(b->src + i * TEST_LZ4_BLOCK,
+					       b->comp + i * bound,
+					       TEST_LZ4_BLOCK, bound, b->wrkmem);
+		if (clen[i] <= 0)
+			return;
+	}
+
+	/* the same blocks through the 8-byte copies and the wide ones */
+	narrow = test_lz4_time(b, clen, LZ4_decompress_safe_wildCopy8);
+	wide = test_lz4_time(b, clen, LZ4_decompress_safe);
+
+	pr_info("%-6s: wildCopy8 %llu MB/s, wildCopy32 %llu MB/s\n",
+		corpus_names[kind], narrow, wide);
+}
+
+static int __init test_lz4_init(void)
+{
+	struct test_lz4_bufs b = {};
+	int kind, len, err = -ENOMEM;
+	int comp_size = max(LZ4_compressBound(TEST_LZ4_MAX),
+			    TEST_LZ4_NBLOCK *
+			    LZ4_compressBound(TEST_LZ4_BLOCK));
+
+	b.src = vmalloc(max(TEST_LZ4_MAX, TEST_LZ4_NBLOCK * TEST_LZ4_BLOCK));
+	b.comp = vmalloc(comp_size);
+	b.dst = vmalloc(TEST_LZ4_MAX + TEST_LZ4_GUARD);
+	b.wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+	if (!b.src || !b.comp || !b.dst || !b.wrkmem)
+		goto out;
+
+	rnd_state = get_random_u32();
+	pr_info("seed %u\n", rnd_state);
+
+	for (kind = 0; kind < CORPUS_MAX; kind++) {
+		for (len = 1; len <= TEST_LZ4_MAX;
+		     len = len < 64 ? len + 1 : len * 2 + test_lz4_rand() % 7) {
+			err = test_lz4_roundtrip(&b, kind, len);
+			if (err)
+				goto out;
+		}
+	}
+	pr_info("all tests passed\n");
+
+	if (bench_iters)
+		for (kind = 0; kind < CORPUS_MAX; kind++)
+			test_lz4_bench(&b, kind);
+	err = 0;
+out:
+	vfree(b.wrkmem);
+	vfree(b.dst);
+	vfree(b.comp);
+	vfree(b.src);
+	return err;
+}
+
+static void __exit test_lz4_exit(void)
+{
+}
+
+module_init(test_lz4_init);
+module_exit(test_lz4_exit);
+
+MODULE_DESCRIPTION("LZ4 decompressor test and benchmark");
+MODULE_LICENSE("GPL");
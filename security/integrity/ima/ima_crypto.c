@@ -20,7 +20,9 @@
 #include <linux/scatterlist.h>
 #include <linux/err.h>
 #include <linux/slab.h>
+#include <linux/ktime.h>
 #include <crypto/hash.h>
+#include <crypto/hash_batch.h>
 
 #include "ima.h"
 
@@ -29,6 +31,9 @@ static unsigned long ima_ahash_minsize;
 module_param_named(ahash_minsize, ima_ahash_minsize, ulong, 0644);
 MODULE_PARM_DESC(ahash_minsize, "Minimum file size for ahash use");
 
+/* time spent hashing files and buffers, shown in debugfs hash_batch/stats */
+static DEFINE_CRYPTO_HASH_BATCH_STATS(ima_hash_stats, "ima");
+
 /* default is 0 - 1 page. */
 static int ima_maxorder;
 static unsigned int ima_bufsize = PAGE_SIZE;
@@ -72,6 +77,7 @@ int __init ima_init_crypto(void)
 	}
 	pr_info("Allocated hash algorithm: %s\n",
 		hash_algo_name[ima_hash_algo]);
+	crypto_hash_batch_stats_register(&ima_hash_stats);
 	return 0;
 }
 
@@ -408,7 +414,9 @@ static int ima_calc_file_shash(struct file *file, struct ima_digest_data *hash)
  */
 int ima_calc_file_hash(struct file *file, struct ima_digest_data *hash)
 {
+	enum crypto_hash_batch_impl impl = CRYPTO_HASH_BATCH_SYNC;
 	loff_t i_size;
+	u64 start;
 	int rc;
 	struct file *f = file;
 	bool new_file_instance = false, modified_mode = false;
@@ -444,15 +452,21 @@ int ima_calc_file_hash(struct file *file, struct ima_digest_data *hash)
 	}
 
 	i_size = i_size_read(file_inode(f));
+	start = ktime_get_ns();
 
 	if (ima_ahash_minsize && i_size >= ima_ahash_minsize) {
 		rc = ima_calc_file_ahash(f, hash);
-		if (!rc)
+		if (!rc) {
+			impl = CRYPTO_HASH_BATCH_ASYNC;
 			goto out;
+		}
 	}
 
 	rc = ima_calc_file_shash(f, hash);
 out:
+	if (!rc)
+		crypto_hash_batch_account(&ima_hash_stats, impl, 1, i_size,
+					  ktime_get_ns() - start);
 	if (new_file_instance)
 		fput(f);
 	else if (modified_mode)
@@ -634,15 +648,24 @@ static int calc_buffer_shash(const void *buf, loff_t len,
 int ima_calc_buffer_hash(const void *buf, loff_t len,
 			 struct ima_digest_data *hash)
 {
+	enum crypto_hash_batch_impl impl = CRYPTO_HASH_BATCH_SYNC;
+	u64 start = ktime_get_ns();
 	int rc;
 
 	if (ima_ahash_minsize && len >= ima_ahash_minsize) {
 		rc = calc_buffer_ahash(buf, len, hash);
-		if (!rc)
-			return 0;
+		if (!rc) {
+			impl = CRYPTO_HASH_BATCH_ASYNC;
+			goto out;
+		}
 	}
 
-	return calc_buffer_shash(buf, len, hash);
+	rc = calc_buffer_shash(buf, len, hash);
+out:
+	if (!rc)
+		crypto_hash_batch_account(&ima_hash_stats, impl, 1, len,
+					  ktime_get_ns() - start);
+	return rc;
 }
 
 static void ima_pcrread(u32 idx, struct tpm_digest *d)
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_KERNEL_H
+#define _LINUX_KERNEL_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int64_t s64;
+typedef unsigned int gfp_t;
+typedef s64 ktime_t;
+
+#define GFP_KERNEL		0
+#define U8_MAX			((u8)~0U)
+#define U32_MAX			((u32)~0U)
+#define USEC_PER_MSEC		1000L
+#define NSEC_PER_USEC		1000L
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define BITS_PER_TYPE(t)	(sizeof(t) * 8)
+#define BIT_ULL(n)		(1ULL << (n))
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+#define DIV_ROUND_UP_ULL(n, d)	DIV_ROUND_UP((unsigned long long)(n), (d))
+#define DIV_ROUND_DOWN_ULL(n, d) ((unsigned long long)(n) / (d))
+#define min_t(t, a, b)		((t)(a) < (t)(b) ? (t)(a) : (t)(b))
+#define min(a, b)		((a) < (b) ? (a) : (b))
+#define max(a, b)		((a) > (b) ? (a) : (b))
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+/* DIM only reads the clock; the simulation drives it */
+extern ktime_t sim_now_ns;
+
+static inline ktime_t ktime_get(void)
+{
+	return sim_now_ns;
+}
+
+static inline s64 ktime_us_delta(ktime_t later, ktime_t earlier)
+{
+	return (later - earlier) / 1000;
+}
+
+struct work_struct {
+	void (*func)(struct work_struct *work);
+	bool pending;
+};
+
+static inline bool schedule_work(struct work_struct *work)
+{
+	work->pending = true;
+	return true;
+}
+
+#endif
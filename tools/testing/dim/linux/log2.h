@@ -0,0 +1,7 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_LOG2_H
+#define _LINUX_LOG2_H
+
+#define ilog2(n)	(31 - __builtin_clz(n))
+
+#endif
@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_SLAB_H
+#define _LINUX_SLAB_H
+
+#include <linux/kernel.h>
+
+#define kzalloc(size, gfp)	calloc(1, size)
+#define kfree(p)		free(p)
+
+#endif
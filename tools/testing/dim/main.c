@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Userspace simulation of a completion queue under adaptive interrupt
+ * coalescing, driving the DIM algorithms from lib/dim.
+ *
+ * Requests arrive as a Poisson process and complete after a base service
+ * time plus exponential jitter.  The simulated controller raises an
+ * interrupt once a profile's completion threshold is reached or its
+ * aggregation time has passed since the first pending completion, the
+ * way NVMe interrupt coalescing works.  Every interrupt feeds DIM, and
+ * profile changes take effect after a short apply delay.
+ */
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <linux/dim.h>
+
+ktime_t sim_now_ns;
+
+/* aggregation time in usec and completion threshold */
+static const struct {
+	u32 time_us;
+	u32 thr;
+} profiles[] = {
+	{ 0, 1 },
+	{ 100, 4 },
+	{ 100, 8 },
+	{ 200, 16 },
+	{ 400, 32 },
+};
+#define NR_PROFILES	ARRAY_SIZE(profiles)
+
+#define APPLY_DELAY_NS	20000
+#define IRQ_COST_NS	2000
+
+struct sim_result {
+	u64 irqs;
+	u64 comps;
+	u32 p99_us;
+	u32 changes;
+};
+
+static unsigned int rnd_state = 1;
+
+static double sim_rand(void)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return ((rnd_state >> 1) + 1.0) / 2147483649.0;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+struct req {
+	u64 submit;
+	u64 done;
+};
+
+static int cmp_req(const void *a, const void *b)
+{
+	return cmp_u64(&((const struct req *)a)->done,
+		       &((const struct req *)b)->done);
+}
+
+/*
+ * Simulate @n requests at @iops.  With @algo NULL the profile stays at
+ * @fixed_ix.  Latencies of the second half of the run (after DIM had time
+ * to converge) are used for the reported p99.
+ */
+static struct sim_result simulate(const char *algo, int fixed_ix,
+				  unsigned int iops, unsigned int n,
+				  u32 target_us)
+{
+	struct req *reqs = calloc(n, sizeof(*reqs));
+	u64 *lat = calloc(n, sizeof(*lat));
+	struct sim_result res = { 0 };
+	struct dim dim = { 0 };
+	unsigned int i, first = 0, pending = 0, nlat = 0;
+	u64 t = 0, first_done = 0, apply_at = 0;
+	int ix = fixed_ix;
+
+	assert(reqs && lat);
+	if (algo) {
+		assert(!dim_set_algo(&dim, algo));
+		if (target_us)
+			assert(!dim_lat_enable(&dim, target_us, GFP_KERNEL));
+		ix = dim.profile_ix;
+	}
+
+	for (i = 0; i < n; i++) {
+		t += -log(sim_rand()) * 1e9 / iops;
+		reqs[i].submit = t;
+		reqs[i].done = t + 80000 - log(sim_rand()) * 20000;
+	}
+	qsort(reqs, n, sizeof(*reqs), cmp_req);
+
+	i = 0;
+	while (i < n || pending) {
+		u64 next = i < n ? reqs[i].done : ~0ULL;
+		u64 deadline = ~0ULL;
+		u64 irq_at = 0;
+		unsigned int j;
+
+		if (pending)
+			deadline = first_done + profiles[ix].time_us * 1000ULL;
+
+		if (apply_at && apply_at <= min(next, deadline)) {
+			ix = dim.profile_ix;
+			dim.state = DIM_START_MEASURE;
+			dim.work.pending = false;
+			apply_at = 0;
+			res.changes++;
+			continue;
+		}
+
+		if (deadline < next) {
+			irq_at = deadline;
+		} else {
+			if (!pending++) {
+				first = i;
+				first_done = next;
+			}
+			i++;
+			if (pending >= profiles[ix].thr || !profiles[ix].time_us)
+				irq_at = next;
+		}
+		if (!irq_at)
+			continue;
+
+		sim_now_ns = irq_at;
+		for (j = first; j < first + pending; j++) {
+			u64 l = irq_at + IRQ_COST_NS - reqs[j].submit;
+
+			dim_lat_record(&dim, l / 1000);
+			if (j >= n / 2)
+				lat[nlat++] = l;
+		}
+		res.irqs++;
+		res.comps += pending;
+		if (algo) {
+			dim_run_comps(&dim, pending, NR_PROFILES);
+			if (dim.work.pending && !apply_at)
+				apply_at = irq_at + APPLY_DELAY_NS;
+		}
+		pending = 0;
+	}
+
+	qsort(lat, nlat, sizeof(*lat), cmp_u64);
+	res.p99_us = nlat ? lat[nlat * 99 / 100] / 1000 : 0;
+	dim_lat_disable(&dim);
+	dim_put_algo(&dim);
+	free(lat);
+	free(reqs);
+	return res;
+}
+
+static void test_histogram(void)
+{
+	struct dim dim = { 0 };
+	u32 v, p;
+
+	assert(!dim_lat_enable(&dim, 100, GFP_KERNEL));
+	for (v = 0; v < 100000; v++)
+		assert(dim_lat_bucket(v) < DIM_LAT_BUCKETS);
+	for (v = 1; v < 1000; v++)
+		assert(dim_lat_bucket(v) >= dim_lat_bucket(v - 1));
+
+	for (v = 1; v <= 1000; v++)
+		dim_lat_record(&dim, v);
+	p = dim_lat_percentile(dim.lat, 99);
+	/* exact p99 is 990; buckets are at most 25% wide */
+	assert(p >= 990 && p <= 990 * 5 / 4);
+	p = dim_lat_percentile(dim.lat, 50);
+	assert(p >= 500 && p <= 500 * 5 / 4);
+	dim_lat_disable(&dim);
+	printf("histogram: ok\n");
+}
+
+static bool custom_decide(struct dim *dim, struct dim_stats *curr_stats,
+			  u8 nr_profiles)
+{
+	dim->profile_ix = nr_profiles - 1;
+	return true;
+}
+
+static struct dim_algo custom_algo = {
+	.name	= "custom",
+	.decide	= custom_decide,
+};
+
+static void test_registry(void)
+{
+	struct dim dim = { 0 };
+
+	assert(dim_set_algo(&dim, "nonexistent") == -ENOENT);
+	assert(!dim_set_algo(&dim, "latency") && dim.algo == &dim_lat_algo);
+	/* the latency algorithm parks without a tired countdown */
+	dim.tune_state = DIM_PARKING_TIRED;
+	dim.steps_left = 3;
+	assert(!dim_set_algo(&dim, NULL) && !dim.algo);
+	assert(dim.tune_state == DIM_PARKING_ON_TOP && !dim.steps_left &&
+	       !dim.steps_right && !dim.tired);
+	assert(dim_register_algo(&dim_net_algo) == -EEXIST);
+	assert(!dim_register_algo(&custom_algo));
+	assert(dim_register_algo(&custom_algo) == -EEXIST);
+	assert(!dim_set_algo(&dim, "custom") && dim.algo == &custom_algo);
+	dim_put_algo(&dim);
+	dim_unregister_algo(&custom_algo);
+	assert(dim_set_algo(&dim, "custom") == -ENOENT);
+	printf("registry: ok\n");
+}
+
+static void test_latency_mode(unsigned int iops, u32 target_us)
+{
+	struct sim_result base = simulate(NULL, 0, iops, 400000, 0);
+	struct sim_result max = simulate(NULL, NR_PROFILES - 1, iops, 400000, 0);
+	struct sim_result lat = simulate("latency", 0, iops, 400000, target_us);
+	struct sim_result rdma = simulate("rdma", 0, iops, 400000, 0);
+
+	printf("%7u iops, target %u us: irqs/comp off %.3f max %.3f latency %.3f rdma %.3f; p99 off %u max %u latency %u rdma %u us; changes %u\n",
+	       iops, target_us,
+	       (double)base.irqs / base.comps, (double)max.irqs / max.comps,
+	       (double)lat.irqs / lat.comps, (double)rdma.irqs / rdma.comps,
+	       base.p99_us, max.p99_us, lat.p99_us, rdma.p99_us, lat.changes);
+
+	/* the goal holds whenever it is reachable at all */
+	if (base.p99_us < target_us)
+		assert(lat.p99_us <= target_us + target_us / 10);
+	/* without flapping between profiles */
+	assert(lat.changes <= 64);
+	/* and interrupts are saved when there is headroom for it */
+	if (base.p99_us * 2 < target_us && max.irqs * 2 < base.irqs)
+		assert(lat.irqs < base.irqs);
+}
+
+int main(void)
+{
+	test_histogram();
+	test_registry();
+	test_latency_mode(5000, 300);
+	test_latency_mode(50000, 300);
+	test_latency_mode(400000, 300);
+	test_latency_mode(400000, 150);
+	test_latency_mode(400000, 1000);
+	return 0;
+}